@@ -0,0 +1,167 @@
+//
+//	Readiness dispatch with many mostly idle device sockets: Poco::Net::SocketReactor and its
+//	notification observers, against the edge-triggered AP_WS_EpollLoop used when
+//	openwifi.session.reactor.eventloop is "epoll". One thread writes small messages to random
+//	sockets; the loop under test reads them.
+//
+//	epoll_dispatch [sockets] [seconds]
+//
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "Poco/NObserver.h"
+#include "Poco/Net/SocketNotification.h"
+#include "Poco/Net/SocketReactor.h"
+#include "Poco/Net/StreamSocket.h"
+#include "Poco/Net/StreamSocketImpl.h"
+#include "Poco/Thread.h"
+
+#include "AP_WS_EpollLoop.h"
+
+namespace {
+
+	std::atomic_uint64_t Received = 0;
+	std::atomic_uint64_t Calls = 0;
+
+	void Drain(int fd) {
+		char Buffer[4096];
+		while (true) {
+			auto n = read(fd, Buffer, sizeof(Buffer));
+			if (n <= 0)
+				return;
+			Received += n;
+		}
+	}
+
+	struct Pair {
+		int Reader = -1;
+		int Writer = -1;
+	};
+
+	std::vector<Pair> MakePairs(std::size_t Count) {
+		std::vector<Pair> Pairs(Count);
+		for (auto &P : Pairs) {
+			int fds[2];
+			if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) < 0) {
+				std::perror("socketpair");
+				std::exit(1);
+			}
+			fcntl(fds[0], F_SETFL, O_NONBLOCK);
+			fcntl(fds[1], F_SETFL, O_NONBLOCK);
+			P.Reader = fds[0];
+			P.Writer = fds[1];
+		}
+		return Pairs;
+	}
+
+	void Send(const std::vector<Pair> &Pairs, double Seconds) {
+		std::mt19937_64 Rng(1);
+		std::uniform_int_distribution<std::size_t> Pick(0, Pairs.size() - 1);
+		const char Message[64] = {};
+		auto End = std::chrono::steady_clock::now() + std::chrono::duration<double>(Seconds);
+		while (std::chrono::steady_clock::now() < End) {
+			for (int i = 0; i < 64; i++) {
+				[[maybe_unused]] auto r = write(Pairs[Pick(Rng)].Writer, Message, sizeof(Message));
+			}
+			//	leave the loop some room: devices are mostly idle
+			std::this_thread::yield();
+		}
+	}
+
+	void Report(const char *Name, std::size_t Sockets, double Seconds) {
+		std::printf("%-6s sockets=%-7zu MB/s=%.1f handler calls/s=%.0f\n", Name, Sockets,
+					(double)Received / Seconds / 1e6, (double)Calls / Seconds);
+	}
+
+	class PocoReader {
+	  public:
+		//	the socket owns its descriptor, so it gets a copy the epoll run can do without
+		explicit PocoReader(int fd) : Socket_(new Poco::Net::StreamSocketImpl(dup(fd))) {}
+		void OnReadable(const Poco::AutoPtr<Poco::Net::ReadableNotification> &) {
+			Calls++;
+			Drain(Socket_.impl()->sockfd());
+		}
+		Poco::Net::StreamSocket Socket_;
+	};
+
+	void RunPoco(const std::vector<Pair> &Pairs, double Seconds) {
+		Received = Calls = 0;
+		Poco::Net::SocketReactor Reactor;
+		std::vector<std::unique_ptr<PocoReader>> Readers;
+		for (const auto &P : Pairs) {
+			Readers.push_back(std::make_unique<PocoReader>(P.Reader));
+			Reactor.addEventHandler(
+				Readers.back()->Socket_,
+				Poco::NObserver<PocoReader, Poco::Net::ReadableNotification>(
+					*Readers.back(), &PocoReader::OnReadable));
+		}
+		Poco::Thread T;
+		T.start(Reactor);
+		Send(Pairs, Seconds);
+		Reactor.stop();
+		T.join();
+		Report("poco", Pairs.size(), Seconds);
+		for (auto &R : Readers)
+			Reactor.removeEventHandler(
+				R->Socket_, Poco::NObserver<PocoReader, Poco::Net::ReadableNotification>(
+								*R, &PocoReader::OnReadable));
+	}
+
+	class EpollReader : public OpenWifi::AP_WS_EpollLoop::Handler {
+	  public:
+		explicit EpollReader(int fd) : fd_(fd) {}
+		bool OnEpollReadable() override {
+			Calls++;
+			Drain(fd_);
+			return false;
+		}
+		void OnEpollWritable() override {}
+		void OnEpollShutdown() override {}
+		void OnEpollError() override {}
+
+	  private:
+		int fd_;
+	};
+
+	void RunEpoll(const std::vector<Pair> &Pairs, double Seconds) {
+		Received = Calls = 0;
+		OpenWifi::AP_WS_EpollLoop Loop;
+		std::vector<std::shared_ptr<EpollReader>> Readers;
+		for (const auto &P : Pairs) {
+			Readers.push_back(std::make_shared<EpollReader>(P.Reader));
+			Loop.Add(P.Reader, Readers.back());
+		}
+		Poco::Thread T;
+		T.start(Loop);
+		Send(Pairs, Seconds);
+		Loop.stop();
+		T.join();
+		Report("epoll", Pairs.size(), Seconds);
+	}
+
+} // namespace
+
+int main(int argc, char **argv) {
+	std::size_t Sockets = argc > 1 ? (std::size_t)std::atoll(argv[1]) : 10000;
+	double Seconds = argc > 2 ? std::atof(argv[2]) : 5.0;
+
+	//	both loops see the same sockets; what is left unread by one is drained first
+	auto Pairs = MakePairs(Sockets);
+	RunPoco(Pairs, Seconds);
+	for (const auto &P : Pairs)
+		Drain(P.Reader);
+	RunEpoll(Pairs, Seconds);
+	return 0;
+}
@@ -0,0 +1,193 @@
+//
+//	Cost of CommandManager's outstanding RPC table with 100k RPCs in flight: the former
+//	std::map scanned for every lookup against OutstandingRPCTable, the table CommandManager
+//	uses, with its indexes by device, by command UUID and by submission time.
+//
+//	outstanding_rpcs [requests] [devices]
+//
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <random>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "OutstandingRPCTable.h"
+
+namespace {
+
+	using Clock = std::chrono::high_resolution_clock;
+
+	//	the fields of CommandManager::CommandInfo that the table reads, and a completion
+	struct CommandInfo {
+		std::uint64_t Id = 0;
+		std::uint64_t SerialNumber = 0;
+		std::string UUID;
+		Clock::time_point submitted;
+		Clock::time_point Deadline;
+		std::function<void()> Completion;
+	};
+
+	class ScanTable {
+	  public:
+		void Add(const CommandInfo &C) { Requests_[C.Id] = C; }
+		void Erase(std::uint64_t Id) { Requests_.erase(Id); }
+		bool RunningForDevice(std::uint64_t SerialNumber) const {
+			for (const auto &[Id, C] : Requests_)
+				if (C.SerialNumber == SerialNumber)
+					return true;
+			return false;
+		}
+		bool Running(const std::string &UUID) const {
+			for (const auto &[Id, C] : Requests_)
+				if (C.UUID == UUID)
+					return true;
+			return false;
+		}
+		std::size_t TimeOut(Clock::time_point Cutoff) {
+			std::size_t Count = 0;
+			for (auto R = Requests_.begin(); R != Requests_.end();) {
+				if (R->second.submitted < Cutoff) {
+					R = Requests_.erase(R);
+					Count++;
+				} else {
+					++R;
+				}
+			}
+			return Count;
+		}
+
+	  private:
+		std::map<std::uint64_t, CommandInfo> Requests_;
+	};
+
+	//	CommandManager's table, under a recursive lock as LocalMutex_ is, the completion moved
+	//	out of a retired request as EraseOutstanding does.
+	class IndexedTable {
+	  public:
+		void Add(const CommandInfo &C) {
+			std::lock_guard Lock(Mutex_);
+			Table_.Add(C, C.Completion != nullptr);
+		}
+		void Erase(std::uint64_t Id) {
+			std::lock_guard Lock(Mutex_);
+			CommandInfo Removed;
+			if (Table_.Erase(Id, &Removed) && Removed.Completion)
+				Removed.Completion();
+		}
+		bool RunningForDevice(std::uint64_t SerialNumber) {
+			std::lock_guard Lock(Mutex_);
+			return Table_.FirstForDevice(SerialNumber) != nullptr;
+		}
+		bool Running(const std::string &UUID) {
+			std::lock_guard Lock(Mutex_);
+			return Table_.FindUUID(UUID) != nullptr;
+		}
+		std::size_t TimeOut(Clock::time_point Cutoff) {
+			std::lock_guard Lock(Mutex_);
+			std::size_t Count = 0;
+			while (auto Request = Table_.OldestSubmittedBefore(Cutoff)) {
+				Erase(Request->Id);
+				Count++;
+			}
+			return Count;
+		}
+
+	  private:
+		std::recursive_mutex Mutex_;
+		OpenWifi::OutstandingRPCTable<CommandInfo> Table_;
+	};
+
+	//	Nanoseconds per call of Op, over Calls calls.
+	double PerCall(std::size_t Calls, const std::function<void(std::size_t)> &Op) {
+		auto Start = Clock::now();
+		for (std::size_t i = 0; i < Calls; i++)
+			Op(i);
+		std::chrono::duration<double, std::nano> Elapsed = Clock::now() - Start;
+		return Elapsed.count() / (double)Calls;
+	}
+
+	template <typename Table>
+	void Run(const char *Name, const std::vector<CommandInfo> &Commands,
+			 const std::vector<std::uint64_t> &Devices, std::size_t Calls) {
+		Table T;
+		for (const auto &C : Commands)
+			T.Add(C);
+
+		std::mt19937_64 Rng(7);
+		std::size_t Hits = 0;
+		auto Device = PerCall(Calls, [&](std::size_t) {
+			Hits += T.RunningForDevice(Devices[Rng() % Devices.size()]);
+		});
+		auto UUID = PerCall(Calls, [&](std::size_t) {
+			Hits += T.Running(Commands[Rng() % Commands.size()].UUID);
+		});
+		//	an answer retires its RPC and the device's next command takes its place
+		auto NextId = Commands.back().Id;
+		auto Complete = PerCall(Calls, [&](std::size_t i) {
+			auto C = Commands[i % Commands.size()];
+			T.Erase(C.Id);
+			C.Id = ++NextId;
+			C.submitted = Commands.back().submitted;
+			T.Add(C);
+		});
+		//	janitor passes that find nothing due, then the oldest 1% timed out
+		std::size_t Expired = 0;
+		auto Idle =
+			PerCall(1, [&](std::size_t) { Expired += T.TimeOut(Commands[Calls].submitted); });
+		auto Cutoff = Commands[Calls + Commands.size() / 100].submitted;
+		auto Janitor = PerCall(1, [&](std::size_t) { Expired += T.TimeOut(Cutoff); });
+
+		std::printf("%-8s in-flight=%-7zu device=%.0fns uuid=%.0fns complete=%.0fns "
+					"janitor idle=%.1fus 1%%=%.0fus (%zu expired)\n",
+					Name, Commands.size(), Device, UUID, Complete, Idle / 1000.0,
+					Janitor / 1000.0, Expired);
+		if (Hits < Calls)
+			std::abort();
+	}
+
+} // namespace
+
+int main(int argc, char **argv) {
+	std::size_t Requests = argc > 1 ? (std::size_t)std::atoll(argv[1]) : 100000;
+	std::size_t NumberOfDevices = argc > 2 ? (std::size_t)std::atoll(argv[2]) : 20000;
+	if (Requests < 1000 || NumberOfDevices == 0 || NumberOfDevices > Requests) {
+		std::fprintf(stderr, "usage: outstanding_rpcs [requests >= 1000] [devices]\n");
+		return 1;
+	}
+
+	std::mt19937_64 Rng(42);
+	std::vector<std::uint64_t> Devices;
+	for (std::size_t i = 0; i < NumberOfDevices; i++)
+		Devices.push_back((0x903cb3ULL << 24) | (Rng() & 0xffffff));
+
+	//	one submission per microsecond, spread over the devices, each with its UUID
+	auto Start = Clock::now();
+	std::vector<CommandInfo> Commands;
+	Commands.reserve(Requests);
+	for (std::size_t i = 0; i < Requests; i++) {
+		CommandInfo C;
+		C.Id = i + 4;
+		C.SerialNumber = Devices[i % Devices.size()];
+		char UUID[40];
+		std::snprintf(UUID, sizeof(UUID), "%08llx-0000-4000-8000-%012llx",
+					  (unsigned long long)(Rng() & 0xffffffff), (unsigned long long)i);
+		C.UUID = UUID;
+		C.submitted = Start + std::chrono::microseconds(i);
+		Commands.push_back(std::move(C));
+	}
+
+	//	a scan costs the whole table, so it gets fewer calls
+	Run<ScanTable>("scan", Commands, Devices, 200);
+	Run<IndexedTable>("indexed", Commands, Devices, 200);
+	Run<IndexedTable>("indexed", Commands, Devices, Requests / 10);
+	return 0;
+}
@@ -0,0 +1,117 @@
+//
+//	Lookup throughput of the AP connection registry at 100k sessions: the former single
+//	std::map behind a recursive mutex against AP_WS_DeviceRegistry, the serial number shards
+//	of AP_WS_Server.
+//
+//	registry_lookup [threads] [sessions] [seconds]
+//
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "AP_WS_DeviceRegistry.h"
+
+namespace {
+
+	struct Connection {
+		std::uint64_t SerialNumber = 0;
+	};
+
+	class GlobalRegistry {
+	  public:
+		bool Register(std::uint64_t SerialNumber, std::uint64_t Session,
+					  std::shared_ptr<Connection> C) {
+			std::lock_guard G(Mutex_);
+			SerialNumbers_[SerialNumber] = std::make_pair(Session, std::move(C));
+			return true;
+		}
+		std::shared_ptr<Connection> Find(std::uint64_t SerialNumber) const {
+			std::lock_guard G(Mutex_);
+			auto Hint = SerialNumbers_.find(SerialNumber);
+			return Hint == SerialNumbers_.end() ? nullptr : Hint->second.second;
+		}
+
+	  private:
+		mutable std::recursive_mutex Mutex_;
+		std::map<std::uint64_t, std::pair<std::uint64_t, std::shared_ptr<Connection>>>
+			SerialNumbers_;
+	};
+
+	template <typename Registry>
+	double Run(const char *Name, const std::vector<std::uint64_t> &SerialNumbers,
+			   unsigned Threads, double Seconds) {
+		Registry R;
+		for (const auto SN : SerialNumbers)
+			R.Register(SN, SN, std::make_shared<Connection>(Connection{SN}));
+
+		std::atomic_bool Go = false, Done = false;
+		std::vector<std::uint64_t> Lookups(Threads, 0);
+		std::vector<std::thread> Workers;
+		for (unsigned t = 0; t < Threads; t++) {
+			Workers.emplace_back([&, t] {
+				std::mt19937_64 Rng(t + 1);
+				std::uniform_int_distribution<std::size_t> Pick(0, SerialNumbers.size() - 1);
+				std::uint64_t Count = 0, Found = 0;
+				while (!Go)
+					std::this_thread::yield();
+				while (!Done) {
+					for (int i = 0; i < 1024; i++)
+						Found += R.Find(SerialNumbers[Pick(Rng)]) != nullptr;
+					Count += 1024;
+				}
+				Lookups[t] = Count;
+				if (Found != Count)
+					std::abort();
+			});
+		}
+		auto Start = std::chrono::steady_clock::now();
+		Go = true;
+		std::this_thread::sleep_for(std::chrono::duration<double>(Seconds));
+		Done = true;
+		for (auto &W : Workers)
+			W.join();
+		std::chrono::duration<double> Elapsed = std::chrono::steady_clock::now() - Start;
+		std::uint64_t Total = 0;
+		for (const auto L : Lookups)
+			Total += L;
+		auto PerSecond = (double)Total / Elapsed.count();
+		std::printf("%-8s threads=%-3u sessions=%-7zu lookups/s=%.0f\n", Name, Threads,
+					SerialNumbers.size(), PerSecond);
+		return PerSecond;
+	}
+
+} // namespace
+
+int main(int argc, char **argv) {
+	unsigned Threads = argc > 1 ? (unsigned)std::atoi(argv[1])
+								: std::max(1u, std::thread::hardware_concurrency());
+	std::size_t Sessions = argc > 2 ? (std::size_t)std::atoll(argv[2]) : 100000;
+	double Seconds = argc > 3 ? std::atof(argv[3]) : 2.0;
+
+	//	serial numbers look like MACs: a few OUIs and random low bytes
+	std::mt19937_64 Rng(42);
+	const std::uint64_t OUIs[] = {0x903cb3, 0x24f5a2, 0x04f8f8, 0xe8b1fc};
+	std::vector<std::uint64_t> SerialNumbers;
+	SerialNumbers.reserve(Sessions);
+	for (std::size_t i = 0; i < Sessions; i++)
+		SerialNumbers.push_back((OUIs[i % 4] << 24) | (Rng() & 0xffffff));
+
+	for (unsigned T = 1; T <= Threads; T *= 2) {
+		auto Global = Run<GlobalRegistry>("global", SerialNumbers, T, Seconds);
+		auto Sharded = Run<OpenWifi::AP_WS_DeviceRegistry<Connection>>("sharded", SerialNumbers,
+																		T, Seconds);
+		std::printf("speedup  threads=%-3u %.2fx\n", T, Sharded / Global);
+	}
+	return 0;
+}
@@ -18,6 +18,8 @@
 #include "CentralConfig.h"
 #include "CommandManager.h"
 #include "ConfigurationCache.h"
+#include "DeviceShadow.h"
+#include "DisconnectionCleanup.h"
 #include "StorageService.h"
 #include "TelemetryStream.h"
 
@@ -49,9 +51,10 @@ namespace OpenWifi {
 	AP_WS_Connection::AP_WS_Connection(Poco::Net::HTTPServerRequest &request,
 									   Poco::Net::HTTPServerResponse &response,
 									   uint64_t connection_id, Poco::Logger &L,
-									   Poco::Net::SocketReactor &R)
-		: Logger_(L), Reactor_(R) {
+									   AP_WS_Reactor &R)
+		: Logger_(L), Reactor_(&R) {
 		State_.sessionId = connection_id;
+		AP_WS_Server()->ConfigureSendQueue(SendQueue_);
 		WS_ = std::make_unique<Poco::Net::WebSocket>(request, response);
 
 		auto TS = Poco::Timespan(360, 0);
@@ -62,20 +65,73 @@ namespace OpenWifi {
 		WS_->setKeepAlive(true);
 		WS_->setBlocking(false);
 
-		Reactor_.addEventHandler(*WS_,
-								 Poco::NObserver<AP_WS_Connection, Poco::Net::ReadableNotification>(
-									 *this, &AP_WS_Connection::OnSocketReadable));
-		Reactor_.addEventHandler(*WS_,
-								 Poco::NObserver<AP_WS_Connection, Poco::Net::ShutdownNotification>(
-									 *this, &AP_WS_Connection::OnSocketShutdown));
-		Reactor_.addEventHandler(*WS_,
-								 Poco::NObserver<AP_WS_Connection, Poco::Net::ErrorNotification>(
-									 *this, &AP_WS_Connection::OnSocketError));
-		Registered_ = true;
 		Valid_ = true;
 		uuid_ = MicroServiceRandom(std::numeric_limits<std::uint64_t>::max()-1);
 	}
 
+	//	Only called once the device has been validated, so reactor threads never see a device
+	//	that has not completed its TLS and certificate checks.
+	void AP_WS_Connection::Start() {
+		std::lock_guard G(ReactorMutex_);
+		AddEventHandlers();
+		Reactor_->Sockets++;
+		Registered_ = true;
+	}
+
+	void AP_WS_Connection::AddEventHandlers() {
+		if (Reactor_->Epoll) {
+			EpollToken_ = Reactor_->Epoll->Add(WS_->impl()->sockfd(), weak_from_this());
+			return;
+		}
+		auto &Reactor = Reactor_->Reactor;
+		Reactor.addEventHandler(*WS_,
+								Poco::NObserver<AP_WS_Connection, Poco::Net::ReadableNotification>(
+									*this, &AP_WS_Connection::OnSocketReadable));
+		Reactor.addEventHandler(*WS_,
+								Poco::NObserver<AP_WS_Connection, Poco::Net::ShutdownNotification>(
+									*this, &AP_WS_Connection::OnSocketShutdown));
+		Reactor.addEventHandler(*WS_,
+								Poco::NObserver<AP_WS_Connection, Poco::Net::ErrorNotification>(
+									*this, &AP_WS_Connection::OnSocketError));
+	}
+
+	void AP_WS_Connection::RemoveEventHandlers() {
+		if (Reactor_->Epoll) {
+			Reactor_->Epoll->Remove(WS_->impl()->sockfd(), EpollToken_);
+			return;
+		}
+		if (WriteArmed_)
+			RemoveWritableHandler();
+		auto &Reactor = Reactor_->Reactor;
+		Reactor.removeEventHandler(
+			*WS_, Poco::NObserver<AP_WS_Connection, Poco::Net::ReadableNotification>(
+					  *this, &AP_WS_Connection::OnSocketReadable));
+		Reactor.removeEventHandler(
+			*WS_, Poco::NObserver<AP_WS_Connection, Poco::Net::ShutdownNotification>(
+					  *this, &AP_WS_Connection::OnSocketShutdown));
+		Reactor.removeEventHandler(
+			*WS_, Poco::NObserver<AP_WS_Connection, Poco::Net::ErrorNotification>(
+					  *this, &AP_WS_Connection::OnSocketError));
+	}
+
+	//	Runs on the current reactor thread, between two frames, so no handler of this connection
+	//	is active while the socket changes hands.
+	void AP_WS_Connection::MigrateReactor(AP_WS_Reactor &Target) {
+		std::lock_guard G(ReactorMutex_);
+		if (!Registered_ || &Target == Reactor_)
+			return;
+		RemoveEventHandlers();
+		Reactor_->Sockets--;
+		Reactor_->MigratedOut++;
+		Reactor_ = &Target;
+		AddEventHandlers();
+		if (!Reactor_->Epoll && !SendQueue_.IfEmpty([] {}))
+			AddWritableHandler();
+		Reactor_->Sockets++;
+		Reactor_->MigratedIn++;
+		poco_debug(Logger_, fmt::format("MIGRATE({}): moved to reactor {}.", CId_, Target.Id));
+	}
+
 	bool AP_WS_Connection::ValidatedDevice() {
 		if (DeviceValidated_)
 			return true;
@@ -146,7 +202,9 @@ namespace OpenWifi {
 
 			std::string reason, author;
 			std::uint64_t created;
-			if (!CN_.empty() && StorageService()->IsBlackListed(CN_, reason, author, created)) {
+			if (!CN_.empty() && Utils::ValidSerialNumber(CN_) &&
+				StorageService()->IsBlackListed(Utils::SerialNumberToInt(CN_), reason, author,
+												created)) {
 				DeviceBlacklistedKafkaEvent KE(Utils::SerialNumberToInt(CN_), Utils::Now(), reason, author, created, CId_);
 				poco_warning(
 					Logger_,
@@ -223,56 +281,53 @@ namespace OpenWifi {
 		return false;
 	}
 
-	static void NotifyKafkaDisconnect(const std::string &SerialNumber, std::uint64_t uuid) {
-		try {
-			Poco::JSON::Object Disconnect;
-			Poco::JSON::Object Details;
-			Details.set(uCentralProtocol::SERIALNUMBER, SerialNumber);
-			Details.set(uCentralProtocol::TIMESTAMP, Utils::Now());
-			Details.set(uCentralProtocol::UUID,uuid);
-			Disconnect.set(uCentralProtocol::DISCONNECTION, Details);
-			KafkaManager()->PostMessage(KafkaTopics::CONNECTION, SerialNumber, Disconnect);
-		} catch (...) {
-		}
-	}
-
 	AP_WS_Connection::~AP_WS_Connection() {
 		Valid_ = false;
 		EndConnection();
+		AP_WS_Server()->AccountLastStats(LastStats_.RawSize(), LastStats_.HeldSize(), 0, 0);
 	}
 
-	void DeviceDisconnectionCleanup(const std::string &SerialNumber, std::uint64_t uuid) {
-		if (KafkaManager()->Enabled()) {
-			NotifyKafkaDisconnect(SerialNumber, uuid);
+	void AP_WS_Connection::GetLastStats(std::string &LastStats) {
+		CompressedText Held;
+		{
+			std::shared_lock G(ConnectionMutex_);
+			Held = LastStats_;
 		}
-		RADIUSSessionTracker()->DeviceDisconnect(SerialNumber);
+		LastStats = Held.Text();
+	}
+
+	void AP_WS_Connection::SetLastStats(const CompressedText &LastStats,
+										const StateUtils::DeviceMetrics &Metrics) {
+		std::unique_lock G(ConnectionMutex_);
+		AP_WS_Server()->AccountLastStats(LastStats_.RawSize(), LastStats_.HeldSize(),
+										 LastStats.RawSize(), LastStats.HeldSize());
+		LastStats_ = LastStats;
+		auto Sanity = Metrics_.Sanity;
+		Metrics_ = Metrics;
+		Metrics_.Sanity = Sanity;
 	}
 
 	void AP_WS_Connection::EndConnection(bool DeleteSession) {
     	Valid_ = false;
 		if (!Dead_.test_and_set()) {
-
-			if(!SerialNumber_.empty() && State_.LastContact!=0) {
-				StorageService()->SetDeviceLastRecordedContact(SerialNumber_, State_.LastContact);
-			}
-
-			if (Registered_) {
-				Registered_ = false;
-				Reactor_.removeEventHandler(
-					*WS_, Poco::NObserver<AP_WS_Connection, Poco::Net::ReadableNotification>(
-							  *this, &AP_WS_Connection::OnSocketReadable));
-				Reactor_.removeEventHandler(
-					*WS_, Poco::NObserver<AP_WS_Connection, Poco::Net::ShutdownNotification>(
-							  *this, &AP_WS_Connection::OnSocketShutdown));
-				Reactor_.removeEventHandler(
-					*WS_, Poco::NObserver<AP_WS_Connection, Poco::Net::ErrorNotification>(
-							  *this, &AP_WS_Connection::OnSocketError));
+			if (Counted_.exchange(CountedEnded) == CountedConnected)
+				AP_WS_Server()->DeviceDisconnected(State_.started);
+
+			{
+				std::lock_guard G(ReactorMutex_);
+				if (Registered_) {
+					Registered_ = false;
+					RemoveEventHandlers();
+					Reactor_->Sockets--;
+				}
 			}
 			WS_->close();
 
 			if(!SerialNumber_.empty()) {
-				std::thread	Cleanup(DeviceDisconnectionCleanup,SerialNumber_, uuid_);
-				Cleanup.detach();
+				DisconnectionCleanup()->DeviceDisconnected(SerialNumber_, uuid_, State_.LastContact);
+				GWObjects::ConnectionState LastState;
+				GetState(LastState);
+				DeviceShadow()->SetConnection(SerialNumberInt_, LastState);
 			}
 
 			bool SessionDeleted = false;
@@ -433,27 +488,8 @@ namespace OpenWifi {
 			return;
 		}
 
-		auto Serial =
-			Poco::trim(Poco::toLower(ParamsObj->get(uCentralProtocol::SERIAL).toString()));
-		if (!Utils::ValidSerialNumber(Serial)) {
-			Poco::Exception E(
-				fmt::format(
-					"ILLEGAL-DEVICE-NAME({}): device name is illegal and not allowed to connect.",
-					Serial),
-				EACCES);
-			E.rethrow();
-		}
-
-		std::string reason, author;
-		std::uint64_t created;
-		if (StorageService()->IsBlackListed(Serial, reason, author, created)) {
-			DeviceBlacklistedKafkaEvent KE(Utils::SerialNumberToInt(CN_), Utils::Now(), reason, author, created, CId_);
-			Poco::Exception E(
-				fmt::format("BLACKLIST({}): device is blacklisted and not allowed to connect.",
-							Serial),
-				EACCES);
-			E.rethrow();
-		}
+		auto Serial = ParamsObj->get(uCentralProtocol::SERIAL).toString();
+		ValidateEventSerialNumber(Serial);
 
 		switch (EventType) {
 		case uCentralProtocol::Events::ET_CONNECT: {
@@ -526,6 +562,87 @@ namespace OpenWifi {
 		}
 	}
 
+	void AP_WS_Connection::ValidateEventSerialNumber(std::string &Serial) {
+		Poco::trimInPlace(Poco::toLowerInPlace(Serial));
+		if (Serial.empty() || !Utils::ValidSerialNumber(Serial)) {
+			Poco::Exception E(
+				fmt::format(
+					"ILLEGAL-DEVICE-NAME({}): device name is illegal and not allowed to connect.",
+					Serial),
+				EACCES);
+			E.rethrow();
+		}
+
+		std::string reason, author;
+		std::uint64_t created;
+		if (StorageService()->IsBlackListed(Utils::SerialNumberToInt(Serial), reason, author,
+											created)) {
+			DeviceBlacklistedKafkaEvent KE(Utils::SerialNumberToInt(CN_), Utils::Now(), reason, author, created, CId_);
+			Poco::Exception E(
+				fmt::format("BLACKLIST({}): device is blacklisted and not allowed to connect.",
+							Serial),
+				EACCES);
+			E.rethrow();
+		}
+	}
+
+	//	State and healthcheck messages make up most of the traffic and are large. They are routed
+	//	without building a DOM for the whole frame. Returns false when the message should go
+	//	through the regular parser instead.
+	bool AP_WS_Connection::ProcessRawJSONRPCEvent(const RawJSONObject &Frame) {
+		std::string Method;
+		if (!Frame.GetString(uCentralProtocol::METHOD, Method))
+			return false;
+		auto EventType = uCentralProtocol::Events::EventFromString(Method);
+		if (EventType != uCentralProtocol::Events::ET_STATE &&
+			EventType != uCentralProtocol::Events::ET_HEALTHCHECK)
+			return false;
+
+		RawJSONObject ParamsObj;
+		if (!ParamsObj.Parse(Frame.Raw(uCentralProtocol::PARAMS)))
+			return false;
+
+		std::string UncompressedData;
+		if (ParamsObj.Has(uCentralProtocol::COMPRESS_64)) {
+			std::string CompressedData;
+			uint64_t compress_sz = 0;
+			if (!ParamsObj.GetString(uCentralProtocol::COMPRESS_64, CompressedData))
+				return false;
+			if (ParamsObj.Has("compress_sz") && !ParamsObj.GetUInt("compress_sz", compress_sz))
+				return false;
+			if (!Utils::ExtractBase64CompressedData(CompressedData, UncompressedData,
+													compress_sz)) {
+				poco_warning(Logger_,
+							 fmt::format("INVALID-COMPRESSED-DATA({}): Compressed cannot be "
+										 "uncompressed - content must be corrupt..: size={}",
+										 CId_, CompressedData.size()));
+				Errors_++;
+				return true;
+			}
+			poco_trace(Logger_, fmt::format("EVENT({}): Found compressed payload expanded to '{}'.",
+											CId_, UncompressedData));
+			if (!ParamsObj.Parse(UncompressedData)) {
+				poco_warning(Logger_, fmt::format("INVALID-COMPRESSED-JSON-DATA({}): Compressed "
+												  "cannot be parsed - JSON must be corrupt..",
+												  CId_));
+				return true;
+			}
+		}
+
+		std::string Serial;
+		if (!ParamsObj.GetString(uCentralProtocol::SERIAL, Serial)) {
+			poco_warning(
+				Logger_,
+				fmt::format("MISSING-PARAMS({}): Serial number is missing in message.", CId_));
+			return true;
+		}
+		ValidateEventSerialNumber(Serial);
+
+		if (EventType == uCentralProtocol::Events::ET_STATE)
+			return Process_state(ParamsObj);
+		return Process_healthcheck(ParamsObj);
+	}
+
 	bool AP_WS_Connection::StartTelemetry(uint64_t RPCID,
 										  const std::vector<std::string> &TelemetryTypes) {
 		poco_information(Logger_, fmt::format("TELEMETRY({}): Starting.", CId_));
@@ -654,7 +771,30 @@ namespace OpenWifi {
 
 	void AP_WS_Connection::OnSocketReadable(
 		[[maybe_unused]] const Poco::AutoPtr<Poco::Net::ReadableNotification> &pNf) {
+		ProcessReadable();
+	}
+
+	bool AP_WS_Connection::OnEpollReadable() {
+		ProcessReadable();
+		if (!Valid_ || !Registered_)
+			return false;
+		//	Frames already decoded by TLS or buffered by the WebSocket are not visible to epoll.
+		if (WS_->available() > 0)
+			return true;
+		return WS_->poll(Poco::Timespan(0), Poco::Net::Socket::SELECT_READ);
+	}
+
+	void AP_WS_Connection::OnEpollShutdown() {
+		poco_trace(Logger_, fmt::format("SOCKET-SHUTDOWN({}): Closing.", CId_));
+		return EndConnection();
+	}
 
+	void AP_WS_Connection::OnEpollError() {
+		poco_trace(Logger_, fmt::format("SOCKET-ERROR({}): Closing.", CId_));
+		return EndConnection();
+	}
+
+	void AP_WS_Connection::ProcessReadable() {
 		if (!Valid_)
 			return;
 
@@ -665,7 +805,14 @@ namespace OpenWifi {
 			return;
 
 		try {
-			return ProcessIncomingFrame();
+			auto Start = std::chrono::steady_clock::now();
+			ProcessIncomingFrame();
+			Reactor_->AddBusyTime(std::chrono::duration_cast<std::chrono::microseconds>(
+									  std::chrono::steady_clock::now() - Start)
+									  .count());
+			if (Valid_ && Reactor_->TakeMigration())
+				MigrateReactor(AP_WS_Server()->Reactor(Reactor_->MigrationTarget));
+			return;
 		} catch (const Poco::Exception &E) {
 			Logger_.log(E);
 			return EndConnection();
@@ -683,7 +830,8 @@ namespace OpenWifi {
 	}
 
 	void AP_WS_Connection::ProcessIncomingFrame() {
-		Poco::Buffer<char> IncomingFrame(0);
+		auto FrameLease = Reactor_->Arena.Acquire();
+		auto &IncomingFrame = FrameLease.Buffer();
 		try {
 			int Op, flags;
 			auto IncomingSize = WS_->receiveFrame(IncomingFrame, flags);
@@ -707,9 +855,11 @@ namespace OpenWifi {
 			switch (Op) {
 			case Poco::Net::WebSocket::FRAME_OP_PING: {
 				poco_trace(Logger_, fmt::format("WS-PING({}): received. PONG sent back.", CId_));
-				WS_->sendFrame("", 0,
-							   (int)Poco::Net::WebSocket::FRAME_OP_PONG |
-								   (int)Poco::Net::WebSocket::FRAME_FLAG_FIN);
+				//	Goes through the queue so it cannot land in the middle of a pending frame.
+				if (SendQueue_.Push("", (int)Poco::Net::WebSocket::FRAME_OP_PONG |
+											(int)Poco::Net::WebSocket::FRAME_FLAG_FIN) ==
+					AP_WS_SendQueue::PushResult::Queued)
+					DrainSendQueue();
 
 				if (KafkaManager()->Enabled()) {
 					Poco::JSON::Object PingObject;
@@ -738,6 +888,13 @@ namespace OpenWifi {
 						   fmt::format("FRAME({}): Frame received (length={}, flags={}). Msg={}",
 									   CId_, IncomingSize, flags, IncomingFrame.begin()));
 
+				RawJSONObject Frame;
+				if (Frame.Parse(std::string_view(IncomingFrame.begin(), IncomingSize)) &&
+					Frame.Has(uCentralProtocol::JSONRPC) && Frame.IsObject(uCentralProtocol::PARAMS) &&
+					ProcessRawJSONRPCEvent(Frame)) {
+					return;
+				}
+
 				Poco::JSON::Parser parser;
 				auto ParsedMessage = parser.parse(IncomingFrame.begin());
 				auto IncomingJSON = ParsedMessage.extract<Poco::JSON::Object::Ptr>();
@@ -862,51 +1019,89 @@ namespace OpenWifi {
 		return EndConnection();
 	}
 
+	//	Never writes from the calling thread: the frame is queued and the connection's reactor
+	//	writes it when the socket can take it. Returns false when the frame could not be queued.
 	bool AP_WS_Connection::Send(const std::string &Payload) {
+		if (!Valid_)
+			return false;
+		switch (SendQueue_.Push(Payload)) {
+		case AP_WS_SendQueue::PushResult::Queued:
+			break;
+		case AP_WS_SendQueue::PushResult::Dropped:
+			poco_debug(Logger_, fmt::format("SEND-QUEUE({}): full, frame dropped.", CId_));
+			return false;
+		case AP_WS_SendQueue::PushResult::Overflow:
+			poco_warning(Logger_,
+						 fmt::format("SEND-QUEUE({}): full, device is not reading. Disconnecting.",
+									 CId_));
+			EndConnection();
+			return false;
+		}
+		ScheduleWrite();
+		return true;
+	}
+
+	void AP_WS_Connection::ScheduleWrite() {
+		std::lock_guard G(ReactorMutex_);
+		if (!Registered_)
+			return;
+		if (Reactor_->Epoll) {
+			Reactor_->Epoll->Wake(EpollToken_);
+		} else if (!WriteArmed_) {
+			AddWritableHandler();
+		}
+	}
+
+	void AP_WS_Connection::AddWritableHandler() {
+		Reactor_->Reactor.addEventHandler(
+			*WS_, Poco::NObserver<AP_WS_Connection, Poco::Net::WritableNotification>(
+					  *this, &AP_WS_Connection::OnSocketWritable));
+		WriteArmed_ = true;
+	}
+
+	void AP_WS_Connection::RemoveWritableHandler() {
+		Reactor_->Reactor.removeEventHandler(
+			*WS_, Poco::NObserver<AP_WS_Connection, Poco::Net::WritableNotification>(
+					  *this, &AP_WS_Connection::OnSocketWritable));
+		WriteArmed_ = false;
+	}
+
+	//	Reactor thread only.
+	void AP_WS_Connection::DrainSendQueue() {
+		if (!Valid_)
+			return;
 		try {
-			size_t BytesSent = WS_->sendFrame(Payload.c_str(), (int)Payload.size());
-
-			/*
-			 * 	There is a possibility to actually try and send data but the device is no longer
-			 * listening. This code attempts to wait 5 seconds to see if the device is actually
-			 * still listening. if the data is not acked under 5 seconds, then we consider that the
-			 * data never made it or the device is disconnected somehow.
-			 */
-#if defined(__APPLE__)
-			tcp_connection_info info;
-			int timeout = 4000;
-			auto expireAt = std::chrono::system_clock::now() + std::chrono::milliseconds(timeout);
-			do {
-				std::this_thread::sleep_for(std::chrono::milliseconds(50));
-				socklen_t opt_len = sizeof(info);
-				getsockopt(WS_->impl()->sockfd(), SOL_SOCKET, TCP_CONNECTION_INFO, (void *)&info,
-						   &opt_len);
-			} while (!info.tcpi_tfo_syn_data_acked && expireAt > std::chrono::system_clock::now());
-			if (!info.tcpi_tfo_syn_data_acked)
-				return false;
-#else
-			tcp_info info;
-			int timeout = 4000;
-			auto expireAt = std::chrono::system_clock::now() + std::chrono::milliseconds(timeout);
-			do {
-				std::this_thread::sleep_for(std::chrono::milliseconds(20));
-				socklen_t opt_len = sizeof(info);
-				getsockopt(WS_->impl()->sockfd(), SOL_TCP, TCP_INFO, (void *)&info, &opt_len);
-			} while (info.tcpi_unacked > 0 && expireAt > std::chrono::system_clock::now());
-
-			if (info.tcpi_unacked > 0) {
-				return false;
+			auto Socket =
+				dynamic_cast<Poco::Net::WebSocketImpl *>(WS_->impl())->streamSocketImpl();
+			bool Empty = false;
+			auto Written = SendQueue_.Drain(
+				[Socket](const char *Data, std::size_t Size) {
+					return Socket->sendBytes(Data, (int)Size);
+				},
+				Empty);
+			if (Written > 0) {
+				State_.TX += Written;
+				AP_WS_Server()->AddTX(Written);
 			}
-#endif
-			State_.TX += BytesSent;
-			AP_WS_Server()->AddTX(BytesSent);
-			return BytesSent == Payload.size();
 		} catch (const Poco::Exception &E) {
 			Logger_.log(E);
+			EndConnection();
 		}
-		return false;
 	}
 
+	void AP_WS_Connection::OnSocketWritable(
+		[[maybe_unused]] const Poco::AutoPtr<Poco::Net::WritableNotification> &pNf) {
+		DrainSendQueue();
+		//	The Poco reactor reports a writable socket continuously: stop listening once the queue
+		//	is empty. Holding the reactor lock first means a concurrent Send() either sees the
+		//	handler still armed after its frame was queued, or re-arms it.
+		std::lock_guard G(ReactorMutex_);
+		if (Registered_ && WriteArmed_)
+			SendQueue_.IfEmpty([this] { RemoveWritableHandler(); });
+	}
+
+	void AP_WS_Connection::OnEpollWritable() { DrainSendQueue(); }
+
 	std::string Base64Encode(const unsigned char *buffer, std::size_t size) {
 		return Utils::base64encode(buffer, size);
 	}
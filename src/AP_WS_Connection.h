@@ -15,25 +15,34 @@
 #include "Poco/Net/StreamSocket.h"
 #include "Poco/Net/WebSocket.h"
 
+#include "AP_WS_ReactorPool.h"
+#include "AP_WS_SendQueue.h"
+#include "CompressedText.h"
 #include "RESTObjects/RESTAPI_GWobjects.h"
+#include "RawJSONObject.h"
+#include "StateUtils.h"
 
 namespace OpenWifi {
 
-	class AP_WS_Connection {
+	class AP_WS_Connection : public AP_WS_EpollLoop::Handler {
 		static constexpr int BufSize = 256000;
 
 	  public:
 		explicit AP_WS_Connection(Poco::Net::HTTPServerRequest &request,
 								  Poco::Net::HTTPServerResponse &response, uint64_t connection_id,
-								  Poco::Logger &L, Poco::Net::SocketReactor &R);
-		~AP_WS_Connection();
+								  Poco::Logger &L, AP_WS_Reactor &R);
+		~AP_WS_Connection() override;
 
+		void Start();
 		void EndConnection(bool DeleteSession=true);
 		void ProcessJSONRPCEvent(Poco::JSON::Object::Ptr &Doc);
+		bool ProcessRawJSONRPCEvent(const RawJSONObject &Frame);
 		void ProcessJSONRPCResult(Poco::JSON::Object::Ptr Doc);
 		void ProcessIncomingFrame();
 		void ProcessIncomingRadiusData(const Poco::JSON::Object::Ptr &Doc);
 
+		//	True once the frame is queued: it is written later by the reactor, and may still be lost
+		//	if the connection ends first. False when the queue is full or the connection is gone.
 		[[nodiscard]] bool Send(const std::string &Payload);
 
 		bool SendRadiusAuthenticationData(const unsigned char *buffer, std::size_t size);
@@ -43,6 +52,11 @@ namespace OpenWifi {
 		void OnSocketReadable(const Poco::AutoPtr<Poco::Net::ReadableNotification> &pNf);
 		void OnSocketShutdown(const Poco::AutoPtr<Poco::Net::ShutdownNotification> &pNf);
 		void OnSocketError(const Poco::AutoPtr<Poco::Net::ErrorNotification> &pNf);
+		void OnSocketWritable(const Poco::AutoPtr<Poco::Net::WritableNotification> &pNf);
+		bool OnEpollReadable() override;
+		void OnEpollWritable() override;
+		void OnEpollShutdown() override;
+		void OnEpollError() override;
 		bool LookForUpgrade(uint64_t UUID, uint64_t &UpgradedUUID);
 		static bool ExtractBase64CompressedData(const std::string &CompressedData,
 												std::string &UnCompressedData,
@@ -58,46 +72,20 @@ namespace OpenWifi {
 		bool StopWebSocketTelemetry(uint64_t RPCID);
 		bool StopKafkaTelemetry(uint64_t RPCID);
 
-		inline void GetLastStats(std::string &LastStats) {
-			std::shared_lock G(ConnectionMutex_);
-			LastStats = RawLastStats_;
-		}
+		//	Decompressed here when held compressed.
+		void GetLastStats(std::string &LastStats);
+		//	Metrics were taken from the same report when it was received.
+		void SetLastStats(const CompressedText &LastStats, const StateUtils::DeviceMetrics &Metrics);
 
-		inline void SetLastStats(const std::string &LastStats) {
-			std::unique_lock G(ConnectionMutex_);
-			RawLastStats_ = LastStats;
-			try {
-				Poco::JSON::Parser P;
-				auto Stats = P.parse(LastStats).extract<Poco::JSON::Object::Ptr>();
-				hasGPS = Stats->isObject("gps");
-				auto Unit = Stats->getObject("unit");
-				auto Memory = Unit->getObject("memory");
-				std::uint64_t TotalMemory = Memory->get("total");
-				std::uint64_t FreeMemory = Memory->get("free");
-				if(TotalMemory>0) {
-					memory_used_ =
-						(100.0 * ((double)TotalMemory - (double)FreeMemory)) / (double)TotalMemory;
-				}
-				if(Unit->isArray("load")) {
-					Poco::JSON::Array::Ptr Load = Unit->getArray("load");
-					if(Load->size()>1) {
-						cpu_load_ = Load->get(1);
-					}
-				}
-				if(Unit->isArray("temperature")) {
-					Poco::JSON::Array::Ptr Temperature = Unit->getArray("temperature");
-					if(Temperature->size()>1) {
-						temperature_ = Temperature->get(0);
-					}
-				}
-			} catch (...) {
-
-			}
+		inline void GetMetrics(StateUtils::DeviceMetrics &Metrics) const {
+			std::shared_lock G(ConnectionMutex_);
+			Metrics = Metrics_;
 		}
 
 		inline void SetLastHealthCheck(const GWObjects::HealthCheck &H) {
 			std::unique_lock G(ConnectionMutex_);
 			RawLastHealthcheck_ = H;
+			Metrics_.Sanity = H.Sanity;
 		}
 
 		inline void GetLastHealthCheck(GWObjects::HealthCheck &H) {
@@ -106,11 +94,18 @@ namespace OpenWifi {
 		}
 
 		inline void GetState(GWObjects::ConnectionState &State) const {
-			std::shared_lock G(ConnectionMutex_);
-			State = State_;
+			{
+				std::shared_lock G(ConnectionMutex_);
+				State = State_;
+			}
+			SendQueue_.GetDepth(State.sendQueueFrames, State.sendQueueBytes,
+								State.sendQueueDropped);
 		}
 
-		inline bool HasGPS() { return hasGPS; }
+		inline bool HasGPS() const {
+			std::shared_lock G(ConnectionMutex_);
+			return Metrics_.HasGPS;
+		}
 
 		inline void GetRestrictions(GWObjects::DeviceRestrictions &R) const {
 			std::shared_lock G(ConnectionMutex_);
@@ -119,7 +114,10 @@ namespace OpenWifi {
 
 		void Process_connect(Poco::JSON::Object::Ptr ParamsObj, const std::string &Serial);
 		void Process_state(Poco::JSON::Object::Ptr ParamsObj);
+		//	These return false, before doing anything, when the message must be parsed with Poco.
+		bool Process_state(const RawJSONObject &ParamsObj);
 		void Process_healthcheck(Poco::JSON::Object::Ptr ParamsObj);
+		bool Process_healthcheck(const RawJSONObject &ParamsObj);
 		void Process_log(Poco::JSON::Object::Ptr ParamsObj);
 		void Process_crashlog(Poco::JSON::Object::Ptr ParamsObj);
 		void Process_ping(Poco::JSON::Object::Ptr ParamsObj);
@@ -164,7 +162,11 @@ namespace OpenWifi {
 		mutable std::shared_mutex ConnectionMutex_;
 		std::shared_mutex TelemetryMutex_;
 		Poco::Logger &Logger_;
-		Poco::Net::SocketReactor &Reactor_;
+		std::mutex ReactorMutex_;
+		AP_WS_Reactor *Reactor_;
+		std::uint64_t EpollToken_ = 0;
+		bool WriteArmed_ = false;
+		AP_WS_SendQueue SendQueue_;
 		std::unique_ptr<Poco::Net::WebSocket> WS_;
 		std::string SerialNumber_;
 		uint64_t SerialNumberInt_ = 0;
@@ -183,7 +185,8 @@ namespace OpenWifi {
 		volatile uint64_t TelemetryWebSocketPackets_ = 0;
 		volatile uint64_t TelemetryKafkaPackets_ = 0;
 		GWObjects::ConnectionState State_;
-		std::string RawLastStats_;
+		//	Deflated when openwifi.session.laststats.compress is set, and shared with the shadow.
+		CompressedText LastStats_;
 		GWObjects::HealthCheck RawLastHealthcheck_;
 		std::chrono::time_point<std::chrono::high_resolution_clock> ConnectionStart_ =
 			std::chrono::high_resolution_clock::now();
@@ -196,11 +199,28 @@ namespace OpenWifi {
 
 		static inline std::atomic_uint64_t ConcurrentStartingDevices_ = 0;
 
+		//	Whether this connection is part of the server's connected devices count. A connection
+		//	that ended before its connect message completed is never counted.
+		static constexpr int CountedNone = 0, CountedConnected = 1, CountedEnded = 2;
+		std::atomic_int Counted_ = CountedNone;
+
+		void ValidateEventSerialNumber(std::string &Serial);
+		void ProcessReadable();
+		void AddEventHandlers();
+		void RemoveEventHandlers();
+		void MigrateReactor(AP_WS_Reactor &Target);
+		void ScheduleWrite();
+		void AddWritableHandler();
+		void RemoveWritableHandler();
+		void DrainSendQueue();
+		void StateReceived(uint64_t UUID, std::string &StateStr,
+						   const StateUtils::DeviceMetrics &Metrics, std::string &request_uuid);
+		void HealthCheckReceived(uint64_t UUID, uint64_t Sanity, std::string &CheckData,
+								 std::string &request_uuid);
 		bool StartTelemetry(uint64_t RPCID, const std::vector<std::string> &TelemetryTypes);
 		bool StopTelemetry(uint64_t RPCID);
 		void UpdateCounts();
-		bool hasGPS=false;
-		std::double_t 	memory_used_=0.0, cpu_load_ = 0.0, temperature_ = 0.0;
+		StateUtils::DeviceMetrics Metrics_;
 		std::uint64_t 	uuid_=0;
 	};
 
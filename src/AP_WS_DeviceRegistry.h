@@ -0,0 +1,70 @@
+//
+//	License type: BSD 3-Clause License
+//	License copy: https://github.com/Telecominfraproject/wlan-cloud-ucentralgw/blob/master/LICENSE
+//
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+
+namespace OpenWifi {
+
+	//	The connection of each device by serial number, with the session that registered it.
+	//	Serial numbers are spread over independently locked shards so REST lookups and command
+	//	sends for different devices do not contend on a single lock.
+	template <typename Connection> class AP_WS_DeviceRegistry {
+	  public:
+		static constexpr std::uint64_t NumberOfShards = 256;
+
+		static inline std::uint64_t ShardOf(std::uint64_t SerialNumber) {
+			//	the low bytes of a MAC are the most random, the high bytes are the OUI
+			return (SerialNumber ^ (SerialNumber >> 24)) % NumberOfShards;
+		}
+
+		std::shared_ptr<Connection> Find(std::uint64_t SerialNumber) const {
+			auto &S = Shards_[ShardOf(SerialNumber)];
+			std::lock_guard Lock(S.Mutex);
+			auto Device = S.Devices.find(SerialNumber);
+			if (Device == S.Devices.end())
+				return nullptr;
+			return Device->second.second;
+		}
+
+		//	A device that reconnects keeps its newest session: an older one is not registered.
+		bool Register(std::uint64_t SerialNumber, std::uint64_t Session,
+					  std::shared_ptr<Connection> C) {
+			auto &S = Shards_[ShardOf(SerialNumber)];
+			std::lock_guard Lock(S.Mutex);
+			auto Device = S.Devices.find(SerialNumber);
+			if (Device != S.Devices.end() && Device->second.first >= Session)
+				return false;
+			S.Devices[SerialNumber] = std::make_pair(Session, std::move(C));
+			return true;
+		}
+
+		//	Only the session that registered the device removes it.
+		bool Unregister(std::uint64_t SerialNumber, std::uint64_t Session) {
+			auto &S = Shards_[ShardOf(SerialNumber)];
+			std::lock_guard Lock(S.Mutex);
+			auto Device = S.Devices.find(SerialNumber);
+			if (Device == S.Devices.end() || Device->second.first != Session)
+				return false;
+			S.Devices.erase(Device);
+			return true;
+		}
+
+	  private:
+		struct Shard {
+			mutable std::mutex Mutex;
+			std::unordered_map<std::uint64_t, std::pair<std::uint64_t, std::shared_ptr<Connection>>>
+				Devices;
+		};
+		std::array<Shard, NumberOfShards> Shards_;
+	};
+
+} // namespace OpenWifi
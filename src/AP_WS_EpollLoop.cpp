@@ -0,0 +1,188 @@
+//
+//	License type: BSD 3-Clause License
+//	License copy: https://github.com/Telecominfraproject/wlan-cloud-ucentralgw/blob/master/LICENSE
+//
+
+#include "AP_WS_EpollLoop.h"
+
+#include "Poco/Exception.h"
+
+#ifdef __linux__
+#include <cerrno>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#endif
+
+namespace OpenWifi {
+
+#ifdef __linux__
+
+	bool AP_WS_EpollLoop::Available() { return true; }
+
+	AP_WS_EpollLoop::AP_WS_EpollLoop() {
+		EpollFd_ = epoll_create1(EPOLL_CLOEXEC);
+		if (EpollFd_ < 0)
+			throw Poco::SystemException("epoll_create1 failed", errno);
+		WakeFd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+		if (WakeFd_ < 0) {
+			close(EpollFd_);
+			throw Poco::SystemException("eventfd failed", errno);
+		}
+		epoll_event Event{};
+		Event.events = EPOLLIN;
+		Event.data.u64 = WakeUpToken;
+		epoll_ctl(EpollFd_, EPOLL_CTL_ADD, WakeFd_, &Event);
+		Running_ = true;
+	}
+
+	AP_WS_EpollLoop::~AP_WS_EpollLoop() {
+		close(WakeFd_);
+		close(EpollFd_);
+	}
+
+	std::uint64_t AP_WS_EpollLoop::Add(int fd, std::weak_ptr<Handler> H) {
+		std::uint64_t Token;
+		{
+			std::lock_guard G(Mutex_);
+			Token = NextToken_++;
+			Handlers_[Token] = std::move(H);
+		}
+		epoll_event Event{};
+		Event.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+		Event.data.u64 = Token;
+		//	A socket that already has data waiting is reported right away, so nothing is lost
+		//	when it is added after the handshake or moved from another loop.
+		if (epoll_ctl(EpollFd_, EPOLL_CTL_ADD, fd, &Event) < 0) {
+			std::lock_guard G(Mutex_);
+			Handlers_.erase(Token);
+			throw Poco::SystemException("epoll_ctl failed", errno);
+		}
+		return Token;
+	}
+
+	void AP_WS_EpollLoop::Remove(int fd, std::uint64_t Token) {
+		epoll_ctl(EpollFd_, EPOLL_CTL_DEL, fd, nullptr);
+		std::lock_guard G(Mutex_);
+		Handlers_.erase(Token);
+	}
+
+	void AP_WS_EpollLoop::Wake(std::uint64_t Token) {
+		{
+			std::lock_guard G(Mutex_);
+			Wakes_.push_back(Token);
+		}
+		std::uint64_t One = 1;
+		[[maybe_unused]] auto r = write(WakeFd_, &One, sizeof(One));
+	}
+
+	std::shared_ptr<AP_WS_EpollLoop::Handler> AP_WS_EpollLoop::Find(std::uint64_t Token) {
+		std::lock_guard G(Mutex_);
+		auto Hint = Handlers_.find(Token);
+		return Hint == Handlers_.end() ? nullptr : Hint->second.lock();
+	}
+
+	void AP_WS_EpollLoop::Readable(std::uint64_t Token) {
+		auto H = Find(Token);
+		if (H == nullptr)
+			return;
+		Dispatched_++;
+		if (H->OnEpollReadable()) {
+			Requeued_++;
+			Pending_.push_back(Token);
+		}
+	}
+
+	void AP_WS_EpollLoop::Writable(std::uint64_t Token) {
+		if (auto H = Find(Token))
+			H->OnEpollWritable();
+	}
+
+	void AP_WS_EpollLoop::run() {
+		epoll_event Events[MaxEvents];
+		while (Running_) {
+			auto Count = epoll_wait(EpollFd_, Events, MaxEvents, Pending_.empty() ? WaitTimeOut : 0);
+			if (Count < 0) {
+				if (errno == EINTR)
+					continue;
+				break;
+			}
+
+			for (int i = 0; i < Count; ++i) {
+				auto Token = Events[i].data.u64;
+				if (Token == WakeUpToken) {
+					std::uint64_t Value;
+					[[maybe_unused]] auto r = read(WakeFd_, &Value, sizeof(Value));
+					std::vector<std::uint64_t> Wakes;
+					{
+						std::lock_guard G(Mutex_);
+						Wakes.swap(Wakes_);
+					}
+					for (auto WakeToken : Wakes)
+						Writable(WakeToken);
+					continue;
+				}
+				auto Flags = Events[i].events;
+				if (Flags & EPOLLERR) {
+					if (auto H = Find(Token))
+						H->OnEpollError();
+					continue;
+				}
+				if (Flags & EPOLLOUT)
+					Writable(Token);
+				if (Flags & EPOLLIN) {
+					//	A peer that sends its last frame and closes shows up as readable: the
+					//	handler sees the close when it reads.
+					Readable(Token);
+				} else if (Flags & (EPOLLHUP | EPOLLRDHUP)) {
+					if (auto H = Find(Token))
+						H->OnEpollShutdown();
+				}
+			}
+
+			//	One more turn for each socket that still had data, in arrival order.
+			for (auto Pending = Pending_.size(); Pending > 0 && Running_; --Pending) {
+				auto Token = Pending_.front();
+				Pending_.pop_front();
+				Readable(Token);
+			}
+		}
+		Pending_.clear();
+	}
+
+	void AP_WS_EpollLoop::stop() {
+		Running_ = false;
+		std::uint64_t One = 1;
+		[[maybe_unused]] auto r = write(WakeFd_, &One, sizeof(One));
+	}
+
+#else
+
+	bool AP_WS_EpollLoop::Available() { return false; }
+	AP_WS_EpollLoop::AP_WS_EpollLoop() {
+		throw Poco::NotImplementedException("epoll is only available on Linux");
+	}
+	AP_WS_EpollLoop::~AP_WS_EpollLoop() = default;
+	std::uint64_t AP_WS_EpollLoop::Add(int, std::weak_ptr<Handler>) { return 0; }
+	void AP_WS_EpollLoop::Remove(int, std::uint64_t) {}
+	void AP_WS_EpollLoop::Wake(std::uint64_t) {}
+	std::shared_ptr<AP_WS_EpollLoop::Handler> AP_WS_EpollLoop::Find(std::uint64_t) {
+		return nullptr;
+	}
+	void AP_WS_EpollLoop::Readable(std::uint64_t) {}
+	void AP_WS_EpollLoop::Writable(std::uint64_t) {}
+	void AP_WS_EpollLoop::run() {}
+	void AP_WS_EpollLoop::stop() {}
+
+#endif
+
+	void AP_WS_EpollLoop::to_json(Poco::JSON::Object &Obj) const {
+		{
+			std::lock_guard G(Mutex_);
+			Obj.set("registered", Handlers_.size());
+		}
+		Obj.set("dispatched", Dispatched_.load());
+		Obj.set("requeued", Requeued_.load());
+	}
+
+} // namespace OpenWifi
@@ -0,0 +1,81 @@
+//
+//	License type: BSD 3-Clause License
+//	License copy: https://github.com/Telecominfraproject/wlan-cloud-ucentralgw/blob/master/LICENSE
+//
+
+#pragma once
+
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "Poco/JSON/Object.h"
+#include "Poco/Runnable.h"
+
+namespace OpenWifi {
+
+	//	Edge-triggered epoll event loop, used instead of Poco::Net::SocketReactor when
+	//	openwifi.session.reactor.eventloop is "epoll". Sockets are registered once with a single
+	//	handler instead of one observer per notification type. Only available on Linux.
+	class AP_WS_EpollLoop : public Poco::Runnable {
+	  public:
+		//	Handlers are owned by shared pointers: the loop only keeps a weak reference and holds a
+		//	strong one while it calls into the handler, so a connection that ends on another thread
+		//	is never destroyed under a running callback.
+		class Handler : public std::enable_shared_from_this<Handler> {
+		  public:
+			virtual ~Handler() = default;
+			//	Must return true when more data is already waiting: with edge-triggered events
+			//	there will be no new notification for it, so the loop calls the handler again after
+			//	giving the other sockets a turn.
+			virtual bool OnEpollReadable() = 0;
+			virtual void OnEpollWritable() = 0;
+			virtual void OnEpollShutdown() = 0;
+			virtual void OnEpollError() = 0;
+		};
+
+		static bool Available();
+
+		AP_WS_EpollLoop();
+		~AP_WS_EpollLoop() override;
+
+		//	Both may be called from any thread. The token returned by Add() identifies the
+		//	registration, so events for a socket that was removed, or whose descriptor was reused,
+		//	are never delivered to the wrong handler.
+		std::uint64_t Add(int fd, std::weak_ptr<Handler> H);
+		void Remove(int fd, std::uint64_t Token);
+		//	Asks the loop thread to call OnEpollWritable() for this registration, e.g. after data
+		//	was queued by another thread while the socket was already writable.
+		void Wake(std::uint64_t Token);
+
+		void run() override;
+		void stop();
+
+		void to_json(Poco::JSON::Object &Obj) const;
+
+	  private:
+		static constexpr int MaxEvents = 256;
+		static constexpr int WaitTimeOut = 250;
+		static constexpr std::uint64_t WakeUpToken = 0;
+
+		int EpollFd_ = -1;
+		int WakeFd_ = -1;
+		std::atomic_bool Running_ = false;
+		mutable std::mutex Mutex_;
+		std::unordered_map<std::uint64_t, std::weak_ptr<Handler>> Handlers_;
+		std::uint64_t NextToken_ = 1;
+		std::vector<std::uint64_t> Wakes_;
+		//	Only touched by the loop thread.
+		std::deque<std::uint64_t> Pending_;
+		std::atomic_uint64_t Dispatched_ = 0;
+		std::atomic_uint64_t Requeued_ = 0;
+
+		std::shared_ptr<Handler> Find(std::uint64_t Token);
+		void Readable(std::uint64_t Token);
+		void Writable(std::uint64_t Token);
+	};
+
+} // namespace OpenWifi
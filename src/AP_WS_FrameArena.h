@@ -0,0 +1,108 @@
+//
+//	License type: BSD 3-Clause License
+//	License copy: https://github.com/Telecominfraproject/wlan-cloud-ucentralgw/blob/master/LICENSE
+//
+
+#pragma once
+
+#include <atomic>
+#include <mutex>
+
+#include "Poco/Buffer.h"
+#include "Poco/JSON/Object.h"
+
+#include "framework/utils.h"
+
+namespace OpenWifi {
+
+	//	One receive buffer per reactor. A reactor thread handles one frame at a time, so all the
+	//	connections it serves can share the same buffer instead of allocating a new one for every
+	//	frame. The buffer keeps the capacity of the largest recent frame and is brought back to its
+	//	initial size once it has not needed that much for a while.
+	class AP_WS_FrameArena {
+	  public:
+		class Lease {
+		  public:
+			explicit Lease(AP_WS_FrameArena &A) : Arena_(A), Lock_(A.Mutex_, std::try_to_lock) {
+				if (Lock_.owns_lock()) {
+					Arena_.Buffer_.resize(0);
+				} else {
+					//	Only possible if a frame is processed outside its reactor thread.
+					Arena_.Fallbacks_++;
+				}
+			}
+
+			~Lease() {
+				auto Size = Buffer().size();
+				Arena_.Frames_++;
+				Arena_.Bytes_ += Size;
+				if (Lock_.owns_lock()) {
+					if (Size > Arena_.HighWater_)
+						Arena_.HighWater_ = Size;
+					if (Size > Arena_.InitialSize_)
+						Arena_.LastLargeFrame_ = Utils::Now();
+					Arena_.Capacity_ = Arena_.Buffer_.capacity();
+				}
+			}
+
+			Lease(const Lease &) = delete;
+			Lease &operator=(const Lease &) = delete;
+
+			inline Poco::Buffer<char> &Buffer() {
+				return Lock_.owns_lock() ? Arena_.Buffer_ : Fallback_;
+			}
+
+		  private:
+			AP_WS_FrameArena &Arena_;
+			std::unique_lock<std::mutex> Lock_;
+			Poco::Buffer<char> Fallback_{0};
+		};
+
+		explicit AP_WS_FrameArena(std::size_t InitialSize, std::uint64_t IdleSeconds)
+			: InitialSize_(InitialSize), IdleSeconds_(IdleSeconds), Buffer_(InitialSize),
+			  Capacity_(InitialSize) {
+			Buffer_.resize(0);
+		}
+
+		inline Lease Acquire() { return Lease(*this); }
+
+		//	Called periodically from outside the reactor thread. A busy buffer is left alone.
+		inline void Trim() {
+			std::unique_lock Lock(Mutex_, std::try_to_lock);
+			if (!Lock.owns_lock())
+				return;
+			if (Buffer_.capacity() > InitialSize_ &&
+				(Utils::Now() - LastLargeFrame_) > IdleSeconds_) {
+				Buffer_.setCapacity(InitialSize_, false);
+				Buffer_.resize(0);
+				Capacity_ = Buffer_.capacity();
+				Trims_++;
+			}
+		}
+
+		inline std::uint64_t Capacity() const { return Capacity_; }
+
+		inline void to_json(Poco::JSON::Object &Obj) const {
+			Obj.set("capacity", Capacity_.load());
+			Obj.set("highWater", HighWater_.load());
+			Obj.set("frames", Frames_.load());
+			Obj.set("bytes", Bytes_.load());
+			Obj.set("fallbacks", Fallbacks_.load());
+			Obj.set("trims", Trims_.load());
+		}
+
+	  private:
+		std::mutex Mutex_;
+		std::size_t InitialSize_;
+		std::uint64_t IdleSeconds_;
+		Poco::Buffer<char> Buffer_;
+		std::uint64_t LastLargeFrame_ = 0;
+		std::atomic_uint64_t Capacity_ = 0;
+		std::atomic_uint64_t HighWater_ = 0;
+		std::atomic_uint64_t Frames_ = 0;
+		std::atomic_uint64_t Bytes_ = 0;
+		std::atomic_uint64_t Fallbacks_ = 0;
+		std::atomic_uint64_t Trims_ = 0;
+	};
+
+} // namespace OpenWifi
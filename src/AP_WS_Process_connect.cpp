@@ -6,6 +6,7 @@
 #include "AP_WS_Server.h"
 #include "CentralConfig.h"
 #include "Daemon.h"
+#include "DeviceSearchIndex.h"
 #include "FindCountry.h"
 #include "StorageService.h"
 
@@ -248,6 +249,10 @@ namespace OpenWifi {
 
 			State_.Compatible = Compatible_;
 			State_.Connected = true;
+			DeviceSearchIndex()->SetAddress(SerialNumber_, IP);
+			if (auto Expected = CountedNone;
+				Counted_.compare_exchange_strong(Expected, CountedConnected))
+				AP_WS_Server()->DeviceConnected(State_.started);
 			ConnectionCompletionTime_ =
 				std::chrono::high_resolution_clock::now() - ConnectionStart_;
 			State_.connectionCompletionTime = ConnectionCompletionTime_.count();
@@ -298,6 +303,8 @@ namespace OpenWifi {
 				ParamsObj->set(uCentralProtocol::UUID, uuid_);
 				KafkaManager()->PostMessage(KafkaTopics::CONNECTION, SerialNumber_, *ParamsObj);
 			}
+
+			CommandManager()->DeviceConnected(SerialNumberInt_);
 		} else {
 			poco_warning(
 				Logger_,
@@ -3,6 +3,7 @@
 //
 
 #include "AP_WS_Connection.h"
+#include "StorageIngestion.h"
 #include "StorageService.h"
 
 #include "fmt/format.h"
@@ -29,7 +30,7 @@ namespace OpenWifi {
 										   .Recorded = Utils::Now(),
 										   .LogType = 1,
 										   .UUID = ParamsObj->get(uCentralProtocol::UUID)};
-			StorageService()->AddLog(DeviceLog);
+			StorageIngestion()->AddLog(DeviceLog);
 			DeviceLogKafkaEvent	E(DeviceLog);
 		} else {
 			poco_warning(Logger_, fmt::format("LOG({}): Missing parameters.", CId_));
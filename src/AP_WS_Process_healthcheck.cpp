@@ -3,6 +3,8 @@
 //
 
 #include "AP_WS_Connection.h"
+#include "DeviceShadow.h"
+#include "StorageIngestion.h"
 #include "StorageService.h"
 
 #include "fmt/format.h"
@@ -24,48 +26,90 @@ namespace OpenWifi {
 			ParamsObj->has(uCentralProtocol::DATA)) {
 
 			uint64_t UUID = ParamsObj->get(uCentralProtocol::UUID);
-			auto Sanity = ParamsObj->get(uCentralProtocol::SANITY);
+			uint64_t Sanity = ParamsObj->get(uCentralProtocol::SANITY);
 			auto CheckData = ParamsObj->get(uCentralProtocol::DATA).toString();
-			if (CheckData.empty())
-				CheckData = uCentralProtocol::EMPTY_JSON_DOC;
 
 			std::string request_uuid;
 			if (ParamsObj->has(uCentralProtocol::REQUEST_UUID))
 				request_uuid = ParamsObj->get(uCentralProtocol::REQUEST_UUID).toString();
 
-			if (request_uuid.empty()) {
-				poco_trace(Logger_, fmt::format("HEALTHCHECK({}): UUID={} Updating.", CId_, UUID));
-			} else {
-				poco_trace(Logger_, fmt::format("HEALTHCHECK({}): UUID={} Updating for CMD={}.",
-												CId_, UUID, request_uuid));
+			HealthCheckReceived(UUID, Sanity, CheckData, request_uuid);
+
+			if (KafkaManager()->Enabled()) {
+				KafkaManager()->PostMessage(KafkaTopics::HEALTHCHECK, SerialNumber_, *ParamsObj);
 			}
+		} else {
+			poco_warning(Logger_, fmt::format("HEALTHCHECK({}): Missing parameter", CId_));
+			return;
+		}
+	}
 
-			uint64_t UpgradedUUID;
-			LookForUpgrade(UUID, UpgradedUUID);
-			State_.UUID = UpgradedUUID;
+	bool AP_WS_Connection::Process_healthcheck(const RawJSONObject &ParamsObj) {
+		uint64_t UUID, Sanity;
+		if (!ParamsObj.GetUInt(uCentralProtocol::UUID, UUID) ||
+			!ParamsObj.GetUInt(uCentralProtocol::SANITY, Sanity) ||
+			!ParamsObj.Has(uCentralProtocol::DATA))
+			return false;
 
-			GWObjects::HealthCheck Check;
+		std::string CheckData;
+		if (!ParamsObj.GetString(uCentralProtocol::DATA, CheckData))
+			CheckData = ParamsObj.Raw(uCentralProtocol::DATA);
 
-			Check.SerialNumber = SerialNumber_;
-			Check.Recorded = Utils::Now();
-			Check.UUID = UUID;
-			Check.Data = CheckData;
-			Check.Sanity = Sanity;
+		std::string request_uuid;
+		if (ParamsObj.Has(uCentralProtocol::REQUEST_UUID) &&
+			!ParamsObj.GetString(uCentralProtocol::REQUEST_UUID, request_uuid))
+			return false;
 
-			StorageService()->AddHealthCheckData(Check);
+		if (!State_.Connected) {
+			poco_warning(Logger_,
+						 fmt::format("INVALID-PROTOCOL({}): Device '{}' is not following protocol",
+									 CId_, CN_));
+			Errors_++;
+			return true;
+		}
 
-			if (!request_uuid.empty()) {
-				StorageService()->SetCommandResult(request_uuid, CheckData);
-			}
+		HealthCheckReceived(UUID, Sanity, CheckData, request_uuid);
 
-			SetLastHealthCheck(Check);
-			if (KafkaManager()->Enabled()) {
-				KafkaManager()->PostMessage(KafkaTopics::HEALTHCHECK, SerialNumber_, *ParamsObj);
-			}
+		if (KafkaManager()->Enabled()) {
+			KafkaManager()->PostMessage(KafkaTopics::HEALTHCHECK, SerialNumber_,
+										std::string{ParamsObj.Document()});
+		}
+		return true;
+	}
+
+	void AP_WS_Connection::HealthCheckReceived(uint64_t UUID, uint64_t Sanity,
+											   std::string &CheckData,
+											   std::string &request_uuid) {
+		if (CheckData.empty())
+			CheckData = uCentralProtocol::EMPTY_JSON_DOC;
+
+		if (request_uuid.empty()) {
+			poco_trace(Logger_, fmt::format("HEALTHCHECK({}): UUID={} Updating.", CId_, UUID));
 		} else {
-			poco_warning(Logger_, fmt::format("HEALTHCHECK({}): Missing parameter", CId_));
-			return;
+			poco_trace(Logger_, fmt::format("HEALTHCHECK({}): UUID={} Updating for CMD={}.",
+											CId_, UUID, request_uuid));
 		}
+
+		uint64_t UpgradedUUID;
+		LookForUpgrade(UUID, UpgradedUUID);
+		State_.UUID = UpgradedUUID;
+
+		GWObjects::HealthCheck Check;
+
+		Check.SerialNumber = SerialNumber_;
+		Check.Recorded = Utils::Now();
+		Check.UUID = UUID;
+		Check.Data = CheckData;
+		Check.Sanity = Sanity;
+
+		StorageIngestion()->AddHealthCheckData(Check);
+		DeviceShadow()->SetHealthCheck(SerialNumberInt_, Check);
+
+		if (!request_uuid.empty()) {
+			StorageService()->SetCommandResult(request_uuid, CheckData);
+		}
+
+		SetLastHealthCheck(Check);
 	}
 
-} // namespace OpenWifi
\ No newline at end of file
+} // namespace OpenWifi
@@ -3,6 +3,7 @@
 //
 
 #include "AP_WS_Connection.h"
+#include "StorageIngestion.h"
 #include "StorageService.h"
 
 #include "fmt/format.h"
@@ -36,7 +37,7 @@ namespace OpenWifi {
 										   .Recorded = (uint64_t)time(nullptr),
 										   .LogType = 0,
 										   .UUID = State_.UUID};
-			StorageService()->AddLog(DeviceLog);
+			StorageIngestion()->AddLog(DeviceLog);
 			DeviceLogKafkaEvent	E(DeviceLog);
 		} else {
 			poco_warning(Logger_, fmt::format("LOG({}): Missing parameters.", CId_));
@@ -2,6 +2,7 @@
 // Created by stephane bourque on 2023-05-16.
 //
 #include "AP_WS_Connection.h"
+#include "StorageIngestion.h"
 #include "StorageService.h"
 
 #include "fmt/format.h"
@@ -35,7 +36,7 @@ namespace OpenWifi {
 										   .Recorded = ParamsObj->get(uCentralProtocol::DATE),
 										   .LogType = 2,
 										   .UUID = ParamsObj->get(uCentralProtocol::UUID)};
-			StorageService()->AddLog(DeviceLog);
+			StorageIngestion()->AddLog(DeviceLog);
 			DeviceLogKafkaEvent	E(DeviceLog);
 		} else {
 			poco_warning(Logger_, fmt::format("REBOOT-LOG({}): Missing parameters.", CId_));
@@ -4,6 +4,7 @@
 
 #include "AP_WS_Connection.h"
 #include "CommandManager.h"
+#include "StorageIngestion.h"
 #include "StorageService.h"
 
 #include "fmt/format.h"
@@ -35,7 +36,7 @@ namespace OpenWifi {
 										   .LogType = 1,
 										   .UUID = 0};
 
-			StorageService()->AddLog(DeviceLog);
+			StorageIngestion()->AddLog(DeviceLog);
 
 			if (ParamsObj->get(uCentralProtocol::REBOOT).toString() == "true") {
 				GWObjects::CommandDetails Cmd;
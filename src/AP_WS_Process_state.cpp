@@ -3,7 +3,10 @@
 //
 
 #include "AP_WS_Connection.h"
+#include "AP_WS_Server.h"
+#include "DeviceShadow.h"
 #include "StateUtils.h"
+#include "StorageIngestion.h"
 #include "StorageService.h"
 
 #include "UI_GW_WebSocketNotifications.h"
@@ -32,41 +35,89 @@ namespace OpenWifi {
 			if (ParamsObj->has(uCentralProtocol::REQUEST_UUID))
 				request_uuid = ParamsObj->get(uCentralProtocol::REQUEST_UUID).toString();
 
-			if (request_uuid.empty()) {
-				poco_trace(Logger_, fmt::format("STATE({}): UUID={} Updating.", CId_, UUID));
-			} else {
-				poco_trace(Logger_, fmt::format("STATE({}): UUID={} Updating for CMD={}.", CId_,
-												UUID, request_uuid));
-			}
-
-			uint64_t UpgradedUUID;
-			LookForUpgrade(UUID, UpgradedUUID);
-			State_.UUID = UpgradedUUID;
-			SetLastStats(StateStr);
-
-			GWObjects::Statistics Stats{
-				.SerialNumber = SerialNumber_, .UUID = UUID, .Data = StateStr};
-			Stats.Recorded = Utils::Now();
-			StorageService()->AddStatisticsData(Stats);
-			if (!request_uuid.empty()) {
-				StorageService()->SetCommandResult(request_uuid, StateStr);
-			}
-
-			StateUtils::ComputeAssociations(StateObj, State_.Associations_2G,
-											State_.Associations_5G, State_.Associations_6G);
+			StateUtils::DeviceMetrics Metrics;
+			StateUtils::ExtractMetrics(StateObj, Metrics);
+			StateReceived(UUID, StateStr, Metrics, request_uuid);
 
 			if (KafkaManager()->Enabled()) {
 				KafkaManager()->PostMessage(KafkaTopics::STATE, SerialNumber_, *ParamsObj);
 			}
-
-			GWWebSocketNotifications::SingleDevice_t N;
-			N.content.serialNumber = SerialNumber_;
-			GWWebSocketNotifications::DeviceStatistics(N);
-
 		} else {
 			poco_warning(
 				Logger_,
 				fmt::format("STATE({}): Invalid request. Missing serial, uuid, or state", CId_));
 		}
 	}
-} // namespace OpenWifi
\ No newline at end of file
+
+	//	Fast path: the state document is taken verbatim from the frame and its metrics are read
+	//	from the text, so no DOM is built. The params are forwarded to Kafka as received instead
+	//	of being stringified again. Anything this cannot read goes back to the Poco path.
+	bool AP_WS_Connection::Process_state(const RawJSONObject &ParamsObj) {
+		uint64_t UUID;
+		if (!ParamsObj.GetUInt(uCentralProtocol::UUID, UUID) ||
+			!ParamsObj.IsObject(uCentralProtocol::STATE))
+			return false;
+
+		std::string request_uuid;
+		if (ParamsObj.Has(uCentralProtocol::REQUEST_UUID) &&
+			!ParamsObj.GetString(uCentralProtocol::REQUEST_UUID, request_uuid))
+			return false;
+
+		StateUtils::DeviceMetrics Metrics;
+		if (!StateUtils::ExtractMetrics(ParamsObj.Raw(uCentralProtocol::STATE), Metrics))
+			return false;
+
+		if (!State_.Connected) {
+			poco_warning(Logger_,
+						 fmt::format("INVALID-PROTOCOL({}): Device '{}' is not following protocol",
+									 CId_, CN_));
+			Errors_++;
+			return true;
+		}
+
+		std::string StateStr{ParamsObj.Raw(uCentralProtocol::STATE)};
+		StateReceived(UUID, StateStr, Metrics, request_uuid);
+
+		if (KafkaManager()->Enabled()) {
+			KafkaManager()->PostMessage(KafkaTopics::STATE, SerialNumber_,
+										std::string{ParamsObj.Document()});
+		}
+		return true;
+	}
+
+	void AP_WS_Connection::StateReceived(uint64_t UUID, std::string &StateStr,
+										 const StateUtils::DeviceMetrics &Metrics,
+										 std::string &request_uuid) {
+		if (request_uuid.empty()) {
+			poco_trace(Logger_, fmt::format("STATE({}): UUID={} Updating.", CId_, UUID));
+		} else {
+			poco_trace(Logger_, fmt::format("STATE({}): UUID={} Updating for CMD={}.", CId_,
+											UUID, request_uuid));
+		}
+
+		uint64_t UpgradedUUID;
+		LookForUpgrade(UUID, UpgradedUUID);
+		State_.UUID = UpgradedUUID;
+		//	the connection and the shadow share one copy of the report
+		CompressedText LastStats(StateStr, AP_WS_Server()->CompressLastStats(),
+								 AP_WS_Server()->LastStatsCompressionLevel());
+		SetLastStats(LastStats, Metrics);
+
+		GWObjects::Statistics Stats{
+			.SerialNumber = SerialNumber_, .UUID = UUID, .Data = StateStr};
+		Stats.Recorded = Utils::Now();
+		StorageIngestion()->AddStatisticsData(Stats);
+		DeviceShadow()->SetStatistics(SerialNumberInt_, UUID, Stats.Recorded, LastStats);
+		if (!request_uuid.empty()) {
+			StorageService()->SetCommandResult(request_uuid, StateStr);
+		}
+
+		State_.Associations_2G = Metrics.Associations_2G;
+		State_.Associations_5G = Metrics.Associations_5G;
+		State_.Associations_6G = Metrics.Associations_6G;
+
+		GWWebSocketNotifications::SingleDevice_t N;
+		N.content.serialNumber = SerialNumber_;
+		GWWebSocketNotifications::DeviceStatistics(N);
+	}
+} // namespace OpenWifi
@@ -4,15 +4,62 @@
 
 #pragma once
 
-#include <shared_mutex>
+#include <algorithm>
+#include <atomic>
 #include <string>
 
 #include "Poco/Environment.h"
+#include "Poco/JSON/Array.h"
 #include "Poco/Net/SocketAcceptor.h"
+#include "Poco/Thread.h"
 
+#include "AP_WS_EpollLoop.h"
+#include "AP_WS_FrameArena.h"
 #include "framework/utils.h"
 
 namespace OpenWifi {
+
+	//	A reactor thread, its receive buffer, and the load it is carrying. Busy time is accumulated
+	//	by the connections while they process frames and rolled into RecentBusyUs at every
+	//	rebalancing round. The thread runs either the Poco reactor or, when Epoll is set, the epoll
+	//	event loop.
+	struct AP_WS_Reactor {
+		AP_WS_Reactor(std::uint64_t Id, std::size_t FrameBufferSize, std::uint64_t FrameBufferIdle,
+					  bool UseEpoll)
+			: Id(Id), Arena(FrameBufferSize, FrameBufferIdle) {
+			if (UseEpoll)
+				Epoll = std::make_unique<AP_WS_EpollLoop>();
+		}
+
+		std::uint64_t Id;
+		Poco::Net::SocketReactor Reactor;
+		std::unique_ptr<AP_WS_EpollLoop> Epoll;
+		Poco::Thread Thread;
+		AP_WS_FrameArena Arena;
+		std::atomic_uint64_t Sockets = 0;
+		std::atomic_uint64_t BusyUs = 0;
+		std::atomic_uint64_t RecentBusyUs = 0;
+		std::atomic_uint64_t Frames = 0;
+		std::atomic_uint64_t MigratedIn = 0;
+		std::atomic_uint64_t MigratedOut = 0;
+		//	Set by Rebalance(): how many sockets should leave this reactor, and for which one.
+		std::atomic_int64_t PendingMigrations = 0;
+		std::atomic_uint64_t MigrationTarget = 0;
+
+		inline void AddBusyTime(std::uint64_t us) {
+			BusyUs += us;
+			Frames++;
+		}
+
+		//	A migration slot is handed out to the next connection that finishes a frame here, so
+		//	the sockets that move are the ones that are actually generating the load.
+		inline bool TakeMigration() {
+			if (PendingMigrations.load(std::memory_order_relaxed) <= 0)
+				return false;
+			return PendingMigrations.fetch_sub(1) > 0;
+		}
+	};
+
 	class AP_WS_ReactorThreadPool {
 	  public:
 		explicit AP_WS_ReactorThreadPool() {
@@ -23,40 +70,135 @@ namespace OpenWifi {
 
 		~AP_WS_ReactorThreadPool() { Stop(); }
 
-		void Start() {
+		void Start(std::size_t FrameBufferSize, std::uint64_t FrameBufferIdle,
+				   std::uint64_t MaxMigrations, bool UseEpoll) {
+			MaxMigrations_ = MaxMigrations;
+			UseEpoll_ = UseEpoll && AP_WS_EpollLoop::Available();
 			for (uint64_t i = 0; i < NumberOfThreads_; ++i) {
-				auto NewReactor = std::make_unique<Poco::Net::SocketReactor>();
-				auto NewThread = std::make_unique<Poco::Thread>();
-				NewThread->start(*NewReactor);
+				auto NewReactor = std::make_unique<AP_WS_Reactor>(i, FrameBufferSize,
+																  FrameBufferIdle, UseEpoll_);
+				if (NewReactor->Epoll)
+					NewReactor->Thread.start(*NewReactor->Epoll);
+				else
+					NewReactor->Thread.start(NewReactor->Reactor);
 				std::string ThreadName{"ap:react:" + std::to_string(i)};
-				Utils::SetThreadName(*NewThread, ThreadName.c_str());
+				Utils::SetThreadName(NewReactor->Thread, ThreadName.c_str());
 				Reactors_.emplace_back(std::move(NewReactor));
-				Threads_.emplace_back(std::move(NewThread));
 			}
 		}
 
 		void Stop() {
-			for (auto &i : Reactors_)
-				i->stop();
-			for (auto &i : Threads_) {
-				i->join();
+			for (auto &i : Reactors_) {
+				if (i->Epoll)
+					i->Epoll->stop();
+				else
+					i->Reactor.stop();
+			}
+			for (auto &i : Reactors_) {
+				i->Thread.join();
 			}
 			Reactors_.clear();
-			Threads_.clear();
 		}
 
-		Poco::Net::SocketReactor &NextReactor() {
-			std::shared_lock Lock(Mutex_);
-			NextReactor_++;
-			NextReactor_ %= NumberOfThreads_;
-			return *Reactors_[NextReactor_];
+		//	Picks the reactor with the lowest estimated load: the time it spent processing frames
+		//	during the last round, plus what the sockets it already carries are expected to cost.
+		//	The scan starts at a rotating position so that equally loaded reactors share new
+		//	devices.
+		AP_WS_Reactor &NextReactor() {
+			auto Start = NextReactor_++ % Reactors_.size();
+			auto PerSocket = AverageBusyPerSocket();
+			AP_WS_Reactor *Best = nullptr;
+			std::uint64_t BestScore = 0;
+			for (std::size_t i = 0; i < Reactors_.size(); ++i) {
+				auto &R = *Reactors_[(Start + i) % Reactors_.size()];
+				auto Score = R.RecentBusyUs + R.Sockets * PerSocket;
+				if (Best == nullptr || Score < BestScore) {
+					Best = &R;
+					BestScore = Score;
+				}
+			}
+			return *Best;
+		}
+
+		//	Called periodically. Closes the current measurement window and, when the busiest
+		//	reactor carries noticeably more work than the least busy one, asks some of its sockets
+		//	to move over.
+		void Rebalance() {
+			if (Reactors_.empty())
+				return;
+			AP_WS_Reactor *Busiest = nullptr, *Idlest = nullptr;
+			for (auto &R : Reactors_) {
+				R->RecentBusyUs = R->BusyUs.exchange(0);
+				R->PendingMigrations = 0;
+				if (Busiest == nullptr || R->RecentBusyUs > Busiest->RecentBusyUs)
+					Busiest = R.get();
+				if (Idlest == nullptr || R->RecentBusyUs < Idlest->RecentBusyUs)
+					Idlest = R.get();
+			}
+
+			if (MaxMigrations_ == 0 || Busiest == Idlest || Busiest->Sockets < 2 ||
+				Busiest->RecentBusyUs < 2 * Idlest->RecentBusyUs + MinimumImbalanceUs)
+				return;
+
+			//	Move enough sockets to close half of the gap, assuming an average cost per socket.
+			auto PerSocket = std::max<std::uint64_t>(1, Busiest->RecentBusyUs / Busiest->Sockets);
+			auto ToMove = (Busiest->RecentBusyUs - Idlest->RecentBusyUs) / (2 * PerSocket);
+			ToMove = std::min<std::uint64_t>({ToMove, MaxMigrations_, Busiest->Sockets / 2});
+			if (ToMove == 0)
+				return;
+			Busiest->MigrationTarget = Idlest->Id;
+			Busiest->PendingMigrations = (std::int64_t)ToMove;
+		}
+
+		inline AP_WS_Reactor &Reactor(std::uint64_t Id) { return *Reactors_[Id]; }
+
+		void TrimFrameArenas() {
+			for (auto &R : Reactors_)
+				R->Arena.Trim();
+		}
+
+		void GetStatistics(Poco::JSON::Object &Obj) const {
+			Poco::JSON::Array Reactors;
+			std::uint64_t TotalCapacity = 0;
+			for (const auto &R : Reactors_) {
+				Poco::JSON::Object Entry, FrameBuffer;
+				Entry.set("id", R->Id);
+				Entry.set("sockets", R->Sockets.load());
+				Entry.set("busyUs", R->RecentBusyUs.load());
+				Entry.set("frames", R->Frames.load());
+				Entry.set("migratedIn", R->MigratedIn.load());
+				Entry.set("migratedOut", R->MigratedOut.load());
+				R->Arena.to_json(FrameBuffer);
+				Entry.set("frameBuffer", FrameBuffer);
+				if (R->Epoll) {
+					Poco::JSON::Object Epoll;
+					R->Epoll->to_json(Epoll);
+					Entry.set("epoll", Epoll);
+				}
+				TotalCapacity += R->Arena.Capacity();
+				Reactors.add(Entry);
+			}
+			Obj.set("eventLoop", UseEpoll_ ? "epoll" : "poco");
+			Obj.set("frameBufferCapacity", TotalCapacity);
+			Obj.set("reactors", Reactors);
 		}
 
 	  private:
-		std::shared_mutex Mutex_;
+		static constexpr std::uint64_t MinimumImbalanceUs = 100000;
+
 		uint64_t NumberOfThreads_;
-		uint64_t NextReactor_ = 0;
-		std::vector<std::unique_ptr<Poco::Net::SocketReactor>> Reactors_;
-		std::vector<std::unique_ptr<Poco::Thread>> Threads_;
+		std::uint64_t MaxMigrations_ = 16;
+		bool UseEpoll_ = false;
+		std::atomic_uint64_t NextReactor_ = 0;
+		std::vector<std::unique_ptr<AP_WS_Reactor>> Reactors_;
+
+		inline std::uint64_t AverageBusyPerSocket() const {
+			std::uint64_t Busy = 0, Sockets = 0;
+			for (const auto &R : Reactors_) {
+				Busy += R->RecentBusyUs;
+				Sockets += R->Sockets;
+			}
+			return Sockets == 0 ? 1 : std::max<std::uint64_t>(1, Busy / Sockets);
+		}
 	};
-} // namespace OpenWifi
\ No newline at end of file
+} // namespace OpenWifi
@@ -0,0 +1,163 @@
+//
+//	License type: BSD 3-Clause License
+//	License copy: https://github.com/Telecominfraproject/wlan-cloud-ucentralgw/blob/master/LICENSE
+//
+
+#pragma once
+
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <string>
+
+#include "Poco/JSON/Object.h"
+#include "Poco/Net/WebSocket.h"
+
+namespace OpenWifi {
+
+	//	Outbound frames for one device. Any thread may queue a frame; only the connection's reactor
+	//	thread writes to the socket. Frames are encoded when they are queued, and consecutive frames
+	//	are written together up to CoalesceSize bytes. A write the socket cannot take in full stays
+	//	in WriteBuffer_ and is retried unchanged, as TLS requires, when the socket becomes writable.
+	//	The socket is written without the queue lock, so senders never wait on a slow device.
+	class AP_WS_SendQueue {
+	  public:
+		enum class PushResult { Queued, Dropped, Overflow };
+
+		inline void Configure(std::uint64_t HighWater, std::uint64_t CoalesceSize,
+							  bool CloseOnOverflow) {
+			std::lock_guard G(Mutex_);
+			HighWater_ = HighWater;
+			CoalesceSize_ = CoalesceSize;
+			CloseOnOverflow_ = CloseOnOverflow;
+		}
+
+		inline PushResult Push(const std::string &Payload,
+							   int Flags = (int)Poco::Net::WebSocket::FRAME_TEXT) {
+			std::string Frame;
+			Encode(Payload, Flags, Frame);
+			std::lock_guard G(Mutex_);
+			auto Pending = QueuedBytes_ + Unsent_;
+			//	A single frame larger than the high-water mark still goes out on an idle queue.
+			if (Pending > 0 && Pending + Frame.size() > HighWater_) {
+				Dropped_++;
+				return CloseOnOverflow_ ? PushResult::Overflow : PushResult::Dropped;
+			}
+			QueuedBytes_ += Frame.size();
+			Frames_.emplace_back(std::move(Frame));
+			Queued_++;
+			if (QueuedBytes_ > PeakBytes_)
+				PeakBytes_ = QueuedBytes_;
+			return PushResult::Queued;
+		}
+
+		//	Writes until the queue is empty or the socket stops accepting data. Writer returns the
+		//	number of bytes taken, or 0 or less when the socket would block. The queue lock is only
+		//	held to take the next coalesced buffer and to account for what was written.
+		template <typename W> std::uint64_t Drain(W Writer, bool &Empty) {
+			std::lock_guard D(DrainMutex_);
+			std::uint64_t Written = 0;
+			while (true) {
+				if (WriteOffset_ == WriteBuffer_.size()) {
+					WriteBuffer_.clear();
+					WriteOffset_ = 0;
+					std::lock_guard G(Mutex_);
+					if (Frames_.empty()) {
+						Empty = true;
+						return Written;
+					}
+					QueuedBytes_ -= Frames_.front().size();
+					WriteBuffer_ = std::move(Frames_.front());
+					Frames_.pop_front();
+					while (!Frames_.empty() &&
+						   WriteBuffer_.size() + Frames_.front().size() <= CoalesceSize_) {
+						Coalesced_++;
+						QueuedBytes_ -= Frames_.front().size();
+						WriteBuffer_ += Frames_.front();
+						Frames_.pop_front();
+					}
+					Unsent_ = WriteBuffer_.size();
+				}
+				auto Count = Writer(WriteBuffer_.data() + WriteOffset_,
+									WriteBuffer_.size() - WriteOffset_);
+				if (Count <= 0) {
+					Empty = false;
+					return Written;
+				}
+				WriteOffset_ += Count;
+				Written += Count;
+				std::lock_guard G(Mutex_);
+				Unsent_ -= Count;
+				BytesSent_ += Count;
+			}
+		}
+
+		//	Runs Action while holding the queue lock, if nothing is left to write. Used to stop
+		//	waiting for writable events without missing a frame queued at the same moment.
+		template <typename F> bool IfEmpty(F Action) {
+			std::lock_guard G(Mutex_);
+			if (!Frames_.empty() || Unsent_ > 0)
+				return false;
+			Action();
+			return true;
+		}
+
+		inline void GetDepth(std::uint64_t &Frames, std::uint64_t &Bytes,
+							 std::uint64_t &Dropped) const {
+			std::lock_guard G(Mutex_);
+			Frames = Frames_.size() + (Unsent_ > 0 ? 1 : 0);
+			Bytes = QueuedBytes_ + Unsent_;
+			Dropped = Dropped_;
+		}
+
+		inline void to_json(Poco::JSON::Object &Obj) const {
+			std::lock_guard G(Mutex_);
+			Obj.set("frames", Frames_.size());
+			Obj.set("bytes", QueuedBytes_ + Unsent_);
+			Obj.set("peakBytes", PeakBytes_);
+			Obj.set("queued", Queued_);
+			Obj.set("coalesced", Coalesced_);
+			Obj.set("dropped", Dropped_);
+			Obj.set("bytesSent", BytesSent_);
+		}
+
+	  private:
+		mutable std::mutex Mutex_;
+		std::deque<std::string> Frames_;
+		std::uint64_t QueuedBytes_ = 0;
+		//	What is left of WriteBuffer_, so that senders can see it without the drain lock.
+		std::uint64_t Unsent_ = 0;
+		std::uint64_t PeakBytes_ = 0;
+		std::uint64_t Queued_ = 0;
+		std::uint64_t Coalesced_ = 0;
+		std::uint64_t Dropped_ = 0;
+		std::uint64_t BytesSent_ = 0;
+		std::uint64_t HighWater_ = 4 * 1024 * 1024;
+		std::uint64_t CoalesceSize_ = 64 * 1024;
+		bool CloseOnOverflow_ = false;
+		//	Taken only by the thread writing to the socket; guards the buffer being written.
+		std::mutex DrainMutex_;
+		std::string WriteBuffer_;
+		std::size_t WriteOffset_ = 0;
+
+		//	Server frames are never masked (RFC 6455, section 5.1).
+		static inline void Encode(const std::string &Payload, int Flags, std::string &Frame) {
+			auto Size = Payload.size();
+			Frame.reserve(Size + 10);
+			Frame += (char)(Flags & 0xff);
+			if (Size < 126) {
+				Frame += (char)Size;
+			} else if (Size <= 0xffff) {
+				Frame += (char)126;
+				Frame += (char)((Size >> 8) & 0xff);
+				Frame += (char)(Size & 0xff);
+			} else {
+				Frame += (char)127;
+				for (int Shift = 56; Shift >= 0; Shift -= 8)
+					Frame += (char)((Size >> Shift) & 0xff);
+			}
+			Frame += Payload;
+		}
+	};
+
+} // namespace OpenWifi
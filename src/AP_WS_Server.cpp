@@ -6,6 +6,8 @@
 //	Arilia Wireless Inc.
 //
 
+#include <algorithm>
+
 #include "Poco/Net/Context.h"
 #include "Poco/Net/HTTPHeaderStream.h"
 #include "Poco/Net/HTTPServerRequest.h"
@@ -25,13 +27,29 @@ namespace OpenWifi {
 
 	void AP_WS_RequestHandler::handleRequest(Poco::Net::HTTPServerRequest &request,
 											 Poco::Net::HTTPServerResponse &response) {
+		//	This runs on the device connection pool: the WebSocket upgrade and the certificate
+		//	validation happen here, and only validated devices are handed to a reactor.
+		auto Start = std::chrono::steady_clock::now();
+		AP_WS_Server()->HandshakesInProgress_++;
 		try {
-			AP_WS_Server()->AddConnection(
-				id_, std::make_shared<AP_WS_Connection>(request, response, id_, Logger_,
-														AP_WS_Server()->NextReactor()));
+			auto Connection = std::make_shared<AP_WS_Connection>(request, response, id_, Logger_,
+																 AP_WS_Server()->NextReactor());
+			if (Connection->ValidatedDevice()) {
+				AP_WS_Server()->AddConnection(id_, Connection);
+				Connection->Start();
+				AP_WS_Server()->HandshakesValidated_++;
+			} else {
+				AP_WS_Server()->HandshakesRejected_++;
+			}
 		} catch (...) {
+			AP_WS_Server()->HandshakesRejected_++;
 			poco_warning(Logger_, "Exception during WS creation");
 		}
+		AP_WS_Server()->HandshakesInProgress_--;
+		AP_WS_Server()->HandshakeLatency_.Add(
+			std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() -
+																  Start)
+				.count());
 	};
 
 	bool AP_WS_Server::ValidateCertificate(const std::string &ConnectionId,
@@ -56,9 +74,27 @@ namespace OpenWifi {
 		MismatchDepth_ = MicroServiceConfigGetInt("openwifi.certificates.mismatchdepth", 2);
 
 		SessionTimeOut_ = MicroServiceConfigGetInt("openwifi.session.timeout", 10*60);
+		SendQueueHighWater_ =
+			MicroServiceConfigGetInt("openwifi.session.sendqueue.highwater", 4 * 1024 * 1024);
+		SendQueueCoalesce_ =
+			MicroServiceConfigGetInt("openwifi.session.sendqueue.coalesce", 64 * 1024);
+		SendQueueCloseOnOverflow_ =
+			MicroServiceConfigGetString("openwifi.session.sendqueue.policy", "drop") == "close";
+		CompressLastStats_ = MicroServiceConfigGetBool("openwifi.session.laststats.compress", false);
+		LastStatsCompressionLevel_ = std::clamp(
+			(int)MicroServiceConfigGetInt("openwifi.session.laststats.level", 1), 1, 9);
 
 		Reactor_pool_ = std::make_unique<AP_WS_ReactorThreadPool>();
-		Reactor_pool_->Start();
+		Reactor_pool_->Start(
+			MicroServiceConfigGetInt("openwifi.session.framebuffer.size", 16 * 1024),
+			MicroServiceConfigGetInt("openwifi.session.framebuffer.idle", 60),
+			MicroServiceConfigGetInt("openwifi.session.reactor.migrations", 16),
+			MicroServiceConfigGetString("openwifi.session.reactor.eventloop", "poco") == "epoll");
+
+		auto HandshakeThreads = MicroServiceConfigGetInt("openwifi.session.handshake.threads", 64);
+		auto HandshakeQueue = MicroServiceConfigGetInt("openwifi.session.handshake.queue", 200);
+		DeviceConnectionPool_ =
+			std::make_unique<Poco::ThreadPool>("ws:dev-pool", 2, (int)HandshakeThreads);
 
 		for (const auto &Svr : ConfigServersList_) {
 
@@ -112,8 +148,8 @@ namespace OpenWifi {
 									  Poco::Net::Context::PROTO_TLSV1_1);
 
 			auto WebServerHttpParams = new Poco::Net::HTTPServerParams;
-			WebServerHttpParams->setMaxThreads(50);
-			WebServerHttpParams->setMaxQueued(200);
+			WebServerHttpParams->setMaxThreads((int)HandshakeThreads);
+			WebServerHttpParams->setMaxQueued((int)HandshakeQueue);
 			WebServerHttpParams->setKeepAlive(true);
 			WebServerHttpParams->setName("ws:ap_dispatch");
 
@@ -123,7 +159,7 @@ namespace OpenWifi {
 													  : Poco::Net::AddressFamily::IPv4));
 				Poco::Net::SocketAddress SockAddr(Addr, Svr.Port());
 				auto NewWebServer = std::make_unique<Poco::Net::HTTPServer>(
-					new AP_WS_RequestHandlerFactory(Logger()), DeviceConnectionPool_,
+					new AP_WS_RequestHandlerFactory(Logger()), *DeviceConnectionPool_,
 					Poco::Net::SecureServerSocket(SockAddr, Svr.Backlog(), Context),
 					WebServerHttpParams);
 				WebServers_.push_back(std::move(NewWebServer));
@@ -131,7 +167,7 @@ namespace OpenWifi {
 				Poco::Net::IPAddress Addr(Svr.Address());
 				Poco::Net::SocketAddress SockAddr(Addr, Svr.Port());
 				auto NewWebServer = std::make_unique<Poco::Net::HTTPServer>(
-					new AP_WS_RequestHandlerFactory(Logger()), DeviceConnectionPool_,
+					new AP_WS_RequestHandlerFactory(Logger()), *DeviceConnectionPool_,
 					Poco::Net::SecureServerSocket(SockAddr, Svr.Backlog(), Context),
 					WebServerHttpParams);
 				WebServers_.push_back(std::move(NewWebServer));
@@ -175,47 +211,48 @@ namespace OpenWifi {
 		static uint64_t last_log = Utils::Now();
 		auto now = Utils::Now();
 
+		std::vector<std::shared_ptr<AP_WS_Connection>> OldGarbage;
 		{
-			std::lock_guard Lock(WSServerMutex_);
-			if (!Garbage_.empty()) {
-				Garbage_.clear();
-			}
-
-			NumberOfConnectedDevices_ = 0;
-			NumberOfConnectingDevices_ = 0;
-			AverageDeviceConnectionTime_ = 0;
-			uint64_t total_connected_time = 0;
-
-			auto hint = SerialNumbers_.begin();
-			while (hint != end(SerialNumbers_)) {
-				if (hint->second.second == nullptr) {
-					hint = SerialNumbers_.erase(hint);
-				} else if ((now - hint->second.second->State_.LastContact) > SessionTimeOut_) {
-					hint->second.second->EndConnection(false);
-					poco_information(Logger(),fmt::format("{}: Session seems idle. Controller disconnecting device.", hint->second.second->SerialNumber_));
-					Sessions_.erase(hint->second.second->State_.sessionId);
-					Garbage_.push_back(hint->second.second);
-					hint = SerialNumbers_.erase(hint);
-				} else if (hint->second.second->State_.Connected) {
-					NumberOfConnectedDevices_++;
-					total_connected_time += (now - hint->second.second->State_.started);
-					hint++;
-				} else {
-					NumberOfConnectingDevices_++;
-					hint++;
-				}
-			}
+			std::lock_guard Lock(GarbageMutex_);
+			OldGarbage.swap(Garbage_);
+		}
 
-			AverageDeviceConnectionTime_ = NumberOfConnectedDevices_ > 0
-											   ? total_connected_time / NumberOfConnectedDevices_
-											   : 0;
-			if ((now - last_log) > 120) {
-				last_log = now;
-				poco_information(Logger(),
-								 fmt::format("Active AP connections: {} Connecting: {} Average connection time: {} seconds",
-											 NumberOfConnectedDevices_, NumberOfConnectingDevices_,
-											 AverageDeviceConnectionTime_));
-			}
+		//	Only the sessions whose idle deadline has come up are looked at. A session that was
+		//	active since it was scheduled goes back on the wheel for its new deadline.
+		IdleSessions_.Advance(now, [this, now](std::uint64_t session_id,
+											   [[maybe_unused]] std::uint64_t Deadline) -> std::uint64_t {
+			auto Session = FindConnection(session_id);
+			if (Session == nullptr)
+				return 0;
+			auto LastContact = Session->State_.LastContact;
+			if (LastContact == 0)
+				LastContact = Session->State_.started;
+			if ((now - LastContact) <= SessionTimeOut_)
+				return LastContact + SessionTimeOut_ + 1;
+
+			Session->EndConnection(false);
+			poco_information(Logger(),fmt::format("{}: Session seems idle. Controller disconnecting device.", Session->SerialNumber_));
+			RemoveSession(session_id);
+			Devices_.Unregister(Session->SerialNumberInt_, session_id);
+			std::lock_guard Lock(GarbageMutex_);
+			Garbage_.push_back(Session);
+			return 0;
+		});
+
+		Reactor_pool_->TrimFrameArenas();
+		Reactor_pool_->Rebalance();
+
+		std::uint64_t connected_devices = ConnectedDevices_, sessions = NumberOfSessions_;
+		NumberOfConnectedDevices_ = connected_devices;
+		NumberOfConnectingDevices_ = sessions > connected_devices ? sessions - connected_devices : 0;
+		AverageDeviceConnectionTime_ =
+			connected_devices > 0 ? now - (ConnectedSince_ / connected_devices) : 0;
+		if ((now - last_log) > 120) {
+			last_log = now;
+			poco_information(Logger(),
+							 fmt::format("Active AP connections: {} Connecting: {} Average connection time: {} seconds",
+										 NumberOfConnectedDevices_, NumberOfConnectingDevices_,
+										 AverageDeviceConnectionTime_));
 		}
 
 		GWWebSocketNotifications::NumberOfConnection_t Notification;
@@ -236,6 +273,35 @@ namespace OpenWifi {
 		KafkaManager()->PostMessage(KafkaTopics::DEVICE_EVENT_QUEUE, "system", FullEvent);
 	}
 
+	bool AP_WS_Server::GetResourceStatistics(Poco::JSON::Object &Stats) {
+		Poco::JSON::Object Handshakes;
+		std::uint64_t Queued = 0, Refused = 0;
+		for (const auto &server : WebServers_) {
+			Queued += server->queuedConnections();
+			Refused += server->refusedConnections();
+		}
+		Handshakes.set("inProgress", HandshakesInProgress_.load());
+		Handshakes.set("queued", Queued);
+		Handshakes.set("refused", Refused);
+		Handshakes.set("validated", HandshakesValidated_.load());
+		Handshakes.set("rejected", HandshakesRejected_.load());
+		Poco::JSON::Object Latency;
+		HandshakeLatency_.to_json(Latency);
+		Handshakes.set("latencyMs", Latency);
+		Stats.set("handshakes", Handshakes);
+		Poco::JSON::Object LastStats;
+		auto Connections = LastStatsConnections_.load();
+		LastStats.set("compressed", CompressLastStats_);
+		LastStats.set("connections", Connections);
+		LastStats.set("rawBytes", LastStatsRawBytes_.load());
+		LastStats.set("heldBytes", LastStatsHeldBytes_.load());
+		LastStats.set("rawBytesPerConnection", Connections ? LastStatsRawBytes_ / Connections : 0);
+		LastStats.set("heldBytesPerConnection", Connections ? LastStatsHeldBytes_ / Connections : 0);
+		Stats.set("lastStats", LastStats);
+		Reactor_pool_->GetStatistics(Stats);
+		return true;
+	}
+
 	void AP_WS_Server::Stop() {
 		poco_information(Logger(), "Stopping...");
 		Running_ = false;
@@ -252,28 +318,18 @@ namespace OpenWifi {
 	}
 
 	bool AP_WS_Server::GetStatistics(uint64_t SerialNumber, std::string &Statistics) const {
-		std::shared_ptr<AP_WS_Connection> DevicePtr;
-		{
-			std::lock_guard Lock(WSServerMutex_);
-			auto Device = SerialNumbers_.find(SerialNumber);
-			if (Device == SerialNumbers_.end() || Device->second.second == nullptr) {
-				return false;
-			}
-			DevicePtr = Device->second.second;
+		auto DevicePtr = FindDevice(SerialNumber);
+		if (DevicePtr == nullptr) {
+			return false;
 		}
 		DevicePtr->GetLastStats(Statistics);
 		return true;
 	}
 
 	bool AP_WS_Server::GetState(uint64_t SerialNumber, GWObjects::ConnectionState &State) const {
-		std::shared_ptr<AP_WS_Connection> DevicePtr;
-		{
-			std::lock_guard Lock(WSServerMutex_);
-			auto Device = SerialNumbers_.find(SerialNumber);
-			if (Device == SerialNumbers_.end() || Device->second.second == nullptr) {
-				return false;
-			}
-			DevicePtr = Device->second.second;
+		auto DevicePtr = FindDevice(SerialNumber);
+		if (DevicePtr == nullptr) {
+			return false;
 		}
 		DevicePtr->GetState(State);
 		return true;
@@ -281,122 +337,92 @@ namespace OpenWifi {
 
 	bool AP_WS_Server::GetHealthcheck(uint64_t SerialNumber,
 									  GWObjects::HealthCheck &CheckData) const {
-		std::shared_ptr<AP_WS_Connection> DevicePtr;
-		{
-			std::lock_guard Lock(WSServerMutex_);
-			auto Device = SerialNumbers_.find(SerialNumber);
-			if (Device == SerialNumbers_.end() || Device->second.second == nullptr) {
-				return false;
-			}
-			DevicePtr = Device->second.second;
+		auto DevicePtr = FindDevice(SerialNumber);
+		if (DevicePtr == nullptr) {
+			return false;
 		}
 		DevicePtr->GetLastHealthCheck(CheckData);
 		return true;
 	}
 
 	void AP_WS_Server::SetSessionDetails(uint64_t connection_id, uint64_t SerialNumber) {
-		std::lock_guard Lock(WSServerMutex_);
-
-		auto Conn = Sessions_.find(connection_id);
-		if (Conn == end(Sessions_))
+		auto Conn = FindConnection(connection_id);
+		if (Conn == nullptr)
 			return;
 
-		auto CurrentSerialNumber = SerialNumbers_.find(SerialNumber);
-		if ((CurrentSerialNumber == SerialNumbers_.end()) ||
-			(CurrentSerialNumber->second.first < connection_id)) {
-			SerialNumbers_[SerialNumber] = std::make_pair(connection_id, Conn->second);
-			return;
-		}
+		Devices_.Register(SerialNumber, connection_id, std::move(Conn));
 	}
 
-	bool AP_WS_Server::EndSession(uint64_t session_id, uint64_t serial_number) {
-		std::lock_guard G(WSServerMutex_);
-
-		auto Session = Sessions_.find(session_id);
-		if (Session == end(Sessions_))
-			return false;
-
-		Garbage_.push_back(Session->second);
-
-		auto Device = SerialNumbers_.find(serial_number);
-		if (Device == end(SerialNumbers_)) {
-			Sessions_.erase(Session);
-			return false;
-		}
-
-		if (Device->second.first == session_id) {
-			Sessions_.erase(Session);
-			SerialNumbers_.erase(Device);
-			return true;
+	void AP_WS_Server::AddConnection(uint64_t session_id,
+									 std::shared_ptr<AP_WS_Connection> Connection) {
+		{
+			auto shard = SessionShard(session_id);
+			std::lock_guard Lock(SessionMutex_[shard]);
+			Sessions_[shard][session_id] = std::move(Connection);
 		}
-
-		Sessions_.erase(Session);
-
-		return false;
+		NumberOfSessions_++;
+		IdleSessions_.Schedule(session_id, Utils::Now() + SessionTimeOut_ + 1);
 	}
 
-	bool AP_WS_Server::EndSessionUnSafe(uint64_t session_id, uint64_t serial_number) {
-
-		auto Session = Sessions_.find(session_id);
-		if (Session == end(Sessions_))
+	bool AP_WS_Server::RemoveSession(uint64_t session_id) {
+		auto shard = SessionShard(session_id);
+		std::lock_guard Lock(SessionMutex_[shard]);
+		if (Sessions_[shard].erase(session_id) == 0)
 			return false;
+		NumberOfSessions_--;
+		return true;
+	}
 
-		Garbage_.push_back(Session->second);
+	void AP_WS_Server::DeviceConnected(std::uint64_t Started) {
+		ConnectedDevices_++;
+		ConnectedSince_ += Started;
+	}
 
-		auto Device = SerialNumbers_.find(serial_number);
-		if (Device == end(SerialNumbers_)) {
-			Sessions_.erase(Session);
-			return false;
-		}
+	void AP_WS_Server::DeviceDisconnected(std::uint64_t Started) {
+		ConnectedDevices_--;
+		ConnectedSince_ -= Started;
+	}
 
-		if (Device->second.first == session_id) {
-			Sessions_.erase(Session);
-			SerialNumbers_.erase(Device);
-			return true;
+	bool AP_WS_Server::EndSession(uint64_t session_id, uint64_t serial_number) {
+		{
+			auto shard = SessionShard(session_id);
+			std::lock_guard Lock(SessionMutex_[shard]);
+			auto Session = Sessions_[shard].find(session_id);
+			if (Session == end(Sessions_[shard]))
+				return false;
+			{
+				std::lock_guard GLock(GarbageMutex_);
+				Garbage_.push_back(Session->second);
+			}
+			Sessions_[shard].erase(Session);
+			NumberOfSessions_--;
 		}
 
-		Sessions_.erase(Session);
-
-		return false;
+		return Devices_.Unregister(serial_number, session_id);
 	}
 
 	bool AP_WS_Server::Connected(uint64_t SerialNumber,
 								 GWObjects::DeviceRestrictions &Restrictions) const {
-		std::shared_ptr<AP_WS_Connection> DevicePtr;
-		{
-			std::lock_guard Lock(WSServerMutex_);
-			auto Device = SerialNumbers_.find(SerialNumber);
-			if (Device == end(SerialNumbers_) || Device->second.second == nullptr) {
-				return false;
-			}
-			DevicePtr = Device->second.second;
+		auto DevicePtr = FindDevice(SerialNumber);
+		if (DevicePtr == nullptr) {
+			return false;
 		}
 		DevicePtr->GetRestrictions(Restrictions);
 		return DevicePtr->State_.Connected;
 	}
 
 	bool AP_WS_Server::Connected(uint64_t SerialNumber) const {
-		std::shared_ptr<AP_WS_Connection> DevicePtr;
-		{
-			std::lock_guard Lock(WSServerMutex_);
-			auto Device = SerialNumbers_.find(SerialNumber);
-			if (Device == end(SerialNumbers_) || Device->second.second == nullptr) {
-				return false;
-			}
-			DevicePtr = Device->second.second;
+		auto DevicePtr = FindDevice(SerialNumber);
+		if (DevicePtr == nullptr) {
+			return false;
 		}
 		return DevicePtr->State_.Connected;
 	}
 
 	bool AP_WS_Server::SendFrame(uint64_t SerialNumber, const std::string &Payload) const {
-		std::shared_ptr<AP_WS_Connection> DevicePtr;
-		{
-			std::lock_guard Lock(WSServerMutex_);
-			auto Device = SerialNumbers_.find(SerialNumber);
-			if (Device == SerialNumbers_.end() || Device->second.second == nullptr) {
-				return false;
-			}
-			DevicePtr = Device->second.second;
+		auto DevicePtr = FindDevice(SerialNumber);
+		if (DevicePtr == nullptr) {
+			return false;
 		}
 		try {
 			return DevicePtr->Send(Payload);
@@ -408,15 +434,9 @@ namespace OpenWifi {
 	}
 
 	void AP_WS_Server::StopWebSocketTelemetry(uint64_t RPCID, uint64_t SerialNumber) {
-		std::shared_ptr<AP_WS_Connection> DevicePtr;
-		{
-			std::lock_guard Lock(WSServerMutex_);
-
-			auto Device = SerialNumbers_.find(SerialNumber);
-			if (Device == end(SerialNumbers_) || Device->second.second == nullptr) {
-				return;
-			}
-			DevicePtr = Device->second.second;
+		auto DevicePtr = FindDevice(SerialNumber);
+		if (DevicePtr == nullptr) {
+			return;
 		}
 		DevicePtr->StopWebSocketTelemetry(RPCID);
 	}
@@ -425,14 +445,9 @@ namespace OpenWifi {
 	AP_WS_Server::SetWebSocketTelemetryReporting(uint64_t RPCID, uint64_t SerialNumber,
 												 uint64_t Interval, uint64_t Lifetime,
 												 const std::vector<std::string> &TelemetryTypes) {
-		std::shared_ptr<AP_WS_Connection> DevicePtr;
-		{
-			std::lock_guard Lock(WSServerMutex_);
-			auto Device = SerialNumbers_.find(SerialNumber);
-			if (Device == end(SerialNumbers_) || Device->second.second == nullptr) {
-				return;
-			}
-			DevicePtr = Device->second.second;
+		auto DevicePtr = FindDevice(SerialNumber);
+		if (DevicePtr == nullptr) {
+			return;
 		}
 		DevicePtr->SetWebSocketTelemetryReporting(RPCID, Interval, Lifetime, TelemetryTypes);
 	}
@@ -440,27 +455,17 @@ namespace OpenWifi {
 	void AP_WS_Server::SetKafkaTelemetryReporting(uint64_t RPCID, uint64_t SerialNumber,
 												  uint64_t Interval, uint64_t Lifetime,
 												  const std::vector<std::string> &TelemetryTypes) {
-		std::shared_ptr<AP_WS_Connection> DevicePtr;
-		{
-			std::lock_guard Lock(WSServerMutex_);
-			auto Device = SerialNumbers_.find(SerialNumber);
-			if (Device == end(SerialNumbers_) || Device->second.second == nullptr) {
-				return;
-			}
-			DevicePtr = Device->second.second;
+		auto DevicePtr = FindDevice(SerialNumber);
+		if (DevicePtr == nullptr) {
+			return;
 		}
 		DevicePtr->SetKafkaTelemetryReporting(RPCID, Interval, Lifetime, TelemetryTypes);
 	}
 
 	void AP_WS_Server::StopKafkaTelemetry(uint64_t RPCID, uint64_t SerialNumber) {
-		std::shared_ptr<AP_WS_Connection> DevicePtr;
-		{
-			std::lock_guard Lock(WSServerMutex_);
-			auto Device = SerialNumbers_.find(SerialNumber);
-			if (Device == end(SerialNumbers_) || Device->second.second == nullptr) {
-				return;
-			}
-			DevicePtr = Device->second.second;
+		auto DevicePtr = FindDevice(SerialNumber);
+		if (DevicePtr == nullptr) {
+			return;
 		}
 		DevicePtr->StopKafkaTelemetry(RPCID);
 	}
@@ -470,14 +475,9 @@ namespace OpenWifi {
 		uint64_t &TelemetryWebSocketTimer, uint64_t &TelemetryKafkaTimer,
 		uint64_t &TelemetryWebSocketCount, uint64_t &TelemetryKafkaCount,
 		uint64_t &TelemetryWebSocketPackets, uint64_t &TelemetryKafkaPackets) {
-		std::shared_ptr<AP_WS_Connection> DevicePtr;
-		{
-			std::lock_guard Lock(WSServerMutex_);
-			auto Device = SerialNumbers_.find(SerialNumber);
-			if (Device == end(SerialNumbers_) || Device->second.second == nullptr) {
-				return;
-			}
-			DevicePtr = Device->second.second;
+		auto DevicePtr = FindDevice(SerialNumber);
+		if (DevicePtr == nullptr) {
+			return;
 		}
 		DevicePtr->GetTelemetryParameters(TelemetryRunning, TelemetryInterval,
 										  TelemetryWebSocketTimer, TelemetryKafkaTimer,
@@ -487,14 +487,9 @@ namespace OpenWifi {
 
 	bool AP_WS_Server::SendRadiusAccountingData(const std::string &SerialNumber,
 												const unsigned char *buffer, std::size_t size) {
-		std::shared_ptr<AP_WS_Connection> DevicePtr;
-		{
-			std::lock_guard Lock(WSServerMutex_);
-			auto Device = SerialNumbers_.find(Utils::SerialNumberToInt(SerialNumber));
-			if (Device == SerialNumbers_.end() || Device->second.second == nullptr) {
-				return false;
-			}
-			DevicePtr = Device->second.second;
+		auto DevicePtr = FindDevice(Utils::SerialNumberToInt(SerialNumber));
+		if (DevicePtr == nullptr) {
+			return false;
 		}
 
 		try {
@@ -510,14 +505,9 @@ namespace OpenWifi {
 
 	bool AP_WS_Server::SendRadiusAuthenticationData(const std::string &SerialNumber,
 													const unsigned char *buffer, std::size_t size) {
-		std::shared_ptr<AP_WS_Connection> DevicePtr;
-		{
-			std::lock_guard Lock(WSServerMutex_);
-			auto Device = SerialNumbers_.find(Utils::SerialNumberToInt(SerialNumber));
-			if (Device == SerialNumbers_.end() || Device->second.second == nullptr) {
-				return false;
-			}
-			DevicePtr = Device->second.second;
+		auto DevicePtr = FindDevice(Utils::SerialNumberToInt(SerialNumber));
+		if (DevicePtr == nullptr) {
+			return false;
 		}
 
 		try {
@@ -533,14 +523,9 @@ namespace OpenWifi {
 
 	bool AP_WS_Server::SendRadiusCoAData(const std::string &SerialNumber,
 										 const unsigned char *buffer, std::size_t size) {
-		std::shared_ptr<AP_WS_Connection> DevicePtr;
-		{
-			std::lock_guard Lock(WSServerMutex_);
-			auto Device = SerialNumbers_.find(Utils::SerialNumberToInt(SerialNumber));
-			if (Device == SerialNumbers_.end() || Device->second.second == nullptr) {
-				return false;
-			}
-			DevicePtr = Device->second.second;
+		auto DevicePtr = FindDevice(Utils::SerialNumberToInt(SerialNumber));
+		if (DevicePtr == nullptr) {
+			return false;
 		}
 
 		try {
@@ -12,6 +12,7 @@
 #include <ctime>
 #include <mutex>
 #include <thread>
+#include <unordered_map>
 
 #include "Poco/AutoPtr.h"
 #include "Poco/Net/HTTPRequestHandler.h"
@@ -24,8 +25,11 @@
 #include "Poco/Timer.h"
 
 #include "AP_WS_Connection.h"
+#include "AP_WS_DeviceRegistry.h"
 #include "AP_WS_ReactorPool.h"
+#include "AP_WS_TimingWheel.h"
 
+#include "framework/LatencyTracker.h"
 #include "framework/SubSystemServer.h"
 #include "framework/utils.h"
 
@@ -65,6 +69,8 @@ namespace OpenWifi {
 
 	class AP_WS_Server : public SubSystemServer {
 	  public:
+		friend class AP_WS_RequestHandler;
+
 		static auto instance() {
 			static auto instance_ = new AP_WS_Server;
 			return instance_;
@@ -72,6 +78,7 @@ namespace OpenWifi {
 
 		int Start() override;
 		void Stop() override;
+		bool GetResourceStatistics(Poco::JSON::Object &Stats) override;
 		bool IsCertOk() { return IssuerCert_ != nullptr; }
 		bool ValidateCertificate(const std::string &ConnectionId,
 								 const Poco::Crypto::X509Certificate &Certificate);
@@ -95,33 +102,52 @@ namespace OpenWifi {
 		inline bool UseProvisioning() const { return LookAtProvisioning_; }
 		inline bool UseDefaults() const { return UseDefaultConfig_; }
 
-		[[nodiscard]] inline Poco::Net::SocketReactor &NextReactor() {
+		[[nodiscard]] inline AP_WS_Reactor &NextReactor() {
 			return Reactor_pool_->NextReactor();
 		}
-		[[nodiscard]] inline bool Running() const { return Running_; }
+		[[nodiscard]] inline AP_WS_Reactor &Reactor(std::uint64_t Id) {
+			return Reactor_pool_->Reactor(Id);
+		}
+		inline void ConfigureSendQueue(AP_WS_SendQueue &Queue) const {
+			Queue.Configure(SendQueueHighWater_, SendQueueCoalesce_, SendQueueCloseOnOverflow_);
+		}
 
-		inline void AddConnection(uint64_t session_id,
-								  std::shared_ptr<AP_WS_Connection> Connection) {
-			std::lock_guard Lock(WSServerMutex_);
-			Sessions_[session_id] = std::move(Connection);
+		inline bool CompressLastStats() const { return CompressLastStats_; }
+		inline int LastStatsCompressionLevel() const { return LastStatsCompressionLevel_; }
+
+		//	Memory held by the last state report of each connection, before and after compression.
+		inline void AccountLastStats(std::uint64_t OldRaw, std::uint64_t OldHeld, std::uint64_t Raw,
+									 std::uint64_t Held) {
+			if (!OldRaw && Raw)
+				LastStatsConnections_++;
+			else if (OldRaw && !Raw)
+				LastStatsConnections_--;
+			LastStatsRawBytes_ += Raw;
+			LastStatsRawBytes_ -= OldRaw;
+			LastStatsHeldBytes_ += Held;
+			LastStatsHeldBytes_ -= OldHeld;
 		}
+		[[nodiscard]] inline bool Running() const { return Running_; }
+
+		void AddConnection(uint64_t session_id, std::shared_ptr<AP_WS_Connection> Connection);
+		void DeviceConnected(std::uint64_t Started);
+		void DeviceDisconnected(std::uint64_t Started);
 
 		inline std::shared_ptr<AP_WS_Connection> FindConnection(uint64_t session_id) const {
-			std::lock_guard Lock(WSServerMutex_);
+			auto shard = SessionShard(session_id);
+			std::lock_guard Lock(SessionMutex_[shard]);
 
-			auto Connection = Sessions_.find(session_id);
-			if (Connection != end(Sessions_))
+			auto Connection = Sessions_[shard].find(session_id);
+			if (Connection != end(Sessions_[shard]))
 				return Connection->second;
 			return nullptr;
 		}
 
 		inline bool DeviceRequiresSecureRtty(uint64_t serialNumber) const {
-			std::lock_guard Lock(WSServerMutex_);
-
-			auto Connection = SerialNumbers_.find(serialNumber);
-			if (Connection==end(SerialNumbers_) || Connection->second.second==nullptr)
+			auto Connection = FindDevice(serialNumber);
+			if (Connection == nullptr)
 				return false;
-			return Connection->second.second->RttyMustBeSecure_;
+			return Connection->RttyMustBeSecure_;
 		}
 
 		inline bool GetStatistics(const std::string &SerialNumber, std::string &Statistics) const {
@@ -159,7 +185,6 @@ namespace OpenWifi {
 
 		void SetSessionDetails(uint64_t connection_id, uint64_t SerialNumber);
 		bool EndSession(uint64_t connection_id, uint64_t serial_number);
-		bool EndSessionUnSafe(uint64_t session_id, uint64_t serial_number);
 		void SetWebSocketTelemetryReporting(uint64_t RPCID, uint64_t SerialNumber,
 											uint64_t Interval, uint64_t Lifetime,
 											const std::vector<std::string> &TelemetryTypes);
@@ -202,12 +227,14 @@ namespace OpenWifi {
 		}
 
 		inline bool GetHealthDevices(std::uint64_t lowLimit, std::uint64_t  highLimit, std::vector<std::string> & SerialNumbers) {
-			std::lock_guard		G(WSServerMutex_);
-
-			for(const auto &connection:Sessions_) {
-				if(	connection.second->RawLastHealthcheck_.Sanity>=lowLimit 	&&
-					connection.second->RawLastHealthcheck_.Sanity<=highLimit) {
-					SerialNumbers.push_back(connection.second->SerialNumber_);
+			for (std::uint64_t shard = 0; shard < SessionShards; ++shard) {
+				std::lock_guard G(SessionMutex_[shard]);
+				for (const auto &connection : Sessions_[shard]) {
+					StateUtils::DeviceMetrics Metrics;
+					connection.second->GetMetrics(Metrics);
+					if (Metrics.Sanity >= lowLimit && Metrics.Sanity <= highLimit) {
+						SerialNumbers.push_back(connection.second->SerialNumber_);
+					}
 				}
 			}
 			return true;
@@ -220,44 +247,90 @@ namespace OpenWifi {
 			std::double_t &Load,
 			std::double_t &Temperature
 			) {
-			std::lock_guard	G(WSServerMutex_);
-			auto session_hint = SerialNumbers_.find(Utils::SerialNumberToInt(serialNumber));
-			if(session_hint==end(SerialNumbers_)) {
+			auto Connection = FindDevice(Utils::SerialNumberToInt(serialNumber));
+			if (Connection == nullptr) {
 				return false;
 			}
-			hasGPS = session_hint->second.second->hasGPS;
-			Sanity = session_hint->second.second->RawLastHealthcheck_.Sanity;
-			MemoryUsed = session_hint->second.second->memory_used_;
-			Load = session_hint->second.second->cpu_load_;
-			Temperature = session_hint->second.second->temperature_;
+			StateUtils::DeviceMetrics Metrics;
+			Connection->GetMetrics(Metrics);
+			hasGPS = Metrics.HasGPS;
+			Sanity = Metrics.Sanity;
+			MemoryUsed = Metrics.MemoryUsed;
+			Load = (std::double_t)Metrics.Load[1];
+			Temperature = Metrics.Temperature;
+			return true;
+		}
+
+		inline bool GetMetrics(const std::string &SerialNumber, StateUtils::DeviceMetrics &Metrics) {
+			auto Connection = FindDevice(Utils::SerialNumberToInt(SerialNumber));
+			if (Connection == nullptr) {
+				return false;
+			}
+			Connection->GetMetrics(Metrics);
 			return true;
 		}
 
 	  private:
-		mutable std::recursive_mutex WSServerMutex_;
+		//	Sessions are spread over independently locked shards, as devices are in Devices_, so
+		//	REST lookups and command sends for different devices do not contend on a single lock.
+		static constexpr std::uint64_t SessionShards = 64;
+
+		using SessionMap = std::unordered_map<std::uint64_t, std::shared_ptr<AP_WS_Connection>>;
+
+		static inline std::uint64_t SessionShard(std::uint64_t session_id) {
+			return session_id % SessionShards;
+		}
+
+		bool RemoveSession(std::uint64_t session_id);
+
+		std::shared_ptr<AP_WS_Connection> FindDevice(std::uint64_t SerialNumber) const {
+			return Devices_.Find(SerialNumber);
+		}
+
+		mutable std::array<std::mutex, SessionShards> SessionMutex_;
+		std::array<SessionMap, SessionShards> Sessions_;
+		AP_WS_DeviceRegistry<AP_WS_Connection> Devices_;
 		std::unique_ptr<Poco::Crypto::X509Certificate> IssuerCert_;
 		std::list<std::unique_ptr<Poco::Net::HTTPServer>> WebServers_;
 		Poco::Net::SocketReactor Reactor_;
 		Poco::Thread ReactorThread_;
 		std::string SimulatorId_;
-		Poco::ThreadPool DeviceConnectionPool_{"ws:dev-pool", 2, 64};
+		std::unique_ptr<Poco::ThreadPool> DeviceConnectionPool_;
+		std::atomic_uint64_t HandshakesInProgress_ = 0;
+		std::atomic_uint64_t HandshakesValidated_ = 0;
+		std::atomic_uint64_t HandshakesRejected_ = 0;
+		LatencyTracker HandshakeLatency_;
 		bool LookAtProvisioning_ = false;
 		bool UseDefaultConfig_ = true;
 		bool SimulatorEnabled_ = false;
 		std::unique_ptr<AP_WS_ReactorThreadPool> Reactor_pool_;
 		std::atomic_bool Running_ = false;
-		std::map<std::uint64_t, std::shared_ptr<AP_WS_Connection>> Sessions_;
-		std::map<uint64_t, std::pair<uint64_t, std::shared_ptr<AP_WS_Connection>>> SerialNumbers_;
 		std::atomic_bool AllowSerialNumberMismatch_ = true;
 		std::atomic_uint64_t MismatchDepth_ = 2;
 
+		//	Kept up to date as devices come and go, so housekeeping never walks every session.
+		//	ConnectedSince_ is the sum of the start times of connected devices.
+		std::atomic_uint64_t 	NumberOfSessions_ = 0;
+		std::atomic_uint64_t 	ConnectedDevices_ = 0;
+		std::atomic_uint64_t 	ConnectedSince_ = 0;
+		AP_WS_TimingWheel 		IdleSessions_{10, 128};
+
 		std::uint64_t 			NumberOfConnectedDevices_ = 0;
 		std::uint64_t 			AverageDeviceConnectionTime_ = 0;
 		std::uint64_t 			NumberOfConnectingDevices_ = 0;
 		std::uint64_t 			SessionTimeOut_ = 10*60;
+		std::uint64_t 			SendQueueHighWater_ = 4 * 1024 * 1024;
+		std::uint64_t 			SendQueueCoalesce_ = 64 * 1024;
+		bool 					SendQueueCloseOnOverflow_ = false;
+		bool 					CompressLastStats_ = false;
+		int 					LastStatsCompressionLevel_ = 1;
+		std::atomic_uint64_t 	LastStatsConnections_ = 0;
+		std::atomic_uint64_t 	LastStatsRawBytes_ = 0;
+		std::atomic_uint64_t 	LastStatsHeldBytes_ = 0;
 		mutable std::mutex		StatsMutex_;
 		std::atomic_uint64_t 	TX_=0,RX_=0;
 
+		std::mutex GarbageMutex_;
 		std::vector<std::shared_ptr<AP_WS_Connection>> Garbage_;
 
 		std::unique_ptr<Poco::TimerCallback<AP_WS_Server>> GarbageCollectorCallback_;
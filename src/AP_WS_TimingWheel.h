@@ -0,0 +1,78 @@
+//
+//	License type: BSD 3-Clause License
+//	License copy: https://github.com/Telecominfraproject/wlan-cloud-ucentralgw/blob/master/LICENSE
+//
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace OpenWifi {
+
+	//	Hashed timing wheel: entries are kept in the slot of their deadline, so advancing the wheel
+	//	only looks at the slots whose time has come. Deadlines beyond one turn of the wheel stay in
+	//	their slot until the turn in which they fall due.
+	class AP_WS_TimingWheel {
+	  public:
+		AP_WS_TimingWheel(std::uint64_t TickSeconds, std::size_t Slots)
+			: Tick_(TickSeconds == 0 ? 1 : TickSeconds), Slots_(Slots == 0 ? 1 : Slots) {}
+
+		inline void Schedule(std::uint64_t Id, std::uint64_t Deadline) {
+			std::lock_guard G(Mutex_);
+			//	never behind the cursor, or the entry would wait for a full turn
+			auto Tick = std::max(Deadline / Tick_, NextTick_);
+			Slots_[Tick % Slots_.size()].emplace_back(Id, Deadline);
+			Size_++;
+		}
+
+		//	Calls Expired(Id, Deadline) for every entry due at Now. Expired returns 0 to drop the
+		//	entry, or a new deadline to keep it. Returns the number of entries that were looked at.
+		template <typename F> std::uint64_t Advance(std::uint64_t Now, F Expired) {
+			std::vector<std::pair<std::uint64_t, std::uint64_t>> Due;
+			{
+				std::lock_guard G(Mutex_);
+				auto Last = Now / Tick_;
+				//	after a long pause, or on the first call, one turn covers every slot
+				if (NextTick_ <= Last && Last - NextTick_ >= Slots_.size())
+					NextTick_ = Last - Slots_.size() + 1;
+				for (; NextTick_ <= Last; ++NextTick_) {
+					auto &Slot = Slots_[NextTick_ % Slots_.size()];
+					for (std::size_t i = 0; i < Slot.size();) {
+						if (Slot[i].second <= Now) {
+							Due.push_back(Slot[i]);
+							Slot[i] = Slot.back();
+							Slot.pop_back();
+							Size_--;
+						} else {
+							++i;
+						}
+					}
+				}
+			}
+
+			for (const auto &[Id, Deadline] : Due) {
+				auto NewDeadline = Expired(Id, Deadline);
+				if (NewDeadline != 0)
+					Schedule(Id, NewDeadline);
+			}
+			return Due.size();
+		}
+
+		inline std::uint64_t Size() const {
+			std::lock_guard G(Mutex_);
+			return Size_;
+		}
+
+	  private:
+		mutable std::mutex Mutex_;
+		std::uint64_t Tick_;
+		std::vector<std::vector<std::pair<std::uint64_t, std::uint64_t>>> Slots_;
+		std::uint64_t NextTick_ = 0;
+		std::uint64_t Size_ = 0;
+	};
+
+} // namespace OpenWifi
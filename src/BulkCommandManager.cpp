@@ -0,0 +1,392 @@
+//
+//	License type: BSD 3-Clause License
+//	License copy: https://github.com/Telecominfraproject/wlan-cloud-ucentralgw/blob/master/LICENSE
+//
+
+#include "BulkCommandManager.h"
+
+#include <set>
+
+#include "Poco/JSON/Parser.h"
+#include "Poco/URI.h"
+
+#include "AP_WS_Server.h"
+#include "CommandManager.h"
+#include "RESTAPI/RESTAPI_RPC.h"
+#include "SerialNumberCache.h"
+#include "SignatureMgr.h"
+#include "StorageService.h"
+#include "UI_GW_WebSocketNotifications.h"
+#include "framework/MicroServiceFuncs.h"
+#include "framework/ow_constants.h"
+#include "framework/utils.h"
+
+using namespace std::chrono_literals;
+
+namespace OpenWifi {
+
+	static const char *RUNNING = "running";
+	static const char *QUEUED = "queued";
+	static const char *CANCELLED = "cancelled";
+
+	bool BulkCommandManager::SupportedCommand(const std::string &Command) {
+		return Command == uCentralProtocol::REBOOT || Command == uCentralProtocol::LEDS ||
+			   Command == uCentralProtocol::FACTORY || Command == uCentralProtocol::UPGRADE;
+	}
+
+	int BulkCommandManager::Start() {
+		poco_notice(Logger(), "Starting...");
+		MaxDevices_ = MicroServiceConfigGetInt("bulkcommands.maxdevices", 10000);
+		MaxConcurrency_ = std::max<std::uint64_t>(1, MicroServiceConfigGetInt("bulkcommands.concurrency", 100));
+		MaxRate_ = std::max<std::uint64_t>(1, MicroServiceConfigGetInt("bulkcommands.rate", 50));
+		Timeout_ = std::chrono::seconds(MicroServiceConfigGetInt("bulkcommands.timeout", 120));
+
+		//	jobs interrupted by a restart carry on with the devices they had not reached
+		std::vector<GWObjects::BulkCommand> Interrupted;
+		for (std::uint64_t Offset = 0;; Offset += ResumePageSize) {
+			auto Read = Interrupted.size();
+			StorageService()->BulkCommandDB().GetRecords(
+				Offset, ResumePageSize, Interrupted, fmt::format(" status='{}' ", RUNNING),
+				" ORDER BY id ");
+			if (Interrupted.size() - Read < ResumePageSize)
+				break;
+		}
+		Poco::JSON::Parser P;
+		for (auto &Record : Interrupted) {
+			auto J = std::make_shared<Job>();
+			J->Record = std::move(Record);
+			try {
+				J->Params = P.parse(J->Record.details).extract<Poco::JSON::Object::Ptr>();
+			} catch (const Poco::Exception &E) {
+				Logger().log(E);
+				J->Params = new Poco::JSON::Object;
+				J->Cancelled = true;
+			}
+			J->Waiting.assign(J->Record.devices.size(), false);
+			Settle(*J);
+			while (J->Next < J->Record.devices.size() &&
+				   J->Record.devices[J->Next].status != QUEUED)
+				J->Next++;
+			Jobs_[J->Record.id] = J;
+		}
+		poco_information(Logger(), fmt::format("{} bulk commands resumed.", Jobs_.size()));
+
+		Running_ = true;
+		Worker_.start(*this);
+		return 0;
+	}
+
+	//	The answers to the devices sent the command before the restart never reach this job, so
+	//	each takes the status of its command in the command list. A command still waiting for
+	//	its answer lost it with the restart and is marked failed.
+	void BulkCommandManager::Settle(Job &J) {
+		auto Executed = StorageService()->to_string(Storage::CommandExecutionType::COMMAND_EXECUTED);
+		for (auto &Device : J.Record.devices) {
+			if (Device.status != Executed)
+				continue;
+			GWObjects::CommandDetails Cmd;
+			if (!Device.UUID.empty() && StorageService()->GetCommand(Device.UUID, Cmd) &&
+				Cmd.UUID == Device.UUID && Cmd.Status != Executed) {
+				Device.status = Cmd.Status;
+				Device.errorCode = Cmd.ErrorCode;
+				Device.errorText = Cmd.ErrorText;
+			} else {
+				Device.status =
+					StorageService()->to_string(Storage::CommandExecutionType::COMMAND_FAILED);
+				Device.errorText = "No answer before the gateway restarted.";
+			}
+		}
+	}
+
+	void BulkCommandManager::Stop() {
+		poco_notice(Logger(), "Stopping...");
+		Running_ = false;
+		Worker_.wakeUp();
+		Worker_.join();
+		std::lock_guard G(Mutex_);
+		for (auto &[Id, J] : Jobs_)
+			StorageService()->BulkCommandDB().UpdateRecord("id", Id, J->Record);
+		Jobs_.clear();
+		poco_notice(Logger(), "Stopped...");
+	}
+
+	bool BulkCommandManager::Submit(GWObjects::BulkCommand &Job) {
+		auto J = std::make_shared<BulkCommandManager::Job>();
+		try {
+			Poco::JSON::Parser P;
+			J->Params = P.parse(Job.details).extract<Poco::JSON::Object::Ptr>();
+		} catch (const Poco::Exception &E) {
+			Logger().log(E);
+			return false;
+		}
+
+		Job.id = MicroServiceCreateUUID();
+		Job.created = Utils::Now();
+		Job.completed = 0;
+		Job.status = RUNNING;
+		for (auto &Device : Job.devices)
+			Device.status = QUEUED;
+		if (!StorageService()->BulkCommandDB().CreateRecord(Job))
+			return false;
+
+		J->Record = Job;
+		J->Waiting.assign(Job.devices.size(), false);
+		poco_information(Logger(), fmt::format("{}: {} for {} devices submitted by {}.", Job.id,
+											   Job.command, Job.devices.size(), Job.submittedBy));
+		std::lock_guard G(Mutex_);
+		Jobs_[Job.id] = J;
+		Worker_.wakeUp();
+		return true;
+	}
+
+	bool BulkCommandManager::Cancel(const std::string &Id) {
+		std::lock_guard G(Mutex_);
+		auto Hint = Jobs_.find(Id);
+		if (Hint == Jobs_.end())
+			return false;
+		auto &J = *Hint->second;
+		J.Cancelled = true;
+		for (; J.Next < J.Record.devices.size(); J.Next++)
+			J.Record.devices[J.Next].status = CANCELLED;
+		J.Changed = true;
+		poco_information(Logger(), fmt::format("{}: cancelled.", Id));
+		Worker_.wakeUp();
+		return true;
+	}
+
+	bool BulkCommandManager::GetJob(const std::string &Id, GWObjects::BulkCommand &Job) {
+		{
+			std::lock_guard G(Mutex_);
+			auto Hint = Jobs_.find(Id);
+			if (Hint != Jobs_.end()) {
+				Job = Hint->second->Record;
+				return true;
+			}
+		}
+		return StorageService()->BulkCommandDB().GetRecord("id", Id, Job);
+	}
+
+	void BulkCommandManager::GetJobs(std::uint64_t Offset, std::uint64_t Limit,
+									 std::vector<GWObjects::BulkCommand> &Jobs) {
+		StorageService()->BulkCommandDB().GetRecords(Offset, Limit, Jobs, "", " ORDER BY created DESC ");
+		std::lock_guard G(Mutex_);
+		for (auto &Job : Jobs) {
+			auto Hint = Jobs_.find(Job.id);
+			if (Hint != Jobs_.end())
+				Job = Hint->second->Record;
+		}
+	}
+
+	void BulkCommandManager::run() {
+		Utils::SetThreadName("bulk:cmds");
+		while (Running_) {
+			Poco::Thread::trySleep(100);
+			if (!Running_)
+				break;
+
+			//	pick the devices to send to, within each job's concurrency and rate
+			std::vector<std::pair<std::shared_ptr<Job>, std::size_t>> ToSend;
+			std::vector<GWObjects::BulkCommand> ToSave;
+			{
+				std::lock_guard G(Mutex_);
+				auto Now = std::chrono::steady_clock::now();
+				for (auto &[Id, J] : Jobs_) {
+					std::chrono::duration<double> Elapsed = Now - J->LastRefill;
+					J->LastRefill = Now;
+					J->Tokens = std::min<double>(J->Tokens + J->Record.rate * Elapsed.count(),
+												 std::max<double>(1.0, J->Record.rate / 10.0));
+					auto Picked = ToSend.size();
+					while (!J->Cancelled && J->Next < J->Record.devices.size() &&
+						   J->InFlight < J->Record.concurrency && J->Tokens >= 1.0) {
+						J->Tokens -= 1.0;
+						J->InFlight++;
+						J->Waiting[J->Next] = true;
+						auto &Device = J->Record.devices[J->Next];
+						Device.UUID = MicroServiceCreateUUID();
+						Device.status = StorageService()->to_string(
+							Storage::CommandExecutionType::COMMAND_EXECUTED);
+						J->Changed = true;
+						ToSend.emplace_back(J, J->Next++);
+					}
+					if (ToSend.size() > Picked)
+						ToSave.push_back(J->Record);
+				}
+			}
+
+			//	The devices are saved as sent before their commands go out, so a restart never
+			//	sends them again. Their answers are found in the command list by UUID.
+			std::set<std::string> Unsaved;
+			for (const auto &Record : ToSave) {
+				if (!StorageService()->BulkCommandDB().UpdateRecord("id", Record.id, Record))
+					Unsaved.insert(Record.id);
+			}
+
+			for (const auto &[J, Index] : ToSend) {
+				if (Unsaved.find(J->Record.id) != Unsaved.end()) {
+					DeviceFailed(J->Record.id, Index, "Could not save the bulk command.");
+					continue;
+				}
+				try {
+					Send(J, Index);
+				} catch (const Poco::Exception &E) {
+					Logger().log(E);
+					DeviceFailed(J->Record.id, Index, E.displayText());
+				} catch (...) {
+					poco_warning(Logger(), "Exception while sending a bulk command.");
+					DeviceFailed(J->Record.id, Index, "Internal error.");
+				}
+			}
+
+			std::lock_guard G(Mutex_);
+			for (auto Hint = Jobs_.begin(); Hint != Jobs_.end();) {
+				auto &J = *Hint->second;
+				bool Finished = J.InFlight == 0 && J.Next == J.Record.devices.size();
+				Progress(J, Finished);
+				if (Finished) {
+					poco_information(Logger(), fmt::format("{}: {}.", J.Record.id, J.Record.status));
+					Hint = Jobs_.erase(Hint);
+				} else {
+					++Hint;
+				}
+			}
+		}
+	}
+
+	//	Sends the job's command to one device. Mutex_ must not be held: this writes to the
+	//	database, and the answer may come back on another thread before it returns.
+	void BulkCommandManager::Send(const std::shared_ptr<Job> &J, std::size_t Index) {
+		GWObjects::CommandDetails Cmd;
+		Poco::JSON::Object Params(*J->Params);
+		{
+			std::lock_guard G(Mutex_);
+			Cmd.SerialNumber = J->Record.devices[Index].serialNumber;
+			Cmd.UUID = J->Record.devices[Index].UUID;
+		}
+		Cmd.SubmittedBy = J->Record.submittedBy;
+		Cmd.Command = J->Record.command;
+		Cmd.Submitted = Utils::Now();
+		Cmd.RunAt = Params.has(uCentralProtocol::WHEN)
+						? Params.getValue<std::uint64_t>(uCentralProtocol::WHEN)
+						: 0;
+		Params.set(uCentralProtocol::SERIAL, Cmd.SerialNumber);
+
+		auto Command = APCommands::to_apcommand(Cmd.Command.c_str());
+		bool RetryLater = Command == APCommands::Commands::upgrade ||
+						  Command == APCommands::Commands::factory;
+		auto SerialNumberInt = Utils::SerialNumberToInt(Cmd.SerialNumber);
+		GWObjects::DeviceRestrictions Restrictions;
+		bool Connected = AP_WS_Server()->Connected(SerialNumberInt, Restrictions);
+
+		auto Record = [&](Storage::CommandExecutionType Status, const std::string &ErrorText) {
+			Cmd.ErrorText = ErrorText;
+			std::stringstream ParamStream;
+			Params.stringify(ParamStream);
+			Cmd.Details = ParamStream.str();
+			StorageService()->AddCommand(Cmd.SerialNumber, Cmd, Status);
+			DeviceDone(J->Record.id, Index, Cmd);
+		};
+
+		if (!SerialNumberCache()->NumberExists(SerialNumberInt)) {
+			Cmd.Status = StorageService()->to_string(Storage::CommandExecutionType::COMMAND_FAILED);
+			Cmd.ErrorText = "Unknown device.";
+			return DeviceDone(J->Record.id, Index, Cmd);
+		}
+
+		if (Command == APCommands::Commands::upgrade && !Params.has(uCentralProtocol::SIGNATURE)) {
+			GWObjects::Device DeviceInfo;
+			if (StorageService()->GetDevice(Cmd.SerialNumber, DeviceInfo) &&
+				DeviceInfo.restrictionDetails.upgrade) {
+				Poco::URI uri(Params.get(uCentralProtocol::URI).toString());
+				auto FWSignature = SignatureManager()->Sign(DeviceInfo.restrictionDetails, uri);
+				if (FWSignature.empty() && !Restrictions.developer)
+					return Record(Storage::CommandExecutionType::COMMAND_FAILED,
+								  RESTAPI::Errors::DeviceRequiresSignature.err_txt);
+				if (!FWSignature.empty())
+					Params.set(uCentralProtocol::SIGNATURE, FWSignature);
+			}
+		}
+
+		if (Cmd.RunAt || !Connected) {
+			return Record(Cmd.RunAt || RetryLater ? Storage::CommandExecutionType::COMMAND_PENDING
+												  : Storage::CommandExecutionType::COMMAND_FAILED,
+						  Cmd.RunAt ? "" : "Device is not connected.");
+		}
+
+		std::string RunningUUID;
+		APCommands::Commands RunningCommand;
+		if (CommandManager()->CommandRunningForDevice(SerialNumberInt, RunningUUID,
+													  RunningCommand)) {
+			return Record(RetryLater ? Storage::CommandExecutionType::COMMAND_PENDING
+									 : Storage::CommandExecutionType::COMMAND_FAILED,
+						  RESTAPI::Errors::DeviceIsAlreadyBusy.err_txt);
+		}
+
+		std::stringstream ParamStream;
+		Params.stringify(ParamStream);
+		Cmd.Details = ParamStream.str();
+		auto Id = J->Record.id;
+		if (!RESTAPI_RPC::SendCommand(CommandManager()->Next_RPC_ID(), Command, RetryLater, Cmd,
+									  Params, Timeout_, Logger(), false,
+									  [this, Id, Index](const GWObjects::CommandDetails &C) {
+										  DeviceDone(Id, Index, C);
+									  })) {
+			return Record(RetryLater ? Storage::CommandExecutionType::COMMAND_PENDING
+									 : Storage::CommandExecutionType::COMMAND_FAILED,
+						  "Device is not connected.");
+		}
+	}
+
+	void BulkCommandManager::DeviceDone(const std::string &Id, std::size_t Index,
+										const GWObjects::CommandDetails &Cmd) {
+		std::lock_guard G(Mutex_);
+		auto Hint = Jobs_.find(Id);
+		if (Hint == Jobs_.end())
+			return;
+		auto &J = *Hint->second;
+		if (!J.Waiting[Index])
+			return;
+		J.Waiting[Index] = false;
+		auto &Device = J.Record.devices[Index];
+		Device.status = Cmd.Status;
+		Device.errorCode = Cmd.ErrorCode;
+		Device.errorText = Cmd.ErrorText;
+		J.InFlight--;
+		J.Changed = true;
+		Worker_.wakeUp();
+	}
+
+	void BulkCommandManager::DeviceFailed(const std::string &Id, std::size_t Index,
+										  const std::string &ErrorText) {
+		GWObjects::CommandDetails Cmd;
+		Cmd.Status = StorageService()->to_string(Storage::CommandExecutionType::COMMAND_FAILED);
+		Cmd.ErrorText = ErrorText;
+		DeviceDone(Id, Index, Cmd);
+	}
+
+	//	Tells the submitter how the job progresses, at most once a second, and saves it once
+	//	finished. Mutex_ must be held.
+	void BulkCommandManager::Progress(Job &J, bool Finished) {
+		auto Now = std::chrono::steady_clock::now();
+		if (Finished) {
+			J.Record.status = J.Cancelled ? CANCELLED : "completed";
+			J.Record.completed = Utils::Now();
+		} else if (!J.Changed || Now - J.LastProgress < 1s) {
+			return;
+		}
+
+		GWWebSocketNotifications::BulkCommandProgress_t N;
+		N.content.id = J.Record.id;
+		N.content.command = J.Record.command;
+		N.content.status = J.Record.status;
+		N.content.total = J.Record.devices.size();
+		N.content.sent = J.Next;
+		N.content.outstanding = J.InFlight;
+		GWWebSocketNotifications::BulkCommandProgress(J.Record.submittedBy, N);
+		J.LastProgress = Now;
+		J.Changed = false;
+
+		if (Finished)
+			StorageService()->BulkCommandDB().UpdateRecord("id", J.Record.id, J.Record);
+	}
+
+} // namespace OpenWifi
@@ -0,0 +1,93 @@
+//
+//	License type: BSD 3-Clause License
+//	License copy: https://github.com/Telecominfraproject/wlan-cloud-ucentralgw/blob/master/LICENSE
+//
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Poco/JSON/Object.h"
+#include "Poco/Thread.h"
+
+#include "RESTObjects/RESTAPI_GWobjects.h"
+#include "framework/SubSystemServer.h"
+
+namespace OpenWifi {
+
+	//	Sends one command to many devices. A job is stored once, with the state of each device,
+	//	and its devices are sent the command through the command manager without waiting for
+	//	the answers: at most Concurrency commands are outstanding and at most Rate are sent per
+	//	second. Each device's command is a regular entry of the command list, so its results are
+	//	found there, under the UUID given in the job.
+	class BulkCommandManager : public SubSystemServer, Poco::Runnable {
+	  public:
+		static auto instance() {
+			static auto instance_ = new BulkCommandManager;
+			return instance_;
+		}
+
+		int Start() override;
+		void Stop() override;
+		void run() override;
+
+		//	Job.devices holds the serial numbers; the id and status are set here.
+		bool Submit(GWObjects::BulkCommand &Job);
+		//	Devices not sent the command yet are cancelled. Returns false if the job is not running.
+		bool Cancel(const std::string &Id);
+		//	A running job is returned from memory, a finished one from the database.
+		bool GetJob(const std::string &Id, GWObjects::BulkCommand &Job);
+		void GetJobs(std::uint64_t Offset, std::uint64_t Limit,
+					 std::vector<GWObjects::BulkCommand> &Jobs);
+
+		inline auto MaxDevices() const { return MaxDevices_; }
+		inline auto MaxConcurrency() const { return MaxConcurrency_; }
+		inline auto MaxRate() const { return MaxRate_; }
+
+		static bool SupportedCommand(const std::string &Command);
+
+	  private:
+		struct Job {
+			GWObjects::BulkCommand Record;
+			Poco::JSON::Object::Ptr Params;
+			std::size_t Next = 0;
+			std::uint64_t InFlight = 0;
+			//	devices sent the command and not done yet, each counted once in InFlight
+			std::vector<bool> Waiting;
+			bool Cancelled = false;
+			bool Changed = true;
+			double Tokens = 1.0;
+			std::chrono::steady_clock::time_point LastRefill = std::chrono::steady_clock::now();
+			std::chrono::steady_clock::time_point LastProgress;
+		};
+
+		//	interrupted jobs are read back from the database this many at a time
+		static constexpr std::uint64_t ResumePageSize = 1000;
+
+		std::atomic_bool Running_ = false;
+		Poco::Thread Worker_;
+		std::map<std::string, std::shared_ptr<Job>> Jobs_;
+		std::uint64_t MaxDevices_ = 10000;
+		std::uint64_t MaxConcurrency_ = 100;
+		std::uint64_t MaxRate_ = 50;
+		std::chrono::milliseconds Timeout_{120000};
+
+		void Settle(Job &J);
+		void Send(const std::shared_ptr<Job> &J, std::size_t Index);
+		void DeviceDone(const std::string &Id, std::size_t Index,
+						const GWObjects::CommandDetails &Cmd);
+		void DeviceFailed(const std::string &Id, std::size_t Index, const std::string &ErrorText);
+		void Progress(Job &J, bool Finished);
+
+		BulkCommandManager() noexcept
+			: SubSystemServer("BulkCommandManager", "BULK-CMD", "bulkcommands") {}
+	};
+
+	inline auto BulkCommandManager() { return BulkCommandManager::instance(); }
+
+} // namespace OpenWifi
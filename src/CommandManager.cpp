@@ -21,149 +21,193 @@ using namespace std::chrono_literals;
 
 namespace OpenWifi {
 
-	void CommandManager::run() {
-		Utils::SetThreadName("cmd:mgr");
-		Running_ = true;
-
-		Poco::AutoPtr<Poco::Notification> NextMsg(ResponseQueue_.waitDequeueNotification());
-		while (NextMsg && Running_) {
+	void RPCResponseWorker::run() {
+		Utils::SetThreadName(fmt::format("cmd:rsp:{}", Index_).c_str());
+		Poco::AutoPtr<Poco::Notification> NextMsg(Queue_.waitDequeueNotification());
+		while (NextMsg && CommandManager()->Running()) {
 			auto Resp = dynamic_cast<RPCResponseNotification *>(NextMsg.get());
+			if (Resp != nullptr)
+				CommandManager()->ProcessResponse(Resp->SerialNumber_, Resp->Payload_);
+			NextMsg = Queue_.waitDequeueNotification();
+		}
+	}
 
-			try {
-				if (Resp != nullptr) {
-					Poco::JSON::Object::Ptr Payload = Resp->Payload_;
-					std::string SerialNumberStr = Utils::IntToSerialNumber(Resp->SerialNumber_);
+	void CommandManager::ProcessResponse(std::uint64_t SerialNumber,
+										 const Poco::JSON::Object::Ptr &Payload) {
+		try {
+			std::string SerialNumberStr = Utils::IntToSerialNumber(SerialNumber);
 
-					if (!Payload->has(uCentralProtocol::ID)) {
-						poco_error(Logger(),
-								   fmt::format("({}): Invalid RPC response.", SerialNumberStr));
+			if (!Payload->has(uCentralProtocol::ID)) {
+				poco_error(Logger(), fmt::format("({}): Invalid RPC response.", SerialNumberStr));
+			} else {
+				uint64_t ID = Payload->get(uCentralProtocol::ID);
+				if (ID > 1) {
+					poco_debug(Logger(),
+							   fmt::format("({}): Processing {} response.", SerialNumberStr, ID));
+					std::lock_guard Lock(LocalMutex_);
+					auto RPC = Outstanding_.Find(ID);
+					if (RPC == nullptr) {
+						poco_debug(Logger(), fmt::format("({}): RPC {} cannot be found.",
+														 SerialNumberStr, ID));
+					} else if (RPC->SerialNumber != SerialNumber) {
+						poco_debug(Logger(),
+								   fmt::format("({}): RPC {} serial number mismatch {}!={}.",
+											   SerialNumberStr, ID, RPC->SerialNumber,
+											   SerialNumber));
 					} else {
-						uint64_t ID = Payload->get(uCentralProtocol::ID);
-						if (ID > 1) {
-							poco_debug(Logger(), fmt::format("({}): Processing {} response.",
-															 SerialNumberStr, ID));
-							std::lock_guard Lock(LocalMutex_);
-							auto RPC = OutStandingRequests_.find(ID);
-							if (RPC == OutStandingRequests_.end()) {
-								//								std::cout << __LINE__ << std::endl;
-								poco_debug(Logger(), fmt::format("({}): RPC {} cannot be found.",
-																 SerialNumberStr, ID));
-							} else if (RPC->second.SerialNumber != Resp->SerialNumber_) {
-								//								std::cout << __LINE__ << std::endl;
-								poco_debug(
-									Logger(),
-									fmt::format("({}): RPC {} serial number mismatch {}!={}.",
-												SerialNumberStr, ID, RPC->second.SerialNumber,
-												Resp->SerialNumber_));
-							} else {
-								std::shared_ptr<promise_type_t> TmpRpcEntry;
-								std::chrono::duration<double, std::milli> rpc_execution_time =
-									std::chrono::high_resolution_clock::now() -
-									RPC->second.submitted;
-								//								std::cout << __LINE__ << std::endl;
-								poco_debug(Logger(),
-										   fmt::format("({}): Received RPC answer {}. Command={}",
-													   SerialNumberStr, ID,
-													   APCommands::to_string(RPC->second.Command)));
-								if (RPC->second.Command == APCommands::Commands::script) {
-									CompleteScriptCommand(RPC->second, Payload, rpc_execution_time);
-								} else if (RPC->second.Command == APCommands::Commands::telemetry) {
-									CompleteTelemetryCommand(RPC->second, Payload,
-															 rpc_execution_time);
-								} else if (RPC->second.Command == APCommands::Commands::configure && RPC->second.rpc_entry==nullptr) {
-									CompleteConfigureCommand(RPC->second, Payload,
-															 rpc_execution_time);
-								} else {
-									StorageService()->CommandCompleted(RPC->second.UUID, Payload,
-																	   rpc_execution_time, true);
-									if (RPC->second.rpc_entry) {
-										TmpRpcEntry = RPC->second.rpc_entry;
-									}
-									RPC->second.State = 0;
-									OutStandingRequests_.erase(ID);
-									if (TmpRpcEntry != nullptr)
-										TmpRpcEntry->set_value(Payload);
-								}
-							}
+						std::chrono::duration<double, std::milli> rpc_execution_time =
+							std::chrono::high_resolution_clock::now() - RPC->submitted;
+						poco_debug(Logger(),
+								   fmt::format("({}): Received RPC answer {}. Command={}",
+											   SerialNumberStr, ID,
+											   APCommands::to_string(RPC->Command)));
+						if (RPC->Command == APCommands::Commands::script) {
+							CompleteScriptCommand(*RPC, Payload, rpc_execution_time);
+						} else if (RPC->Command == APCommands::Commands::telemetry) {
+							CompleteTelemetryCommand(*RPC, Payload, rpc_execution_time);
+						} else if (RPC->Command == APCommands::Commands::configure &&
+								   RPC->rpc_entry == nullptr) {
+							CompleteConfigureCommand(*RPC, Payload, rpc_execution_time);
+						} else {
+							auto TmpRpcEntry = RPC->rpc_entry;
+							auto Completion = TakeCompletion(*RPC);
+							auto UUID = RPC->UUID;
+							EraseOutstanding(ID);
+							if (!Deliver(TmpRpcEntry, std::move(Completion), Payload))
+								PersistResult(UUID, Payload, rpc_execution_time);
 						}
 					}
 				}
-			} catch (const Poco::Exception &E) {
-				Logger().log(E);
-			} catch (...) {
-				poco_warning(Logger(), "Exception occurred during run.");
 			}
-			NextMsg = ResponseQueue_.waitDequeueNotification();
+		} catch (const Poco::Exception &E) {
+			Logger().log(E);
+		} catch (...) {
+			poco_warning(Logger(), "Exception occurred during run.");
 		}
-		poco_information(Logger(), "RPC Command processor stopping.");
+		//	the device may now take its next queued command
+		ReadyToDispatch(SerialNumber);
 	}
 
-	bool CommandManager::CompleteTelemetryCommand(
-		CommandInfo &Command, [[maybe_unused]] const Poco::JSON::Object::Ptr &Payload,
-		std::chrono::duration<double, std::milli> rpc_execution_time) {
-		std::shared_ptr<promise_type_t> TmpRpcEntry;
+	//	Results handed to a waiting REST request are not queued: the request stores the whole
+	//	command itself once it has the answer.
+	void CommandManager::PersistResult(const std::string &UUID,
+									   const Poco::JSON::Object::Ptr &Payload,
+									   std::chrono::duration<double, std::milli> rpc_execution_time) {
+		ResultQueue_.enqueueNotification(new CommandResultNotification(
+			Storage::MakeCommandResult(UUID, Payload, rpc_execution_time, true)));
+	}
 
-		StorageService()->CommandCompleted(Command.UUID, Payload, rpc_execution_time, true);
+	void CommandManager::PersistAction(std::function<void()> Action) {
+		ResultQueue_.enqueueNotification(new CommandResultNotification(std::move(Action)));
+	}
 
-		if (Command.rpc_entry) {
-			TmpRpcEntry = Command.rpc_entry;
+	//	Hands an answer to the REST request waiting for it, either blocked on its promise or
+	//	asynchronous. Returns false if no request waits for it.
+	bool CommandManager::Deliver(const std::shared_ptr<promise_type_t> &Promise,
+								 completion_t Completion, const objtype_t &Payload) {
+		if (Promise != nullptr) {
+			Promise->set_value(Payload);
+			return true;
+		}
+		if (Completion) {
+			PersistAction([Completion, Payload]() { Completion(Payload); });
+			return true;
 		}
-		Command.State = 0;
+		return false;
+	}
 
-		OutStandingRequests_.erase(Command.Id);
-		if (TmpRpcEntry != nullptr)
-			TmpRpcEntry->set_value(Payload);
-		return true;
+	//	Writes command results in the order they were queued. Consecutive results go to the
+	//	database as one batch; actions queued between them run in place.
+	void CommandManager::run() {
+		Utils::SetThreadName("cmd:results");
+
+		std::vector<Storage::CommandResult> Batch;
+		auto Flush = [&]() {
+			if (Batch.empty())
+				return;
+			StorageService()->CommandsCompleted(Batch);
+			Batch.clear();
+		};
+
+		while (true) {
+			Poco::AutoPtr<Poco::Notification> NextMsg(ResultQueue_.waitDequeueNotification(1000));
+			if (!NextMsg) {
+				if (!WriterRunning_)
+					break;
+				continue;
+			}
+			while (NextMsg) {
+				auto Item = dynamic_cast<CommandResultNotification *>(NextMsg.get());
+				try {
+					if (Item != nullptr && Item->Action_) {
+						Flush();
+						Item->Action_();
+					} else if (Item != nullptr) {
+						Batch.emplace_back(std::move(Item->Result_));
+						if (Batch.size() >= MaxResultBatch)
+							Flush();
+					}
+				} catch (const Poco::Exception &E) {
+					Logger().log(E);
+				} catch (...) {
+					poco_warning(Logger(), "Exception occurred while writing command results.");
+				}
+				NextMsg = ResultQueue_.dequeueNotification();
+			}
+			Flush();
+		}
+		poco_information(Logger(), "RPC result writer stopping.");
 	}
 
-	bool CommandManager::CompleteConfigureCommand(
+	bool CommandManager::CompleteTelemetryCommand(
 		CommandInfo &Command, [[maybe_unused]] const Poco::JSON::Object::Ptr &Payload,
 		std::chrono::duration<double, std::milli> rpc_execution_time) {
-		std::shared_ptr<promise_type_t> TmpRpcEntry;
+		auto TmpRpcEntry = Command.rpc_entry;
+		auto Completion = TakeCompletion(Command);
+		auto UUID = Command.UUID;
 
-		if (Command.rpc_entry) {
-			TmpRpcEntry = Command.rpc_entry;
-		}
+		EraseOutstanding(Command.Id);
+		if (!Deliver(TmpRpcEntry, std::move(Completion), Payload))
+			PersistResult(UUID, Payload, rpc_execution_time);
+		return true;
+	}
 
-		StorageService()->CommandCompleted(Command.UUID, Payload, rpc_execution_time, true);
+	bool CommandManager::CompleteConfigureCommand(
+		CommandInfo &Command, [[maybe_unused]] const Poco::JSON::Object::Ptr &Payload,
+		std::chrono::duration<double, std::milli> rpc_execution_time) {
+		auto TmpRpcEntry = Command.rpc_entry;
+		auto Completion = TakeCompletion(Command);
+		auto UUID = Command.UUID;
 
+		EraseOutstanding(Command.Id);
+		if (!Deliver(TmpRpcEntry, std::move(Completion), Payload))
+			PersistResult(UUID, Payload, rpc_execution_time);
 		if (Payload->has("result")) {
 			auto Result = Payload->getObject("result");
 			if (Result->has("status") && Result->has("serial")) {
 				auto Status = Result->getObject("status");
 				auto SerialNumber = Result->get("serial").toString();
 				std::uint64_t Error = Status->get("error");
-				if (Error == 2) {
-					StorageService()->RollbackDeviceConfigurationChange(SerialNumber);
-				} else {
-					StorageService()->CompleteDeviceConfigurationChange(SerialNumber);
-				}
+				PersistAction([SerialNumber, Error]() mutable {
+					if (Error == 2) {
+						StorageService()->RollbackDeviceConfigurationChange(SerialNumber);
+					} else {
+						StorageService()->CompleteDeviceConfigurationChange(SerialNumber);
+					}
+				});
 			}
-		} else {
-			//				std::cout << __LINE__ << std::endl;
 		}
-		Command.State = 0;
-
-		if (Command.rpc_entry) {
-			TmpRpcEntry = Command.rpc_entry;
-		}
-
-		OutStandingRequests_.erase(Command.Id);
-		if (TmpRpcEntry != nullptr)
-			TmpRpcEntry->set_value(Payload);
 		return true;
 	}
 
 	bool CommandManager::CompleteScriptCommand(
 		CommandInfo &Command, const Poco::JSON::Object::Ptr &Payload,
 		std::chrono::duration<double, std::milli> rpc_execution_time) {
-		bool Reply = true;
-		std::shared_ptr<promise_type_t> TmpRpcEntry;
+		bool Reply = true, Persist = false, Cancel = false;
+		std::string ErrorTxt;
+		auto TmpRpcEntry = Command.rpc_entry;
+		auto UUID = Command.UUID;
 
-		if (Command.rpc_entry) {
-			TmpRpcEntry = Command.rpc_entry;
-		}
-		//		std::cout << __LINE__ << "  State=" << Command.State << std::endl;
 		if (Command.State == 2) {
 			//	 look at the payload to see if we should continue or not...
 			if (Payload->has("result")) {
@@ -172,42 +216,37 @@ namespace OpenWifi {
 					auto Status = Result->getObject("status");
 
 					std::uint64_t Error = Status->get("error");
+					Persist = true;
 					if (Error == 0) {
-						//						std::cout << __LINE__ << std::endl;
-						StorageService()->CommandCompleted(Command.UUID, Payload,
-														   rpc_execution_time, true);
 						Command.State = 1;
 					} else {
-						//						std::cout << __LINE__ << std::endl;
-						StorageService()->CommandCompleted(Command.UUID, Payload,
-														   rpc_execution_time, true);
-						std::string ErrorTxt = Status->get("result");
-						StorageService()->CancelWaitFile(Command.UUID, ErrorTxt);
+						ErrorTxt = Status->get("result").toString();
+						Cancel = true;
 						Command.State = 0;
 					}
-				} else {
-					//					std::cout << __LINE__ << std::endl;
 				}
 			} else {
-				//				std::cout << __LINE__ << std::endl;
 				Command.State = 0;
 			}
 		} else if (Command.State == 1) {
-			//			std::cout << "Completing script 2 phase commit." << std::endl;
-			StorageService()->CommandCompleted(Command.UUID, Payload, rpc_execution_time, true);
+			Persist = true;
 			if (Command.Deferred) {
 				Reply = false;
 			}
 			Command.State = 0;
 		}
 
+		auto Completion = Reply ? TakeCompletion(Command) : completion_t{};
 		if (Command.State == 0) {
-			//			std::cout << __LINE__ << "  State=" << Command.State << std::endl;
-			OutStandingRequests_.erase(Command.Id);
+			EraseOutstanding(Command.Id);
 		}
-		if (Reply && TmpRpcEntry != nullptr)
-			TmpRpcEntry->set_value(Payload);
-
+		bool Delivered = Reply && Deliver(TmpRpcEntry, std::move(Completion), Payload);
+		if (!Delivered && Persist)
+			PersistResult(UUID, Payload, rpc_execution_time);
+		if (Cancel)
+			PersistAction([UUID, ErrorTxt]() mutable {
+				StorageService()->CancelWaitFile(UUID, ErrorTxt);
+			});
 		return true;
 	}
 
@@ -219,7 +258,20 @@ namespace OpenWifi {
 		janitorInterval_ = MicroServiceConfigGetInt("command.janitor", 2 * 60); //	1 hour
 		queueInterval_ = MicroServiceConfigGetInt("command.queue", 30);
 
+		std::vector<GWObjects::CommandDetails> Pending;
+		StorageService()->GetPendingCommands(Pending);
+		for (const auto &Cmd : Pending)
+			QueueCommand(Cmd);
+		poco_information(Logger(), fmt::format("{} pending commands.", Pending.size()));
+
+		Running_ = WriterRunning_ = true;
+		auto Workers = std::max<std::uint64_t>(1, MicroServiceConfigGetInt("command.workers", 4));
+		for (std::uint64_t i = 0; i < Workers; i++) {
+			ResponseWorkers_.push_back(std::make_unique<RPCResponseWorker>(i));
+			ResponseWorkers_.back()->Thread_.start(*ResponseWorkers_.back());
+		}
 		ManagerThread.start(*this);
+		DispatchThread_.start(Dispatcher_);
 
 		JanitorCallback_ = std::make_unique<Poco::TimerCallback<CommandManager>>(
 			*this, &CommandManager::onJanitorTimer);
@@ -233,6 +285,12 @@ namespace OpenWifi {
 		CommandRunnerTimer_.setPeriodicInterval(queueInterval_ * 1000); // 1 hours
 		CommandRunnerTimer_.start(*CommandRunnerCallback_, MicroServiceTimerPool());
 
+		DeadlineCallback_ = std::make_unique<Poco::TimerCallback<CommandManager>>(
+			*this, &CommandManager::onDeadlineTimer);
+		DeadlineTimer_.setStartInterval(1000);
+		DeadlineTimer_.setPeriodicInterval(1000);
+		DeadlineTimer_.start(*DeadlineCallback_, MicroServiceTimerPool());
+
 		return 0;
 	}
 
@@ -241,8 +299,16 @@ namespace OpenWifi {
 		Running_ = false;
 		JanitorTimer_.stop();
 		CommandRunnerTimer_.stop();
-		ResponseQueue_.wakeUpAll();
-		ManagerThread.wakeUp();
+		DeadlineTimer_.stop();
+		for (auto &Worker : ResponseWorkers_)
+			Worker->Queue_.wakeUpAll();
+		for (auto &Worker : ResponseWorkers_)
+			Worker->Thread_.join();
+		DispatchQueue_.wakeUpAll();
+		DispatchThread_.join();
+		//	the writer leaves once the results queued so far are written
+		WriterRunning_ = false;
+		ResultQueue_.wakeUpAll();
 		ManagerThread.join();
 		poco_notice(Logger(), "Stopped...");
 	}
@@ -253,42 +319,69 @@ namespace OpenWifi {
 	}
 
 	void CommandManager::onJanitorTimer([[maybe_unused]] Poco::Timer &timer) {
-		std::lock_guard Lock(LocalMutex_);
 		Utils::SetThreadName("cmd:janitor");
 		Poco::Logger &MyLogger = Poco::Logger::get("CMD-MGR-JANITOR");
 		std::string TimeOutError("No response.");
 
-		auto now = std::chrono::high_resolution_clock::now();
-		for (auto request = OutStandingRequests_.begin(); request != OutStandingRequests_.end();) {
-			std::chrono::duration<double, std::milli> delta = now - request->second.submitted;
-			if (delta > 10min) {
-				//				std::cout << __LINE__ << "  -->> " << request->second.Id <<
-				// std::endl;
-				MyLogger.debug(fmt::format("{}: Command={} for {} Timed out.", request->second.UUID,
-										   APCommands::to_string(request->second.Command),
-										   Utils::IntToSerialNumber(request->second.SerialNumber)));
-				if ((request->second.Command == APCommands::Commands::script &&
-					 request->second.Deferred) ||
-					(request->second.Command == APCommands::Commands::trace)) {
-					StorageService()->CancelWaitFile(request->second.UUID, TimeOutError);
-				}
-				StorageService()->SetCommandTimedOut(request->second.UUID);
-				request = OutStandingRequests_.erase(request);
-			} else {
-				//				std::cout << __LINE__ << "  -->> " << request->second.Id <<
-				// std::endl;
-				++request;
+		//	only the requests submitted before the cutoff are visited
+		std::vector<CommandInfo> TimedOut;
+		std::size_t Outstanding;
+		{
+			std::lock_guard Lock(LocalMutex_);
+			auto Cutoff = std::chrono::high_resolution_clock::now() - 10min;
+			while (auto Request = Outstanding_.OldestSubmittedBefore(Cutoff)) {
+				TimedOut.push_back(*Request);
+				EraseOutstanding(Request->Id);
+			}
+			Outstanding = Outstanding_.Size();
+		}
+
+		for (auto &request : TimedOut) {
+			MyLogger.debug(fmt::format("{}: Command={} for {} Timed out.", request.UUID,
+									   APCommands::to_string(request.Command),
+									   Utils::IntToSerialNumber(request.SerialNumber)));
+			if ((request.Command == APCommands::Commands::script && request.Deferred) ||
+				(request.Command == APCommands::Commands::trace)) {
+				StorageService()->CancelWaitFile(request.UUID, TimeOutError);
 			}
+			StorageService()->SetCommandTimedOut(request.UUID);
+			ReadyToDispatch(request.SerialNumber);
 		}
-		poco_information(MyLogger,
-						 fmt::format("Outstanding-requests {}", OutStandingRequests_.size()));
+		poco_information(MyLogger, fmt::format("Outstanding-requests {}", Outstanding));
+	}
+
+	void CommandManager::onDeadlineTimer([[maybe_unused]] Poco::Timer &timer) {
+		std::lock_guard Lock(LocalMutex_);
+		auto Now = std::chrono::high_resolution_clock::now();
+		while (auto Request = Outstanding_.FirstDeadlineAtOrBefore(Now))
+			EraseOutstanding(Request->Id);
 	}
 
 	bool CommandManager::IsCommandRunning(const std::string &C) {
 		std::lock_guard Lock(LocalMutex_);
-		return std::any_of(
-			OutStandingRequests_.begin(), OutStandingRequests_.end(),
-			[C](const std::pair<std::uint64_t, CommandInfo> &r) { return r.second.UUID == C; });
+		return Outstanding_.FindUUID(C) != nullptr;
+	}
+
+	//	LocalMutex_ must be held.
+	void CommandManager::AddOutstanding(const CommandInfo &Command) {
+		EraseOutstanding(Command.Id);
+		Outstanding_.Add(Command, Command.Completion != nullptr);
+	}
+
+	//	LocalMutex_ must be held.
+	CommandManager::completion_t CommandManager::TakeCompletion(CommandInfo &Command) {
+		Outstanding_.ClearDeadline(Command);
+		return std::exchange(Command.Completion, nullptr);
+	}
+
+	//	LocalMutex_ must be held.
+	void CommandManager::EraseOutstanding(std::uint64_t Id) {
+		CommandInfo Command;
+		if (!Outstanding_.Erase(Id, &Command))
+			return;
+		//	an asynchronous request dropped before its answer came
+		if (auto Completion = std::move(Command.Completion))
+			PersistAction([Completion]() { Completion(nullptr); });
 	}
 
 	void CommandManager::onCommandRunnerTimer([[maybe_unused]] Poco::Timer &timer) {
@@ -302,111 +395,33 @@ namespace OpenWifi {
 			StorageService()->RemovedExpiredCommands();
 			StorageService()->RemoveTimedOutCommands();
 
-			std::uint64_t offset = 0;
-			bool Done = false;
-			while (!Done) {
-				std::vector<GWObjects::CommandDetails> Commands;
-				if (StorageService()->GetReadyToExecuteCommands(offset, 200, Commands)) {
-					if(Commands.empty()) {
-						Done=true;
-						continue;
+			//	The commands themselves are sent by the dispatcher as events come in. This only
+			//	forgets the commands the queries above expired, and looks again at every device
+			//	in case an event was missed.
+			auto Window = Utils::Now() - commandTimeOut_;
+			std::vector<std::uint64_t> SerialNumbers;
+			{
+				std::lock_guard Lock(QueueMutex_);
+				for (auto Device = Queued_.begin(); Device != Queued_.end();) {
+					auto &Commands = Device->second;
+					for (auto Cmd = Commands.begin(); Cmd != Commands.end();) {
+						if (Cmd->second.Submitted < Window)
+							Cmd = Commands.erase(Cmd);
+						else
+							++Cmd;
 					}
-					poco_trace(MyLogger, fmt::format("Scheduler about to process {} commands.",
-													 Commands.size()));
-					for (auto &Cmd : Commands) {
-						if (!Running_) {
-							poco_warning(MyLogger,
-										 "Scheduler quitting because service is stopping.");
-							break;
-						}
-						poco_trace(MyLogger,
-								   fmt::format("{}: Serial={} Command={} Starting processing.",
-											   Cmd.UUID, Cmd.SerialNumber, Cmd.Command));
-						try {
-
-							//	Skip an already running command
-							if (IsCommandRunning(Cmd.UUID)) {
-								continue;
-							}
-
-							auto now = Utils::Now();
-							// 2 hour timeout for commands
-							if ((now - Cmd.Submitted) > commandTimeOut_) {
-								poco_information(
-									MyLogger, fmt::format("{}: Serial={} Command={} has expired.",
-														  Cmd.UUID, Cmd.SerialNumber, Cmd.Command));
-								StorageService()->SetCommandTimedOut(Cmd.UUID);
-								continue;
-							}
-
-							auto SerialNumberInt = Utils::SerialNumberToInt(Cmd.SerialNumber);
-							if (!AP_WS_Server()->Connected(SerialNumberInt)) {
-								poco_trace(
-									MyLogger,
-									fmt::format("{}: Serial={} Command={} Device is not connected.",
-												Cmd.UUID, Cmd.SerialNumber, Cmd.Command));
-								StorageService()->SetCommandLastTry(Cmd.UUID);
-								continue;
-							}
-
-							std::string ExecutingUUID;
-							APCommands::Commands ExecutingCommand = APCommands::Commands::unknown;
-							if (CommandRunningForDevice(SerialNumberInt, ExecutingUUID,
-														ExecutingCommand)) {
-								poco_trace(
-									MyLogger,
-									fmt::format("{}: Serial={} Command={} Device is already busy "
-												"with command {} (Command={}).",
-												Cmd.UUID, Cmd.SerialNumber, Cmd.Command,
-												ExecutingUUID,
-												APCommands::to_string(ExecutingCommand)));
-								continue;
-							}
-
-							Poco::JSON::Parser P;
-							bool Sent;
-							poco_information(
-								MyLogger,
-								fmt::format("{}: Serial={} Command={} Preparing execution.",
-											Cmd.UUID, Cmd.SerialNumber, Cmd.Command));
-							auto Params = P.parse(Cmd.Details).extract<Poco::JSON::Object::Ptr>();
-							auto Result = PostCommandDisk(
-								Next_RPC_ID(), APCommands::to_apcommand(Cmd.Command.c_str()),
-								Cmd.SerialNumber, Cmd.Command, *Params, Cmd.UUID, Sent);
-							if (Sent) {
-								StorageService()->SetCommandExecuted(Cmd.UUID);
-								poco_debug(MyLogger,
-										   fmt::format("{}: Serial={} Command={} Sent.", Cmd.UUID,
-													   Cmd.SerialNumber, Cmd.Command));
-							} else {
-								poco_debug(
-									MyLogger,
-									fmt::format("{}: Serial={} Command={} Re-queued command.",
-												Cmd.UUID, Cmd.SerialNumber, Cmd.Command));
-								StorageService()->SetCommandLastTry(Cmd.UUID);
-							}
-						} catch (const Poco::Exception &E) {
-							poco_debug(
-								MyLogger,
-								fmt::format(
-									"{}: Serial={} Command={} Failed. Command marked as completed.",
-									Cmd.UUID, Cmd.SerialNumber, Cmd.Command));
-							MyLogger.log(E);
-							StorageService()->SetCommandExecuted(Cmd.UUID);
-						} catch (...) {
-							poco_debug(MyLogger,
-									   fmt::format("{}: Serial={} Command={} Hard failure. "
-												   "Command marked as completed.",
-												   Cmd.UUID, Cmd.SerialNumber, Cmd.Command));
-							StorageService()->SetCommandExecuted(Cmd.UUID);
-						}
+					if (Commands.empty()) {
+						Device = Queued_.erase(Device);
+					} else {
+						SerialNumbers.push_back(Device->first);
+						++Device;
 					}
-					offset += Commands.size();
-				} else {
-					Done=true;
-					continue;
 				}
 			}
+			for (const auto SerialNumber : SerialNumbers)
+				ReadyToDispatch(SerialNumber);
+			poco_trace(MyLogger,
+					   fmt::format("Scheduler found {} devices with commands.", SerialNumbers.size()));
 		}
 		catch (Poco::Exception &E) {
 			MyLogger.log(E);
@@ -417,10 +432,233 @@ namespace OpenWifi {
 		poco_trace(MyLogger, "Scheduler done.");
 	}
 
+	void CommandManager::QueueCommand(const GWObjects::CommandDetails &Cmd) {
+		auto SerialNumber = Utils::SerialNumberToInt(Cmd.SerialNumber);
+		bool Later = Cmd.RunAt > Utils::Now();
+		{
+			std::lock_guard Lock(QueueMutex_);
+			Queued_[SerialNumber][std::make_pair(Cmd.Submitted, Cmd.UUID)] = Cmd;
+			if (Later)
+				Deadlines_.emplace(Cmd.RunAt, SerialNumber);
+		}
+		if (Later)
+			DispatchQueue_.wakeUpAll();
+		else
+			ReadyToDispatch(SerialNumber);
+	}
+
+	void CommandManager::UnqueueCommand(const std::string &UUID) {
+		std::lock_guard Lock(QueueMutex_);
+		for (auto Device = Queued_.begin(); Device != Queued_.end(); ++Device) {
+			auto &Commands = Device->second;
+			auto Cmd = std::find_if(Commands.begin(), Commands.end(),
+									[&UUID](const auto &C) { return C.second.UUID == UUID; });
+			if (Cmd != Commands.end()) {
+				Commands.erase(Cmd);
+				if (Commands.empty())
+					Queued_.erase(Device);
+				return;
+			}
+		}
+	}
+
+	void CommandManager::UnqueueCommands(const std::string &SerialNumber,
+										 const std::string &Command) {
+		std::lock_guard Lock(QueueMutex_);
+		auto Device = Queued_.find(Utils::SerialNumberToInt(SerialNumber));
+		if (Device == Queued_.end())
+			return;
+		auto &Commands = Device->second;
+		for (auto Cmd = Commands.begin(); Cmd != Commands.end();) {
+			if (Cmd->second.Command == Command)
+				Cmd = Commands.erase(Cmd);
+			else
+				++Cmd;
+		}
+		if (Commands.empty())
+			Queued_.erase(Device);
+	}
+
+	//	An empty serial number stands for every device, and a date of 0 for no limit, as in
+	//	Storage::DeleteCommands.
+	void CommandManager::UnqueueCommands(const std::string &SerialNumber, std::uint64_t FromDate,
+										 std::uint64_t ToDate) {
+		std::lock_guard Lock(QueueMutex_);
+		auto SerialNumberInt = SerialNumber.empty() ? 0 : Utils::SerialNumberToInt(SerialNumber);
+		for (auto Device = Queued_.begin(); Device != Queued_.end();) {
+			if (!SerialNumber.empty() && Device->first != SerialNumberInt) {
+				++Device;
+				continue;
+			}
+			auto &Commands = Device->second;
+			for (auto Cmd = Commands.begin(); Cmd != Commands.end();) {
+				if ((FromDate == 0 || Cmd->second.Submitted >= FromDate) &&
+					(ToDate == 0 || Cmd->second.Submitted <= ToDate))
+					Cmd = Commands.erase(Cmd);
+				else
+					++Cmd;
+			}
+			if (Commands.empty())
+				Device = Queued_.erase(Device);
+			else
+				++Device;
+		}
+	}
+
+	void CommandManager::DeviceConnected(std::uint64_t SerialNumber) {
+		ReadyToDispatch(SerialNumber);
+	}
+
+	//	Hands a device to the dispatcher if it has commands and is connected.
+	void CommandManager::ReadyToDispatch(std::uint64_t SerialNumber) {
+		{
+			std::lock_guard Lock(QueueMutex_);
+			if (Queued_.find(SerialNumber) == Queued_.end())
+				return;
+		}
+		if (AP_WS_Server()->Connected(SerialNumber))
+			DispatchQueue_.enqueueNotification(new CommandDispatchNotification(SerialNumber));
+	}
+
+	void CommandManager::RunDispatcher() {
+		Utils::SetThreadName("cmd:dispatch");
+		while (Running_) {
+			long WaitMs = 60000;
+			{
+				std::lock_guard Lock(QueueMutex_);
+				if (!Deadlines_.empty()) {
+					auto Now = Utils::Now();
+					auto First = Deadlines_.begin()->first;
+					WaitMs = First > Now ? (long)std::min<std::uint64_t>((First - Now) * 1000, WaitMs)
+										 : 0;
+				}
+			}
+
+			std::set<std::uint64_t> SerialNumbers;
+			Poco::AutoPtr<Poco::Notification> Msg(WaitMs > 0
+													  ? DispatchQueue_.waitDequeueNotification(WaitMs)
+													  : DispatchQueue_.dequeueNotification());
+			while (Msg) {
+				if (auto Ready = dynamic_cast<CommandDispatchNotification *>(Msg.get()))
+					SerialNumbers.insert(Ready->SerialNumber_);
+				Msg = DispatchQueue_.dequeueNotification();
+			}
+			if (!Running_)
+				break;
+			{
+				std::lock_guard Lock(QueueMutex_);
+				auto Now = Utils::Now();
+				while (!Deadlines_.empty() && Deadlines_.begin()->first <= Now) {
+					SerialNumbers.insert(Deadlines_.begin()->second);
+					Deadlines_.erase(Deadlines_.begin());
+				}
+			}
+
+			for (const auto SerialNumber : SerialNumbers) {
+				try {
+					Dispatch(SerialNumber);
+				} catch (const Poco::Exception &E) {
+					Logger().log(E);
+				} catch (...) {
+					poco_warning(Logger(), "Exception during command dispatch.");
+				}
+			}
+		}
+	}
+
+	//	Sends the oldest due command of a device. The next one goes once this one completes.
+	void CommandManager::Dispatch(std::uint64_t SerialNumber) {
+		Poco::Logger &MyLogger = Poco::Logger::get("CMD-MGR-SCHEDULER");
+
+		if (!AP_WS_Server()->Connected(SerialNumber)) {
+			return;
+		}
+
+		std::string ExecutingUUID;
+		APCommands::Commands ExecutingCommand = APCommands::Commands::unknown;
+		if (CommandRunningForDevice(SerialNumber, ExecutingUUID, ExecutingCommand)) {
+			poco_trace(MyLogger, fmt::format("Serial={} Device is already busy with command {} "
+											 "(Command={}).",
+											 Utils::IntToSerialNumber(SerialNumber), ExecutingUUID,
+											 APCommands::to_string(ExecutingCommand)));
+			return;
+		}
+
+		GWObjects::CommandDetails Cmd;
+		std::vector<GWObjects::CommandDetails> Expired;
+		{
+			std::lock_guard Lock(QueueMutex_);
+			auto Device = Queued_.find(SerialNumber);
+			if (Device == Queued_.end())
+				return;
+			auto Now = Utils::Now();
+			auto &Commands = Device->second;
+			for (auto Entry = Commands.begin(); Entry != Commands.end();) {
+				if (Entry->second.Submitted + commandTimeOut_ < Now) {
+					Expired.emplace_back(std::move(Entry->second));
+					Entry = Commands.erase(Entry);
+				} else if (Entry->second.RunAt > Now) {
+					Deadlines_.emplace(Entry->second.RunAt, SerialNumber);
+					++Entry;
+				} else {
+					Cmd = std::move(Entry->second);
+					Commands.erase(Entry);
+					break;
+				}
+			}
+			if (Commands.empty())
+				Queued_.erase(Device);
+		}
+
+		for (auto &E : Expired) {
+			poco_information(MyLogger, fmt::format("{}: Serial={} Command={} has expired.", E.UUID,
+												   E.SerialNumber, E.Command));
+			StorageService()->SetCommandTimedOut(E.UUID);
+		}
+		if (Cmd.UUID.empty())
+			return;
+
+		try {
+			Poco::JSON::Parser P;
+			bool Sent;
+			poco_information(MyLogger, fmt::format("{}: Serial={} Command={} Preparing execution.",
+												   Cmd.UUID, Cmd.SerialNumber, Cmd.Command));
+			auto Params = P.parse(Cmd.Details).extract<Poco::JSON::Object::Ptr>();
+			auto Result = PostCommandDisk(Next_RPC_ID(),
+										  APCommands::to_apcommand(Cmd.Command.c_str()),
+										  Cmd.SerialNumber, Cmd.Command, *Params, Cmd.UUID, Sent);
+			if (Sent) {
+				StorageService()->SetCommandExecuted(Cmd.UUID);
+				poco_debug(MyLogger, fmt::format("{}: Serial={} Command={} Sent.", Cmd.UUID,
+												 Cmd.SerialNumber, Cmd.Command));
+			} else {
+				poco_debug(MyLogger, fmt::format("{}: Serial={} Command={} Re-queued command.",
+												 Cmd.UUID, Cmd.SerialNumber, Cmd.Command));
+				StorageService()->SetCommandLastTry(Cmd.UUID);
+				std::lock_guard Lock(QueueMutex_);
+				auto Key = std::make_pair(Cmd.Submitted, Cmd.UUID);
+				Queued_[SerialNumber][Key] = std::move(Cmd);
+				Deadlines_.emplace(Utils::Now() + commandRetry_, SerialNumber);
+			}
+		} catch (const Poco::Exception &E) {
+			poco_debug(MyLogger,
+					   fmt::format("{}: Serial={} Command={} Failed. Command marked as completed.",
+								   Cmd.UUID, Cmd.SerialNumber, Cmd.Command));
+			MyLogger.log(E);
+			StorageService()->SetCommandExecuted(Cmd.UUID);
+		} catch (...) {
+			poco_debug(MyLogger, fmt::format("{}: Serial={} Command={} Hard failure. "
+											 "Command marked as completed.",
+											 Cmd.UUID, Cmd.SerialNumber, Cmd.Command));
+			StorageService()->SetCommandExecuted(Cmd.UUID);
+		}
+	}
+
 	std::shared_ptr<CommandManager::promise_type_t> CommandManager::PostCommand(
 		uint64_t RPC_ID, APCommands::Commands Command, const std::string &SerialNumber,
 		const std::string &CommandStr, const Poco::JSON::Object &Params, const std::string &UUID,
-		bool oneway_rpc, [[maybe_unused]] bool disk_only, bool &Sent, bool rpc, bool Deferred) {
+		bool oneway_rpc, [[maybe_unused]] bool disk_only, bool &Sent, bool rpc, bool Deferred,
+		completion_t Completion, std::chrono::milliseconds Timeout) {
 
 		auto SerialNumberInt = Utils::SerialNumberToInt(SerialNumber);
 		Sent = false;
@@ -446,22 +684,27 @@ namespace OpenWifi {
 		CompleteRPC.set(uCentralProtocol::PARAMS, Params);
 		Poco::JSON::Stringifier::stringify(CompleteRPC, ToSend);
 		CInfo.rpc_entry = rpc ? std::make_shared<CommandManager::promise_type_t>() : nullptr;
+		CInfo.Completion = std::move(Completion);
+		CInfo.Deadline = CInfo.submitted + Timeout;
 
 		poco_debug(Logger(), fmt::format("{}: Sending command {} to {}. ID: {}", UUID, CommandStr,
 										 SerialNumber, RPC_ID));
 		//	Do not change the order. It is possible that an RPC completes before it is entered in
 		// the map. So we insert it 	first, even if we may need to remove it later upon failure.
 		if (!oneway_rpc) {
-			std::lock_guard M(Mutex_);
-			OutStandingRequests_[RPC_ID] = CInfo;
+			std::lock_guard M(LocalMutex_);
+			AddOutstanding(CInfo);
 		}
 		if (AP_WS_Server()->SendFrame(SerialNumber, ToSend.str())) {
 			poco_debug(Logger(), fmt::format("{}: Sent command. ID: {}", UUID, RPC_ID));
 			Sent = true;
 			return CInfo.rpc_entry;
 		} else if (!oneway_rpc) {
-			std::lock_guard M(Mutex_);
-			OutStandingRequests_.erase(RPC_ID);
+			std::lock_guard M(LocalMutex_);
+			//	the caller learns of the failure from Sent
+			if (auto Request = Outstanding_.Find(RPC_ID))
+				TakeCompletion(*Request);
+			EraseOutstanding(RPC_ID);
 		}
 
 		poco_warning(Logger(), fmt::format("{}: Failed to send command. ID: {}", UUID, RPC_ID));
@@ -12,7 +12,9 @@
 #include <functional>
 #include <future>
 #include <map>
+#include <set>
 #include <shared_mutex>
+#include <unordered_map>
 #include <utility>
 
 #include "Poco/JSON/Object.h"
@@ -20,12 +22,15 @@
 #include "Poco/Net/HTTPServerResponse.h"
 #include "Poco/Notification.h"
 #include "Poco/NotificationQueue.h"
+#include "Poco/RunnableAdapter.h"
 #include "Poco/Timer.h"
 
 #include "fmt/format.h"
 #include "framework/SubSystemServer.h"
 
+#include "OutstandingRPCTable.h"
 #include "RESTObjects/RESTAPI_GWobjects.h"
+#include "StorageService.h"
 
 namespace OpenWifi {
 
@@ -37,10 +42,36 @@ namespace OpenWifi {
 		Poco::JSON::Object::Ptr Payload_;
 	};
 
+	class CommandDispatchNotification : public Poco::Notification {
+	  public:
+		explicit CommandDispatchNotification(std::uint64_t ser) : SerialNumber_(ser) {}
+		std::uint64_t SerialNumber_;
+	};
+
+	class CommandResultNotification : public Poco::Notification {
+	  public:
+		explicit CommandResultNotification(Storage::CommandResult R) : Result_(std::move(R)) {}
+		explicit CommandResultNotification(std::function<void()> A) : Action_(std::move(A)) {}
+		Storage::CommandResult Result_;
+		std::function<void()> Action_;
+	};
+
+	//	Responses from a device always go to the same worker, so they are processed in order.
+	class RPCResponseWorker : public Poco::Runnable {
+	  public:
+		explicit RPCResponseWorker(std::uint64_t Index) : Index_(Index) {}
+		void run() override;
+		Poco::NotificationQueue Queue_;
+		Poco::Thread Thread_;
+		std::uint64_t Index_;
+	};
+
 	class CommandManager : public SubSystemServer, Poco::Runnable {
 	  public:
 		using objtype_t = Poco::JSON::Object::Ptr;
 		using promise_type_t = std::promise<objtype_t>;
+		//	receives the answer, or nullptr when none came in time
+		using completion_t = std::function<void(const objtype_t &)>;
 
 		struct CommandInfo {
 			std::uint64_t Id = 0;
@@ -52,6 +83,8 @@ namespace OpenWifi {
 				std::chrono::high_resolution_clock::now();
 			std::shared_ptr<promise_type_t> rpc_entry;
 			bool Deferred = false;
+			completion_t Completion;
+			std::chrono::time_point<std::chrono::high_resolution_clock> Deadline;
 		};
 
 		struct RPCResponse {
@@ -67,9 +100,13 @@ namespace OpenWifi {
 		void WakeUp();
 		inline void PostCommandResult(const std::string &SerialNumber,
 									  Poco::JSON::Object::Ptr Obj) {
-			ResponseQueue_.enqueueNotification(new RPCResponseNotification(
-				Utils::SerialNumberToInt(SerialNumber), std::move(Obj)));
+			if (ResponseWorkers_.empty())
+				return;
+			auto SN = Utils::SerialNumberToInt(SerialNumber);
+			ResponseWorkers_[SN % ResponseWorkers_.size()]->Queue_.enqueueNotification(
+				new RPCResponseNotification(SN, std::move(Obj)));
 		}
+		void ProcessResponse(std::uint64_t SerialNumber, const Poco::JSON::Object::Ptr &Payload);
 
 		std::shared_ptr<promise_type_t> PostCommandOneWayDisk(uint64_t RPC_ID,
 															  APCommands::Commands Command,
@@ -105,6 +142,20 @@ namespace OpenWifi {
 							   Sent, false);
 		}
 
+		//	Sends a command whose answer goes to Completion, run on the result writer thread, so
+		//	no thread waits for the device. Returns false if the command could not be sent, in
+		//	which case Completion is never called.
+		bool PostCommandAsync(uint64_t RPC_ID, APCommands::Commands Command,
+							  const std::string &SerialNumber, const std::string &Method,
+							  const Poco::JSON::Object &Params, const std::string &UUID,
+							  bool Deferred, std::chrono::milliseconds Timeout,
+							  completion_t Completion) {
+			bool Sent;
+			PostCommand(RPC_ID, Command, SerialNumber, Method, Params, UUID, false, false, Sent,
+						false, Deferred, std::move(Completion), Timeout);
+			return Sent;
+		}
+
 		bool IsCommandRunning(const std::string &C);
 
 		void run() override;
@@ -117,46 +168,36 @@ namespace OpenWifi {
 		inline bool Running() const { return Running_; }
 		void onJanitorTimer(Poco::Timer &timer);
 		void onCommandRunnerTimer(Poco::Timer &timer);
+		void onDeadlineTimer(Poco::Timer &timer);
 		inline uint64_t Next_RPC_ID() { return ++Id_; }
 
 		void RemovePendingCommand(std::uint64_t Id) {
 			std::unique_lock Lock(LocalMutex_);
-			OutStandingRequests_.erase(Id);
+			EraseOutstanding(Id);
 		}
 
 		inline bool CommandRunningForDevice(std::uint64_t SerialNumber, std::string &uuid,
 											APCommands::Commands &command) {
 			std::lock_guard Lock(LocalMutex_);
 
-			for (const auto &[Request, Command] : OutStandingRequests_) {
-				if (Command.SerialNumber == SerialNumber) {
-					uuid = Command.UUID;
-					command = Command.Command;
-					return true;
-				}
-			}
-			return false;
+			auto Command = Outstanding_.FirstForDevice(SerialNumber);
+			if (Command == nullptr)
+				return false;
+			uuid = Command->UUID;
+			command = Command->Command;
+			return true;
 		}
 
 		inline void ClearQueue(std::uint64_t SerialNumber) {
 			std::lock_guard Lock(LocalMutex_);
-			for (auto Request = OutStandingRequests_.begin();
-				 Request != OutStandingRequests_.end();) {
-				if (Request->second.SerialNumber == SerialNumber)
-					Request = OutStandingRequests_.erase(Request);
-				else
-					++Request;
-			}
+			for (const auto Id : Outstanding_.ForDevice(SerialNumber))
+				EraseOutstanding(Id);
 		}
 
 		inline void RemoveCommand(const std::string &UUID) {
 			std::lock_guard Lock(LocalMutex_);
-			for (const auto &[Id, Cmd] : OutStandingRequests_) {
-				if (Cmd.UUID == UUID) {
-					OutStandingRequests_.erase(Id);
-					return;
-				}
-			}
+			if (auto Request = Outstanding_.FindUUID(UUID))
+				EraseOutstanding(Request->Id);
 		}
 
 		inline auto CommandTimeout() const { return commandTimeOut_; }
@@ -164,27 +205,69 @@ namespace OpenWifi {
 
 		bool FireAndForget(const std::string &SerialNumber, const std::string &Method,
 						   const Poco::JSON::Object &Params);
+
+		//	Pending commands are kept here as well as in the CommandList table, which remains the
+		//	record. A device's commands are sent when it connects, when its running command
+		//	completes, or when a RunAt time or retry delay expires.
+		void QueueCommand(const GWObjects::CommandDetails &Cmd);
+		void UnqueueCommand(const std::string &UUID);
+		void UnqueueCommands(const std::string &SerialNumber, const std::string &Command);
+		void UnqueueCommands(const std::string &SerialNumber, std::uint64_t FromDate,
+							 std::uint64_t ToDate);
+		void DeviceConnected(std::uint64_t SerialNumber);
+
 	  private:
 		mutable std::recursive_mutex LocalMutex_;
 		std::atomic_bool Running_ = false;
 		Poco::Thread ManagerThread;
 		std::atomic_uint64_t Id_ = 3; //	do not start @1. We ignore ID=1 & 0 is illegal..
-		std::map<std::uint64_t, CommandInfo> OutStandingRequests_;
+		//	asynchronous requests have a deadline, when their completion gives up
+		OutstandingRPCTable<CommandInfo> Outstanding_; //	under LocalMutex_
 		Poco::Timer JanitorTimer_;
 		std::unique_ptr<Poco::TimerCallback<CommandManager>> JanitorCallback_;
 		Poco::Timer CommandRunnerTimer_;
 		std::unique_ptr<Poco::TimerCallback<CommandManager>> CommandRunnerCallback_;
-		Poco::NotificationQueue ResponseQueue_;
+		Poco::Timer DeadlineTimer_;
+		std::unique_ptr<Poco::TimerCallback<CommandManager>> DeadlineCallback_;
+		std::vector<std::unique_ptr<RPCResponseWorker>> ResponseWorkers_;
+		//	results and follow-up writes, done in order by ManagerThread
+		static constexpr std::size_t MaxResultBatch = 500;
+		Poco::NotificationQueue ResultQueue_;
+		std::atomic_bool WriterRunning_ = false;
 		std::uint64_t commandTimeOut_ = 0;
 		std::uint64_t commandRetry_ = 0;
 		std::uint64_t janitorInterval_ = 0;
 		std::uint64_t queueInterval_ = 0;
 
+		using QueuedCommands = std::map<std::pair<std::uint64_t, std::string>,
+										GWObjects::CommandDetails>; //	by (Submitted, UUID)
+		std::mutex QueueMutex_;
+		std::unordered_map<std::uint64_t, QueuedCommands> Queued_;
+		std::set<std::pair<std::uint64_t, std::uint64_t>> Deadlines_; //	(time, serial number)
+		Poco::NotificationQueue DispatchQueue_;
+		Poco::Thread DispatchThread_;
+		Poco::RunnableAdapter<CommandManager> Dispatcher_{*this, &CommandManager::RunDispatcher};
+
+		void AddOutstanding(const CommandInfo &Command);
+		void EraseOutstanding(std::uint64_t Id);
+		completion_t TakeCompletion(CommandInfo &Command);
+		bool Deliver(const std::shared_ptr<promise_type_t> &Promise, completion_t Completion,
+					 const objtype_t &Payload);
+
+		void PersistResult(const std::string &UUID, const Poco::JSON::Object::Ptr &Payload,
+						   std::chrono::duration<double, std::milli> rpc_execution_time);
+		void PersistAction(std::function<void()> Action);
+
+		void RunDispatcher();
+		void Dispatch(std::uint64_t SerialNumber);
+		void ReadyToDispatch(std::uint64_t SerialNumber);
+
 		std::shared_ptr<promise_type_t>
 		PostCommand(uint64_t RPCID, APCommands::Commands Command, const std::string &SerialNumber,
 					const std::string &Method, const Poco::JSON::Object &Params,
 					const std::string &UUID, bool oneway_rpc, bool disk_only, bool &Sent,
-					bool rpc_call, bool Deferred = false);
+					bool rpc_call, bool Deferred = false, completion_t Completion = nullptr,
+					std::chrono::milliseconds Timeout = std::chrono::milliseconds(0));
 
 		bool CompleteScriptCommand(CommandInfo &Command, const Poco::JSON::Object::Ptr &Payload,
 								   std::chrono::duration<double, std::milli> rpc_execution_time);
@@ -0,0 +1,71 @@
+//
+//	License type: BSD 3-Clause License
+//	License copy: https://github.com/Telecominfraproject/wlan-cloud-ucentralgw/blob/master/LICENSE
+//
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include <zlib.h>
+
+namespace OpenWifi {
+
+	//	Immutable text held deflated when asked to and when that makes it smaller. Copies share
+	//	the held bytes, so a state report kept by its connection and by the device shadow is
+	//	held once.
+	class CompressedText {
+	  public:
+		CompressedText() = default;
+
+		//	Level goes from 1 (fastest) to 9 (smallest).
+		CompressedText(const std::string &Text, bool Compress, int Level = 1) : Size_(Text.size()) {
+			if (Text.empty())
+				return;
+			if (Compress) {
+				std::string Buffer(compressBound(Text.size()), '\0');
+				uLongf Size = Buffer.size();
+				if (compress2((Bytef *)Buffer.data(), &Size, (const Bytef *)Text.data(),
+							  Text.size(), Level) == Z_OK &&
+					Size < Text.size()) {
+					Buffer.resize(Size);
+					Buffer.shrink_to_fit();
+					Held_ = std::make_shared<const std::string>(std::move(Buffer));
+					Compressed_ = true;
+					return;
+				}
+			}
+			Held_ = std::make_shared<const std::string>(Text);
+		}
+
+		//	Inflated on each call when held compressed; empty if the held bytes are damaged.
+		[[nodiscard]] inline std::string Text() const {
+			if (!Held_)
+				return {};
+			if (!Compressed_)
+				return *Held_;
+			std::string Result(Size_, '\0');
+			uLongf FinalSize = Size_;
+			if (uncompress((Bytef *)Result.data(), &FinalSize, (const Bytef *)Held_->data(),
+						   Held_->size()) != Z_OK ||
+				FinalSize != Size_)
+				Result.clear();
+			return Result;
+		}
+
+		[[nodiscard]] inline bool Empty() const { return Size_ == 0; }
+		[[nodiscard]] inline bool Compressed() const { return Compressed_; }
+		//	Size of the text itself.
+		[[nodiscard]] inline std::size_t RawSize() const { return Size_; }
+		//	Bytes held for it, whoever else shares them.
+		[[nodiscard]] inline std::size_t HeldSize() const { return Held_ ? Held_->capacity() : 0; }
+
+	  private:
+		std::shared_ptr<const std::string> Held_;
+		std::size_t Size_ = 0;
+		bool Compressed_ = false;
+	};
+
+} // namespace OpenWifi
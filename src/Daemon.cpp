@@ -16,8 +16,12 @@
 #include <framework/default_device_types.h>
 
 #include "AP_WS_Server.h"
+#include "BulkCommandManager.h"
 #include "CommandManager.h"
 #include "Daemon.h"
+#include "DeviceSearchIndex.h"
+#include "DeviceShadow.h"
+#include "DisconnectionCleanup.h"
 #include "FileUploader.h"
 #include "FindCountry.h"
 #include "OUIServer.h"
@@ -28,6 +32,7 @@
 #include "SerialNumberCache.h"
 #include "SignatureMgr.h"
 #include "StorageArchiver.h"
+#include "StorageIngestion.h"
 #include "StorageService.h"
 #include "TelemetryStream.h"
 #include "GenericScheduler.h"
@@ -42,11 +47,12 @@ namespace OpenWifi {
 		static Daemon instance(
 			vDAEMON_PROPERTIES_FILENAME, vDAEMON_ROOT_ENV_VAR, vDAEMON_CONFIG_ENV_VAR,
 			vDAEMON_APP_NAME, vDAEMON_BUS_TIMER,
-			SubSystemVec{GenericScheduler(), StorageService(), SerialNumberCache(), ConfigurationValidator(),
+			SubSystemVec{GenericScheduler(), StorageService(), StorageIngestion(), SerialNumberCache(), DeviceSearchIndex(), ConfigurationValidator(),
 				UI_WebSocketClientServer(), OUIServer(), FindCountryFromIP(),
 				CommandManager(), FileUploader(), StorageArchiver(), TelemetryStream(),
 				RTTYS_server(), RADIUS_proxy_server(), VenueBroadcaster(), ScriptManager(),
-				SignatureManager(), AP_WS_Server(),
+				SignatureManager(), DeviceShadow(), DisconnectionCleanup(), AP_WS_Server(),
+				BulkCommandManager(),
 				RegulatoryInfo(),
 				RADIUSSessionTracker(),
 				AP_WS_ConfigAutoUpgrader(),
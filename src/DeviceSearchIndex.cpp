@@ -0,0 +1,134 @@
+//
+//	License type: BSD 3-Clause License
+//	License copy: https://github.com/Telecominfraproject/wlan-cloud-ucentralgw/blob/master/LICENSE
+//
+
+#include "DeviceSearchIndex.h"
+
+#include "Poco/JSON/Array.h"
+
+#include "StorageService.h"
+#include "framework/utils.h"
+
+namespace OpenWifi {
+
+	static constexpr std::size_t MaxFacetValues = 25;
+
+	void DeviceSearchIndex::Result::to_json(Poco::JSON::Object &Obj) const {
+		Obj.set("serialNumber", serialNumber);
+		Obj.set("compatible", compatible);
+		Obj.set("firmware", firmware);
+		Obj.set("locale", locale);
+		Obj.set("ipAddress", ipAddress);
+	}
+
+	const char *DeviceSearchIndex::FacetName(std::size_t F) {
+		switch (F) {
+		case COMPATIBLE:
+			return "compatible";
+		case FIRMWARE:
+			return "firmware";
+		case LOCALE:
+			return "locale";
+		default:
+			return "";
+		}
+	}
+
+	int DeviceSearchIndex::Start() {
+		poco_notice(Logger(), "Starting...");
+		StorageService()->UpdateDeviceSearchIndex();
+		return 0;
+	}
+
+	void DeviceSearchIndex::Stop() {
+		poco_notice(Logger(), "Stopping...");
+		Table_.Clear();
+		poco_notice(Logger(), "Stopped...");
+	}
+
+	void DeviceSearchIndex::Update(const std::string &SerialNumber, const std::string &Compatible,
+								   const std::string &Firmware, const std::string &Locale) {
+		if (!Utils::ValidSerialNumber(SerialNumber))
+			return;
+		Table_.Update(Utils::SerialNumberToInt(SerialNumber), {Compatible, Firmware, Locale});
+	}
+
+	void DeviceSearchIndex::Update(const GWObjects::Device &D) {
+		Update(D.SerialNumber, D.Compatible, D.Firmware, D.locale);
+	}
+
+	void DeviceSearchIndex::SetFirmware(const std::string &SerialNumber,
+										const std::string &Firmware) {
+		if (!Utils::ValidSerialNumber(SerialNumber))
+			return;
+		Table_.SetValue(Utils::SerialNumberToInt(SerialNumber), DeviceSearchTable::FIRMWARE,
+						Firmware);
+	}
+
+	void DeviceSearchIndex::SetAddress(const std::string &SerialNumber,
+									   const std::string &IPAddress) {
+		if (!Utils::ValidSerialNumber(SerialNumber))
+			return;
+		Table_.SetAddress(Utils::SerialNumberToInt(SerialNumber), IPAddress);
+	}
+
+	void DeviceSearchIndex::Remove(const std::string &SerialNumber) {
+		if (!Utils::ValidSerialNumber(SerialNumber))
+			return;
+		Table_.Remove(Utils::SerialNumberToInt(SerialNumber));
+	}
+
+	bool DeviceSearchIndex::Search(const Query &Q, std::vector<Result> &Results,
+								   Poco::JSON::Object &Facets) {
+		DeviceSearchTable::Query TQ;
+		if (!DeviceSearchTable::SetSerialNumber(Q.SerialNumber, TQ))
+			return false;
+		for (std::size_t F = 0; F < NUMBER_OF_FACETS; F++)
+			TQ.Terms[F] = DeviceSearchTable::Terms(Q.Terms[F]);
+		TQ.IPAddress = Q.IPAddress;
+		TQ.After = Q.After;
+		TQ.HasAfter = Q.HasAfter;
+		TQ.Limit = Q.Limit;
+		TQ.Facets = Q.Facets;
+
+		std::vector<DeviceSearchTable::Entry> Entries;
+		DeviceSearchTable::FacetCounts Counts;
+		auto More = Table_.Search(TQ, Entries, Counts, MaxFacetValues);
+
+		Results.reserve(Results.size() + Entries.size());
+		for (auto &E : Entries) {
+			Result R;
+			R.serialNumber = Utils::IntToSerialNumber(E.SerialNumber);
+			R.compatible = std::move(E.Values[COMPATIBLE]);
+			R.firmware = std::move(E.Values[FIRMWARE]);
+			R.locale = std::move(E.Values[LOCALE]);
+			R.ipAddress = std::move(E.IPAddress);
+			Results.emplace_back(std::move(R));
+		}
+
+		if (Q.Facets) {
+			Facets.set("total", Counts.Total);
+			for (std::size_t F = 0; F < NUMBER_OF_FACETS; F++) {
+				Poco::JSON::Array Values;
+				for (const auto &[Value, Count] : Counts.Top[F]) {
+					Poco::JSON::Object Entry;
+					Entry.set("value", Value);
+					Entry.set("count", Count);
+					Values.add(Entry);
+				}
+				Facets.set(FacetName(F), Values);
+			}
+		}
+		return More;
+	}
+
+	bool DeviceSearchIndex::GetResourceStatistics(Poco::JSON::Object &Stats) {
+		Stats.set("devices", Table_.Devices());
+		for (std::size_t F = 0; F < NUMBER_OF_FACETS; F++)
+			Stats.set(std::string(FacetName(F)) + "Values",
+					  Table_.Values((DeviceSearchTable::Facet)F));
+		return true;
+	}
+
+} // namespace OpenWifi
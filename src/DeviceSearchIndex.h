@@ -0,0 +1,83 @@
+//
+//	License type: BSD 3-Clause License
+//	License copy: https://github.com/Telecominfraproject/wlan-cloud-ucentralgw/blob/master/LICENSE
+//
+
+#pragma once
+
+#include <array>
+#include <string>
+#include <vector>
+
+#include "Poco/JSON/Object.h"
+
+#include "DeviceSearchTable.h"
+#include "RESTObjects/RESTAPI_GWobjects.h"
+#include "framework/SubSystemServer.h"
+
+namespace OpenWifi {
+
+	//	In-memory search index over the devices table, kept in a DeviceSearchTable.
+	class DeviceSearchIndex : public SubSystemServer {
+	  public:
+		enum Facet : std::size_t {
+			COMPATIBLE = DeviceSearchTable::COMPATIBLE,
+			FIRMWARE = DeviceSearchTable::FIRMWARE,
+			LOCALE = DeviceSearchTable::LOCALE,
+			NUMBER_OF_FACETS = DeviceSearchTable::NUMBER_OF_FACETS
+		};
+
+		struct Query {
+			//	hex digits the serial number starts with, or "*" then the digits it ends with
+			std::string SerialNumber;
+			//	space separated terms; each must start the value or one of its words
+			std::array<std::string, NUMBER_OF_FACETS> Terms;
+			std::string IPAddress;
+			std::uint64_t After = 0;
+			bool HasAfter = false;
+			std::uint64_t Limit = 100;
+			bool Facets = false;
+		};
+
+		struct Result {
+			std::string serialNumber;
+			std::string compatible;
+			std::string firmware;
+			std::string locale;
+			std::string ipAddress;
+			void to_json(Poco::JSON::Object &Obj) const;
+		};
+
+		static auto instance() {
+			static auto instance_ = new DeviceSearchIndex;
+			return instance_;
+		}
+
+		int Start() override;
+		void Stop() override;
+		bool GetResourceStatistics(Poco::JSON::Object &Stats) override;
+
+		void Update(const GWObjects::Device &D);
+		void Update(const std::string &SerialNumber, const std::string &Compatible,
+					const std::string &Firmware, const std::string &Locale);
+		void SetFirmware(const std::string &SerialNumber, const std::string &Firmware);
+		void SetAddress(const std::string &SerialNumber, const std::string &IPAddress);
+		void Remove(const std::string &SerialNumber);
+
+		//	Fills Results with at most Q.Limit devices and returns true if more follow. When
+		//	Q.Facets is set, every match is visited and Facets receives the total and the most
+		//	frequent values of each facet among the matches.
+		bool Search(const Query &Q, std::vector<Result> &Results, Poco::JSON::Object &Facets);
+
+		static const char *FacetName(std::size_t F);
+
+	  private:
+		DeviceSearchTable Table_;
+
+		DeviceSearchIndex() noexcept
+			: SubSystemServer("DeviceSearchIndex", "DEVSEARCH-SVR", "devicesearch") {}
+	};
+
+	inline auto DeviceSearchIndex() { return DeviceSearchIndex::instance(); }
+
+} // namespace OpenWifi
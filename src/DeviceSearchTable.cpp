@@ -0,0 +1,295 @@
+//
+//	License type: BSD 3-Clause License
+//	License copy: https://github.com/Telecominfraproject/wlan-cloud-ucentralgw/blob/master/LICENSE
+//
+
+#include "DeviceSearchTable.h"
+
+#include <algorithm>
+#include <cctype>
+#include <mutex>
+
+namespace OpenWifi {
+
+	static std::string Lower(const std::string &S) {
+		std::string Result{S};
+		for (auto &c : Result)
+			c = (char)std::tolower((unsigned char)c);
+		return Result;
+	}
+
+	bool DeviceSearchTable::SetSerialNumber(const std::string &Pattern, Query &Q) {
+		Q.Low = 0;
+		Q.High = 0xffffffffffff;
+		Q.SuffixMask = Q.Suffix = 0;
+		if (Pattern.empty())
+			return true;
+		//	Serial numbers are 12 hex digits: a prefix selects a range, a suffix a mask.
+		bool IsSuffix = Pattern[0] == '*';
+		auto Digits = IsSuffix ? Pattern.substr(1) : Pattern;
+		if (Digits.size() > 12 || !std::all_of(Digits.begin(), Digits.end(), [](char c) {
+				return std::isxdigit((unsigned char)c);
+			}))
+			return false;
+		if (Digits.empty())
+			return true;
+		auto Value = std::stoull(Digits, nullptr, 16);
+		auto Bits = 4 * (12 - Digits.size());
+		if (IsSuffix) {
+			Q.SuffixMask = (1ULL << (4 * Digits.size())) - 1;
+			Q.Suffix = Value;
+		} else {
+			Q.Low = Value << Bits;
+			Q.High = Q.Low + ((1ULL << Bits) - 1);
+		}
+		return true;
+	}
+
+	std::vector<std::string> DeviceSearchTable::Terms(const std::string &Text) {
+		std::vector<std::string> Result;
+		std::string Term;
+		for (const auto c : Lower(Text) + " ") {
+			if (std::isspace((unsigned char)c)) {
+				if (!Term.empty())
+					Result.emplace_back(std::move(Term));
+				Term.clear();
+			} else {
+				Term += c;
+			}
+		}
+		return Result;
+	}
+
+	//	Each value is kept with its searchable words: the whole value and each run of letters and
+	//	digits in it, lower case, each preceded by a space.
+	std::uint32_t DeviceSearchTable::Dictionary::Id(const std::string &Value) {
+		if (Value.empty())
+			return NoValue;
+		auto Hint = Ids.find(Value);
+		if (Hint != Ids.end())
+			return Hint->second;
+		auto LowerValue = Lower(Value);
+		std::string W = " " + LowerValue;
+		std::string Word;
+		for (const auto c : LowerValue + " ") {
+			if (std::isalnum((unsigned char)c)) {
+				Word += c;
+			} else if (!Word.empty()) {
+				W += " " + Word;
+				Word.clear();
+			}
+		}
+		std::uint32_t NewId = Values.size();
+		Ids[Value] = NewId;
+		Values.push_back(Value);
+		Words.push_back(W);
+		Counts.push_back(0);
+		return NewId;
+	}
+
+	bool DeviceSearchTable::Matches(const std::string &Words, const std::vector<std::string> &Terms) {
+		for (const auto &Term : Terms) {
+			if (Words.find(" " + Term) == std::string::npos)
+				return false;
+		}
+		return true;
+	}
+
+	//	Mutex_ must be held exclusively.
+	DeviceSearchTable::Record &DeviceSearchTable::GetRecord(std::uint64_t SerialNumber) {
+		auto Hint = Ids_.find(SerialNumber);
+		if (Hint != Ids_.end())
+			return Records_[Hint->second];
+		std::uint32_t Id;
+		if (Free_.empty()) {
+			Id = Records_.size();
+			Records_.emplace_back();
+		} else {
+			Id = Free_.back();
+			Free_.pop_back();
+			Records_[Id] = Record{};
+		}
+		Ids_[SerialNumber] = Id;
+		auto &R = Records_[Id];
+		R.SerialNumber = SerialNumber;
+		OrderStale_ = true;
+		return R;
+	}
+
+	//	Mutex_ must be held exclusively.
+	void DeviceSearchTable::Set(Record &R, std::size_t F, const std::string &Value) {
+		auto &D = Dictionaries_[F];
+		auto NewId = D.Id(Value);
+		if (R.Values[F] == NewId)
+			return;
+		if (R.Values[F] != NoValue)
+			D.Counts[R.Values[F]]--;
+		if (NewId != NoValue)
+			D.Counts[NewId]++;
+		R.Values[F] = NewId;
+	}
+
+	void DeviceSearchTable::Update(std::uint64_t SerialNumber,
+								   const std::array<std::string, NUMBER_OF_FACETS> &Values) {
+		std::unique_lock G(Mutex_);
+		auto &R = GetRecord(SerialNumber);
+		for (std::size_t F = 0; F < NUMBER_OF_FACETS; F++)
+			Set(R, F, Values[F]);
+	}
+
+	void DeviceSearchTable::SetValue(std::uint64_t SerialNumber, Facet F,
+									 const std::string &Value) {
+		std::unique_lock G(Mutex_);
+		Set(GetRecord(SerialNumber), F, Value);
+	}
+
+	void DeviceSearchTable::SetAddress(std::uint64_t SerialNumber, const std::string &IPAddress) {
+		std::unique_lock G(Mutex_);
+		GetRecord(SerialNumber).IPAddress = IPAddress;
+	}
+
+	void DeviceSearchTable::Remove(std::uint64_t SerialNumber) {
+		std::unique_lock G(Mutex_);
+		auto Hint = Ids_.find(SerialNumber);
+		if (Hint == Ids_.end())
+			return;
+		auto &R = Records_[Hint->second];
+		for (std::size_t F = 0; F < NUMBER_OF_FACETS; F++) {
+			if (R.Values[F] != NoValue)
+				Dictionaries_[F].Counts[R.Values[F]]--;
+		}
+		R = Record{};
+		Free_.push_back(Hint->second);
+		Ids_.erase(Hint);
+		OrderStale_ = true;
+	}
+
+	void DeviceSearchTable::Clear() {
+		std::unique_lock G(Mutex_);
+		Records_.clear();
+		Free_.clear();
+		Ids_.clear();
+		Order_.clear();
+		Dictionaries_ = {};
+		OrderStale_ = false;
+	}
+
+	//	Mutex_ must be held exclusively.
+	void DeviceSearchTable::SortOrder() {
+		Order_.clear();
+		Order_.reserve(Ids_.size());
+		for (const auto &[SerialNumber, Id] : Ids_)
+			Order_.push_back(Id);
+		std::sort(Order_.begin(), Order_.end(), [this](std::uint32_t A, std::uint32_t B) {
+			return Records_[A].SerialNumber < Records_[B].SerialNumber;
+		});
+		OrderStale_ = false;
+	}
+
+	bool DeviceSearchTable::Search(const Query &Q, std::vector<Entry> &Results,
+								   FacetCounts &Facets, std::size_t MaxFacetValues) {
+		//	The order is searched under the same lock it was checked or sorted under: a device
+		//	added in between could reuse the id of a removed one and break the order.
+		std::shared_lock Shared(Mutex_);
+		std::unique_lock Exclusive(Mutex_, std::defer_lock);
+		if (OrderStale_) {
+			Shared.unlock();
+			Exclusive.lock();
+			if (OrderStale_)
+				SortOrder();
+		}
+
+		//	matching is decided once per distinct value
+		std::array<std::vector<char>, NUMBER_OF_FACETS> Allowed;
+		for (std::size_t F = 0; F < NUMBER_OF_FACETS; F++) {
+			if (Q.Terms[F].empty())
+				continue;
+			const auto &D = Dictionaries_[F];
+			Allowed[F].resize(D.Values.size());
+			for (std::size_t Id = 0; Id < D.Values.size(); Id++)
+				Allowed[F][Id] = Id != NoValue && Matches(D.Words[Id], Q.Terms[F]);
+		}
+		std::array<std::vector<std::uint64_t>, NUMBER_OF_FACETS> Counts;
+		if (Q.Facets) {
+			for (std::size_t F = 0; F < NUMBER_OF_FACETS; F++)
+				Counts[F].resize(Dictionaries_[F].Values.size());
+		}
+
+		//	Facets need every match; a plain page starts right after the previous one.
+		auto Start = Q.Low;
+		if (Q.HasAfter && !Q.Facets) {
+			if (Q.After >= Q.High)
+				return false;
+			Start = std::max(Start, Q.After + 1);
+		}
+		auto First = std::lower_bound(Order_.begin(), Order_.end(), Start,
+									  [this](std::uint32_t Id, std::uint64_t SN) {
+										  return Records_[Id].SerialNumber < SN;
+									  });
+		std::uint64_t Total = 0;
+		bool More = false;
+		for (auto It = First; It != Order_.end(); ++It) {
+			const auto &R = Records_[*It];
+			if (R.SerialNumber > Q.High)
+				break;
+			if ((R.SerialNumber & Q.SuffixMask) != Q.Suffix)
+				continue;
+			bool Match = true;
+			for (std::size_t F = 0; F < NUMBER_OF_FACETS && Match; F++)
+				Match = Allowed[F].empty() || Allowed[F][R.Values[F]];
+			if (!Match || (!Q.IPAddress.empty() && R.IPAddress.compare(0, Q.IPAddress.size(),
+																		Q.IPAddress) != 0))
+				continue;
+
+			Total++;
+			if (Q.Facets) {
+				for (std::size_t F = 0; F < NUMBER_OF_FACETS; F++)
+					Counts[F][R.Values[F]]++;
+			}
+			if (Q.HasAfter && R.SerialNumber <= Q.After)
+				continue;
+			if (Results.size() < Q.Limit) {
+				Entry E;
+				E.SerialNumber = R.SerialNumber;
+				for (std::size_t F = 0; F < NUMBER_OF_FACETS; F++)
+					E.Values[F] = Dictionaries_[F].Values[R.Values[F]];
+				E.IPAddress = R.IPAddress;
+				Results.emplace_back(std::move(E));
+			} else {
+				More = true;
+				if (!Q.Facets)
+					break;
+			}
+		}
+
+		if (Q.Facets) {
+			Facets.Total = Total;
+			for (std::size_t F = 0; F < NUMBER_OF_FACETS; F++) {
+				std::vector<std::pair<std::uint64_t, std::uint32_t>> Top;
+				for (std::uint32_t Id = 1; Id < Counts[F].size(); Id++) {
+					if (Counts[F][Id] > 0)
+						Top.emplace_back(Counts[F][Id], Id);
+				}
+				auto Keep = std::min(Top.size(), MaxFacetValues);
+				std::partial_sort(Top.begin(), Top.begin() + Keep, Top.end(),
+								  [](const auto &A, const auto &B) { return A.first > B.first; });
+				Facets.Top[F].clear();
+				for (std::size_t i = 0; i < Keep; i++)
+					Facets.Top[F].emplace_back(Dictionaries_[F].Values[Top[i].second],
+											   Top[i].first);
+			}
+		}
+		return More;
+	}
+
+	std::size_t DeviceSearchTable::Devices() const {
+		std::shared_lock G(Mutex_);
+		return Ids_.size();
+	}
+
+	std::size_t DeviceSearchTable::Values(Facet F) const {
+		std::shared_lock G(Mutex_);
+		return Dictionaries_[F].Values.size() - 1;
+	}
+
+} // namespace OpenWifi
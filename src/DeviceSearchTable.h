@@ -0,0 +1,108 @@
+//
+//	License type: BSD 3-Clause License
+//	License copy: https://github.com/Telecominfraproject/wlan-cloud-ucentralgw/blob/master/LICENSE
+//
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <map>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace OpenWifi {
+
+	//	The devices behind DeviceSearchIndex. Compatible, firmware and locale are kept as
+	//	dictionary ids, so matching a term only looks at the distinct values and counting facets
+	//	is one pass over a flat array. Devices are visited in serial number order, which gives
+	//	keyset pagination: a page continues after the last serial number of the previous one.
+	class DeviceSearchTable {
+	  public:
+		enum Facet : std::size_t { COMPATIBLE = 0, FIRMWARE, LOCALE, NUMBER_OF_FACETS };
+
+		struct Query {
+			//	serial numbers between Low and High whose low bits match Suffix
+			std::uint64_t Low = 0;
+			std::uint64_t High = 0xffffffffffff;
+			std::uint64_t SuffixMask = 0;
+			std::uint64_t Suffix = 0;
+			//	lower case terms; each must start the value or one of its words
+			std::array<std::vector<std::string>, NUMBER_OF_FACETS> Terms;
+			std::string IPAddress;
+			std::uint64_t After = 0;
+			bool HasAfter = false;
+			std::uint64_t Limit = 100;
+			bool Facets = false;
+		};
+
+		struct Entry {
+			std::uint64_t SerialNumber = 0;
+			std::array<std::string, NUMBER_OF_FACETS> Values;
+			std::string IPAddress;
+		};
+
+		struct FacetCounts {
+			std::uint64_t Total = 0;
+			//	most frequent values first
+			std::array<std::vector<std::pair<std::string, std::uint64_t>>, NUMBER_OF_FACETS> Top;
+		};
+
+		//	Sets Low, High, SuffixMask and Suffix from hex digits the serial number starts with, or
+		//	"*" then the digits it ends with. Returns false when Pattern is not one of those.
+		static bool SetSerialNumber(const std::string &Pattern, Query &Q);
+		//	Splits space separated terms, in lower case.
+		static std::vector<std::string> Terms(const std::string &Text);
+
+		void Update(std::uint64_t SerialNumber,
+					const std::array<std::string, NUMBER_OF_FACETS> &Values);
+		void SetValue(std::uint64_t SerialNumber, Facet F, const std::string &Value);
+		void SetAddress(std::uint64_t SerialNumber, const std::string &IPAddress);
+		void Remove(std::uint64_t SerialNumber);
+		void Clear();
+
+		//	Fills Results with at most Q.Limit devices and returns true if more follow. When
+		//	Q.Facets is set, every match is visited and Facets receives the total and the
+		//	MaxFacetValues most frequent values of each facet among the matches.
+		bool Search(const Query &Q, std::vector<Entry> &Results, FacetCounts &Facets,
+					std::size_t MaxFacetValues = 25);
+
+		std::size_t Devices() const;
+		std::size_t Values(Facet F) const;
+
+	  private:
+		static constexpr std::uint32_t NoValue = 0;
+
+		struct Record {
+			std::uint64_t SerialNumber = 0;
+			std::array<std::uint32_t, NUMBER_OF_FACETS> Values{};
+			std::string IPAddress;
+		};
+
+		struct Dictionary {
+			std::map<std::string, std::uint32_t> Ids;
+			std::vector<std::string> Values{""};
+			std::vector<std::string> Words{""};
+			std::vector<std::uint64_t> Counts{0};
+			std::uint32_t Id(const std::string &Value);
+		};
+
+		mutable std::shared_mutex Mutex_;
+		std::vector<Record> Records_;
+		std::vector<std::uint32_t> Free_;
+		std::unordered_map<std::uint64_t, std::uint32_t> Ids_;
+		std::array<Dictionary, NUMBER_OF_FACETS> Dictionaries_;
+		//	record ids ordered by serial number, rebuilt after devices come or go
+		std::vector<std::uint32_t> Order_;
+		bool OrderStale_ = false;
+
+		Record &GetRecord(std::uint64_t SerialNumber);
+		void Set(Record &R, std::size_t F, const std::string &Value);
+		void SortOrder();
+		static bool Matches(const std::string &Words, const std::vector<std::string> &Terms);
+	};
+
+} // namespace OpenWifi
@@ -0,0 +1,290 @@
+//
+//	License type: BSD 3-Clause License
+//	License copy: https://github.com/Telecominfraproject/wlan-cloud-ucentralgw/blob/master/LICENSE
+//
+
+#include "DeviceShadow.h"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+#include "Poco/DeflatingStream.h"
+#include "Poco/File.h"
+#include "Poco/InflatingStream.h"
+
+#include "fmt/format.h"
+#include "framework/MicroServiceFuncs.h"
+#include "framework/utils.h"
+
+namespace OpenWifi {
+
+	int DeviceShadow::Start() {
+		poco_notice(Logger(), "Starting...");
+		Enabled_ = MicroServiceConfigGetBool("deviceshadow.enable", true);
+		Table_.SetHistory(MicroServiceConfigGetInt("deviceshadow.history", 1));
+		Checkpoint_ =
+			std::max<std::uint64_t>(1, MicroServiceConfigGetInt("deviceshadow.checkpoint", 60));
+		CompressStatistics_ = MicroServiceConfigGetBool("openwifi.session.laststats.compress", false);
+		CompressionLevel_ = std::clamp(
+			(int)MicroServiceConfigGetInt("openwifi.session.laststats.level", 1), 1, 9);
+		FileName_ = MicroServiceDataDirectory() + "/deviceshadow.bin";
+
+		if (Enabled_) {
+			Load();
+			Running_ = true;
+			Worker_.start(*this);
+		}
+		return 0;
+	}
+
+	void DeviceShadow::Stop() {
+		poco_notice(Logger(), "Stopping...");
+		if (Running_) {
+			Running_ = false;
+			Worker_.wakeUp();
+			Worker_.join();
+			Save();
+		}
+		poco_notice(Logger(), "Stopped...");
+	}
+
+	void DeviceShadow::run() {
+		Utils::SetThreadName("dev:shadow");
+		while (Running_) {
+			Poco::Thread::trySleep((long)Checkpoint_ * 1000);
+			if (!Running_)
+				break;
+			if (Table_.TakeChanged())
+				Save();
+		}
+	}
+
+	void DeviceShadow::SetStatistics(std::uint64_t SerialNumber, std::uint64_t UUID,
+									 std::uint64_t Recorded, const CompressedText &Data) {
+		if (Enabled_)
+			Table_.SetStatistics(SerialNumber, DeviceShadowTable::Statistics{UUID, Recorded, Data});
+	}
+
+	void DeviceShadow::SetHealthCheck(std::uint64_t SerialNumber,
+									  const GWObjects::HealthCheck &Check) {
+		if (Enabled_)
+			Table_.SetHealthCheck(SerialNumber, DeviceShadowTable::HealthCheck{
+													Check.UUID, Check.Recorded, Check.Sanity,
+													Check.Data});
+	}
+
+	void DeviceShadow::SetCapabilities(std::uint64_t SerialNumber, const std::string &Capabilities,
+									   std::uint64_t LastUpdate) {
+		if (Enabled_)
+			Table_.SetCapabilities(SerialNumber, Capabilities, LastUpdate);
+	}
+
+	//	The connection details are kept packed, in the order below.
+	static std::string PackConnection(const GWObjects::ConnectionState &C) {
+		using B = DeviceShadowTable::Binary;
+		std::ostringstream OS;
+		B::Put(OS, C.Address);
+		B::Put(OS, C.UUID);
+		B::Put(OS, C.Firmware);
+		B::Put(OS, C.Compatible);
+		B::Put(OS, C.locale);
+		B::Put(OS, C.LastContact);
+		B::Put(OS, C.started);
+		B::Put(OS, C.connectReason);
+		B::Put(OS, (std::uint64_t)C.VerifiedCertificate);
+		B::Put(OS, C.certificateExpiryDate);
+		B::Put(OS, C.Associations_2G);
+		B::Put(OS, C.Associations_5G);
+		B::Put(OS, C.Associations_6G);
+		B::Put(OS, (std::uint64_t)C.hasGPS);
+		B::Put(OS, C.sanity);
+		B::Put(OS, (double)C.memoryUsed);
+		B::Put(OS, (double)C.load);
+		B::Put(OS, (double)C.temperature);
+		return OS.str();
+	}
+
+	static bool UnpackConnection(const std::string &Packed, GWObjects::ConnectionState &C) {
+		using B = DeviceShadowTable::Binary;
+		std::istringstream IS(Packed);
+		std::uint64_t Verified = 0, HasGPS = 0;
+		double MemoryUsed = 0.0, Load = 0.0, Temperature = 0.0;
+		if (!B::Get(IS, C.Address) || !B::Get(IS, C.UUID) || !B::Get(IS, C.Firmware) ||
+			!B::Get(IS, C.Compatible) || !B::Get(IS, C.locale) || !B::Get(IS, C.LastContact) ||
+			!B::Get(IS, C.started) || !B::Get(IS, C.connectReason) || !B::Get(IS, Verified) ||
+			!B::Get(IS, C.certificateExpiryDate) || !B::Get(IS, C.Associations_2G) ||
+			!B::Get(IS, C.Associations_5G) || !B::Get(IS, C.Associations_6G) ||
+			!B::Get(IS, HasGPS) || !B::Get(IS, C.sanity) || !B::Get(IS, MemoryUsed) ||
+			!B::Get(IS, Load) || !B::Get(IS, Temperature))
+			return false;
+		C.VerifiedCertificate = (GWObjects::CertificateValidation)Verified;
+		C.hasGPS = HasGPS != 0;
+		C.memoryUsed = MemoryUsed;
+		C.load = Load;
+		C.temperature = Temperature;
+		C.Connected = false;
+		return true;
+	}
+
+	void DeviceShadow::SetConnection(std::uint64_t SerialNumber,
+									 const GWObjects::ConnectionState &State) {
+		if (Enabled_)
+			Table_.SetConnection(SerialNumber, PackConnection(State));
+	}
+
+	void DeviceShadow::ClearCapabilities(std::uint64_t SerialNumber) {
+		Table_.ClearCapabilities(SerialNumber);
+	}
+
+	void DeviceShadow::Remove(std::uint64_t SerialNumber) { Table_.Remove(SerialNumber); }
+
+	void DeviceShadow::RemoveStatistics(const std::string &SerialNumber, std::uint64_t FromDate,
+										std::uint64_t ToDate) {
+		if (SerialNumber.empty())
+			Table_.RemoveAllStatistics(FromDate, ToDate);
+		else
+			Table_.RemoveStatistics(Utils::SerialNumberToInt(SerialNumber), FromDate, ToDate);
+	}
+
+	void DeviceShadow::RemoveHealthChecks(const std::string &SerialNumber, std::uint64_t FromDate,
+										  std::uint64_t ToDate) {
+		if (SerialNumber.empty())
+			Table_.RemoveAllHealthChecks(FromDate, ToDate);
+		else
+			Table_.RemoveHealthChecks(Utils::SerialNumberToInt(SerialNumber), FromDate, ToDate);
+	}
+
+	void DeviceShadow::RemoveStatisticsOlderThan(std::uint64_t Date) {
+		if (Date > 0)
+			Table_.RemoveAllStatistics(0, Date - 1);
+	}
+
+	void DeviceShadow::RemoveHealthChecksOlderThan(std::uint64_t Date) {
+		if (Date > 0)
+			Table_.RemoveAllHealthChecks(0, Date - 1);
+	}
+
+	bool DeviceShadow::GetNewestStatistics(std::uint64_t SerialNumber, std::uint64_t HowMany,
+										   std::vector<GWObjects::Statistics> &Stats) {
+		std::vector<DeviceShadowTable::Statistics> Newest;
+		if (!Table_.GetNewestStatistics(SerialNumber, HowMany, Newest))
+			return false;
+		//	inflated once out of the lock
+		auto SerialNumberStr = Utils::IntToSerialNumber(SerialNumber);
+		Stats.clear();
+		for (const auto &Stored : Newest) {
+			GWObjects::Statistics Entry;
+			Entry.SerialNumber = SerialNumberStr;
+			Entry.UUID = Stored.UUID;
+			Entry.Recorded = Stored.Recorded;
+			Entry.Data = Stored.Data.Text();
+			Stats.emplace_back(std::move(Entry));
+		}
+		return true;
+	}
+
+	bool DeviceShadow::GetNewestHealthChecks(std::uint64_t SerialNumber, std::uint64_t HowMany,
+											 std::vector<GWObjects::HealthCheck> &Checks) {
+		std::vector<DeviceShadowTable::HealthCheck> Newest;
+		if (!Table_.GetNewestHealthChecks(SerialNumber, HowMany, Newest))
+			return false;
+		auto SerialNumberStr = Utils::IntToSerialNumber(SerialNumber);
+		Checks.clear();
+		for (auto &Stored : Newest) {
+			GWObjects::HealthCheck Check;
+			Check.SerialNumber = SerialNumberStr;
+			Check.UUID = Stored.UUID;
+			Check.Recorded = Stored.Recorded;
+			Check.Sanity = Stored.Sanity;
+			Check.Data = std::move(Stored.Data);
+			Checks.emplace_back(std::move(Check));
+		}
+		return true;
+	}
+
+	bool DeviceShadow::GetCapabilities(std::uint64_t SerialNumber, GWObjects::Capabilities &Caps) {
+		DeviceShadowTable::Capabilities Stored;
+		if (!Table_.GetCapabilities(SerialNumber, Stored))
+			return false;
+		Caps.Capabilities = std::move(Stored.Text);
+		Caps.FirstUpdate = Stored.FirstUpdate;
+		Caps.LastUpdate = Stored.LastUpdate;
+		return true;
+	}
+
+	bool DeviceShadow::GetConnection(std::uint64_t SerialNumber,
+									 GWObjects::ConnectionState &State) {
+		std::string Packed;
+		return Table_.GetConnection(SerialNumber, Packed) && UnpackConnection(Packed, State);
+	}
+
+	//	The table is written deflated to a temporary file, which then replaces the previous one.
+	void DeviceShadow::Save() {
+		auto Start = std::chrono::steady_clock::now();
+		auto TempName = FileName_ + ".tmp";
+		try {
+			std::uint64_t Devices = 0;
+			{
+				std::ofstream OF(TempName, std::ios::binary | std::ios::trunc);
+				Poco::DeflatingOutputStream Deflater(OF, Poco::DeflatingStreamBuf::STREAM_ZLIB);
+				Devices = Table_.Save(Deflater);
+				Deflater.close();
+				if (!OF)
+					throw std::runtime_error("write failed");
+			}
+			Poco::File Temp(TempName);
+			CheckpointBytes_ = Temp.getSize();
+			Temp.renameTo(FileName_);
+			LastCheckpoint_ = Utils::Now();
+			CheckpointMs_ = std::chrono::duration_cast<std::chrono::milliseconds>(
+								std::chrono::steady_clock::now() - Start)
+								.count();
+			poco_debug(Logger(), fmt::format("Saved {} devices in {}ms.", Devices,
+											 CheckpointMs_.load()));
+		} catch (const Poco::Exception &E) {
+			Logger().log(E);
+			Table_.MarkChanged();
+		} catch (const std::exception &E) {
+			poco_warning(Logger(), fmt::format("Could not save {}: {}", FileName_, E.what()));
+			Table_.MarkChanged();
+		}
+	}
+
+	void DeviceShadow::Load() {
+		if (!Poco::File(FileName_).exists())
+			return;
+		std::uint64_t Devices = 0;
+		try {
+			std::ifstream IF(FileName_, std::ios::binary);
+			Poco::InflatingInputStream Inflater(IF, Poco::InflatingStreamBuf::STREAM_ZLIB);
+			if (!Table_.Load(Inflater, CompressStatistics_, CompressionLevel_, Devices))
+				poco_warning(Logger(), fmt::format("{} is not a complete device shadow file of "
+												   "this version.",
+												   FileName_));
+		} catch (const Poco::Exception &E) {
+			Logger().log(E);
+		} catch (const std::exception &E) {
+			poco_warning(Logger(), fmt::format("Could not load {}: {}", FileName_, E.what()));
+		}
+		//	what was loaded is already on disk
+		Table_.TakeChanged();
+		poco_information(Logger(), fmt::format("Loaded {} devices from {}.", Devices, FileName_));
+	}
+
+	bool DeviceShadow::GetResourceStatistics(Poco::JSON::Object &Stats) {
+		if (!Enabled_)
+			return false;
+		auto Usage = Table_.GetUsage();
+		Stats.set("devices", Usage.Devices);
+		//	held bytes may be shared with the connections' last state reports
+		Stats.set("statisticsRawBytes", Usage.StatisticsRawBytes);
+		Stats.set("statisticsHeldBytes", Usage.StatisticsHeldBytes);
+		Stats.set("lastCheckpoint", LastCheckpoint_.load());
+		Stats.set("checkpointMs", CheckpointMs_.load());
+		Stats.set("checkpointBytes", CheckpointBytes_.load());
+		return true;
+	}
+
+} // namespace OpenWifi
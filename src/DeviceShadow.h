@@ -0,0 +1,87 @@
+//
+//	License type: BSD 3-Clause License
+//	License copy: https://github.com/Telecominfraproject/wlan-cloud-ucentralgw/blob/master/LICENSE
+//
+
+#pragma once
+
+#include "Poco/Thread.h"
+
+#include "CompressedText.h"
+#include "DeviceShadowTable.h"
+#include "RESTObjects/RESTAPI_GWobjects.h"
+#include "framework/SubSystemServer.h"
+
+namespace OpenWifi {
+
+	//	Last known state, healthchecks, capabilities and connection details of every device,
+	//	connected or not. REST answers status, capabilities and newest record queries from here
+	//	instead of the database. The shadow is saved to a compressed file in the data directory
+	//	every checkpoint interval and on shutdown, and reloaded on startup.
+	class DeviceShadow : public SubSystemServer, Poco::Runnable {
+	  public:
+		static auto instance() {
+			static auto instance_ = new DeviceShadow;
+			return instance_;
+		}
+
+		int Start() override;
+		void Stop() override;
+		void run() override;
+		bool GetResourceStatistics(Poco::JSON::Object &Stats) override;
+
+		//	Data is usually the report the connection holds, which is then shared.
+		void SetStatistics(std::uint64_t SerialNumber, std::uint64_t UUID, std::uint64_t Recorded,
+						   const CompressedText &Data);
+		void SetHealthCheck(std::uint64_t SerialNumber, const GWObjects::HealthCheck &Check);
+		//	LastUpdate is the time stored with the capabilities in the database.
+		void SetCapabilities(std::uint64_t SerialNumber, const std::string &Capabilities,
+							 std::uint64_t LastUpdate);
+		//	Kept when the device disconnects, with Connected false.
+		void SetConnection(std::uint64_t SerialNumber, const GWObjects::ConnectionState &State);
+		void ClearCapabilities(std::uint64_t SerialNumber);
+		void Remove(std::uint64_t SerialNumber);
+		//	Follow the database deletes: records recorded from FromDate to ToDate included, a
+		//	date of 0 leaving that end open, of one device or of all when SerialNumber is empty.
+		void RemoveStatistics(const std::string &SerialNumber, std::uint64_t FromDate,
+							  std::uint64_t ToDate);
+		void RemoveHealthChecks(const std::string &SerialNumber, std::uint64_t FromDate,
+								std::uint64_t ToDate);
+		//	Follow the archiver removing records recorded before Date.
+		void RemoveStatisticsOlderThan(std::uint64_t Date);
+		void RemoveHealthChecksOlderThan(std::uint64_t Date);
+
+		//	The newest queries return false when the shadow holds fewer than HowMany records,
+		//	so the caller goes to the database.
+		bool GetNewestStatistics(std::uint64_t SerialNumber, std::uint64_t HowMany,
+								 std::vector<GWObjects::Statistics> &Stats);
+		bool GetNewestHealthChecks(std::uint64_t SerialNumber, std::uint64_t HowMany,
+								   std::vector<GWObjects::HealthCheck> &Checks);
+		bool GetCapabilities(std::uint64_t SerialNumber, GWObjects::Capabilities &Caps);
+		bool GetConnection(std::uint64_t SerialNumber, GWObjects::ConnectionState &State);
+
+		inline bool Enabled() const { return Enabled_; }
+
+	  private:
+		std::atomic_bool Running_ = false;
+		bool Enabled_ = true;
+		//	how statistics loaded from the file are held, as openwifi.session.laststats.*
+		bool CompressStatistics_ = false;
+		int CompressionLevel_ = 1;
+		std::uint64_t Checkpoint_ = 60;
+		std::string FileName_;
+		Poco::Thread Worker_;
+		DeviceShadowTable Table_;
+		std::atomic_uint64_t LastCheckpoint_ = 0;
+		std::atomic_uint64_t CheckpointMs_ = 0;
+		std::atomic_uint64_t CheckpointBytes_ = 0;
+
+		void Load();
+		void Save();
+
+		DeviceShadow() noexcept : SubSystemServer("DeviceShadow", "DEVICE-SHADOW", "deviceshadow") {}
+	};
+
+	inline auto DeviceShadow() { return DeviceShadow::instance(); }
+
+} // namespace OpenWifi
@@ -0,0 +1,314 @@
+//
+//	License type: BSD 3-Clause License
+//	License copy: https://github.com/Telecominfraproject/wlan-cloud-ucentralgw/blob/master/LICENSE
+//
+
+#include "DeviceShadowTable.h"
+
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+#include <utility>
+
+namespace OpenWifi {
+
+	static constexpr std::uint64_t TableMagic = 0x4f575348; //	"OWSH"
+	static constexpr std::uint64_t TableVersion = 2;
+
+	void DeviceShadowTable::Binary::Put(std::ostream &OS, std::uint64_t Value) {
+		char Bytes[8];
+		for (auto &B : Bytes) {
+			B = (char)(Value & 0xff);
+			Value >>= 8;
+		}
+		OS.write(Bytes, sizeof(Bytes));
+	}
+
+	void DeviceShadowTable::Binary::Put(std::ostream &OS, const std::string &Value) {
+		Put(OS, (std::uint64_t)Value.size());
+		OS.write(Value.data(), (std::streamsize)Value.size());
+	}
+
+	void DeviceShadowTable::Binary::Put(std::ostream &OS, double Value) {
+		std::uint64_t Bits;
+		std::memcpy(&Bits, &Value, sizeof(Bits));
+		Put(OS, Bits);
+	}
+
+	bool DeviceShadowTable::Binary::Get(std::istream &IS, std::uint64_t &Value) {
+		unsigned char Bytes[8];
+		if (!IS.read((char *)Bytes, sizeof(Bytes)))
+			return false;
+		Value = 0;
+		for (int i = 7; i >= 0; i--)
+			Value = (Value << 8) | Bytes[i];
+		return true;
+	}
+
+	bool DeviceShadowTable::Binary::Get(std::istream &IS, std::string &Value) {
+		std::uint64_t Size = 0;
+		if (!Get(IS, Size))
+			return false;
+		//	read in pieces, so a damaged length cannot ask for all the memory at once
+		Value.clear();
+		char Buffer[4096];
+		while (Size > 0) {
+			auto Piece = (std::streamsize)std::min<std::uint64_t>(Size, sizeof(Buffer));
+			if (!IS.read(Buffer, Piece))
+				return false;
+			Value.append(Buffer, (std::size_t)Piece);
+			Size -= (std::uint64_t)Piece;
+		}
+		return true;
+	}
+
+	bool DeviceShadowTable::Binary::Get(std::istream &IS, double &Value) {
+		std::uint64_t Bits = 0;
+		if (!Get(IS, Bits))
+			return false;
+		std::memcpy(&Value, &Bits, sizeof(Value));
+		return true;
+	}
+
+	template <typename F> void DeviceShadowTable::Update(std::uint64_t SerialNumber, F Change) {
+		auto &S = ShardOf(SerialNumber);
+		{
+			std::unique_lock G(S.Mutex);
+			Change(S.Records[SerialNumber]);
+		}
+		Changed_ = true;
+	}
+
+	template <typename F> void DeviceShadowTable::UpdateAll(F Change) {
+		for (auto &S : Shards_) {
+			std::unique_lock G(S.Mutex);
+			for (auto &[SerialNumber, R] : S.Records) {
+				if (Change(R))
+					Changed_ = true;
+			}
+		}
+	}
+
+	void DeviceShadowTable::SetStatistics(std::uint64_t SerialNumber, Statistics Stats) {
+		Update(SerialNumber, [&](Record &R) {
+			R.Stats.push_front(std::move(Stats));
+			if (R.Stats.size() > History_)
+				R.Stats.pop_back();
+		});
+	}
+
+	void DeviceShadowTable::SetHealthCheck(std::uint64_t SerialNumber, HealthCheck Check) {
+		Update(SerialNumber, [&](Record &R) {
+			R.Checks.push_front(std::move(Check));
+			if (R.Checks.size() > History_)
+				R.Checks.pop_back();
+		});
+	}
+
+	void DeviceShadowTable::SetCapabilities(std::uint64_t SerialNumber, const std::string &Text,
+											std::uint64_t LastUpdate) {
+		Update(SerialNumber, [&](Record &R) {
+			if (R.Caps.FirstUpdate == 0)
+				R.Caps.FirstUpdate = LastUpdate;
+			R.Caps.LastUpdate = LastUpdate;
+			R.Caps.Text = Text;
+		});
+	}
+
+	void DeviceShadowTable::SetConnection(std::uint64_t SerialNumber, std::string Connection) {
+		Update(SerialNumber, [&](Record &R) { R.Connection = std::move(Connection); });
+	}
+
+	void DeviceShadowTable::ClearCapabilities(std::uint64_t SerialNumber) {
+		Update(SerialNumber, [](Record &R) { R.Caps = Capabilities{}; });
+	}
+
+	void DeviceShadowTable::Remove(std::uint64_t SerialNumber) {
+		auto &S = ShardOf(SerialNumber);
+		std::unique_lock G(S.Mutex);
+		if (S.Records.erase(SerialNumber))
+			Changed_ = true;
+	}
+
+	template <typename Records>
+	static bool RemoveRecorded(Records &List, std::uint64_t FromDate, std::uint64_t ToDate) {
+		auto Size = List.size();
+		List.erase(std::remove_if(List.begin(), List.end(),
+								  [&](const auto &E) {
+									  return (FromDate == 0 || E.Recorded >= FromDate) &&
+											 (ToDate == 0 || E.Recorded <= ToDate);
+								  }),
+				   List.end());
+		return List.size() != Size;
+	}
+
+	void DeviceShadowTable::RemoveStatistics(std::uint64_t SerialNumber, std::uint64_t FromDate,
+											 std::uint64_t ToDate) {
+		auto &S = ShardOf(SerialNumber);
+		std::unique_lock G(S.Mutex);
+		auto Hint = S.Records.find(SerialNumber);
+		if (Hint != S.Records.end() && RemoveRecorded(Hint->second.Stats, FromDate, ToDate))
+			Changed_ = true;
+	}
+
+	void DeviceShadowTable::RemoveHealthChecks(std::uint64_t SerialNumber, std::uint64_t FromDate,
+											   std::uint64_t ToDate) {
+		auto &S = ShardOf(SerialNumber);
+		std::unique_lock G(S.Mutex);
+		auto Hint = S.Records.find(SerialNumber);
+		if (Hint != S.Records.end() && RemoveRecorded(Hint->second.Checks, FromDate, ToDate))
+			Changed_ = true;
+	}
+
+	void DeviceShadowTable::RemoveAllStatistics(std::uint64_t FromDate, std::uint64_t ToDate) {
+		UpdateAll([&](Record &R) { return RemoveRecorded(R.Stats, FromDate, ToDate); });
+	}
+
+	void DeviceShadowTable::RemoveAllHealthChecks(std::uint64_t FromDate, std::uint64_t ToDate) {
+		UpdateAll([&](Record &R) { return RemoveRecorded(R.Checks, FromDate, ToDate); });
+	}
+
+	bool DeviceShadowTable::GetNewestStatistics(std::uint64_t SerialNumber, std::uint64_t HowMany,
+												std::vector<Statistics> &Stats) const {
+		auto &S = ShardOf(SerialNumber);
+		std::shared_lock G(S.Mutex);
+		auto Hint = S.Records.find(SerialNumber);
+		if (Hint == S.Records.end() || HowMany == 0 || Hint->second.Stats.size() < HowMany)
+			return false;
+		Stats.assign(Hint->second.Stats.begin(), Hint->second.Stats.begin() + HowMany);
+		return true;
+	}
+
+	bool DeviceShadowTable::GetNewestHealthChecks(std::uint64_t SerialNumber, std::uint64_t HowMany,
+												  std::vector<HealthCheck> &Checks) const {
+		auto &S = ShardOf(SerialNumber);
+		std::shared_lock G(S.Mutex);
+		auto Hint = S.Records.find(SerialNumber);
+		if (Hint == S.Records.end() || HowMany == 0 || Hint->second.Checks.size() < HowMany)
+			return false;
+		Checks.assign(Hint->second.Checks.begin(), Hint->second.Checks.begin() + HowMany);
+		return true;
+	}
+
+	bool DeviceShadowTable::GetCapabilities(std::uint64_t SerialNumber, Capabilities &Caps) const {
+		auto &S = ShardOf(SerialNumber);
+		std::shared_lock G(S.Mutex);
+		auto Hint = S.Records.find(SerialNumber);
+		if (Hint == S.Records.end() || Hint->second.Caps.Text.empty())
+			return false;
+		Caps = Hint->second.Caps;
+		return true;
+	}
+
+	bool DeviceShadowTable::GetConnection(std::uint64_t SerialNumber,
+										  std::string &Connection) const {
+		auto &S = ShardOf(SerialNumber);
+		std::shared_lock G(S.Mutex);
+		auto Hint = S.Records.find(SerialNumber);
+		if (Hint == S.Records.end() || Hint->second.Connection.empty())
+			return false;
+		Connection = Hint->second.Connection;
+		return true;
+	}
+
+	DeviceShadowTable::Usage DeviceShadowTable::GetUsage() const {
+		Usage U;
+		for (const auto &S : Shards_) {
+			std::shared_lock G(S.Mutex);
+			U.Devices += S.Records.size();
+			for (const auto &[SerialNumber, R] : S.Records) {
+				for (const auto &Stats : R.Stats) {
+					U.StatisticsRawBytes += Stats.Data.RawSize();
+					U.StatisticsHeldBytes += Stats.Data.HeldSize();
+				}
+			}
+		}
+		return U;
+	}
+
+	//	Layout: magic, version, then for each device a 1, its serial number, its statistics,
+	//	healthchecks, capabilities and connection details, and a 0 after the last one.
+	std::uint64_t DeviceShadowTable::Save(std::ostream &OS) const {
+		std::uint64_t Devices = 0;
+		Binary::Put(OS, TableMagic);
+		Binary::Put(OS, TableVersion);
+		for (const auto &S : Shards_) {
+			std::vector<std::pair<std::uint64_t, Record>> Copy;
+			{
+				std::shared_lock G(S.Mutex);
+				Copy.assign(S.Records.begin(), S.Records.end());
+			}
+			for (const auto &[SerialNumber, R] : Copy) {
+				Binary::Put(OS, (std::uint64_t)1);
+				Binary::Put(OS, SerialNumber);
+				Binary::Put(OS, (std::uint64_t)R.Stats.size());
+				for (const auto &Stats : R.Stats) {
+					Binary::Put(OS, Stats.UUID);
+					Binary::Put(OS, Stats.Recorded);
+					Binary::Put(OS, Stats.Data.Text());
+				}
+				Binary::Put(OS, (std::uint64_t)R.Checks.size());
+				for (const auto &Check : R.Checks) {
+					Binary::Put(OS, Check.UUID);
+					Binary::Put(OS, Check.Recorded);
+					Binary::Put(OS, Check.Sanity);
+					Binary::Put(OS, Check.Data);
+				}
+				Binary::Put(OS, R.Caps.Text);
+				Binary::Put(OS, R.Caps.FirstUpdate);
+				Binary::Put(OS, R.Caps.LastUpdate);
+				Binary::Put(OS, R.Connection);
+				Devices++;
+			}
+		}
+		Binary::Put(OS, (std::uint64_t)0);
+		return Devices;
+	}
+
+	bool DeviceShadowTable::Load(std::istream &IS, bool CompressStatistics, int CompressionLevel,
+								 std::uint64_t &Devices) {
+		Devices = 0;
+		std::uint64_t Magic = 0, Version = 0, More = 0;
+		if (!Binary::Get(IS, Magic) || !Binary::Get(IS, Version) || Magic != TableMagic ||
+			Version != TableVersion)
+			return false;
+		while (Binary::Get(IS, More)) {
+			if (More == 0)
+				return true;
+			std::uint64_t SerialNumber = 0, Count = 0;
+			Record Rec;
+			if (!Binary::Get(IS, SerialNumber) || !Binary::Get(IS, Count))
+				return false;
+			for (std::uint64_t i = 0; i < Count; i++) {
+				Statistics Stats;
+				std::string Data;
+				if (!Binary::Get(IS, Stats.UUID) || !Binary::Get(IS, Stats.Recorded) ||
+					!Binary::Get(IS, Data))
+					return false;
+				if (Rec.Stats.size() < History_) {
+					Stats.Data = CompressedText(Data, CompressStatistics, CompressionLevel);
+					Rec.Stats.push_back(std::move(Stats));
+				}
+			}
+			if (!Binary::Get(IS, Count))
+				return false;
+			for (std::uint64_t i = 0; i < Count; i++) {
+				HealthCheck Check;
+				if (!Binary::Get(IS, Check.UUID) || !Binary::Get(IS, Check.Recorded) ||
+					!Binary::Get(IS, Check.Sanity) || !Binary::Get(IS, Check.Data))
+					return false;
+				if (Rec.Checks.size() < History_)
+					Rec.Checks.push_back(std::move(Check));
+			}
+			if (!Binary::Get(IS, Rec.Caps.Text) || !Binary::Get(IS, Rec.Caps.FirstUpdate) ||
+				!Binary::Get(IS, Rec.Caps.LastUpdate) || !Binary::Get(IS, Rec.Connection))
+				return false;
+			auto &S = ShardOf(SerialNumber);
+			std::unique_lock G(S.Mutex);
+			S.Records[SerialNumber] = std::move(Rec);
+			Devices++;
+		}
+		return false;
+	}
+
+} // namespace OpenWifi
@@ -0,0 +1,140 @@
+//
+//	License type: BSD 3-Clause License
+//	License copy: https://github.com/Telecominfraproject/wlan-cloud-ucentralgw/blob/master/LICENSE
+//
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <istream>
+#include <ostream>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "CompressedText.h"
+
+namespace OpenWifi {
+
+	//	The records behind DeviceShadow: the newest statistics and healthchecks, the
+	//	capabilities and the last connection details of each device, in shards that each have
+	//	their own lock. Records are kept newest first, at most History of each per device.
+	class DeviceShadowTable {
+	  public:
+		struct Statistics {
+			std::uint64_t UUID = 0;
+			std::uint64_t Recorded = 0;
+			CompressedText Data;
+		};
+
+		struct HealthCheck {
+			std::uint64_t UUID = 0;
+			std::uint64_t Recorded = 0;
+			std::uint64_t Sanity = 0;
+			std::string Data;
+		};
+
+		struct Capabilities {
+			std::string Text;
+			std::uint64_t FirstUpdate = 0;
+			std::uint64_t LastUpdate = 0;
+		};
+
+		struct Usage {
+			std::uint64_t Devices = 0;
+			std::uint64_t StatisticsRawBytes = 0;
+			std::uint64_t StatisticsHeldBytes = 0;
+		};
+
+		//	Little endian integers and length prefixed strings, for the file and for the
+		//	connection details the caller packs.
+		struct Binary {
+			static void Put(std::ostream &OS, std::uint64_t Value);
+			static void Put(std::ostream &OS, const std::string &Value);
+			static void Put(std::ostream &OS, double Value);
+			static bool Get(std::istream &IS, std::uint64_t &Value);
+			static bool Get(std::istream &IS, std::string &Value);
+			static bool Get(std::istream &IS, double &Value);
+		};
+
+		explicit DeviceShadowTable(std::uint64_t History = 1) : History_(History ? History : 1) {}
+
+		//	Only before the table is used.
+		inline void SetHistory(std::uint64_t History) { History_ = History ? History : 1; }
+
+		void SetStatistics(std::uint64_t SerialNumber, Statistics Stats);
+		void SetHealthCheck(std::uint64_t SerialNumber, HealthCheck Check);
+		void SetCapabilities(std::uint64_t SerialNumber, const std::string &Text,
+							 std::uint64_t LastUpdate);
+		//	Connection is packed by the caller; empty means none.
+		void SetConnection(std::uint64_t SerialNumber, std::string Connection);
+		void ClearCapabilities(std::uint64_t SerialNumber);
+		void Remove(std::uint64_t SerialNumber);
+
+		//	Remove the records recorded from FromDate to ToDate included, as the database deletes
+		//	do: a date of 0 leaves that end open. The All variants apply to every device.
+		void RemoveStatistics(std::uint64_t SerialNumber, std::uint64_t FromDate,
+							  std::uint64_t ToDate);
+		void RemoveHealthChecks(std::uint64_t SerialNumber, std::uint64_t FromDate,
+								std::uint64_t ToDate);
+		void RemoveAllStatistics(std::uint64_t FromDate, std::uint64_t ToDate);
+		void RemoveAllHealthChecks(std::uint64_t FromDate, std::uint64_t ToDate);
+
+		//	The newest queries return false when the table holds fewer than HowMany records,
+		//	which may not be all there are.
+		bool GetNewestStatistics(std::uint64_t SerialNumber, std::uint64_t HowMany,
+								 std::vector<Statistics> &Stats) const;
+		bool GetNewestHealthChecks(std::uint64_t SerialNumber, std::uint64_t HowMany,
+								   std::vector<HealthCheck> &Checks) const;
+		bool GetCapabilities(std::uint64_t SerialNumber, Capabilities &Caps) const;
+		bool GetConnection(std::uint64_t SerialNumber, std::string &Connection) const;
+
+		[[nodiscard]] Usage GetUsage() const;
+
+		//	True once after any change, so the caller knows when to save.
+		inline bool TakeChanged() { return Changed_.exchange(false); }
+		inline void MarkChanged() { Changed_ = true; }
+
+		//	Shards are copied out one at a time, so writers are not held up while the stream
+		//	is written. Returns the number of devices written.
+		std::uint64_t Save(std::ostream &OS) const;
+		//	Adds the devices read, holding their statistics as given. Returns false if the
+		//	stream is not a table of this version or is cut short; the devices read before
+		//	are kept.
+		bool Load(std::istream &IS, bool CompressStatistics, int CompressionLevel,
+				  std::uint64_t &Devices);
+
+	  private:
+		static constexpr std::size_t NumberOfShards = 64;
+
+		struct Record {
+			std::deque<Statistics> Stats;
+			std::deque<HealthCheck> Checks;
+			Capabilities Caps;
+			std::string Connection;
+		};
+
+		struct Shard {
+			mutable std::shared_mutex Mutex;
+			std::unordered_map<std::uint64_t, Record> Records;
+		};
+
+		std::uint64_t History_;
+		std::array<Shard, NumberOfShards> Shards_;
+		std::atomic_bool Changed_ = false;
+
+		inline Shard &ShardOf(std::uint64_t SerialNumber) {
+			return Shards_[SerialNumber % NumberOfShards];
+		}
+		inline const Shard &ShardOf(std::uint64_t SerialNumber) const {
+			return Shards_[SerialNumber % NumberOfShards];
+		}
+		template <typename F> void Update(std::uint64_t SerialNumber, F Change);
+		template <typename F> void UpdateAll(F Change);
+	};
+
+} // namespace OpenWifi
@@ -0,0 +1,141 @@
+//
+//	License type: BSD 3-Clause License
+//	License copy: https://github.com/Telecominfraproject/wlan-cloud-ucentralgw/blob/master/LICENSE
+//
+
+#include "DisconnectionCleanup.h"
+
+#include "RADIUSSessionTracker.h"
+#include "StorageService.h"
+
+#include "fmt/format.h"
+#include "framework/KafkaManager.h"
+#include "framework/MicroServiceFuncs.h"
+#include "framework/ow_constants.h"
+#include "framework/utils.h"
+
+namespace OpenWifi {
+
+	int DisconnectionCleanup::Start() {
+		poco_notice(Logger(), "Starting...");
+		Interval_ = MicroServiceConfigGetInt("disconnection.cleanup.interval", 1000);
+		BatchSize_ = MicroServiceConfigGetInt("disconnection.cleanup.batchsize", 500);
+		MaxBacklog_ = MicroServiceConfigGetInt("disconnection.cleanup.maxbacklog", 100000);
+		if (BatchSize_ == 0)
+			BatchSize_ = 1;
+
+		Running_ = true;
+		Worker_.start(*this);
+		return 0;
+	}
+
+	void DisconnectionCleanup::Stop() {
+		poco_notice(Logger(), "Stopping...");
+		if (Running_) {
+			{
+				std::lock_guard G(QueueMutex_);
+				Running_ = false;
+			}
+			QueueReady_.notify_all();
+			Worker_.join();
+		}
+		poco_notice(Logger(), "Stopped...");
+	}
+
+	void DisconnectionCleanup::run() {
+		Utils::SetThreadName("disc:cleanup");
+		while (Running_) {
+			{
+				std::unique_lock G(QueueMutex_);
+				QueueReady_.wait_for(G, std::chrono::milliseconds(Interval_),
+									 [this] { return !Running_ || Pending_.size() >= BatchSize_; });
+			}
+			FlushAll();
+		}
+		//	Contacts of devices disconnected by the shutdown are saved too.
+		FlushAll();
+	}
+
+	void DisconnectionCleanup::DeviceDisconnected(const std::string &SerialNumber,
+												  std::uint64_t UUID, std::uint64_t LastContact) {
+		Announce(SerialNumber, UUID);
+		if (LastContact == 0)
+			return;
+		bool Wake = false;
+		{
+			std::lock_guard G(QueueMutex_);
+			auto SerialNumberInt = Utils::SerialNumberToInt(SerialNumber);
+			auto Hint = Pending_.find(SerialNumberInt);
+			if (Hint != Pending_.end()) {
+				//	a device seen twice before its row was written is written once
+				Hint->second.second = std::max(Hint->second.second, LastContact);
+			} else if (Pending_.size() < MaxBacklog_) {
+				Pending_.emplace(SerialNumberInt, Contact{SerialNumber, LastContact});
+				Wake = Running_ && Pending_.size() >= BatchSize_;
+			} else {
+				//	too far behind: this last contact time is not saved
+				Overflows_++;
+			}
+		}
+		if (Wake)
+			QueueReady_.notify_one();
+	}
+
+	void DisconnectionCleanup::Announce(const std::string &SerialNumber, std::uint64_t UUID) {
+		if (KafkaManager()->Enabled()) {
+			try {
+				Poco::JSON::Object Disconnect;
+				Poco::JSON::Object Details;
+				Details.set(uCentralProtocol::SERIALNUMBER, SerialNumber);
+				Details.set(uCentralProtocol::TIMESTAMP, Utils::Now());
+				Details.set(uCentralProtocol::UUID, UUID);
+				Disconnect.set(uCentralProtocol::DISCONNECTION, Details);
+				KafkaManager()->PostMessage(KafkaTopics::CONNECTION, SerialNumber, Disconnect);
+			} catch (...) {
+			}
+		}
+		RADIUSSessionTracker()->DeviceDisconnect(SerialNumber);
+	}
+
+	void DisconnectionCleanup::SaveContacts(const Batch &Contacts) {
+		bool Saved = false;
+		try {
+			Saved = StorageService()->SetDevicesLastRecordedContact(Contacts);
+		} catch (...) {
+			poco_warning(Logger(), "Exception while saving last contact times.");
+		}
+		std::lock_guard G(QueueMutex_);
+		Processed_ += Contacts.size();
+		if (!Saved)
+			ContactsFailed_ += Contacts.size();
+	}
+
+	void DisconnectionCleanup::FlushAll() {
+		std::unordered_map<std::uint64_t, Contact> Pending;
+		{
+			std::lock_guard G(QueueMutex_);
+			Pending.swap(Pending_);
+		}
+		Batch Contacts;
+		Contacts.reserve(std::min<std::size_t>(Pending.size(), BatchSize_));
+		for (auto &[SerialNumber, C] : Pending) {
+			Contacts.emplace_back(std::move(C));
+			if (Contacts.size() == BatchSize_) {
+				SaveContacts(Contacts);
+				Contacts.clear();
+			}
+		}
+		if (!Contacts.empty())
+			SaveContacts(Contacts);
+	}
+
+	bool DisconnectionCleanup::GetResourceStatistics(Poco::JSON::Object &Stats) {
+		std::lock_guard G(QueueMutex_);
+		Stats.set("backlog", Pending_.size());
+		Stats.set("processed", Processed_);
+		Stats.set("overflows", Overflows_);
+		Stats.set("contactsFailed", ContactsFailed_);
+		return true;
+	}
+
+} // namespace OpenWifi
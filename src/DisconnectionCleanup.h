@@ -0,0 +1,67 @@
+//
+//	License type: BSD 3-Clause License
+//	License copy: https://github.com/Telecominfraproject/wlan-cloud-ucentralgw/blob/master/LICENSE
+//
+
+#pragma once
+
+#include <condition_variable>
+#include <mutex>
+#include <unordered_map>
+
+#include "Poco/Thread.h"
+
+#include "framework/SubSystemServer.h"
+
+namespace OpenWifi {
+
+	//	Work left when a device disconnects: the Kafka disconnection event, ending its RADIUS
+	//	sessions and saving its last contact time. The first two only queue a message, so they
+	//	are done by the closing connection and come before any later connect event. The last
+	//	contact times are written by a single thread in batches, so many devices dropping at
+	//	once neither start a thread each nor write their rows one by one.
+	class DisconnectionCleanup : public SubSystemServer, Poco::Runnable {
+	  public:
+		static auto instance() {
+			static auto instance_ = new DisconnectionCleanup;
+			return instance_;
+		}
+
+		int Start() override;
+		void Stop() override;
+		void run() override;
+		bool GetResourceStatistics(Poco::JSON::Object &Stats) override;
+
+		//	Never blocks on Kafka or the database.
+		void DeviceDisconnected(const std::string &SerialNumber, std::uint64_t UUID,
+								std::uint64_t LastContact);
+
+	  private:
+		using Contact = std::pair<std::string, std::uint64_t>;
+		using Batch = std::vector<Contact>;
+
+		std::atomic_bool Running_ = false;
+		std::uint64_t Interval_ = 1000;
+		std::uint64_t BatchSize_ = 500;
+		std::uint64_t MaxBacklog_ = 100000;
+		Poco::Thread Worker_;
+		std::mutex QueueMutex_;
+		std::condition_variable QueueReady_;
+		//	last contact time to save for each device
+		std::unordered_map<std::uint64_t, Contact> Pending_;
+		std::uint64_t Processed_ = 0;
+		std::uint64_t Overflows_ = 0;
+		std::uint64_t ContactsFailed_ = 0;
+
+		static void Announce(const std::string &SerialNumber, std::uint64_t UUID);
+		void SaveContacts(const Batch &Contacts);
+		void FlushAll();
+
+		DisconnectionCleanup() noexcept
+			: SubSystemServer("DisconnectionCleanup", "DISCONNECT-CLEANUP",
+							  "disconnection.cleanup") {}
+	};
+
+	inline auto DisconnectionCleanup() { return DisconnectionCleanup::instance(); }
+
+} // namespace OpenWifi
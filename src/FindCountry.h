@@ -4,11 +4,21 @@
 
 #pragma once
 
+#include <mutex>
+#include <set>
+
+#include "Poco/ExpireLRUCache.h"
 #include "Poco/Net/IPAddress.h"
+#include "Poco/Notification.h"
+#include "Poco/NotificationQueue.h"
+
+#include "IPToCountryTable.h"
 
 #include "framework/MicroServiceFuncs.h"
 #include "framework/SubSystemServer.h"
+#include "framework/utils.h"
 
+#include "fmt/format.h"
 #include "nlohmann/json.hpp"
 
 namespace OpenWifi {
@@ -125,7 +135,17 @@ namespace OpenWifi {
 		}
 	}
 
-	class FindCountryFromIP : public SubSystemServer {
+	class IPToCountryLookup : public Poco::Notification {
+	  public:
+		explicit IPToCountryLookup(const std::string &IP) : IP_(IP) {}
+		std::string IP_;
+	};
+
+	//	Lookups never wait on the network: an answer comes from the result cache, then from the
+	//	offline range file (iptocountry.file.source), and otherwise the default country is returned
+	//	while the remote provider is queried in the background. Its answer lands in the cache for
+	//	the next lookup of that address.
+	class FindCountryFromIP : public SubSystemServer, Poco::Runnable {
 	  public:
 		static auto instance() {
 			static auto instance_ = new FindCountryFromIP;
@@ -139,16 +159,39 @@ namespace OpenWifi {
 				Provider_ = IPLocationProvider<IPToCountryProvider, IPInfo, IPData, IP2Location>(
 					ProviderName_);
 				if (Provider_ != nullptr) {
-					Enabled_ = Provider_->Init();
+					RemoteEnabled_ = Provider_->Init();
 				}
 			}
+			auto Source = MicroServiceConfigPath("iptocountry.file.source", "");
+			if (!Source.empty()) {
+				auto Compiled = MicroServiceConfigPath("iptocountry.file.cache", Source + ".bin");
+				if (Table_.Load(Source, Compiled, Logger())) {
+					TableEnabled_ = true;
+					poco_notice(Logger(), fmt::format("Using {} IP ranges from {}.",
+													  Table_.Ranges(), Compiled));
+				}
+			}
+			Enabled_ = RemoteEnabled_ || TableEnabled_;
 			Default_ = MicroServiceConfigGetString("iptocountry.default", "US");
+			Cache_ = std::make_unique<Poco::ExpireLRUCache<std::string, std::string>>(
+				MicroServiceConfigGetInt("iptocountry.cache.size", 16384),
+				MicroServiceConfigGetInt("iptocountry.cache.expiry", 24 * 60 * 60) * 1000);
+			MaxPending_ = MicroServiceConfigGetInt("iptocountry.remote.queue", 10000);
+			if (RemoteEnabled_) {
+				//	set before the thread exists, so a Stop() right after Start() always joins it
+				Running_ = true;
+				Worker_.start(*this);
+			}
 			return 0;
 		}
 
 		inline void Stop() final {
 			poco_notice(Logger(), "Stopping...");
-			//	Nothing to do - just to provide the same look at the others.
+			if (RemoteEnabled_ && Running_) {
+				Running_ = false;
+				Lookups_.wakeUpAll();
+				Worker_.join();
+			}
 			poco_notice(Logger(), "Stopped...");
 		}
 
@@ -166,30 +209,93 @@ namespace OpenWifi {
 			return Get(ReformatAddress(IP.toString()));
 		}
 
-		inline std::string Get(const std::string &IP) {
+		inline std::string Get(const std::string &IP) { return Find(IP, false); }
+
+		//	Same as Get(), except that an address unknown locally waits for the remote provider.
+		//	Only meant for explicit requests, never for the device connection path.
+		inline std::string Resolve(const std::string &IP) { return Find(IP, true); }
+
+		inline auto Enabled() const { return Enabled_; }
+
+		inline void run() final {
+			Utils::SetThreadName("iptocountry");
+			Poco::AutoPtr<Poco::Notification> NextNotification(Lookups_.waitDequeueNotification());
+			while (NextNotification && Running_) {
+				auto Notification = dynamic_cast<IPToCountryLookup *>(NextNotification.get());
+				if (Notification != nullptr) {
+					Remote(Notification->IP_);
+					std::lock_guard G(Mutex_);
+					Pending_.erase(Notification->IP_);
+				}
+				NextNotification = Lookups_.waitDequeueNotification();
+			}
+		}
+
+	  private:
+		std::atomic_bool Enabled_ = false;
+		bool RemoteEnabled_ = false;
+		bool TableEnabled_ = false;
+		std::atomic_bool Running_ = false;
+		std::string Default_;
+		std::unique_ptr<IPToCountryProvider> Provider_;
+		std::string ProviderName_;
+		IPToCountryTable Table_;
+		std::unique_ptr<Poco::ExpireLRUCache<std::string, std::string>> Cache_;
+		Poco::NotificationQueue Lookups_;
+		Poco::Thread Worker_;
+		std::mutex Mutex_;
+		std::set<std::string> Pending_;
+		std::uint64_t MaxPending_ = 10000;
+
+		inline std::string Find(const std::string &Address, bool Wait) {
 			if (!Enabled_)
 				return Default_;
+			auto IP = ReformatAddress(Address);
+			auto Hit = Cache_->get(IP);
+			if (!Hit.isNull())
+				return *Hit;
+
+			if (TableEnabled_) {
+				Poco::Net::IPAddress A;
+				if (Poco::Net::IPAddress::tryParse(IP, A)) {
+					auto Country = Table_.Find(A);
+					if (!Country.empty()) {
+						Cache_->add(IP, Country);
+						return Country;
+					}
+				}
+			}
+
+			if (RemoteEnabled_) {
+				if (Wait) {
+					auto Country = Remote(IP);
+					if (!Country.empty())
+						return Country;
+				} else {
+					std::lock_guard G(Mutex_);
+					if (Pending_.size() < MaxPending_ && Pending_.insert(IP).second)
+						Lookups_.enqueueNotification(new IPToCountryLookup(IP));
+				}
+			}
+			return Default_;
+		}
+
+		inline std::string Remote(const std::string &IP) {
 			try {
 				std::string URL = Provider_->URI(IP).toString();
 				std::string Response;
 				if (Utils::wgets(URL, Response)) {
 					auto Answer = Provider_->Country(Response);
-					if (!Answer.empty())
+					if (!Answer.empty()) {
+						Cache_->add(IP, Answer);
 						return Answer;
+					}
 				}
 			} catch (...) {
 			}
-			return Default_;
+			return "";
 		}
 
-		inline auto Enabled() const { return Enabled_; }
-
-	  private:
-		bool Enabled_ = false;
-		std::string Default_;
-		std::unique_ptr<IPToCountryProvider> Provider_;
-		std::string ProviderName_;
-
 		FindCountryFromIP() noexcept : SubSystemServer("IpToCountry", "IPTOC-SVR", "iptocountry") {}
 	};
 
@@ -0,0 +1,171 @@
+//
+//	License type: BSD 3-Clause License
+//	License copy: https://github.com/Telecominfraproject/wlan-cloud-ucentralgw/blob/master/LICENSE
+//
+
+#include "IPToCountryTable.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+#include "Poco/ByteOrder.h"
+#include "Poco/File.h"
+#include "Poco/NumberParser.h"
+#include "Poco/String.h"
+#include "Poco/StringTokenizer.h"
+
+#include "fmt/format.h"
+
+namespace OpenWifi {
+
+	static bool ParseAddress(const std::string &S, Poco::Net::IPAddress &IP) {
+		if (S.find_first_of(".:") == std::string::npos) {
+			std::uint64_t V;
+			if (!Poco::NumberParser::tryParseUnsigned64(S, V) || V > 0xffffffff)
+				return false;
+			std::uint32_t N = Poco::ByteOrder::toNetwork((Poco::UInt32)V);
+			IP = Poco::Net::IPAddress(&N, sizeof(N));
+			return true;
+		}
+		return Poco::Net::IPAddress::tryParse(S, IP);
+	}
+
+	static std::uint32_t V4Value(const Poco::Net::IPAddress &IP) {
+		return Poco::ByteOrder::fromNetwork(*reinterpret_cast<const Poco::UInt32 *>(IP.addr()));
+	}
+
+	bool IPToCountryTable::Compile(const std::string &Source, const std::string &Compiled,
+								   Poco::Logger &Logger) {
+		std::ifstream In(Source);
+		if (!In)
+			return false;
+
+		std::vector<V4Range> V4;
+		std::vector<V6Range> V6;
+		std::string Line;
+		std::uint64_t Rejected = 0;
+		while (std::getline(In, Line)) {
+			Poco::StringTokenizer Fields(Line, ",", Poco::StringTokenizer::TOK_TRIM);
+			if (Fields.count() < 3)
+				continue;
+			auto Field = [&Fields](std::size_t i) {
+				std::string F = Fields[i];
+				Poco::removeInPlace(F, '"');
+				return F;
+			};
+			Poco::Net::IPAddress Start, End;
+			auto Country = Poco::toUpper(Field(2));
+			if (!ParseAddress(Field(0), Start) || !ParseAddress(Field(1), End) ||
+				Start.family() != End.family() || Country.size() != 2 || Country == "--") {
+				Rejected++;
+				continue;
+			}
+			if (Start.family() == Poco::Net::IPAddress::IPv4) {
+				V4Range R{};
+				R.Start = V4Value(Start);
+				R.End = V4Value(End);
+				std::memcpy(R.Country, Country.c_str(), 2);
+				V4.push_back(R);
+			} else {
+				V6Range R{};
+				std::memcpy(R.Start, Start.addr(), 16);
+				std::memcpy(R.End, End.addr(), 16);
+				std::memcpy(R.Country, Country.c_str(), 2);
+				V6.push_back(R);
+			}
+		}
+
+		std::sort(V4.begin(), V4.end(),
+				  [](const V4Range &A, const V4Range &B) { return A.Start < B.Start; });
+		std::sort(V6.begin(), V6.end(), [](const V6Range &A, const V6Range &B) {
+			return std::memcmp(A.Start, B.Start, 16) < 0;
+		});
+
+		//	Written under a temporary name so a running instance never maps a partial file.
+		auto Temporary = Compiled + ".tmp";
+		{
+			std::ofstream Out(Temporary, std::ios::binary | std::ios::trunc);
+			if (!Out)
+				return false;
+			Header H{};
+			std::memcpy(H.Magic, Magic, sizeof(Magic));
+			H.V4Count = V4.size();
+			H.V6Count = V6.size();
+			Out.write(reinterpret_cast<const char *>(&H), sizeof(H));
+			Out.write(reinterpret_cast<const char *>(V4.data()), V4.size() * sizeof(V4Range));
+			Out.write(reinterpret_cast<const char *>(V6.data()), V6.size() * sizeof(V6Range));
+			if (!Out)
+				return false;
+		}
+		Poco::File(Temporary).renameTo(Compiled);
+		poco_information(Logger, fmt::format("Compiled {} IPv4 and {} IPv6 ranges from {}. {} lines rejected.",
+											 V4.size(), V6.size(), Source, Rejected));
+		return true;
+	}
+
+	bool IPToCountryTable::Map(const std::string &Compiled) {
+		Poco::File F(Compiled);
+		if (!F.exists() || F.getSize() < sizeof(Header))
+			return false;
+		auto M = std::make_unique<Poco::SharedMemory>(F, Poco::SharedMemory::AM_READ);
+		auto H = reinterpret_cast<const Header *>(M->begin());
+		if (std::memcmp(H->Magic, Magic, sizeof(Magic)) != 0)
+			return false;
+		auto Expected =
+			sizeof(Header) + H->V4Count * sizeof(V4Range) + H->V6Count * sizeof(V6Range);
+		if ((std::size_t)(M->end() - M->begin()) < Expected)
+			return false;
+		V4Count_ = H->V4Count;
+		V6Count_ = H->V6Count;
+		V4_ = reinterpret_cast<const V4Range *>(M->begin() + sizeof(Header));
+		V6_ = reinterpret_cast<const V6Range *>(M->begin() + sizeof(Header) +
+												 V4Count_ * sizeof(V4Range));
+		Map_ = std::move(M);
+		return true;
+	}
+
+	bool IPToCountryTable::Load(const std::string &Source, const std::string &Compiled,
+								Poco::Logger &Logger) {
+		try {
+			Poco::File S(Source), C(Compiled);
+			bool Stale = !C.exists() || (S.exists() && S.getLastModified() > C.getLastModified());
+			if (Stale && !Compile(Source, Compiled, Logger)) {
+				poco_error(Logger, fmt::format("Cannot compile IP ranges from '{}'.", Source));
+				return false;
+			}
+			if (!Map(Compiled)) {
+				poco_error(Logger, fmt::format("'{}' is not a valid IP range file.", Compiled));
+				return false;
+			}
+			return true;
+		} catch (const Poco::Exception &E) {
+			Logger.log(E);
+		}
+		return false;
+	}
+
+	std::string IPToCountryTable::Find(const Poco::Net::IPAddress &IP) const {
+		if (Map_ == nullptr)
+			return "";
+		if (IP.family() == Poco::Net::IPAddress::IPv4) {
+			auto Value = V4Value(IP);
+			auto Last = std::upper_bound(
+				V4_, V4_ + V4Count_, Value,
+				[](std::uint32_t V, const V4Range &R) { return V < R.Start; });
+			if (Last == V4_ || (Last - 1)->End < Value)
+				return "";
+			return std::string((Last - 1)->Country, 2);
+		}
+		auto Value = reinterpret_cast<const std::uint8_t *>(IP.addr());
+		auto Last = std::upper_bound(V6_, V6_ + V6Count_, Value,
+									 [](const std::uint8_t *V, const V6Range &R) {
+										 return std::memcmp(V, R.Start, 16) < 0;
+									 });
+		if (Last == V6_ || std::memcmp((Last - 1)->End, Value, 16) < 0)
+			return "";
+		return std::string((Last - 1)->Country, 2);
+	}
+
+} // namespace OpenWifi
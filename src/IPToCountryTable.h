@@ -0,0 +1,60 @@
+//
+//	License type: BSD 3-Clause License
+//	License copy: https://github.com/Telecominfraproject/wlan-cloud-ucentralgw/blob/master/LICENSE
+//
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "Poco/Logger.h"
+#include "Poco/Net/IPAddress.h"
+#include "Poco/SharedMemory.h"
+
+namespace OpenWifi {
+
+	//	Offline IP to country lookups. A CSV of address ranges (start,end,country - addresses in
+	//	dotted/colon form or IPv4 as a decimal number, as published by db-ip and ip2location) is
+	//	compiled once into a sorted binary file, which is then memory-mapped and searched with a
+	//	binary search. The binary file is rebuilt whenever the CSV is newer.
+	class IPToCountryTable {
+	  public:
+		bool Load(const std::string &Source, const std::string &Compiled, Poco::Logger &Logger);
+		[[nodiscard]] std::string Find(const Poco::Net::IPAddress &IP) const;
+		[[nodiscard]] inline std::uint64_t Ranges() const { return V4Count_ + V6Count_; }
+
+	  private:
+		struct Header {
+			char Magic[8];
+			std::uint64_t V4Count;
+			std::uint64_t V6Count;
+		};
+
+		struct V4Range {
+			std::uint32_t Start;
+			std::uint32_t End;
+			char Country[4];
+		};
+
+		struct V6Range {
+			std::uint8_t Start[16];
+			std::uint8_t End[16];
+			char Country[4];
+		};
+
+		static constexpr char Magic[8] = {'O', 'W', 'I', 'P', 'C', 'C', '0', '1'};
+
+		std::unique_ptr<Poco::SharedMemory> Map_;
+		const V4Range *V4_ = nullptr;
+		const V6Range *V6_ = nullptr;
+		std::uint64_t V4Count_ = 0;
+		std::uint64_t V6Count_ = 0;
+
+		static bool Compile(const std::string &Source, const std::string &Compiled,
+							Poco::Logger &Logger);
+		bool Map(const std::string &Compiled);
+	};
+
+} // namespace OpenWifi
@@ -0,0 +1,112 @@
+//
+//	License type: BSD 3-Clause License
+//	License copy: https://github.com/Telecominfraproject/wlan-cloud-ucentralgw/blob/master/LICENSE
+//
+
+#pragma once
+
+#include <cstdint>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace OpenWifi {
+
+	//	The RPCs CommandManager waits on, by id, with indexes by device, by command UUID, by
+	//	submission time, the order in which they time out, and by the deadline of those that
+	//	have one. Info needs Id, SerialNumber, UUID, submitted and Deadline. The caller locks.
+	template <typename Info> class OutstandingRPCTable {
+	  public:
+		using time_point_t = decltype(Info::submitted);
+
+		//	Replaces a request with the same id.
+		void Add(const Info &Request, bool WithDeadline) {
+			Erase(Request.Id);
+			Requests_[Request.Id] = Request;
+			ByDevice_[Request.SerialNumber].insert(Request.Id);
+			ByUUID_.emplace(Request.UUID, Request.Id);
+			BySubmission_.emplace(Request.submitted, Request.Id);
+			if (WithDeadline)
+				Deadlines_.emplace(Request.Deadline, Request.Id);
+		}
+
+		inline Info *Find(std::uint64_t Id) {
+			auto Request = Requests_.find(Id);
+			return Request == Requests_.end() ? nullptr : &Request->second;
+		}
+
+		//	The request is moved to Removed when one is given.
+		bool Erase(std::uint64_t Id, Info *Removed = nullptr) {
+			auto Request = Requests_.find(Id);
+			if (Request == Requests_.end())
+				return false;
+			auto &R = Request->second;
+			if (auto Device = ByDevice_.find(R.SerialNumber); Device != ByDevice_.end()) {
+				Device->second.erase(Id);
+				if (Device->second.empty())
+					ByDevice_.erase(Device);
+			}
+			auto [First, Last] = ByUUID_.equal_range(R.UUID);
+			for (auto Entry = First; Entry != Last; ++Entry) {
+				if (Entry->second == Id) {
+					ByUUID_.erase(Entry);
+					break;
+				}
+			}
+			BySubmission_.erase(std::make_pair(R.submitted, Id));
+			Deadlines_.erase(std::make_pair(R.Deadline, Id));
+			if (Removed != nullptr)
+				*Removed = std::move(R);
+			Requests_.erase(Request);
+			return true;
+		}
+
+		//	The request no longer gives up at its deadline.
+		inline void ClearDeadline(const Info &Request) {
+			Deadlines_.erase(std::make_pair(Request.Deadline, Request.Id));
+		}
+
+		//	The device's oldest request by id.
+		inline Info *FirstForDevice(std::uint64_t SerialNumber) {
+			auto Device = ByDevice_.find(SerialNumber);
+			return Device == ByDevice_.end() ? nullptr : Find(*Device->second.begin());
+		}
+
+		inline std::vector<std::uint64_t> ForDevice(std::uint64_t SerialNumber) const {
+			auto Device = ByDevice_.find(SerialNumber);
+			if (Device == ByDevice_.end())
+				return {};
+			return {Device->second.begin(), Device->second.end()};
+		}
+
+		inline Info *FindUUID(const std::string &UUID) {
+			auto Entry = ByUUID_.find(UUID);
+			return Entry == ByUUID_.end() ? nullptr : Find(Entry->second);
+		}
+
+		//	Only the requests due are visited, oldest first.
+		inline Info *OldestSubmittedBefore(time_point_t Cutoff) {
+			if (BySubmission_.empty() || !(BySubmission_.begin()->first < Cutoff))
+				return nullptr;
+			return Find(BySubmission_.begin()->second);
+		}
+
+		inline Info *FirstDeadlineAtOrBefore(time_point_t Now) {
+			if (Deadlines_.empty() || Now < Deadlines_.begin()->first)
+				return nullptr;
+			return Find(Deadlines_.begin()->second);
+		}
+
+		[[nodiscard]] inline std::size_t Size() const { return Requests_.size(); }
+
+	  private:
+		std::unordered_map<std::uint64_t, Info> Requests_;
+		std::unordered_map<std::uint64_t, std::set<std::uint64_t>> ByDevice_;
+		std::unordered_multimap<std::string, std::uint64_t> ByUUID_;
+		std::set<std::pair<time_point_t, std::uint64_t>> BySubmission_;
+		std::set<std::pair<time_point_t, std::uint64_t>> Deadlines_;
+	};
+
+} // namespace OpenWifi
@@ -0,0 +1,101 @@
+//
+//	License type: BSD 3-Clause License
+//	License copy: https://github.com/Telecominfraproject/wlan-cloud-ucentralgw/blob/master/LICENSE
+//
+
+#pragma once
+
+#include <cctype>
+#include <cstdint>
+#include <string>
+
+namespace OpenWifi {
+
+	//	Position in a listing ordered by (Time, Key), used for keyset pagination: the next page
+	//	starts strictly after the last row returned, so rows removed in between shift nothing.
+	//	Time and Key come from indexed columns, so a page costs the same whatever its depth.
+	struct PageCursor {
+		std::uint64_t Time = 0;
+		std::string Key;
+		bool Valid = false;
+
+		//	Called for each row of a page, in order.
+		inline void Step(std::uint64_t RowTime, const std::string &RowKey) {
+			Time = RowTime;
+			Key = RowKey;
+			Valid = true;
+		}
+
+		//	Keys end up in SQL, so only serial numbers and UUIDs are accepted.
+		static inline bool ValidKey(const std::string &K) {
+			if (K.size() > 64)
+				return false;
+			for (const auto c : K)
+				if (!std::isalnum((unsigned char)c) && c != '-')
+					return false;
+			return true;
+		}
+
+		//	Opaque to clients: hex of "time:key". Tokens handed out as "time:skip:key" are still
+		//	accepted; the skip count is ignored.
+		[[nodiscard]] inline std::string to_token() const {
+			static const char hex[] = "0123456789abcdef";
+			std::string Token;
+			for (const auto c : std::to_string(Time) + ":" + Key) {
+				Token += hex[((unsigned char)c) >> 4];
+				Token += hex[((unsigned char)c) & 0x0f];
+			}
+			return Token;
+		}
+
+		//	An empty token is the start of the listing.
+		static inline bool from_token(const std::string &Token, PageCursor &Cursor) {
+			Cursor = PageCursor{};
+			if (Token.empty())
+				return true;
+			if (Token.size() % 2 || Token.size() > 256)
+				return false;
+			std::string Raw;
+			for (std::size_t i = 0; i < Token.size(); i += 2) {
+				if (!std::isxdigit((unsigned char)Token[i]) ||
+					!std::isxdigit((unsigned char)Token[i + 1]))
+					return false;
+				Raw += (char)std::stoi(Token.substr(i, 2), nullptr, 16);
+			}
+			//	keys never hold ':', so the key follows the last one
+			auto First = Raw.find(':');
+			auto Last = Raw.rfind(':');
+			if (First == std::string::npos || First == 0 || First > 19)
+				return false;
+			if (Last != First && (Last == First + 1 || Last - First - 1 > 19))
+				return false;
+			for (std::size_t i = 0; i < Last; i++)
+				if (i != First && !std::isdigit((unsigned char)Raw[i]))
+					return false;
+			Cursor.Time = std::stoull(Raw.substr(0, First));
+			Cursor.Key = Raw.substr(Last + 1);
+			if (!ValidKey(Cursor.Key))
+				return false;
+			Cursor.Valid = true;
+			return true;
+		}
+	};
+
+	//	When (time, key) does not identify a row, a full page may stop inside the rows sharing its
+	//	last position, and a cursor placed after them would pass over the rest. Those rows are
+	//	replaced by all the rows at that position, read by ReadGroup(Time, Key, Rows), so the page
+	//	may end up a little longer than asked for. Position(Row) returns the (time, key) pair.
+	template <typename RecordList, typename PositionFn, typename ReadGroupFn>
+	inline void CompleteLastPosition(RecordList &Records, PositionFn Position,
+									 ReadGroupFn ReadGroup) {
+		if (Records.empty())
+			return;
+		auto Last = Position(Records.back());
+		while (!Records.empty() && Position(Records.back()) == Last)
+			Records.pop_back();
+		RecordList Group;
+		ReadGroup(Last.first, Last.second, Group);
+		Records.insert(Records.end(), Group.begin(), Group.end());
+	}
+
+} // namespace OpenWifi
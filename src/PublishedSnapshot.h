@@ -0,0 +1,78 @@
+//
+//	License type: BSD 3-Clause License
+//	License copy: https://github.com/Telecominfraproject/wlan-cloud-ucentralgw/blob/master/LICENSE
+//
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>
+
+namespace OpenWifi {
+
+	//	An immutable value that writers replace as a whole and readers use without a lock or a
+	//	reference count. A reader announces itself in a per-thread counter for the epoch it saw,
+	//	then loads the pointer. The writer publishes the new value, flips the epoch twice and
+	//	waits for each counter to drain, after which nobody can still see the old value and it
+	//	is freed. Readers never wait; writers must be serialized by the caller.
+	template <typename T> class PublishedSnapshot {
+	  public:
+		explicit PublishedSnapshot(std::unique_ptr<const T> Initial) : Owned_(std::move(Initial)) {
+			Current_.store(Owned_.get());
+		}
+
+		//	Calls Reader with the current value. The value must not be kept past the call.
+		template <typename Function> inline auto Read(Function &&Reader) const {
+			auto &Counter = Slots_[SlotIndex()].Readers[Epoch_.load() & 1];
+			Counter++;
+			struct Leave {
+				std::atomic<std::uint64_t> &Counter;
+				~Leave() { Counter--; }
+			} L{Counter};
+			return Reader(*Current_.load());
+		}
+
+		//	The value last published. Only for the writer.
+		[[nodiscard]] inline const T &Latest() const { return *Owned_; }
+
+		inline void Publish(std::unique_ptr<const T> Next) {
+			Current_.store(Next.get());
+			auto Old = std::move(Owned_);
+			Owned_ = std::move(Next);
+			for (int i = 0; i < 2; i++) {
+				auto Draining = Epoch_++ & 1;
+				for (const auto &Slot : Slots_)
+					while (Slot.Readers[Draining].load() != 0)
+						std::this_thread::yield();
+			}
+			Replaced_++;
+		}
+
+		//	Values replaced so far; each was freed once its last reader left.
+		[[nodiscard]] inline std::uint64_t Replaced() const { return Replaced_; }
+
+	  private:
+		static constexpr std::size_t NumberOfSlots = 16;
+
+		//	Each reader thread keeps to one slot, so threads on different slots do not share the
+		//	cache line they count themselves in.
+		struct alignas(64) Slot {
+			std::atomic<std::uint64_t> Readers[2]{};
+		};
+
+		std::unique_ptr<const T> Owned_;
+		std::atomic<const T *> Current_{nullptr};
+		std::atomic<std::uint64_t> Epoch_{0};
+		mutable Slot Slots_[NumberOfSlots];
+		std::uint64_t Replaced_ = 0;
+
+		static inline std::size_t SlotIndex() {
+			static std::atomic<std::size_t> NextIndex{0};
+			thread_local std::size_t Index = NextIndex++ % NumberOfSlots;
+			return Index;
+		}
+	};
+
+} // namespace OpenWifi
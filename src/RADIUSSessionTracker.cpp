@@ -81,7 +81,8 @@ namespace OpenWifi {
 							ProcessAuthenticationSession(*Session);
 						} break;
 						case SessionNotification::NotificationType::ap_disconnect: {
-							DisconnectSession(Session->SerialNumber_);
+							for (const auto &SerialNumber : Session->SerialNumbers_)
+								DisconnectSession(SerialNumber);
 						} break;
 					}
 				}
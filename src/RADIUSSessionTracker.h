@@ -30,14 +30,15 @@ namespace OpenWifi {
 			: Type_(T), Destination_(Destination), SerialNumber_(SerialNumber), Packet_(P), Secret_(secret) {
 		}
 
-		explicit SessionNotification(const std::string &SerialNumber)
-			: Type_(NotificationType::ap_disconnect), SerialNumber_(SerialNumber) {
+		explicit SessionNotification(std::vector<std::string> SerialNumbers)
+			: Type_(NotificationType::ap_disconnect), SerialNumbers_(std::move(SerialNumbers)) {
 
 		}
 
 		NotificationType			Type_;
 		std::string 				Destination_;
 		std::string 				SerialNumber_;
+		std::vector<std::string>	SerialNumbers_;
 		RADIUS::RadiusPacket		Packet_;
 		std::string					Secret_;
 	};
@@ -117,7 +118,11 @@ namespace OpenWifi {
 		}
 
 		inline void DeviceDisconnect(const std::string &serialNumber) {
-			SessionMessageQueue_.enqueueNotification(new SessionNotification(serialNumber));
+			DevicesDisconnect(std::vector<std::string>{serialNumber});
+		}
+
+		inline void DevicesDisconnect(std::vector<std::string> serialNumbers) {
+			SessionMessageQueue_.enqueueNotification(new SessionNotification(std::move(serialNumbers)));
 		}
 
 		inline void GetAPList(std::vector<std::string> &SerialNumbers) {
@@ -33,6 +33,191 @@ namespace OpenWifi::RESTAPI_RPC {
 			return Handler->ReturnStatus(Poco::Net::HTTPResponse::HTTP_INTERNAL_SERVER_ERROR);
 	}
 
+	//	Fills Cmd from the device's answer. Returns false when the answer is incomplete, with
+	//	Status set to what the command should be recorded as.
+	static bool ProcessAnswer(uint64_t RPCID, GWObjects::CommandDetails &Cmd,
+							  Poco::JSON::Object &Params, const CommandManager::objtype_t &rpc_answer,
+							  std::chrono::duration<double, std::milli> rpc_execution_time,
+							  Poco::Logger &Logger, Storage::CommandExecutionType &Status) {
+		Status = Storage::CommandExecutionType::COMMAND_FAILED;
+		if (!rpc_answer->has(uCentralProtocol::RESULT) ||
+			!rpc_answer->isObject(uCentralProtocol::RESULT)) {
+			Logger.information(
+				fmt::format("{},{}: Invalid response. Missing result.", Cmd.UUID, RPCID));
+			return false;
+		}
+
+		auto ResultFields =
+			rpc_answer->get(uCentralProtocol::RESULT).extract<Poco::JSON::Object::Ptr>();
+		if (!ResultFields->has(uCentralProtocol::STATUS) ||
+			!ResultFields->isObject(uCentralProtocol::STATUS)) {
+			Cmd.executionTime = rpc_execution_time.count();
+			if (Cmd.Command == "ping") {
+				Status = Storage::CommandExecutionType::COMMAND_COMPLETED;
+				Logger.information(fmt::format(
+					"{},{}: Invalid response from device (ping: fix override). Missing status.",
+					Cmd.UUID, RPCID));
+			} else {
+				Logger.information(fmt::format(
+					"{},{}: Invalid response from device. Missing status.", Cmd.UUID, RPCID));
+			}
+			return false;
+		}
+
+		std::ostringstream ResultFieldsLog;
+		ResultFields->stringify(ResultFieldsLog);
+		Logger.debug(
+			fmt::format("{},{}: RPC response: {}.", Cmd.UUID, RPCID, ResultFieldsLog.str()));
+
+		auto StatusInnerObj =
+			ResultFields->get(uCentralProtocol::STATUS).extract<Poco::JSON::Object::Ptr>();
+		if (StatusInnerObj->has(uCentralProtocol::ERROR))
+			Cmd.ErrorCode = StatusInnerObj->get(uCentralProtocol::ERROR);
+		if (StatusInnerObj->has(uCentralProtocol::TEXT))
+			Cmd.ErrorText = StatusInnerObj->get(uCentralProtocol::TEXT).toString();
+		std::stringstream ResultText;
+		if (rpc_answer->has(uCentralProtocol::RESULT)) {
+			if (Cmd.Command == uCentralProtocol::WIFISCAN) {
+				auto ScanObj = rpc_answer->get(uCentralProtocol::RESULT)
+								   .extract<Poco::JSON::Object::Ptr>();
+				ParseWifiScan(ScanObj, ResultText, Logger);
+			} else {
+				Poco::JSON::Stringifier::stringify(rpc_answer->get(uCentralProtocol::RESULT),
+												   ResultText);
+			}
+		}
+		if (rpc_answer->has(uCentralProtocol::RESULT_64)) {
+			uint64_t sz = 0;
+			if (rpc_answer->has(uCentralProtocol::RESULT_SZ))
+				sz = rpc_answer->get(uCentralProtocol::RESULT_SZ);
+			std::string UnCompressedData;
+			Utils::ExtractBase64CompressedData(
+				rpc_answer->get(uCentralProtocol::RESULT_64).toString(), UnCompressedData, sz);
+			Poco::JSON::Stringifier::stringify(UnCompressedData, ResultText);
+		}
+		Cmd.Results = ResultText.str();
+		Cmd.Status = "completed";
+		Cmd.Completed = Utils::Now();
+		Cmd.executionTime = rpc_execution_time.count();
+
+		if (Cmd.ErrorCode && (Cmd.Command == uCentralProtocol::TRACE ||
+							  Cmd.Command == uCentralProtocol::SCRIPT)) {
+			Cmd.WaitingForFile = 0;
+			Cmd.AttachDate = Cmd.AttachSize = 0;
+			Cmd.AttachType = "";
+		}
+
+		if (Cmd.ErrorCode == 0 && Cmd.Command == uCentralProtocol::CONFIGURE) {
+			//	we need to post a kafka event for this.
+			if (Params.has(uCentralProtocol::CONFIG) && Params.isObject(uCentralProtocol::CONFIG)) {
+				auto Config = Params.get(uCentralProtocol::CONFIG)
+								  .extract<Poco::JSON::Object::Ptr>();
+				DeviceConfigurationChangeKafkaEvent KEvent(
+					Utils::SerialNumberToInt(Cmd.SerialNumber), Utils::Now(),
+					Config);
+			}
+		}
+		Status = Storage::CommandExecutionType::COMMAND_COMPLETED;
+		return true;
+	}
+
+	//	Records the outcome of a command sent with SendCommand, in place of the row written when
+	//	it was sent. Runs on the command manager's result writer.
+	static void
+	CompleteAsyncCommand(uint64_t RPCID, GWObjects::CommandDetails &Cmd, Poco::JSON::Object &Params,
+						 bool RetryLater,
+						 std::chrono::time_point<std::chrono::high_resolution_clock> rpc_submitted,
+						 const CommandManager::objtype_t &rpc_answer, Poco::Logger &Logger,
+						 const CommandDone &Done) {
+		auto Status = Storage::CommandExecutionType::COMMAND_FAILED;
+		if (rpc_answer.isNull()) {
+			if (RetryLater) {
+				Logger.information(fmt::format("{},{}: Pending completion.", Cmd.UUID, RPCID));
+				Cmd.Status = StorageService()->to_string(
+					Storage::CommandExecutionType::COMMAND_PENDING);
+				Cmd.Executed = 0;
+				StorageService()->UpdateCommand(Cmd.UUID, Cmd);
+				CommandManager()->QueueCommand(Cmd);
+				if (Done)
+					Done(Cmd);
+				return;
+			}
+			Logger.information(fmt::format(
+				"{},{}: Command canceled. Device did not answer. Command will not be retried.",
+				Cmd.UUID, RPCID));
+		} else {
+			std::chrono::duration<double, std::milli> rpc_execution_time =
+				std::chrono::high_resolution_clock::now() - rpc_submitted;
+			ProcessAnswer(RPCID, Cmd, Params, rpc_answer, rpc_execution_time, Logger, Status);
+		}
+		Cmd.Status = StorageService()->to_string(Status);
+		Cmd.Completed = Utils::Now();
+		StorageService()->UpdateCommand(Cmd.UUID, Cmd);
+		Logger.information(fmt::format("{},{}: Completed asynchronously in {:.3f}ms.", Cmd.UUID,
+									   RPCID, Cmd.executionTime));
+		if (Done)
+			Done(Cmd);
+	}
+
+	bool SendCommand(uint64_t RPCID, APCommands::Commands Command, bool RetryLater,
+					 GWObjects::CommandDetails &Cmd, Poco::JSON::Object &Params,
+					 std::chrono::milliseconds WaitTimeInMs, Poco::Logger &Logger, bool Deferred,
+					 CommandDone Done) {
+		Cmd.Submitted = Utils::Now();
+		//	the row must exist before the answer can complete it
+		if (!StorageService()->AddCommand(Cmd.SerialNumber, Cmd,
+										  Storage::CommandExecutionType::COMMAND_EXECUTED))
+			return false;
+
+		auto rpc_submitted = std::chrono::high_resolution_clock::now();
+		Poco::JSON::Object::Ptr ParamsCopy = new Poco::JSON::Object(Params);
+		auto Completion = [RPCID, Cmd, ParamsCopy, RetryLater, rpc_submitted, &Logger,
+						   Done](const CommandManager::objtype_t &rpc_answer) mutable {
+			CompleteAsyncCommand(RPCID, Cmd, *ParamsCopy, RetryLater, rpc_submitted, rpc_answer,
+								 Logger, Done);
+		};
+		if (!CommandManager()->PostCommandAsync(RPCID, Command, Cmd.SerialNumber, Cmd.Command,
+												 Params, Cmd.UUID, Deferred, WaitTimeInMs,
+												 std::move(Completion))) {
+			StorageService()->DeleteCommand(Cmd.UUID);
+			Cmd.Executed = 0;
+			return false;
+		}
+		Logger.information(fmt::format("{},{}: Command sent, completing asynchronously.",
+									   Cmd.UUID, RPCID));
+		return true;
+	}
+
+	//	The request returns once the command is sent: the command is recorded as executed and
+	//	its row is completed when the answer comes, so no REST thread waits for the device.
+	static void PostAsyncCommand(uint64_t RPCID, APCommands::Commands Command, bool RetryLater,
+								 GWObjects::CommandDetails &Cmd, Poco::JSON::Object &Params,
+								 Poco::Net::HTTPServerRequest &Request,
+								 Poco::Net::HTTPServerResponse &Response,
+								 std::chrono::milliseconds WaitTimeInMs,
+								 Poco::JSON::Object *ObjectToReturn, RESTAPIHandler *Handler,
+								 Poco::Logger &Logger, bool Deferred) {
+		if (!SendCommand(RPCID, Command, RetryLater, Cmd, Params, WaitTimeInMs, Logger, Deferred)) {
+			if (RetryLater) {
+				Logger.information(fmt::format(
+					"{},{}: Pending completion. Device is not connected.", Cmd.UUID, RPCID));
+				return SetCommandStatus(Cmd, Request, Response, Handler,
+										Storage::CommandExecutionType::COMMAND_PENDING, Logger);
+			}
+			Logger.information(fmt::format(
+				"{},{}: Command canceled. Device is not connected. Command will not be retried.",
+				Cmd.UUID, RPCID));
+			return SetCommandStatus(Cmd, Request, Response, Handler,
+									Storage::CommandExecutionType::COMMAND_FAILED, Logger);
+		}
+
+		if (ObjectToReturn)
+			return Handler->ReturnObject(*ObjectToReturn);
+		Poco::JSON::Object O;
+		Cmd.to_json(O);
+		Handler->ReturnObject(O);
+	}
+
 	void WaitForCommand(uint64_t RPCID, APCommands::Commands Command, bool RetryLater,
 						GWObjects::CommandDetails &Cmd, Poco::JSON::Object &Params,
 						Poco::Net::HTTPServerRequest &Request,
@@ -64,6 +249,10 @@ namespace OpenWifi::RESTAPI_RPC {
 									Storage::CommandExecutionType::COMMAND_FAILED, Logger);
 		}
 
+		if (Handler != nullptr && Handler->GetBoolParameter(RESTAPI::Protocol::ASYNC, false))
+			return PostAsyncCommand(RPCID, Command, RetryLater, Cmd, Params, Request, Response,
+									WaitTimeInMs, ObjectToReturn, Handler, Logger, Deferred);
+
 		bool Sent;
 		std::chrono::time_point<std::chrono::high_resolution_clock> rpc_submitted =
 			std::chrono::high_resolution_clock::now();
@@ -94,89 +283,10 @@ namespace OpenWifi::RESTAPI_RPC {
 		if (rpc_result == std::future_status::ready) {
 			std::chrono::duration<double, std::milli> rpc_execution_time =
 				std::chrono::high_resolution_clock::now() - rpc_submitted;
-			auto rpc_answer = rpc_future.get();
-			if (!rpc_answer->has(uCentralProtocol::RESULT) ||
-				!rpc_answer->isObject(uCentralProtocol::RESULT)) {
-				SetCommandStatus(Cmd, Request, Response, Handler,
-								 Storage::CommandExecutionType::COMMAND_FAILED, Logger);
-				Logger.information(
-					fmt::format("{},{}: Invalid response. Missing result.", Cmd.UUID, RPCID));
-				return;
-			}
-
-			auto ResultFields =
-				rpc_answer->get(uCentralProtocol::RESULT).extract<Poco::JSON::Object::Ptr>();
-			if (!ResultFields->has(uCentralProtocol::STATUS) ||
-				!ResultFields->isObject(uCentralProtocol::STATUS)) {
-				Cmd.executionTime = rpc_execution_time.count();
-				if (Cmd.Command == "ping") {
-					SetCommandStatus(Cmd, Request, Response, Handler,
-									 Storage::CommandExecutionType::COMMAND_COMPLETED, Logger);
-					Logger.information(fmt::format(
-						"{},{}: Invalid response from device (ping: fix override). Missing status.",
-						Cmd.UUID, RPCID));
-				} else {
-					SetCommandStatus(Cmd, Request, Response, Handler,
-									 Storage::CommandExecutionType::COMMAND_FAILED, Logger);
-					Logger.information(fmt::format(
-						"{},{}: Invalid response from device. Missing status.", Cmd.UUID, RPCID));
-				}
-				return;
-			}
-
-			std::ostringstream ResultFieldsLog;
-			ResultFields->stringify(ResultFieldsLog);
-			Logger.debug(
-				fmt::format("{},{}: RPC response: {}.", Cmd.UUID, RPCID, ResultFieldsLog.str()));
-
-			auto StatusInnerObj =
-				ResultFields->get(uCentralProtocol::STATUS).extract<Poco::JSON::Object::Ptr>();
-			if (StatusInnerObj->has(uCentralProtocol::ERROR))
-				Cmd.ErrorCode = StatusInnerObj->get(uCentralProtocol::ERROR);
-			if (StatusInnerObj->has(uCentralProtocol::TEXT))
-				Cmd.ErrorText = StatusInnerObj->get(uCentralProtocol::TEXT).toString();
-			std::stringstream ResultText;
-			if (rpc_answer->has(uCentralProtocol::RESULT)) {
-				if (Cmd.Command == uCentralProtocol::WIFISCAN) {
-					auto ScanObj = rpc_answer->get(uCentralProtocol::RESULT)
-									   .extract<Poco::JSON::Object::Ptr>();
-					ParseWifiScan(ScanObj, ResultText, Logger);
-				} else {
-					Poco::JSON::Stringifier::stringify(rpc_answer->get(uCentralProtocol::RESULT),
-													   ResultText);
-				}
-			}
-			if (rpc_answer->has(uCentralProtocol::RESULT_64)) {
-				uint64_t sz = 0;
-				if (rpc_answer->has(uCentralProtocol::RESULT_SZ))
-					sz = rpc_answer->get(uCentralProtocol::RESULT_SZ);
-				std::string UnCompressedData;
-				Utils::ExtractBase64CompressedData(
-					rpc_answer->get(uCentralProtocol::RESULT_64).toString(), UnCompressedData, sz);
-				Poco::JSON::Stringifier::stringify(UnCompressedData, ResultText);
-			}
-			Cmd.Results = ResultText.str();
-			Cmd.Status = "completed";
-			Cmd.Completed = Utils::Now();
-			Cmd.executionTime = rpc_execution_time.count();
-
-			if (Cmd.ErrorCode && (Cmd.Command == uCentralProtocol::TRACE ||
-								  Cmd.Command == uCentralProtocol::SCRIPT)) {
-				Cmd.WaitingForFile = 0;
-				Cmd.AttachDate = Cmd.AttachSize = 0;
-				Cmd.AttachType = "";
-			}
-
-			if (Cmd.ErrorCode == 0 && Cmd.Command == uCentralProtocol::CONFIGURE) {
-				//	we need to post a kafka event for this.
-				if (Params.has(uCentralProtocol::CONFIG) && Params.isObject(uCentralProtocol::CONFIG)) {
-					auto Config = Params.get(uCentralProtocol::CONFIG)
-									  .extract<Poco::JSON::Object::Ptr>();
-					DeviceConfigurationChangeKafkaEvent KEvent(
-						Utils::SerialNumberToInt(Cmd.SerialNumber), Utils::Now(),
-						Config);
-				}
-			}
+			Storage::CommandExecutionType Status;
+			if (!ProcessAnswer(RPCID, Cmd, Params, rpc_future.get(), rpc_execution_time, Logger,
+							   Status))
+				return SetCommandStatus(Cmd, Request, Response, Handler, Status, Logger);
 
 			//	Add the completed command to the database...
 			StorageService()->AddCommand(Cmd.SerialNumber, Cmd,
@@ -4,6 +4,8 @@
 
 #pragma once
 
+#include <functional>
+
 #include "Poco/File.h"
 #include "Poco/JSON/Object.h"
 #include "Poco/Logger.h"
@@ -22,6 +24,8 @@
 
 namespace OpenWifi::RESTAPI_RPC {
 
+	using CommandDone = std::function<void(const GWObjects::CommandDetails &)>;
+
 	void WaitForCommand(uint64_t RPCID, APCommands::Commands Command, bool RetryLater,
 						GWObjects::CommandDetails &Cmd, Poco::JSON::Object &Params,
 						Poco::Net::HTTPServerRequest &Request,
@@ -29,6 +33,14 @@ namespace OpenWifi::RESTAPI_RPC {
 						std::chrono::milliseconds WaitTimeInMs, Poco::JSON::Object *ObjectToReturn,
 						RESTAPIHandler *Handler, Poco::Logger &Logger, bool Deferred = false);
 
+	//	Sends Cmd without waiting for the device. The command is recorded as executed, then
+	//	completed from the device's answer, after which Done, if set, receives it. Returns false,
+	//	with nothing recorded, if the command could not be sent.
+	bool SendCommand(uint64_t RPCID, APCommands::Commands Command, bool RetryLater,
+					 GWObjects::CommandDetails &Cmd, Poco::JSON::Object &Params,
+					 std::chrono::milliseconds WaitTimeInMs, Poco::Logger &Logger,
+					 bool Deferred = false, CommandDone Done = nullptr);
+
 	void SetCommandStatus(GWObjects::CommandDetails &Cmd, Poco::Net::HTTPServerRequest &Request,
 						  Poco::Net::HTTPServerResponse &Response, RESTAPIHandler *handler,
 						  OpenWifi::Storage::CommandExecutionType Status, Poco::Logger &Logger);
@@ -0,0 +1,44 @@
+//
+//	License type: BSD 3-Clause License
+//	License copy: https://github.com/Telecominfraproject/wlan-cloud-ucentralgw/blob/master/LICENSE
+//
+
+#include "RESTAPI_bulk_command_handler.h"
+#include "BulkCommandManager.h"
+
+namespace OpenWifi {
+
+	void RESTAPI_bulk_command_handler::DoGet() {
+		auto Id = GetBinding("id", "");
+		if (Id.empty()) {
+			return BadRequest(RESTAPI::Errors::MissingOrInvalidParameters);
+		}
+
+		GWObjects::BulkCommand Job;
+		if (BulkCommandManager()->GetJob(Id, Job)) {
+			return Object(Job);
+		}
+		return NotFound();
+	}
+
+	void RESTAPI_bulk_command_handler::DoDelete() {
+		auto Id = GetBinding("id", "");
+		if (Id.empty()) {
+			return BadRequest(RESTAPI::Errors::MissingOrInvalidParameters);
+		}
+
+		if (!Internal_ && UserInfo_.userinfo.userRole != SecurityObjects::ROOT) {
+			return UnAuthorized(RESTAPI::Errors::ACCESS_DENIED);
+		}
+
+		GWObjects::BulkCommand Job;
+		if (!BulkCommandManager()->GetJob(Id, Job)) {
+			return NotFound();
+		}
+		if (!BulkCommandManager()->Cancel(Id)) {
+			return BadRequest(RESTAPI::Errors::BulkCommandNotRunning);
+		}
+		return OK();
+	}
+
+} // namespace OpenWifi
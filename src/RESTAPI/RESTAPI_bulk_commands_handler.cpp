@@ -0,0 +1,166 @@
+//
+//	License type: BSD 3-Clause License
+//	License copy: https://github.com/Telecominfraproject/wlan-cloud-ucentralgw/blob/master/LICENSE
+//
+
+#include "RESTAPI_bulk_commands_handler.h"
+
+#include <algorithm>
+#include <set>
+
+#include "Poco/String.h"
+
+#include "BulkCommandManager.h"
+#include "DeviceSearchIndex.h"
+#include "framework/utils.h"
+
+namespace OpenWifi {
+
+	void RESTAPI_bulk_commands_handler::DoGet() {
+		std::vector<GWObjects::BulkCommand> Jobs;
+		BulkCommandManager()->GetJobs(QB_.Offset, QB_.Limit, Jobs);
+
+		Poco::JSON::Array Arr;
+		for (const auto &Job : Jobs) {
+			Poco::JSON::Object Obj;
+			Job.progress_to_json(Obj);
+			Arr.add(Obj);
+		}
+		Poco::JSON::Object Answer;
+		Answer.set("bulkCommands", Arr);
+		return ReturnObject(Answer);
+	}
+
+	//	Builds the parameters sent to every device, as the single device commands do. The
+	//	serial number is added for each device when it is sent.
+	bool RESTAPI_bulk_commands_handler::MakeParams(const std::string &Command,
+												   const Poco::JSON::Object::Ptr &Payload,
+												   Poco::JSON::Object &Params) {
+		Params.set(uCentralProtocol::WHEN, GetWhen(Payload));
+		if (Command == uCentralProtocol::REBOOT) {
+			return true;
+		}
+		if (Command == uCentralProtocol::LEDS) {
+			auto Pattern = GetS(uCentralProtocol::PATTERN, Payload, uCentralProtocol::BLINK);
+			if (Pattern != uCentralProtocol::ON && Pattern != uCentralProtocol::OFF &&
+				Pattern != uCentralProtocol::BLINK) {
+				return false;
+			}
+			Params.set(uCentralProtocol::PATTERN, Pattern);
+			Params.set(uCentralProtocol::DURATION, Get(uCentralProtocol::DURATION, Payload, 30));
+			return true;
+		}
+		if (Command == uCentralProtocol::FACTORY) {
+			auto KeepRedirector = GetB(RESTAPI::Protocol::KEEPREDIRECTOR, Payload, true);
+			Params.set(uCentralProtocol::KEEP_REDIRECTOR, KeepRedirector ? 1 : 0);
+			return true;
+		}
+		if (Command == uCentralProtocol::UPGRADE) {
+			auto URI = GetS(RESTAPI::Protocol::URI, Payload);
+			if (URI.empty() || !Utils::ValidateURI(URI)) {
+				return false;
+			}
+			auto KeepRedirector = GetB(RESTAPI::Protocol::KEEPREDIRECTOR, Payload, true);
+			Params.set(uCentralProtocol::URI, URI);
+			Params.set(uCentralProtocol::KEEP_REDIRECTOR, KeepRedirector ? 1 : 0);
+			//	without a signature, each restricted device gets one for its own key
+			auto FWSignature = GetS(uCentralProtocol::FWSIGNATURE, Payload);
+			if (!FWSignature.empty()) {
+				Params.set(uCentralProtocol::SIGNATURE, FWSignature);
+			}
+			return true;
+		}
+		return false;
+	}
+
+	void RESTAPI_bulk_commands_handler::DoPost() {
+		if (!Internal_ && UserInfo_.userinfo.userRole != SecurityObjects::ROOT) {
+			return UnAuthorized(RESTAPI::Errors::ACCESS_DENIED);
+		}
+
+		const auto &Obj = ParsedBody_;
+		auto Command = GetS(RESTAPI::Protocol::COMMAND, Obj);
+		if (!BulkCommandManager::SupportedCommand(Command)) {
+			return BadRequest(RESTAPI::Errors::InvalidCommand);
+		}
+
+		Poco::JSON::Object::Ptr Payload = new Poco::JSON::Object;
+		if (Obj->has(RESTAPI::Protocol::PAYLOAD) && Obj->isObject(RESTAPI::Protocol::PAYLOAD)) {
+			Payload = Obj->getObject(RESTAPI::Protocol::PAYLOAD);
+		}
+		Poco::JSON::Object Params;
+		if (!MakeParams(Command, Payload, Params)) {
+			return BadRequest(RESTAPI::Errors::MissingOrInvalidParameters);
+		}
+
+		//	devices are given by serial number, or selected with the same filter as the search
+		std::set<std::string> SerialNumbers;
+		if (Obj->has("serialNumbers") && Obj->isArray("serialNumbers")) {
+			auto Arr = Obj->getArray("serialNumbers");
+			for (const auto &SerialNumber : *Arr) {
+				auto S = Poco::toLower(SerialNumber.toString());
+				if (!Utils::ValidSerialNumber(S)) {
+					return BadRequest(RESTAPI::Errors::InvalidSerialNumber);
+				}
+				SerialNumbers.insert(S);
+			}
+		} else if (Obj->has("filter") && Obj->isObject("filter")) {
+			auto Filter = Obj->getObject("filter");
+			DeviceSearchIndex::Query Q;
+			Q.SerialNumber = GetS("serialNumber", Filter);
+			Q.Terms[DeviceSearchIndex::COMPATIBLE] = GetS("compatible", Filter);
+			Q.Terms[DeviceSearchIndex::FIRMWARE] = GetS("firmware", Filter);
+			Q.Terms[DeviceSearchIndex::LOCALE] = GetS("locale", Filter);
+			Q.IPAddress = GetS("ipAddress", Filter);
+			//	an empty filter, or a bare "*", would select every device
+			auto Blank = [](const std::string &S) {
+				auto T = Poco::trim(S);
+				return T.empty() || T == "*";
+			};
+			if (Blank(Q.SerialNumber) && Blank(Q.IPAddress) &&
+				std::all_of(Q.Terms.begin(), Q.Terms.end(), Blank)) {
+				return BadRequest(RESTAPI::Errors::EmptyFilter);
+			}
+			Q.Limit = BulkCommandManager()->MaxDevices();
+			std::vector<DeviceSearchIndex::Result> Results;
+			Poco::JSON::Object Facets;
+			if (DeviceSearchIndex()->Search(Q, Results, Facets)) {
+				return BadRequest(RESTAPI::Errors::TooManyDevices);
+			}
+			for (const auto &Result : Results)
+				SerialNumbers.insert(Result.serialNumber);
+		}
+
+		if (SerialNumbers.empty()) {
+			return BadRequest(RESTAPI::Errors::NoDevicesSelected);
+		}
+		if (SerialNumbers.size() > BulkCommandManager()->MaxDevices()) {
+			return BadRequest(RESTAPI::Errors::TooManyDevices);
+		}
+
+		GWObjects::BulkCommand Job;
+		Job.command = Command;
+		std::stringstream ParamStream;
+		Params.stringify(ParamStream);
+		Job.details = ParamStream.str();
+		Job.submittedBy = Requester();
+		auto MaxConcurrency = BulkCommandManager()->MaxConcurrency();
+		auto MaxRate = BulkCommandManager()->MaxRate();
+		Job.concurrency =
+			std::clamp<std::uint64_t>(Get("concurrency", Obj, MaxConcurrency), 1, MaxConcurrency);
+		Job.rate = std::clamp<std::uint64_t>(Get("rate", Obj, MaxRate), 1, MaxRate);
+		for (const auto &SerialNumber : SerialNumbers) {
+			GWObjects::BulkCommandDevice Device;
+			Device.serialNumber = SerialNumber;
+			Job.devices.emplace_back(std::move(Device));
+		}
+
+		if (!BulkCommandManager()->Submit(Job)) {
+			return BadRequest(RESTAPI::Errors::RecordNotCreated);
+		}
+		Poco::JSON::Object Answer;
+		Job.progress_to_json(Answer);
+		return ReturnObject(Answer);
+	}
+
+} // namespace OpenWifi
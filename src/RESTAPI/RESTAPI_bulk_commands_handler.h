@@ -0,0 +1,31 @@
+//
+//	License type: BSD 3-Clause License
+//	License copy: https://github.com/Telecominfraproject/wlan-cloud-ucentralgw/blob/master/LICENSE
+//
+
+#pragma once
+
+#include "framework/RESTAPI_Handler.h"
+
+namespace OpenWifi {
+	class RESTAPI_bulk_commands_handler : public RESTAPIHandler {
+	  public:
+		RESTAPI_bulk_commands_handler(const RESTAPIHandler::BindingMap &bindings, Poco::Logger &L,
+									  RESTAPI_GenericServerAccounting &Server,
+									  uint64_t TransactionId, bool Internal)
+			: RESTAPIHandler(bindings, L,
+							 std::vector<std::string>{Poco::Net::HTTPRequest::HTTP_GET,
+													  Poco::Net::HTTPRequest::HTTP_POST,
+													  Poco::Net::HTTPRequest::HTTP_OPTIONS},
+							 Server, TransactionId, Internal){};
+		static auto PathName() { return std::list<std::string>{"/api/v1/bulkcommands"}; };
+		void DoGet() final;
+		void DoDelete() final{};
+		void DoPost() final;
+		void DoPut() final{};
+
+	  private:
+		bool MakeParams(const std::string &Command, const Poco::JSON::Object::Ptr &Payload,
+						Poco::JSON::Object &Params);
+	};
+} // namespace OpenWifi
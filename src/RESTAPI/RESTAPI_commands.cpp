@@ -18,13 +18,20 @@ namespace OpenWifi {
 		}
 
 		std::vector<GWObjects::CommandDetails> Commands;
+		PageCursor After, Next;
+		if (!PageCursor::from_token(GetParameter(RESTAPI::Protocol::CURSOR, ""), After)) {
+			return BadRequest(RESTAPI::Errors::InvalidCursor);
+		}
 		if (QB_.Newest) {
 			StorageService()->GetNewestCommands(SerialNumber, QB_.Limit, Commands);
 		} else {
 			StorageService()->GetCommands(SerialNumber, QB_.StartDate, QB_.EndDate, QB_.Offset,
-										  QB_.Limit, Commands);
+										  QB_.Limit, Commands, After, &Next);
 		}
-		return Object(RESTAPI::Protocol::COMMANDS, Commands);
+		Poco::JSON::Object Answer;
+		RESTAPI_utils::field_to_json(Answer, RESTAPI::Protocol::COMMANDS, Commands);
+		Answer.set(RESTAPI::Protocol::NEXT, Next.Valid ? Next.to_token() : "");
+		return ReturnObject(Answer);
 	}
 
 	void RESTAPI_commands::DoDelete() {
@@ -14,6 +14,7 @@
 #include "AP_WS_Server.h"
 #include "CentralConfig.h"
 #include "CommandManager.h"
+#include "DeviceShadow.h"
 #include "FileUploader.h"
 #include "RESTAPI_RPC.h"
 #include "RESTAPI_device_commandHandler.h"
@@ -260,10 +261,18 @@ namespace OpenWifi {
 			if (AP_WS_Server()->Connected(SerialNumberInt_)) {
 				return BadRequest(RESTAPI::Errors::NoDeviceStatisticsYet);
 			}
+			std::vector<GWObjects::Statistics> Last;
+			if (DeviceShadow()->GetNewestStatistics(SerialNumberInt_, 1, Last)) {
+				return ReturnRawJSON(Last.front().Data);
+			}
 			return BadRequest(RESTAPI::Errors::DeviceNotConnected);
 		}
 
 		std::vector<GWObjects::Statistics> Stats;
+		PageCursor After, Next;
+		if (!PageCursor::from_token(GetParameter(RESTAPI::Protocol::CURSOR, ""), After)) {
+			return BadRequest(RESTAPI::Errors::InvalidCursor);
+		}
 		if (QB_.Newest) {
 			StorageService()->GetNewestStatisticsData(SerialNumber_, QB_.Limit, Stats);
 		} else {
@@ -277,7 +286,7 @@ namespace OpenWifi {
 				QB_.Limit = 100;
 
 			StorageService()->GetStatisticsData(SerialNumber_, QB_.StartDate, QB_.EndDate,
-												QB_.Offset, QB_.Limit, Stats);
+												QB_.Offset, QB_.Limit, Stats, After, &Next);
 		}
 
 		Poco::JSON::Array::Ptr ArrayObj = Poco::SharedPtr<Poco::JSON::Array>(new Poco::JSON::Array);
@@ -291,6 +300,7 @@ namespace OpenWifi {
 		Poco::JSON::Object RetObj;
 		RetObj.set(RESTAPI::Protocol::DATA, ArrayObj);
 		RetObj.set(RESTAPI::Protocol::SERIALNUMBER, SerialNumber_);
+		RetObj.set(RESTAPI::Protocol::NEXT, Next.Valid ? Next.to_token() : "");
 		return ReturnObject(RetObj);
 	}
 
@@ -310,7 +320,8 @@ namespace OpenWifi {
 							   Requester(), SerialNumber_, Poco::Thread::current()->id()));
 		GWObjects::ConnectionState State;
 
-		if (AP_WS_Server()->GetState(SerialNumber_, State)) {
+		if (AP_WS_Server()->GetState(SerialNumber_, State) ||
+			DeviceShadow()->GetConnection(SerialNumberInt_, State)) {
 			Poco::JSON::Object RetObject;
 			State.to_json(SerialNumber_, RetObject);
 			return ReturnObject(RetObject);
@@ -327,11 +338,15 @@ namespace OpenWifi {
 				   fmt::format("GET-LOGS: TID={} user={} serial={}. thr_id={}", TransactionId_,
 							   Requester(), SerialNumber_, Poco::Thread::current()->id()));
 		std::vector<GWObjects::DeviceLog> Logs;
+		PageCursor After, Next;
+		if (!PageCursor::from_token(GetParameter(RESTAPI::Protocol::CURSOR, ""), After)) {
+			return BadRequest(RESTAPI::Errors::InvalidCursor);
+		}
 		if (QB_.Newest) {
 			StorageService()->GetNewestLogData(SerialNumber_, QB_.Limit, Logs, QB_.LogType);
 		} else {
 			StorageService()->GetLogData(SerialNumber_, QB_.StartDate, QB_.EndDate, QB_.Offset,
-										 QB_.Limit, Logs, QB_.LogType);
+										 QB_.Limit, Logs, QB_.LogType, After, &Next);
 		}
 
 		Poco::JSON::Array ArrayObj;
@@ -343,6 +358,7 @@ namespace OpenWifi {
 		Poco::JSON::Object RetObj;
 		RetObj.set(RESTAPI::Protocol::VALUES, ArrayObj);
 		RetObj.set(RESTAPI::Protocol::SERIALNUMBER, SerialNumber_);
+		RetObj.set(RESTAPI::Protocol::NEXT, Next.Valid ? Next.to_token() : "");
 		ReturnObject(RetObj);
 	}
 
@@ -364,20 +380,29 @@ namespace OpenWifi {
 
 		if (QB_.LastOnly) {
 			GWObjects::HealthCheck HC;
+			std::vector<GWObjects::HealthCheck> Last;
 			if (AP_WS_Server()->GetHealthcheck(SerialNumber_, HC)) {
 				Poco::JSON::Object Answer;
 				HC.to_json(Answer);
 				return ReturnObject(Answer);
+			} else if (DeviceShadow()->GetNewestHealthChecks(SerialNumberInt_, 1, Last)) {
+				Poco::JSON::Object Answer;
+				Last.front().to_json(Answer);
+				return ReturnObject(Answer);
 			} else {
 				return NotFound();
 			}
 		} else {
 			std::vector<GWObjects::HealthCheck> Checks;
+			PageCursor After, Next;
+			if (!PageCursor::from_token(GetParameter(RESTAPI::Protocol::CURSOR, ""), After)) {
+				return BadRequest(RESTAPI::Errors::InvalidCursor);
+			}
 			if (QB_.Newest) {
 				StorageService()->GetNewestHealthCheckData(SerialNumber_, QB_.Limit, Checks);
 			} else {
 				StorageService()->GetHealthCheckData(SerialNumber_, QB_.StartDate, QB_.EndDate,
-													 QB_.Offset, QB_.Limit, Checks);
+													 QB_.Offset, QB_.Limit, Checks, After, &Next);
 			}
 
 			Poco::JSON::Array ArrayObj;
@@ -390,6 +415,7 @@ namespace OpenWifi {
 			Poco::JSON::Object RetObj;
 			RetObj.set(RESTAPI::Protocol::VALUES, ArrayObj);
 			RetObj.set(RESTAPI::Protocol::SERIALNUMBER, SerialNumber_);
+			RetObj.set(RESTAPI::Protocol::NEXT, Next.Valid ? Next.to_token() : "");
 			ReturnObject(RetObj);
 		}
 	}
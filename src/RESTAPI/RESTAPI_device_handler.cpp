@@ -53,23 +53,26 @@ namespace OpenWifi {
 		if (HasParameter("oui", Arg) && Arg == "true" && SerialNumber.size() == 6) {
 
 			std::set<std::string> Set;
-			std::vector<GWObjects::Device> Devices;
 
+			//	devices come in serial number order, starting at the OUI
+			PageCursor Cursor;
+			Cursor.Key = SerialNumber;
+			Cursor.Valid = true;
 			bool Done = false;
-			uint64_t Offset = 1;
 			while (!Done) {
-
-				StorageService()->GetDevices(Offset, 500, Devices);
+				std::vector<GWObjects::Device> Devices;
+				PageCursor Next;
+				StorageService()->GetDevices(0, 500, Devices, "", Cursor, &Next);
 				for (const auto &i : Devices) {
-					if (i.SerialNumber.substr(0, 6) == SerialNumber) {
-						Set.insert(i.SerialNumber);
+					if (i.SerialNumber.substr(0, 6) != SerialNumber) {
+						Done = true;
+						break;
 					}
+					Set.insert(i.SerialNumber);
 				}
 
-				if (Devices.size() < 500)
-					Done = true;
-
-				Offset += Devices.size();
+				Done = Done || !Next.Valid;
+				Cursor = Next;
 			}
 
 			for (auto &i : Set) {
@@ -5,6 +5,7 @@
 #pragma once
 
 #include "AP_WS_Server.h"
+#include "DeviceShadow.h"
 #include "RESTObjects/RESTAPI_GWobjects.h"
 #include "StorageService.h"
 #include <Poco/JSON/Parser.h>
@@ -13,11 +14,22 @@ namespace OpenWifi {
 
 	inline void CompleteDeviceInfo(const GWObjects::Device &Device, Poco::JSON::Object &Answer) {
 		GWObjects::ConnectionState CS;
-		AP_WS_Server()->GetState(Device.SerialNumber, CS);
 		GWObjects::HealthCheck HC;
-		AP_WS_Server()->GetHealthcheck(Device.SerialNumber, HC);
 		std::string Stats;
-		AP_WS_Server()->GetStatistics(Device.SerialNumber, Stats);
+		if (AP_WS_Server()->GetState(Device.SerialNumber, CS)) {
+			AP_WS_Server()->GetHealthcheck(Device.SerialNumber, HC);
+			AP_WS_Server()->GetStatistics(Device.SerialNumber, Stats);
+		} else {
+			//	Not connected: last known values.
+			auto SerialNumber = Utils::SerialNumberToInt(Device.SerialNumber);
+			DeviceShadow()->GetConnection(SerialNumber, CS);
+			std::vector<GWObjects::HealthCheck> Checks;
+			if (DeviceShadow()->GetNewestHealthChecks(SerialNumber, 1, Checks))
+				HC = Checks.front();
+			std::vector<GWObjects::Statistics> LastStats;
+			if (DeviceShadow()->GetNewestStatistics(SerialNumber, 1, LastStats))
+				Stats = LastStats.front().Data;
+		}
 
 		Poco::JSON::Object DeviceInfo;
 		Device.to_json(DeviceInfo);
@@ -75,13 +75,20 @@ namespace OpenWifi {
 			return ReturnObject(Answer);
 		}
 
-		std::string OrderBy{" ORDER BY serialNumber ASC "}, Arg;
+		std::string OrderBy, Arg;
 		if (HasParameter("orderBy", Arg)) {
 			if (!PrepareOrderBy(Arg, OrderBy)) {
 				return BadRequest(RESTAPI::Errors::InvalidLOrderBy);
 			}
 		}
 
+		//	cursors follow the default serial number order
+		PageCursor After, Next;
+		if (!PageCursor::from_token(GetParameter(RESTAPI::Protocol::CURSOR, ""), After) ||
+			(After.Valid && !OrderBy.empty())) {
+			return BadRequest(RESTAPI::Errors::InvalidCursor);
+		}
+
 		auto serialOnly = GetBoolParameter(RESTAPI::Protocol::SERIALONLY, false);
 		auto deviceWithStatus = GetBoolParameter(RESTAPI::Protocol::DEVICEWITHSTATUS, false);
 		auto completeInfo = GetBoolParameter("completeInfo", false);
@@ -123,12 +130,14 @@ namespace OpenWifi {
 			}
 		} else if (serialOnly) {
 			std::vector<std::string> SerialNumbers;
-			StorageService()->GetDeviceSerialNumbers(QB_.Offset, QB_.Limit, SerialNumbers, OrderBy);
+			StorageService()->GetDeviceSerialNumbers(QB_.Offset, QB_.Limit, SerialNumbers, OrderBy,
+													 After, &Next);
 			Poco::JSON::Array Objects;
 			for (const auto &i : SerialNumbers) {
 				Objects.add(i);
 			}
 			RetObj.set(RESTAPI::Protocol::SERIALNUMBERS, Objects);
+			RetObj.set(RESTAPI::Protocol::NEXT, Next.Valid ? Next.to_token() : "");
 		} else if (GetBoolParameter("health")) {
 			auto lowLimit = GetParameter("lowLimit",30);
 			auto highLimit = GetParameter("highLimit",80);
@@ -141,7 +150,7 @@ namespace OpenWifi {
 			RetObj.set("serialNumbers", Objects);
 		} else {
 			std::vector<GWObjects::Device> Devices;
-			StorageService()->GetDevices(QB_.Offset, QB_.Limit, Devices, OrderBy);
+			StorageService()->GetDevices(QB_.Offset, QB_.Limit, Devices, OrderBy, After, &Next);
 			Poco::JSON::Array Objects;
 			for (const auto &i : Devices) {
 				Poco::JSON::Object Obj;
@@ -155,6 +164,7 @@ namespace OpenWifi {
 				RetObj.set(RESTAPI::Protocol::DEVICESWITHSTATUS, Objects);
 			else
 				RetObj.set(RESTAPI::Protocol::DEVICES, Objects);
+			RetObj.set(RESTAPI::Protocol::NEXT, Next.Valid ? Next.to_token() : "");
 		}
 		ReturnObject(RetObj);
 	}
@@ -0,0 +1,48 @@
+//
+//	License type: BSD 3-Clause License
+//	License copy: https://github.com/Telecominfraproject/wlan-cloud-ucentralgw/blob/master/LICENSE
+//
+
+#include "RESTAPI_devices_search_handler.h"
+#include "DeviceSearchIndex.h"
+
+namespace OpenWifi {
+
+	void RESTAPI_devices_search_handler::DoGet() {
+		DeviceSearchIndex::Query Q;
+		Q.SerialNumber = GetParameter("serialNumber", "");
+		Q.Terms[DeviceSearchIndex::COMPATIBLE] = GetParameter("compatible", "");
+		Q.Terms[DeviceSearchIndex::FIRMWARE] = GetParameter("firmware", "");
+		Q.Terms[DeviceSearchIndex::LOCALE] = GetParameter("locale", "");
+		Q.IPAddress = GetParameter("ipAddress", "");
+		Q.Limit = std::min(GetParameter("limit", 100), (std::uint64_t)1000);
+		Q.Facets = GetBoolParameter("facets", false);
+
+		auto After = GetParameter("after", "");
+		if (!After.empty()) {
+			if (!Utils::ValidSerialNumber(After)) {
+				return BadRequest(RESTAPI::Errors::InvalidSerialNumber);
+			}
+			Q.After = Utils::SerialNumberToInt(After);
+			Q.HasAfter = true;
+		}
+
+		std::vector<DeviceSearchIndex::Result> Results;
+		Poco::JSON::Object Facets;
+		auto More = DeviceSearchIndex()->Search(Q, Results, Facets);
+
+		Poco::JSON::Object Answer;
+		Poco::JSON::Array Devices;
+		for (const auto &Result : Results) {
+			Poco::JSON::Object Obj;
+			Result.to_json(Obj);
+			Devices.add(Obj);
+		}
+		Answer.set("devices", Devices);
+		Answer.set("next", More && !Results.empty() ? Results.back().serialNumber : "");
+		if (Q.Facets)
+			Answer.set("facets", Facets);
+		return ReturnObject(Answer);
+	}
+
+} // namespace OpenWifi
@@ -21,7 +21,7 @@ namespace OpenWifi {
 		Poco::JSON::Array Countries;
 
 		for (const auto &i : IPAddresses) {
-			Countries.add(FindCountryFromIP()->Get(i));
+			Countries.add(FindCountryFromIP()->Resolve(i));
 		}
 		Answer.set("countryCodes", Countries);
 
@@ -4,6 +4,8 @@
 
 #include "RESTAPI/RESTAPI_blacklist.h"
 #include "RESTAPI/RESTAPI_blacklist_list.h"
+#include "RESTAPI/RESTAPI_bulk_command_handler.h"
+#include "RESTAPI/RESTAPI_bulk_commands_handler.h"
 #include "RESTAPI/RESTAPI_capabilities_handler.h"
 #include "RESTAPI/RESTAPI_command.h"
 #include "RESTAPI/RESTAPI_commands.h"
@@ -13,6 +15,7 @@
 #include "RESTAPI/RESTAPI_device_commandHandler.h"
 #include "RESTAPI/RESTAPI_device_handler.h"
 #include "RESTAPI/RESTAPI_devices_handler.h"
+#include "RESTAPI/RESTAPI_devices_search_handler.h"
 #include "RESTAPI/RESTAPI_file.h"
 #include "RESTAPI/RESTAPI_iptocountry_handler.h"
 #include "RESTAPI/RESTAPI_ouis.h"
@@ -44,8 +47,8 @@ namespace OpenWifi {
 			RESTAPI_radiusProxyConfig_handler, RESTAPI_scripts_handler, RESTAPI_script_handler,
 			RESTAPI_capabilities_handler, RESTAPI_telemetryWebSocket, RESTAPI_radiussessions_handler,
 			RESTAPI_regulatory, RESTAPI_default_firmwares,
-			RESTAPI_default_firmware>(Path, Bindings, L, S,
-																	  TransactionId);
+			RESTAPI_default_firmware, RESTAPI_devices_search_handler, RESTAPI_bulk_commands_handler,
+			RESTAPI_bulk_command_handler>(Path, Bindings, L, S, TransactionId);
 	}
 
 	Poco::Net::HTTPRequestHandler *
@@ -59,6 +62,7 @@ namespace OpenWifi {
 			RESTAPI_iptocountry_handler, RESTAPI_radiusProxyConfig_handler, RESTAPI_scripts_handler,
 			RESTAPI_script_handler, RESTAPI_blacklist_list, RESTAPI_radiussessions_handler,
 			RESTAPI_regulatory, RESTAPI_default_firmwares,
-			RESTAPI_default_firmware>(Path, Bindings, L, S, TransactionId);
+			RESTAPI_default_firmware, RESTAPI_devices_search_handler, RESTAPI_bulk_commands_handler,
+			RESTAPI_bulk_command_handler>(Path, Bindings, L, S, TransactionId);
 	}
 } // namespace OpenWifi
\ No newline at end of file
@@ -61,6 +61,9 @@ namespace OpenWifi::GWObjects {
 		field_to_json(Obj, "lastRecordedContact", lastRecordedContact);
 		field_to_json(Obj, "certificateExpiryDate", certificateExpiryDate);
 		field_to_json(Obj, "connectReason", connectReason);
+		field_to_json(Obj, "sendQueueFrames", sendQueueFrames);
+		field_to_json(Obj, "sendQueueBytes", sendQueueBytes);
+		field_to_json(Obj, "sendQueueDropped", sendQueueDropped);
 	}
 
 	void Device::to_json_with_status(Poco::JSON::Object &Obj) const {
@@ -559,6 +562,71 @@ namespace OpenWifi::GWObjects {
 		return false;
 	}
 
+	void BulkCommandDevice::to_json(Poco::JSON::Object &Obj) const {
+		field_to_json(Obj, "serialNumber", serialNumber);
+		field_to_json(Obj, "UUID", UUID);
+		field_to_json(Obj, "status", status);
+		field_to_json(Obj, "errorCode", errorCode);
+		field_to_json(Obj, "errorText", errorText);
+	}
+
+	bool BulkCommandDevice::from_json(const Poco::JSON::Object::Ptr &Obj) {
+		try {
+			field_from_json(Obj, "serialNumber", serialNumber);
+			field_from_json(Obj, "UUID", UUID);
+			field_from_json(Obj, "status", status);
+			field_from_json(Obj, "errorCode", errorCode);
+			field_from_json(Obj, "errorText", errorText);
+			return true;
+		} catch (const Poco::Exception &E) {
+		}
+		return false;
+	}
+
+	void BulkCommand::to_json(Poco::JSON::Object &Obj) const {
+		progress_to_json(Obj);
+		field_to_json(Obj, "devices", devices);
+	}
+
+	//	Everything but the devices, with the number of devices in each status.
+	void BulkCommand::progress_to_json(Poco::JSON::Object &Obj) const {
+		field_to_json(Obj, "id", id);
+		field_to_json(Obj, "command", command);
+		field_to_json(Obj, "details", details);
+		field_to_json(Obj, "submittedBy", submittedBy);
+		field_to_json(Obj, "created", created);
+		field_to_json(Obj, "completed", completed);
+		field_to_json(Obj, "status", status);
+		field_to_json(Obj, "concurrency", concurrency);
+		field_to_json(Obj, "rate", rate);
+		std::map<std::string, std::uint64_t> Counts;
+		for (const auto &Device : devices)
+			Counts[Device.status]++;
+		Poco::JSON::Object Progress;
+		Progress.set("total", devices.size());
+		for (const auto &[Status, Count] : Counts)
+			Progress.set(Status, Count);
+		Obj.set("progress", Progress);
+	}
+
+	bool BulkCommand::from_json(const Poco::JSON::Object::Ptr &Obj) {
+		try {
+			field_from_json(Obj, "id", id);
+			field_from_json(Obj, "command", command);
+			field_from_json(Obj, "details", details);
+			field_from_json(Obj, "submittedBy", submittedBy);
+			field_from_json(Obj, "created", created);
+			field_from_json(Obj, "completed", completed);
+			field_from_json(Obj, "status", status);
+			field_from_json(Obj, "concurrency", concurrency);
+			field_from_json(Obj, "rate", rate);
+			field_from_json(Obj, "devices", devices);
+			return true;
+		} catch (const Poco::Exception &E) {
+		}
+		return false;
+	}
+
 	void ScriptEntryList::to_json(Poco::JSON::Object &Obj) const {
 		field_to_json(Obj, "scripts", scripts);
 	}
@@ -49,6 +49,9 @@ namespace OpenWifi::GWObjects {
 		std::double_t load=0.0;
 		std::double_t temperature=0.0;
 		std::string 	connectReason;
+		std::uint64_t sendQueueFrames = 0;
+		std::uint64_t sendQueueBytes = 0;
+		std::uint64_t sendQueueDropped = 0;
 
 		void to_json(const std::string &SerialNumber, Poco::JSON::Object &Obj) ;
 	};
@@ -308,6 +311,34 @@ namespace OpenWifi::GWObjects {
 		bool from_json(const Poco::JSON::Object::Ptr &Obj);
 	};
 
+	struct BulkCommandDevice {
+		std::string serialNumber;
+		std::string UUID;
+		std::string status;
+		std::uint64_t errorCode = 0;
+		std::string errorText;
+
+		void to_json(Poco::JSON::Object &Obj) const;
+		bool from_json(const Poco::JSON::Object::Ptr &Obj);
+	};
+
+	struct BulkCommand {
+		std::string id;
+		std::string command;
+		std::string details;
+		std::string submittedBy;
+		std::uint64_t created = 0;
+		std::uint64_t completed = 0;
+		std::string status;
+		std::uint64_t concurrency = 0;
+		std::uint64_t rate = 0;
+		std::vector<BulkCommandDevice> devices;
+
+		void to_json(Poco::JSON::Object &Obj) const;
+		bool from_json(const Poco::JSON::Object::Ptr &Obj);
+		void progress_to_json(Poco::JSON::Object &Obj) const;
+	};
+
 	struct ScriptRequest {
 		std::string serialNumber;
 		uint64_t timeout = 30;
@@ -0,0 +1,260 @@
+//
+//	License type: BSD 3-Clause License
+//	License copy: https://github.com/Telecominfraproject/wlan-cloud-ucentralgw/blob/master/LICENSE
+//
+
+#pragma once
+
+#include <charconv>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace OpenWifi {
+
+	//	Scans a single JSON object and records where each of its top-level members starts and ends,
+	//	without building a document. Values are returned as views into the original text, so large
+	//	members (state, healthcheck data) can be stored or forwarded without being copied or
+	//	re-stringified. Anything unusual makes Parse() fail: callers then fall back to Poco::JSON.
+	class RawJSONObject {
+	  public:
+		inline bool Parse(std::string_view Doc) {
+			Members_.clear();
+			Doc_ = Doc;
+			Pos_ = 0;
+			SkipSpaces();
+			if (!Expect('{'))
+				return false;
+			SkipSpaces();
+			if (Expect('}'))
+				return TrailingOnly();
+			while (true) {
+				SkipSpaces();
+				auto KeyStart = Pos_;
+				if (!SkipString())
+					return false;
+				auto Key = Doc_.substr(KeyStart + 1, Pos_ - KeyStart - 2);
+				SkipSpaces();
+				if (!Expect(':'))
+					return false;
+				SkipSpaces();
+				auto ValueStart = Pos_;
+				if (!SkipValue())
+					return false;
+				Members_.emplace_back(Key, Doc_.substr(ValueStart, Pos_ - ValueStart));
+				SkipSpaces();
+				if (Peek() == ',') {
+					Pos_++;
+					continue;
+				}
+				if (!Expect('}'))
+					return false;
+				return TrailingOnly();
+			}
+		}
+
+		[[nodiscard]] inline std::string_view Document() const { return Doc_; }
+
+		[[nodiscard]] inline bool Has(std::string_view Key) const {
+			return !Raw(Key).empty();
+		}
+
+		//	The raw text of a value: strings keep their quotes, objects their braces.
+		[[nodiscard]] inline std::string_view Raw(std::string_view Key) const {
+			for (const auto &[Name, Value] : Members_) {
+				if (Name == Key)
+					return Value;
+			}
+			return {};
+		}
+
+		[[nodiscard]] inline bool IsObject(std::string_view Key) const {
+			auto V = Raw(Key);
+			return !V.empty() && V.front() == '{';
+		}
+
+		[[nodiscard]] inline bool IsArray(std::string_view Key) const {
+			auto V = Raw(Key);
+			return !V.empty() && V.front() == '[';
+		}
+
+		//	Value is left empty when false is returned.
+		inline bool GetString(std::string_view Key, std::string &Value) const {
+			Value.clear();
+			auto V = Raw(Key);
+			if (V.size() < 2 || V.front() != '"')
+				return false;
+			V = V.substr(1, V.size() - 2);
+			Value.reserve(V.size());
+			for (std::size_t i = 0; i < V.size(); ++i) {
+				if (V[i] != '\\') {
+					Value += V[i];
+					continue;
+				}
+				if (++i == V.size()) {
+					Value.clear();
+					return false;
+				}
+				switch (V[i]) {
+				case '"':
+				case '\\':
+				case '/':
+					Value += V[i];
+					break;
+				case 'b':
+					Value += '\b';
+					break;
+				case 'f':
+					Value += '\f';
+					break;
+				case 'n':
+					Value += '\n';
+					break;
+				case 'r':
+					Value += '\r';
+					break;
+				case 't':
+					Value += '\t';
+					break;
+				default:
+					//	\u escapes are never used in the fields we read this way
+					Value.clear();
+					return false;
+				}
+			}
+			return true;
+		}
+
+		inline bool GetUInt(std::string_view Key, std::uint64_t &Value) const {
+			return ToUInt(Raw(Key), Value);
+		}
+
+		inline bool GetNumber(std::string_view Key, double &Value) const {
+			return ToNumber(Raw(Key), Value);
+		}
+
+		//	Conversions of raw values, as found in an object or an array.
+		static inline bool ToUInt(std::string_view V, std::uint64_t &Value) {
+			if (V.empty())
+				return false;
+			auto Result = std::from_chars(V.data(), V.data() + V.size(), Value);
+			return Result.ec == std::errc() && Result.ptr == V.data() + V.size();
+		}
+
+		static inline bool ToNumber(std::string_view V, double &Value) {
+			if (V.empty())
+				return false;
+			auto Result = std::from_chars(V.data(), V.data() + V.size(), Value);
+			return Result.ec == std::errc() && Result.ptr == V.data() + V.size();
+		}
+
+		//	Splits the raw text of an array into the raw text of its elements.
+		static inline bool Elements(std::string_view Array, std::vector<std::string_view> &Values) {
+			Values.clear();
+			RawJSONObject P;
+			P.Doc_ = Array;
+			P.SkipSpaces();
+			if (!P.Expect('['))
+				return false;
+			P.SkipSpaces();
+			if (P.Expect(']'))
+				return P.TrailingOnly();
+			while (true) {
+				P.SkipSpaces();
+				auto ValueStart = P.Pos_;
+				if (!P.SkipValue())
+					return false;
+				Values.emplace_back(Array.substr(ValueStart, P.Pos_ - ValueStart));
+				P.SkipSpaces();
+				if (P.Peek() == ',') {
+					P.Pos_++;
+					continue;
+				}
+				if (!P.Expect(']'))
+					return false;
+				return P.TrailingOnly();
+			}
+		}
+
+	  private:
+		std::string_view Doc_;
+		std::size_t Pos_ = 0;
+		std::vector<std::pair<std::string_view, std::string_view>> Members_;
+
+		inline char Peek() const { return Pos_ < Doc_.size() ? Doc_[Pos_] : 0; }
+
+		inline bool Expect(char c) {
+			if (Peek() != c)
+				return false;
+			Pos_++;
+			return true;
+		}
+
+		inline void SkipSpaces() {
+			while (Pos_ < Doc_.size() && (Doc_[Pos_] == ' ' || Doc_[Pos_] == '\t' ||
+										  Doc_[Pos_] == '\n' || Doc_[Pos_] == '\r'))
+				Pos_++;
+		}
+
+		inline bool TrailingOnly() {
+			SkipSpaces();
+			//	frames are null terminated
+			while (Pos_ < Doc_.size() && Doc_[Pos_] == 0)
+				Pos_++;
+			return Pos_ == Doc_.size();
+		}
+
+		inline bool SkipString() {
+			if (!Expect('"'))
+				return false;
+			while (Pos_ < Doc_.size()) {
+				auto c = Doc_[Pos_++];
+				if (c == '\\') {
+					Pos_++;
+				} else if (c == '"') {
+					return true;
+				}
+			}
+			return false;
+		}
+
+		inline bool SkipValue() {
+			auto c = Peek();
+			if (c == '"')
+				return SkipString();
+			if (c == '{' || c == '[') {
+				std::string Closers;
+				while (Pos_ < Doc_.size()) {
+					c = Doc_[Pos_];
+					if (c == '"') {
+						if (!SkipString())
+							return false;
+						continue;
+					}
+					if (c == '{')
+						Closers.push_back('}');
+					else if (c == '[')
+						Closers.push_back(']');
+					else if (c == '}' || c == ']') {
+						if (Closers.empty() || Closers.back() != c)
+							return false;
+						Closers.pop_back();
+					}
+					Pos_++;
+					if (Closers.empty())
+						return true;
+				}
+				return false;
+			}
+			//	number, true, false, null
+			auto Start = Pos_;
+			while (Pos_ < Doc_.size() && Doc_[Pos_] != ',' && Doc_[Pos_] != '}' &&
+				   Doc_[Pos_] != ']' && Doc_[Pos_] != ' ' && Doc_[Pos_] != '\t' &&
+				   Doc_[Pos_] != '\n' && Doc_[Pos_] != '\r')
+				Pos_++;
+			return Pos_ > Start;
+		}
+	};
+
+} // namespace OpenWifi
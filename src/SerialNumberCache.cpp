@@ -10,6 +10,17 @@
 
 namespace OpenWifi {
 
+	uint64_t Reverse(uint64_t N) {
+		uint64_t Res = 0;
+
+		for (int i = 0; i < 16; i++) {
+			Res = (Res << 4) + (N & 0x000000000000000f);
+			N >>= 4;
+		}
+		Res >>= 16;
+		return Res;
+	}
+
 	int SerialNumberCache::Start() {
 		poco_notice(Logger(), "Starting...");
 		StorageService()->UpdateSerialNumberCache();
@@ -18,23 +29,50 @@ namespace OpenWifi {
 
 	void SerialNumberCache::Stop() {
 		poco_notice(Logger(), "Stopping...");
+		std::lock_guard G(Mutex_);
+		Numbers_.Clear();
 		SNs_.clear();
 		Reverse_SNs_.clear();
+		PendingAdds_.clear();
+		SortedStale_ = false;
 		poco_notice(Logger(), "Stopped...");
 	}
 
+	//	Brings SNs_ and Reverse_SNs_ up to date with the hash set. Mutex_ must be held.
+	void SerialNumberCache::MergePending() {
+		if (!SortedStale_)
+			return;
+
+		std::sort(PendingAdds_.begin(), PendingAdds_.end());
+		std::vector<uint64_t> Merged;
+		Merged.reserve(SNs_.size() + PendingAdds_.size());
+		std::merge(SNs_.begin(), SNs_.end(), PendingAdds_.begin(), PendingAdds_.end(),
+				   std::back_inserter(Merged));
+		Merged.erase(std::unique(Merged.begin(), Merged.end()), Merged.end());
+		Merged.erase(std::remove_if(Merged.begin(), Merged.end(),
+									[this](uint64_t SN) { return !Numbers_.Contains(SN); }),
+					 Merged.end());
+		SNs_ = std::move(Merged);
+
+		Reverse_SNs_.clear();
+		Reverse_SNs_.reserve(SNs_.size());
+		for (const auto SN : SNs_)
+			Reverse_SNs_.push_back(Reverse(SN));
+		std::sort(Reverse_SNs_.begin(), Reverse_SNs_.end());
+
+		PendingAdds_.clear();
+		SortedStale_ = false;
+	}
+
 	void SerialNumberCache::AddSerialNumber(const std::string &S) {
 		std::lock_guard G(Mutex_);
 
 		uint64_t SN = std::stoull(S, nullptr, 16);
-		if (std::find(std::begin(SNs_), std::end(SNs_), SN) == std::end(SNs_)) {
-			auto insert_point = std::lower_bound(SNs_.begin(), SNs_.end(), SN);
-			SNs_.insert(insert_point, SN);
-
-			auto R = ReverseSerialNumber(S);
-			uint64_t RSN = std::stoull(R, nullptr, 16);
-			auto rev_insert_point = std::lower_bound(Reverse_SNs_.begin(), Reverse_SNs_.end(), RSN);
-			Reverse_SNs_.insert(rev_insert_point, RSN);
+		if (Numbers_.Insert(SN)) {
+			PendingAdds_.push_back(SN);
+			SortedStale_ = true;
+			if (PendingAdds_.size() >= MaxPendingAdds)
+				MergePending();
 		}
 	}
 
@@ -42,40 +80,44 @@ namespace OpenWifi {
 		std::lock_guard G(Mutex_);
 
 		uint64_t SN = std::stoull(S, nullptr, 16);
-		auto It = std::find(SNs_.begin(), SNs_.end(), SN);
-		if (It != SNs_.end()) {
-			SNs_.erase(It);
-
-			auto R = ReverseSerialNumber(S);
-			uint64_t RSN = std::stoull(R, nullptr, 16);
-			auto RIt = std::find(Reverse_SNs_.begin(), Reverse_SNs_.end(), RSN);
-			if (RIt != Reverse_SNs_.end()) {
-				Reverse_SNs_.erase(RIt);
-			}
-		}
+		if (Numbers_.Erase(SN))
+			SortedStale_ = true;
 	}
 
-	uint64_t Reverse(uint64_t N) {
-		uint64_t Res = 0;
+	void SerialNumberCache::Load(std::vector<uint64_t> &&SerialNumbers) {
+		std::sort(SerialNumbers.begin(), SerialNumbers.end());
+		SerialNumbers.erase(std::unique(SerialNumbers.begin(), SerialNumbers.end()),
+							SerialNumbers.end());
 
-		for (int i = 0; i < 16; i++) {
-			Res = (Res << 4) + (N & 0x000000000000000f);
-			N >>= 4;
-		}
-		Res >>= 16;
-		return Res;
+		std::lock_guard G(Mutex_);
+		Numbers_.Assign(SerialNumbers);
+
+		SNs_ = std::move(SerialNumbers);
+		Reverse_SNs_.clear();
+		Reverse_SNs_.reserve(SNs_.size());
+		for (const auto SN : SNs_)
+			Reverse_SNs_.push_back(Reverse(SN));
+		std::sort(Reverse_SNs_.begin(), Reverse_SNs_.end());
+		PendingAdds_.clear();
+		SortedStale_ = false;
+	}
+
+	bool SerialNumberCache::GetResourceStatistics(Poco::JSON::Object &Stats) {
+		std::lock_guard G(Mutex_);
+		Stats.set("serialNumbers", Numbers_.Size());
+		Stats.set("slots", Numbers_.Slots());
+		Stats.set("tablesReclaimed", Numbers_.Reclaimed());
+		Stats.set("pendingAdds", PendingAdds_.size());
+		return true;
 	}
 
 	void SerialNumberCache::ReturnNumbers(const std::string &S, uint HowMany,
 										  const std::vector<uint64_t> &SNArr,
 										  std::vector<uint64_t> &A, bool ReverseResult) {
-		std::lock_guard G(Mutex_);
-
 		if (S.length() == 12) {
 			uint64_t SN = std::stoull(S, nullptr, 16);
-			auto It = std::find(SNArr.begin(), SNArr.end(), SN);
-			if (It != SNArr.end()) {
-				A.push_back(ReverseResult ? Reverse(*It) : *It);
+			if (std::binary_search(SNArr.begin(), SNArr.end(), SN)) {
+				A.push_back(ReverseResult ? Reverse(SN) : SN);
 			}
 		} else if (S.length() < 12) {
 			std::string SS{S};
@@ -110,6 +152,8 @@ namespace OpenWifi {
 		if (S.empty())
 			return;
 
+		std::lock_guard G(Mutex_);
+		MergePending();
 		if (S[0] == '*') {
 			std::string Reversed;
 			std::copy(rbegin(S), rend(S) - 1, std::back_inserter(Reversed));
@@ -120,4 +164,4 @@ namespace OpenWifi {
 			return ReturnNumbers(S, HowMany, SNs_, A, false);
 		}
 	}
-} // namespace OpenWifi
\ No newline at end of file
+} // namespace OpenWifi
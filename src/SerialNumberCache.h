@@ -6,6 +6,8 @@
 
 #include "framework/SubSystemServer.h"
 
+#include "SerialNumberHashSet.h"
+
 namespace OpenWifi {
 	class SerialNumberCache : public SubSystemServer {
 	  public:
@@ -18,12 +20,16 @@ namespace OpenWifi {
 		void Stop() override;
 		void AddSerialNumber(const std::string &SerialNumber);
 		void DeleteSerialNumber(const std::string &SerialNumber);
+		//	Replaces the whole cache, used when loading all devices at startup.
+		void Load(std::vector<uint64_t> &&SerialNumbers);
 		void FindNumbers(const std::string &SerialNumber, uint HowMany, std::vector<uint64_t> &A);
-		inline bool NumberExists(uint64_t SerialNumber) {
-			std::lock_guard G(Mutex_);
-			return std::find(SNs_.begin(), SNs_.end(), SerialNumber) != SNs_.end();
+		//	Does not take any lock.
+		inline bool NumberExists(uint64_t SerialNumber) const {
+			return Numbers_.Contains(SerialNumber);
 		}
 
+		bool GetResourceStatistics(Poco::JSON::Object &Stats) override;
+
 		static inline std::string ReverseSerialNumber(const std::string &S) {
 			std::string ReversedString;
 			std::copy(rbegin(S), rend(S), std::back_inserter(ReversedString));
@@ -31,16 +37,25 @@ namespace OpenWifi {
 		}
 
 	  private:
+		static constexpr std::size_t MaxPendingAdds = 65536;
+
+		SerialNumberHashSet Numbers_;
+
+		//	Sorted serial numbers (and their reversed digits) for prefix and *suffix searches.
+		//	New numbers are collected in PendingAdds_ and merged in, and deleted ones dropped,
+		//	the next time a search needs the sorted arrays.
 		std::vector<uint64_t> SNs_;
 		std::vector<uint64_t> Reverse_SNs_;
+		std::vector<uint64_t> PendingAdds_;
+		bool SortedStale_ = false;
+
+		void MergePending();
 
 		void ReturnNumbers(const std::string &S, uint HowMany, const std::vector<uint64_t> &SNArr,
 						   std::vector<uint64_t> &A, bool ReverseResult);
 
 		SerialNumberCache() noexcept
-			: SubSystemServer("SerialNumberCache", "SNCACHE-SVR", "serialcache") {
-			SNs_.reserve(2000);
-		}
+			: SubSystemServer("SerialNumberCache", "SNCACHE-SVR", "serialcache") {}
 	};
 
 	inline auto SerialNumberCache() { return SerialNumberCache::instance(); }
@@ -0,0 +1,186 @@
+//
+//	License type: BSD 3-Clause License
+//	License copy: https://github.com/Telecominfraproject/wlan-cloud-ucentralgw/blob/master/LICENSE
+//
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace OpenWifi {
+
+	//	Open-addressing hash set of serial numbers with linear probing, where Contains() takes no
+	//	lock. Serial numbers are 48 bits, so the two top values can never be a serial number and
+	//	mark empty and deleted slots. Writers must be serialized by the caller; readers only load
+	//	the slots. A table is never resized in place: a larger one is built and published, and the
+	//	old one is freed as soon as no reader can still be probing it.
+	class SerialNumberHashSet {
+	  public:
+		explicit SerialNumberHashSet(std::size_t MinimumSlots = 4096)
+			: MinimumSlots_(RoundUp(MinimumSlots)) {
+			Current_ = std::make_unique<Table>(MinimumSlots_);
+			Table_.store(Current_.get());
+		}
+
+		//	Does not take any lock.
+		[[nodiscard]] inline bool Contains(std::uint64_t SN) const {
+			auto Epoch = Epoch_.load() & 1;
+			Readers_[Epoch]++;
+			auto Found = Contains(*Table_.load(), SN);
+			Readers_[Epoch]--;
+			return Found;
+		}
+
+		inline bool Insert(std::uint64_t SN) {
+			auto T = Current_.get();
+			if (Contains(*T, SN))
+				return false;
+			//	Keep the table at most half full, deleted slots included. Tables grow by doubling,
+			//	and one of the same size is only rebuilt once deleted slots fill a quarter of it.
+			if ((Used_ + 1) * 2 > T->Mask + 1) {
+				auto Slots = T->Mask + 1;
+				while ((Count_ + 1) * 2 > Slots / 2)
+					Slots <<= 1;
+				Rebuild(Slots);
+				T = Current_.get();
+			}
+			for (auto i = T->Home(SN);; i = (i + 1) & T->Mask) {
+				auto V = T->Slots[i].load(std::memory_order_relaxed);
+				if (V == EmptySlot || V == DeletedSlot) {
+					if (V == EmptySlot)
+						Used_++;
+					T->Slots[i].store(SN, std::memory_order_release);
+					Count_++;
+					return true;
+				}
+			}
+		}
+
+		inline bool Erase(std::uint64_t SN) {
+			auto T = Current_.get();
+			for (auto i = T->Home(SN);; i = (i + 1) & T->Mask) {
+				auto V = T->Slots[i].load(std::memory_order_relaxed);
+				if (V == SN) {
+					T->Slots[i].store(DeletedSlot, std::memory_order_release);
+					Count_--;
+					return true;
+				}
+				if (V == EmptySlot)
+					return false;
+			}
+		}
+
+		//	Replaces the whole set. SerialNumbers must not hold duplicates.
+		inline void Assign(const std::vector<std::uint64_t> &SerialNumbers) {
+			std::size_t Slots = MinimumSlots_;
+			while (SerialNumbers.size() * 2 > Slots / 2)
+				Slots <<= 1;
+			auto T = std::make_unique<Table>(Slots);
+			for (const auto SN : SerialNumbers)
+				Place(*T, SN);
+			Count_ = Used_ = SerialNumbers.size();
+			Publish(std::move(T));
+		}
+
+		inline void Clear() {
+			Count_ = Used_ = 0;
+			Publish(std::make_unique<Table>(MinimumSlots_));
+		}
+
+		[[nodiscard]] inline std::size_t Size() const { return Count_; }
+		[[nodiscard]] inline std::size_t Slots() const { return Current_->Mask + 1; }
+		//	Tables replaced so far; each was freed once its last reader left.
+		[[nodiscard]] inline std::uint64_t Reclaimed() const { return Reclaimed_; }
+
+	  private:
+		static constexpr std::uint64_t EmptySlot = ~0ULL;
+		static constexpr std::uint64_t DeletedSlot = ~0ULL - 1;
+
+		struct Table {
+			explicit Table(std::size_t NumberOfSlots)
+				: Mask(NumberOfSlots - 1), Shift(64),
+				  Slots(new std::atomic<std::uint64_t>[NumberOfSlots]) {
+				for (std::size_t i = 1; i < NumberOfSlots; i <<= 1)
+					Shift--;
+				for (std::size_t i = 0; i < NumberOfSlots; i++)
+					Slots[i].store(EmptySlot, std::memory_order_relaxed);
+			}
+			std::size_t Mask;
+			unsigned Shift;
+			std::unique_ptr<std::atomic<std::uint64_t>[]> Slots;
+			inline std::size_t Home(std::uint64_t SN) const {
+				return (std::size_t)((SN * 0x9E3779B97F4A7C15ULL) >> Shift);
+			}
+		};
+
+		std::size_t MinimumSlots_;
+		std::unique_ptr<Table> Current_;
+		std::atomic<Table *> Table_{nullptr};
+		//	Readers announce themselves in the counter picked by the epoch they saw.
+		mutable std::atomic<std::uint64_t> Readers_[2]{};
+		std::atomic<std::uint64_t> Epoch_{0};
+		std::size_t Count_ = 0;
+		std::size_t Used_ = 0;
+		std::uint64_t Reclaimed_ = 0;
+
+		static inline std::size_t RoundUp(std::size_t Slots) {
+			std::size_t Result = 2;
+			while (Result < Slots)
+				Result <<= 1;
+			return Result;
+		}
+
+		static inline bool Contains(const Table &T, std::uint64_t SN) {
+			for (auto i = T.Home(SN);; i = (i + 1) & T.Mask) {
+				auto V = T.Slots[i].load(std::memory_order_acquire);
+				if (V == SN)
+					return true;
+				if (V == EmptySlot)
+					return false;
+			}
+		}
+
+		static inline void Place(Table &T, std::uint64_t SN) {
+			auto i = T.Home(SN);
+			while (T.Slots[i].load(std::memory_order_relaxed) != EmptySlot)
+				i = (i + 1) & T.Mask;
+			T.Slots[i].store(SN, std::memory_order_relaxed);
+		}
+
+		//	Copies the current entries, without the deleted slots, into a table of the given size.
+		inline void Rebuild(std::size_t NumberOfSlots) {
+			auto T = std::make_unique<Table>(NumberOfSlots);
+			std::size_t Count = 0;
+			for (std::size_t i = 0; i <= Current_->Mask; i++) {
+				auto SN = Current_->Slots[i].load(std::memory_order_relaxed);
+				if (SN == EmptySlot || SN == DeletedSlot)
+					continue;
+				Place(*T, SN);
+				Count++;
+			}
+			Count_ = Used_ = Count;
+			Publish(std::move(T));
+		}
+
+		//	Flipping the epoch sends new readers to the other counter, so each counter drains in
+		//	turn. Once both were seen at zero after the new table was published, no reader can
+		//	still be probing the old one. Readers never wait; only the writer does, for the length
+		//	of a probe.
+		inline void Publish(std::unique_ptr<Table> T) {
+			Table_.store(T.get());
+			auto Old = std::move(Current_);
+			Current_ = std::move(T);
+			for (int i = 0; i < 2; i++) {
+				auto Draining = Epoch_++ & 1;
+				while (Readers_[Draining].load() != 0)
+					std::this_thread::yield();
+			}
+			Reclaimed_++;
+		}
+	};
+
+} // namespace OpenWifi
@@ -95,4 +95,211 @@ namespace OpenWifi::StateUtils {
 		}
 		return false;
 	}
-} // namespace OpenWifi::StateUtils
\ No newline at end of file
+
+	//	A scalar that may have been sent as a string, as Poco would convert it.
+	static bool RawToUInt(std::string_view V, uint64_t &Value) {
+		if (V.size() >= 2 && V.front() == '"')
+			V = V.substr(1, V.size() - 2);
+		return RawJSONObject::ToUInt(V, Value);
+	}
+
+	bool ComputeAssociations(const RawJSONObject &State, uint64_t &Radios_2G,
+							 uint64_t &Radios_5G, uint64_t &Radios_6G) {
+		Radios_2G = 0;
+		Radios_5G = 0;
+		Radios_6G = 0;
+
+		if (!State.IsArray("radios") || !State.IsArray("interfaces"))
+			return false;
+
+		std::vector<std::string_view> Radios;
+		if (!RawJSONObject::Elements(State.Raw("radios"), Radios))
+			return false;
+		std::map<std::string, int> RadioPHYs;
+		bool UseBandInfo = false;
+		RawJSONObject RadioObj;
+		std::vector<std::string_view> Channels;
+		for (const auto &Radio : Radios) {
+			if (!RadioObj.Parse(Radio))
+				return false;
+			if (RadioObj.Has("band")) {
+				UseBandInfo = true;
+			} else if (RadioObj.Has("phy") && RadioObj.Has("channel")) {
+				std::string PHY;
+				uint64_t Channel;
+				if (!RadioObj.GetString("phy", PHY))
+					return false;
+				if (RadioObj.IsArray("channel")) {
+					if (!RawJSONObject::Elements(RadioObj.Raw("channel"), Channels))
+						return false;
+					if (!Channels.empty()) {
+						if (!RawToUInt(Channels[0], Channel))
+							return false;
+						RadioPHYs[PHY] = ChannelToBand(Channel);
+					}
+				} else {
+					if (!RawToUInt(RadioObj.Raw("channel"), Channel))
+						return false;
+					RadioPHYs[PHY] = ChannelToBand(Channel);
+				}
+			}
+		}
+
+		std::vector<std::string_view> Interfaces, SSIDs, Associations;
+		if (!RawJSONObject::Elements(State.Raw("interfaces"), Interfaces))
+			return false;
+		RawJSONObject InterfaceObj, SSID_info;
+		for (const auto &Interface : Interfaces) {
+			if (!InterfaceObj.Parse(Interface))
+				return false;
+			if (!InterfaceObj.IsArray("ssids"))
+				continue;
+			if (!RawJSONObject::Elements(InterfaceObj.Raw("ssids"), SSIDs))
+				return false;
+			for (const auto &SSID : SSIDs) {
+				if (!SSID_info.Parse(SSID))
+					return false;
+				if (!SSID_info.IsArray("associations") || !SSID_info.Has("phy"))
+					continue;
+				int Radio = 2;
+				if (UseBandInfo) {
+					std::string Band;
+					SSID_info.GetString("band", Band);
+					Radio = BandToInt(Band);
+				} else {
+					std::string PHY;
+					SSID_info.GetString("phy", PHY);
+					auto Rit = RadioPHYs.find(PHY);
+					if (Rit != RadioPHYs.end())
+						Radio = Rit->second;
+				}
+				if (!RawJSONObject::Elements(SSID_info.Raw("associations"), Associations))
+					return false;
+				switch (Radio) {
+				case 5:
+					Radios_5G += Associations.size();
+					break;
+				case 6:
+					Radios_6G += Associations.size();
+					break;
+				default:
+					Radios_2G += Associations.size();
+					break;
+				}
+			}
+		}
+		return true;
+	}
+
+	void ExtractMetrics(const Poco::JSON::Object::Ptr &RawObject, DeviceMetrics &Metrics) {
+		auto Sanity = Metrics.Sanity;
+		Metrics = DeviceMetrics{};
+		Metrics.Sanity = Sanity;
+		if (RawObject.isNull())
+			return;
+		Metrics.HasState = true;
+		Metrics.HasGPS = RawObject->isObject("gps");
+		try {
+			ComputeAssociations(RawObject, Metrics.Associations_2G, Metrics.Associations_5G,
+								Metrics.Associations_6G);
+		} catch (...) {
+			Metrics.Associations_2G = Metrics.Associations_5G = Metrics.Associations_6G = 0;
+		}
+		if (!RawObject->isObject("unit"))
+			return;
+		auto Unit = RawObject->getObject("unit");
+		try {
+			if (Unit->has("uptime")) {
+				Metrics.Uptime = Unit->get("uptime");
+				Metrics.HasUptime = true;
+			}
+		} catch (...) {
+		}
+		try {
+			if (Unit->isObject("memory")) {
+				auto Memory = Unit->getObject("memory");
+				Metrics.MemoryTotal = Memory->get("total");
+				Metrics.MemoryFree = Memory->get("free");
+				Metrics.HasMemory = true;
+				if (Metrics.MemoryTotal > 0) {
+					Metrics.MemoryUsed =
+						(100.0 * ((double)Metrics.MemoryTotal - (double)Metrics.MemoryFree)) /
+						(double)Metrics.MemoryTotal;
+				}
+			}
+		} catch (...) {
+		}
+		try {
+			if (Unit->isArray("load")) {
+				auto Load = Unit->getArray("load");
+				if (Load->size() > 2) {
+					for (std::size_t i = 0; i < 3; i++)
+						Metrics.Load[i] = Load->getElement<std::uint64_t>(i);
+					Metrics.HasLoad = true;
+				}
+			}
+		} catch (...) {
+		}
+		try {
+			if (Unit->isArray("temperature")) {
+				auto Temperature = Unit->getArray("temperature");
+				if (Temperature->size() > 1) {
+					Metrics.Temperature = Temperature->get(0);
+				}
+			}
+		} catch (...) {
+		}
+	}
+
+	bool ExtractMetrics(std::string_view State, DeviceMetrics &Metrics) {
+		auto Sanity = Metrics.Sanity;
+		Metrics = DeviceMetrics{};
+		Metrics.Sanity = Sanity;
+
+		RawJSONObject StateObj;
+		if (!StateObj.Parse(State))
+			return false;
+		if (StateObj.IsArray("radios") && StateObj.IsArray("interfaces") &&
+			!ComputeAssociations(StateObj, Metrics.Associations_2G, Metrics.Associations_5G,
+								 Metrics.Associations_6G))
+			return false;
+		Metrics.HasState = true;
+		Metrics.HasGPS = StateObj.IsObject("gps");
+		if (!StateObj.IsObject("unit"))
+			return true;
+
+		RawJSONObject Unit;
+		if (!Unit.Parse(StateObj.Raw("unit")))
+			return false;
+		if (Unit.Has("uptime"))
+			Metrics.HasUptime = RawToUInt(Unit.Raw("uptime"), Metrics.Uptime);
+		if (Unit.IsObject("memory")) {
+			RawJSONObject Memory;
+			if (Memory.Parse(Unit.Raw("memory")) &&
+				RawToUInt(Memory.Raw("total"), Metrics.MemoryTotal) &&
+				RawToUInt(Memory.Raw("free"), Metrics.MemoryFree)) {
+				Metrics.HasMemory = true;
+				if (Metrics.MemoryTotal > 0) {
+					Metrics.MemoryUsed =
+						(100.0 * ((double)Metrics.MemoryTotal - (double)Metrics.MemoryFree)) /
+						(double)Metrics.MemoryTotal;
+				}
+			}
+		}
+		std::vector<std::string_view> Values;
+		if (Unit.IsArray("load") && RawJSONObject::Elements(Unit.Raw("load"), Values) &&
+			Values.size() > 2) {
+			Metrics.HasLoad = true;
+			for (std::size_t i = 0; i < 3; i++)
+				Metrics.HasLoad = Metrics.HasLoad && RawToUInt(Values[i], Metrics.Load[i]);
+			if (!Metrics.HasLoad)
+				Metrics.Load = {0, 0, 0};
+		}
+		if (Unit.IsArray("temperature") &&
+			RawJSONObject::Elements(Unit.Raw("temperature"), Values) && Values.size() > 1) {
+			if (!RawJSONObject::ToNumber(Values[0], Metrics.Temperature))
+				Metrics.Temperature = 0.0;
+		}
+		return true;
+	}
+} // namespace OpenWifi::StateUtils
@@ -4,9 +4,43 @@
 
 #pragma once
 
+#include <array>
+#include <cmath>
+#include <cstdint>
+
 #include "Poco/JSON/Object.h"
 
+#include "RawJSONObject.h"
+
 namespace OpenWifi::StateUtils {
+
+	//	Values taken once from a state report, and the sanity of the last healthcheck, so that
+	//	nothing needs the report parsed again.
+	struct DeviceMetrics {
+		bool HasState = false;
+		bool HasGPS = false;
+		bool HasUptime = false;
+		bool HasMemory = false;
+		bool HasLoad = false;
+		std::uint64_t Uptime = 0;
+		std::uint64_t MemoryFree = 0;
+		std::uint64_t MemoryTotal = 0;
+		std::double_t MemoryUsed = 0.0;
+		std::array<std::uint64_t, 3> Load{0, 0, 0};
+		std::double_t Temperature = 0.0;
+		std::uint64_t Associations_2G = 0;
+		std::uint64_t Associations_5G = 0;
+		std::uint64_t Associations_6G = 0;
+		std::uint64_t Sanity = 0;
+	};
+
 	bool ComputeAssociations(const Poco::JSON::Object::Ptr RawObject, uint64_t &Radios_2G,
 							 uint64_t &Radios_5G, uint64_t &Radio_6G);
+	bool ComputeAssociations(const RawJSONObject &State, uint64_t &Radios_2G,
+							 uint64_t &Radios_5G, uint64_t &Radio_6G);
+	//	Sanity is left alone: it comes from healthchecks.
+	void ExtractMetrics(const Poco::JSON::Object::Ptr &RawObject, DeviceMetrics &Metrics);
+	//	Same values, read straight from the text of the report. Returns false when the report
+	//	cannot be walked this way, and the caller should parse it with Poco instead.
+	bool ExtractMetrics(std::string_view State, DeviceMetrics &Metrics);
 }
\ No newline at end of file
@@ -0,0 +1,202 @@
+//
+//	License type: BSD 3-Clause License
+//	License copy: https://github.com/Telecominfraproject/wlan-cloud-ucentralgw/blob/master/LICENSE
+//
+
+#include "StorageIngestion.h"
+#include "StorageService.h"
+
+#include "fmt/format.h"
+#include "framework/MicroServiceFuncs.h"
+#include "framework/utils.h"
+
+namespace OpenWifi {
+
+	int StorageIngestion::Start() {
+		poco_notice(Logger(), "Starting...");
+		Enabled_ = MicroServiceConfigGetBool("storage.ingestion.enable", true);
+		Interval_ = MicroServiceConfigGetInt("storage.ingestion.interval", 1000);
+		BatchSize_ = MicroServiceConfigGetInt("storage.ingestion.batchsize", 500);
+		MaxBacklog_ = MicroServiceConfigGetInt("storage.ingestion.maxbacklog", 50000);
+		DropOldest_ =
+			MicroServiceConfigGetString("storage.ingestion.droppolicy", "oldest") != "newest";
+		if (BatchSize_ == 0)
+			BatchSize_ = 1;
+
+		if (Enabled_) {
+			Running_ = true;
+			Worker_.start(*this);
+		}
+		return 0;
+	}
+
+	void StorageIngestion::Stop() {
+		poco_notice(Logger(), "Stopping...");
+		if (Running_) {
+			{
+				std::lock_guard G(QueueMutex_);
+				Running_ = false;
+			}
+			QueueReady_.notify_all();
+			Worker_.join();
+		}
+		poco_notice(Logger(), "Stopped...");
+	}
+
+	void StorageIngestion::run() {
+		Utils::SetThreadName("strg:ingest");
+		while (Running_) {
+			{
+				std::unique_lock G(QueueMutex_);
+				QueueReady_.wait_for(G, std::chrono::milliseconds(Interval_),
+									 [this] { return !Running_ || Pending() >= BatchSize_; });
+			}
+			FlushAll();
+		}
+		//	Write whatever is left before the database goes away.
+		FlushAll();
+	}
+
+	template <typename T> bool StorageIngestion::Queue(Backlog<T> &B, const T &Record) {
+		bool Wake;
+		{
+			std::lock_guard G(QueueMutex_);
+			//	Checked under the lock: once Stop() has cleared it, the last flush may be done.
+			if (!Running_)
+				return false;
+			if (B.Records.size() >= MaxBacklog_) {
+				B.Dropped++;
+				if (!DropOldest_)
+					return true;
+				B.Records.pop_front();
+			}
+			B.Records.push_back(Record);
+			Wake = Pending() >= BatchSize_;
+		}
+		if (Wake)
+			QueueReady_.notify_one();
+		return true;
+	}
+
+	template <typename T, typename F, typename S>
+	void StorageIngestion::Flush(Backlog<T> &B, std::deque<T> &Records, bool Retrying, F Writer,
+								 S SingleWriter) {
+		while (!Records.empty()) {
+			auto Count = std::min<std::size_t>(Records.size(), BatchSize_);
+			std::vector<T> Batch(std::make_move_iterator(Records.begin()),
+								 std::make_move_iterator(Records.begin() + Count));
+			Records.erase(Records.begin(), Records.begin() + Count);
+			auto Start = std::chrono::steady_clock::now();
+			bool Success = Writer(Batch);
+			FlushLatency_.Add(std::chrono::duration_cast<std::chrono::milliseconds>(
+								  std::chrono::steady_clock::now() - Start)
+								  .count());
+			if (Success) {
+				std::lock_guard G(QueueMutex_);
+				B.Written += Count;
+				continue;
+			}
+			if (!Retrying && Running_) {
+				std::lock_guard G(QueueMutex_);
+				B.Retried += Count;
+				for (auto &Record : Batch) {
+					if (B.Retry.size() >= MaxBacklog_) {
+						B.Dropped++;
+						continue;
+					}
+					B.Retry.push_back(std::move(Record));
+				}
+				continue;
+			}
+			std::uint64_t Written = 0;
+			for (const auto &Record : Batch)
+				Written += SingleWriter(Record) ? 1 : 0;
+			std::lock_guard G(QueueMutex_);
+			B.Written += Written;
+			B.Failed += Count - Written;
+		}
+	}
+
+	void StorageIngestion::FlushAll() {
+		std::deque<GWObjects::Statistics> Statistics, StatisticsRetry;
+		std::deque<GWObjects::HealthCheck> HealthChecks, HealthChecksRetry;
+		std::deque<GWObjects::DeviceLog> Logs, LogsRetry;
+		{
+			std::lock_guard G(QueueMutex_);
+			Statistics.swap(Statistics_.Records);
+			StatisticsRetry.swap(Statistics_.Retry);
+			HealthChecks.swap(HealthChecks_.Records);
+			HealthChecksRetry.swap(HealthChecks_.Retry);
+			Logs.swap(Logs_.Records);
+			LogsRetry.swap(Logs_.Retry);
+		}
+
+		auto StatisticsWriter = [](const std::vector<GWObjects::Statistics> &Batch) {
+			return StorageService()->AddStatisticsData(Batch);
+		};
+		auto StatisticsSingle = [](const GWObjects::Statistics &Stats) {
+			return StorageService()->AddStatisticsData(Stats);
+		};
+		Flush(Statistics_, StatisticsRetry, true, StatisticsWriter, StatisticsSingle);
+		Flush(Statistics_, Statistics, false, StatisticsWriter, StatisticsSingle);
+
+		auto HealthCheckWriter = [](const std::vector<GWObjects::HealthCheck> &Batch) {
+			return StorageService()->AddHealthCheckData(Batch);
+		};
+		auto HealthCheckSingle = [](const GWObjects::HealthCheck &Check) {
+			return StorageService()->AddHealthCheckData(Check);
+		};
+		Flush(HealthChecks_, HealthChecksRetry, true, HealthCheckWriter, HealthCheckSingle);
+		Flush(HealthChecks_, HealthChecks, false, HealthCheckWriter, HealthCheckSingle);
+
+		auto LogWriter = [](const std::vector<GWObjects::DeviceLog> &Batch) {
+			return StorageService()->AddLogs(Batch);
+		};
+		auto LogSingle = [](const GWObjects::DeviceLog &Log) {
+			return StorageService()->AddLog(Log);
+		};
+		Flush(Logs_, LogsRetry, true, LogWriter, LogSingle);
+		Flush(Logs_, Logs, false, LogWriter, LogSingle);
+	}
+
+	void StorageIngestion::AddStatisticsData(const GWObjects::Statistics &Stats) {
+		if (!Queue(Statistics_, Stats))
+			StorageService()->AddStatisticsData(Stats);
+	}
+
+	void StorageIngestion::AddHealthCheckData(const GWObjects::HealthCheck &Check) {
+		if (!Queue(HealthChecks_, Check))
+			StorageService()->AddHealthCheckData(Check);
+	}
+
+	void StorageIngestion::AddLog(const GWObjects::DeviceLog &Log) {
+		if (!Queue(Logs_, Log))
+			StorageService()->AddLog(Log);
+	}
+
+	bool StorageIngestion::GetResourceStatistics(Poco::JSON::Object &Stats) {
+		if (!Enabled_)
+			return false;
+		auto BacklogToJSON = [](const auto &B) {
+			Poco::JSON::Object Obj;
+			Obj.set("backlog", B.Records.size());
+			Obj.set("retryBacklog", B.Retry.size());
+			Obj.set("written", B.Written);
+			Obj.set("retried", B.Retried);
+			Obj.set("failed", B.Failed);
+			Obj.set("dropped", B.Dropped);
+			return Obj;
+		};
+		{
+			std::lock_guard G(QueueMutex_);
+			Stats.set("statistics", BacklogToJSON(Statistics_));
+			Stats.set("healthchecks", BacklogToJSON(HealthChecks_));
+			Stats.set("logs", BacklogToJSON(Logs_));
+		}
+		Poco::JSON::Object Latency;
+		FlushLatency_.to_json(Latency);
+		Stats.set("flushLatencyMs", Latency);
+		return true;
+	}
+
+} // namespace OpenWifi
@@ -0,0 +1,80 @@
+//
+//	License type: BSD 3-Clause License
+//	License copy: https://github.com/Telecominfraproject/wlan-cloud-ucentralgw/blob/master/LICENSE
+//
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
+#include "Poco/Thread.h"
+
+#include "RESTObjects/RESTAPI_GWobjects.h"
+#include "framework/LatencyTracker.h"
+#include "framework/SubSystemServer.h"
+
+namespace OpenWifi {
+
+	//	Write-behind queue for the high volume device records (state, healthchecks, and logs). Records
+	//	are accumulated and written in batches, so reactor threads never wait on the database.
+	class StorageIngestion : public SubSystemServer, Poco::Runnable {
+	  public:
+		static auto instance() {
+			static auto instance_ = new StorageIngestion;
+			return instance_;
+		}
+
+		int Start() override;
+		void Stop() override;
+		void run() override;
+		bool GetResourceStatistics(Poco::JSON::Object &Stats) override;
+
+		void AddStatisticsData(const GWObjects::Statistics &Stats);
+		void AddHealthCheckData(const GWObjects::HealthCheck &Check);
+		void AddLog(const GWObjects::DeviceLog &Log);
+
+	  private:
+		//	A batch that fails is put in Retry and written again with the next flush. If it fails
+		//	again, or while stopping, its records are written one by one and those that still fail
+		//	are counted as failed.
+		template <typename T> struct Backlog {
+			std::deque<T> Records;
+			std::deque<T> Retry;
+			std::uint64_t Written = 0;
+			std::uint64_t Retried = 0;
+			std::uint64_t Failed = 0;
+			std::uint64_t Dropped = 0;
+		};
+
+		std::atomic_bool Running_ = false;
+		bool Enabled_ = true;
+		bool DropOldest_ = true;
+		std::uint64_t Interval_ = 1000;
+		std::uint64_t BatchSize_ = 500;
+		std::uint64_t MaxBacklog_ = 50000;
+		Poco::Thread Worker_;
+		std::mutex QueueMutex_;
+		std::condition_variable QueueReady_;
+		Backlog<GWObjects::Statistics> Statistics_;
+		Backlog<GWObjects::HealthCheck> HealthChecks_;
+		Backlog<GWObjects::DeviceLog> Logs_;
+		LatencyTracker FlushLatency_;
+
+		//	Returns false once stopping: the caller writes the record itself.
+		template <typename T> bool Queue(Backlog<T> &B, const T &Record);
+		template <typename T, typename F, typename S>
+		void Flush(Backlog<T> &B, std::deque<T> &Records, bool Retrying, F Writer, S SingleWriter);
+		void FlushAll();
+		inline std::uint64_t Pending() const {
+			return Statistics_.Records.size() + HealthChecks_.Records.size() + Logs_.Records.size();
+		}
+
+		StorageIngestion() noexcept
+			: SubSystemServer("StorageIngestion", "STORAGE-INGEST", "storage.ingestion") {}
+	};
+
+	inline auto StorageIngestion() { return StorageIngestion::instance(); }
+
+} // namespace OpenWifi
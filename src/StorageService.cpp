@@ -22,6 +22,10 @@ namespace OpenWifi {
 		ScriptDB_->Create();
 		ScriptDB_->Initialize();
 
+		BulkCommandDB_ = std::make_unique<OpenWifi::BulkCommandDB>("BulkCommands", "blk", dbType_,
+																	*Pool_, Logger());
+		BulkCommandDB_->Create();
+
 		return 0;
 	}
 
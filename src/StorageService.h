@@ -9,9 +9,11 @@
 #pragma once
 
 #include "CentralConfig.h"
+#include "PageCursor.h"
 #include "Poco/Net/IPAddress.h"
 #include "RESTObjects//RESTAPI_GWobjects.h"
 #include "framework/StorageClass.h"
+#include "storage/storage_bulkcommands.h"
 #include "storage/storage_scripts.h"
 
 namespace OpenWifi {
@@ -30,6 +32,7 @@ namespace OpenWifi {
 		};
 
 		inline OpenWifi::ScriptDB &ScriptDB() { return *ScriptDB_; }
+		inline OpenWifi::BulkCommandDB &BulkCommandDB() { return *BulkCommandDB_; }
 
 		inline std::string to_string(const CommandExecutionType &C) {
 			switch (C) {
@@ -64,6 +67,20 @@ namespace OpenWifi {
 			return " LIMIT " + std::to_string(HowMany) + " OFFSET " + std::to_string(From) + " ";
 		}
 
+		//	Condition selecting the rows strictly past a cursor, for a listing ordered by
+		//	(TimeColumn, KeyColumn), both ascending or both descending.
+		[[nodiscard]] inline std::string ComputeKeyset(const PageCursor &After,
+													   const std::string &TimeColumn,
+													   const std::string &KeyColumn,
+													   bool Descending = false) const {
+			auto T = std::to_string(After.Time);
+			auto Op = Descending ? "<" : ">";
+			if (TimeColumn.empty())
+				return " " + KeyColumn + Op + "'" + After.Key + "' ";
+			return " (" + TimeColumn + Op + T + " OR (" + TimeColumn + "=" + T + " AND " +
+				   KeyColumn + Op + "'" + After.Key + "')) ";
+		}
+
 		inline std::string ConvertParams(const std::string &S) const {
 			std::string R;
 			R.reserve(S.size() * 2 + 1);
@@ -83,6 +100,25 @@ namespace OpenWifi {
 			return R;
 		}
 
+		//	Rows written by one multi-row INSERT, keeping its placeholders within the lowest
+		//	limit of the supported databases (999 for older SQLite).
+		static inline std::size_t RowsPerInsert(std::size_t Fields) {
+			return std::max<std::size_t>(1, 999 / Fields);
+		}
+
+		//	Statement followed by Rows groups of "( Values )", comma separated.
+		static inline std::string MultiRowInsert(const std::string &Statement,
+												 const std::string &Values, std::size_t Rows) {
+			std::string R{Statement};
+			R.reserve(Statement.size() + Rows * (Values.size() + 5));
+			for (std::size_t i = 0; i < Rows; ++i) {
+				R += i ? ",( " : " ( ";
+				R += Values;
+				R += " )";
+			}
+			return R;
+		}
+
 		static auto instance() {
 			static auto instance_ = new Storage;
 			return instance_;
@@ -91,10 +127,15 @@ namespace OpenWifi {
 		// typedef std::map<std::string,std::string>	DeviceCapabilitiesCache;
 
 		bool AddLog(const GWObjects::DeviceLog &Log);
+		bool AddLogs(const std::vector<GWObjects::DeviceLog> &Logs);
 		bool AddStatisticsData(const GWObjects::Statistics &Stats);
+		bool AddStatisticsData(const std::vector<GWObjects::Statistics> &Stats);
+		//	Listings start at Offset, or at After when it is valid. Next, when given, receives the
+		//	cursor for the following page, which is invalid once the listing is exhausted.
 		bool GetStatisticsData(std::string &SerialNumber, uint64_t FromDate, uint64_t ToDate,
 							   uint64_t Offset, uint64_t HowMany,
-							   std::vector<GWObjects::Statistics> &Stats);
+							   std::vector<GWObjects::Statistics> &Stats,
+							   const PageCursor &After = PageCursor{}, PageCursor *Next = nullptr);
 		bool GetNumberOfStatisticsDataRecords(std::string &SerialNumber, uint64_t FromDate,
 											  uint64_t ToDate, std::uint64_t &Count);
 		bool DeleteStatisticsData(std::string &SerialNumber, uint64_t FromDate, uint64_t ToDate);
@@ -102,9 +143,11 @@ namespace OpenWifi {
 									 std::vector<GWObjects::Statistics> &Stats);
 
 		bool AddHealthCheckData(const GWObjects::HealthCheck &Check);
+		bool AddHealthCheckData(const std::vector<GWObjects::HealthCheck> &Checks);
 		bool GetHealthCheckData(std::string &SerialNumber, uint64_t FromDate, uint64_t ToDate,
 								uint64_t Offset, uint64_t HowMany,
-								std::vector<GWObjects::HealthCheck> &Checks);
+								std::vector<GWObjects::HealthCheck> &Checks,
+								const PageCursor &After = PageCursor{}, PageCursor *Next = nullptr);
 		bool DeleteHealthCheckData(std::string &SerialNumber, uint64_t FromDate, uint64_t ToDate);
 		bool GetNewestHealthCheckData(std::string &SerialNumber, uint64_t HowMany,
 									  std::vector<GWObjects::HealthCheck> &Checks);
@@ -124,7 +167,8 @@ namespace OpenWifi {
 
 		bool GetDevice(std::string &SerialNumber, GWObjects::Device &);
 		bool GetDevices(uint64_t From, uint64_t HowMany, std::vector<GWObjects::Device> &Devices,
-						const std::string &orderBy = "");
+						const std::string &orderBy = "", const PageCursor &After = PageCursor{},
+						PageCursor *Next = nullptr);
 		//		bool GetDevices(uint64_t From, uint64_t HowMany, const std::string & Select,
 		// std::vector<GWObjects::Device> &Devices, const std::string & orderBy="");
 		bool DeleteDevice(std::string &SerialNumber);
@@ -137,10 +181,13 @@ namespace OpenWifi {
 		bool GetDeviceCount(uint64_t &Count);
 		bool GetDeviceSerialNumbers(uint64_t From, uint64_t HowMany,
 									std::vector<std::string> &SerialNumbers,
-									const std::string &orderBy = "");
+									const std::string &orderBy = "",
+									const PageCursor &After = PageCursor{},
+									PageCursor *Next = nullptr);
 		bool GetDeviceFWUpdatePolicy(std::string &SerialNumber, std::string &Policy);
 		bool SetDevicePassword(std::string &SerialNumber, std::string &Password);
 		bool UpdateSerialNumberCache();
+		bool UpdateDeviceSearchIndex();
 		static void GetDeviceDbFieldList(Types::StringVec &Fields);
 
 		bool ExistingConfiguration(std::string &SerialNumber, uint64_t CurrentConfig,
@@ -156,7 +203,8 @@ namespace OpenWifi {
 
 		bool GetLogData(std::string &SerialNumber, uint64_t FromDate, uint64_t ToDate,
 						uint64_t Offset, uint64_t HowMany, std::vector<GWObjects::DeviceLog> &Stats,
-						uint64_t Type);
+						uint64_t Type, const PageCursor &After = PageCursor{},
+						PageCursor *Next = nullptr);
 		bool DeleteLogData(std::string &SerialNumber, uint64_t FromDate, uint64_t ToDate,
 						   uint64_t Type);
 		bool GetNewestLogData(std::string &SerialNumber, uint64_t HowMany,
@@ -192,7 +240,8 @@ namespace OpenWifi {
 						CommandExecutionType Type);
 		bool GetCommands(std::string &SerialNumber, uint64_t FromDate, uint64_t ToDate,
 						 uint64_t Offset, uint64_t HowMany,
-						 std::vector<GWObjects::CommandDetails> &Commands);
+						 std::vector<GWObjects::CommandDetails> &Commands,
+						 const PageCursor &After = PageCursor{}, PageCursor *Next = nullptr);
 		bool DeleteCommands(std::string &SerialNumber, uint64_t FromDate, uint64_t ToDate);
 		bool GetNonExecutedCommands(uint64_t Offset, uint64_t HowMany,
 									std::vector<GWObjects::CommandDetails> &Commands);
@@ -200,12 +249,31 @@ namespace OpenWifi {
 		bool GetCommand(const std::string &UUID, GWObjects::CommandDetails &Command);
 		bool DeleteCommand(std::string &UUID);
 		bool GetReadyToExecuteCommands(uint64_t Offset, uint64_t HowMany,
-									   std::vector<GWObjects::CommandDetails> &Commands);
+									   std::vector<GWObjects::CommandDetails> &Commands,
+									   const PageCursor &After = PageCursor{},
+									   PageCursor *Next = nullptr);
+		bool GetPendingCommands(std::vector<GWObjects::CommandDetails> &Commands);
 		bool CommandExecuted(std::string &UUID);
 		bool SetCommandLastTry(std::string &UUID);
 		bool CommandCompleted(std::string &UUID, Poco::JSON::Object::Ptr ReturnVars,
 							  const std::chrono::duration<double, std::milli> &execution_time,
 							  bool FullCommand);
+
+		//	What CommandCompleted writes for one command, so completions can be written in
+		//	batches.
+		struct CommandResult {
+			std::string UUID;
+			std::uint64_t Completed = 0;
+			std::uint64_t ErrorCode = 0;
+			std::string ErrorText;
+			std::string Results;
+			double ExecutionTime = 0.0;
+		};
+		static CommandResult
+		MakeCommandResult(const std::string &UUID, const Poco::JSON::Object::Ptr &ReturnVars,
+						  const std::chrono::duration<double, std::milli> &execution_time,
+						  bool FullCommand);
+		bool CommandsCompleted(const std::vector<CommandResult> &Results);
 		bool AttachFileDataToCommand(std::string &UUID, const std::stringstream &s,
 									 const std::string &Type);
 		bool CancelWaitFile(std::string &UUID, std::string &ErrorText);
@@ -225,12 +293,12 @@ namespace OpenWifi {
 		bool RemoveOldCommands(std::string &SerilNumber, std::string &Command);
 
 		bool AddBlackListDevices(std::vector<GWObjects::BlackListedDevice> &Devices);
-		bool AddBlackListDevice(GWObjects::BlackListedDevice &Device);
+		bool AddBlackListDevice(GWObjects::BlackListedDevice &Device, bool Publish = true);
 		bool GetBlackListDevice(std::string &SerialNumber, GWObjects::BlackListedDevice &Device);
 		bool DeleteBlackListDevice(std::string &SerialNumber);
-		bool IsBlackListed(const std::string &SerialNumber, std::string &reason,
-						   std::string &author, std::uint64_t &created);
-		bool IsBlackListed(const std::string &SerialNumber);
+		bool IsBlackListed(std::uint64_t SerialNumber, std::string &reason, std::string &author,
+						   std::uint64_t &created);
+		bool IsBlackListed(std::uint64_t SerialNumber);
 		bool InitializeBlackListCache();
 		bool GetBlackListDevices(uint64_t Offset, uint64_t HowMany,
 								 std::vector<GWObjects::BlackListedDevice> &Devices);
@@ -243,7 +311,8 @@ namespace OpenWifi {
 		bool RemoveCommandListRecordsOlderThan(uint64_t Date);
 		bool RemoveUploadedFilesRecordsOlderThan(uint64_t Date);
 
-		bool SetDeviceLastRecordedContact(std::string & SeialNumber, std::uint64_t lastRecordedContact);
+		bool SetDevicesLastRecordedContact(
+			const std::vector<std::pair<std::string, std::uint64_t>> &Contacts);
 
 		int Create_Tables();
 		int Create_Statistics();
@@ -265,6 +334,7 @@ namespace OpenWifi {
 
 	  private:
 		std::unique_ptr<OpenWifi::ScriptDB> ScriptDB_;
+		std::unique_ptr<OpenWifi::BulkCommandDB> BulkCommandDB_;
 	};
 
 	inline auto StorageService() { return Storage::instance(); }
@@ -73,6 +73,29 @@ namespace OpenWifi::GWWebSocketNotifications {
 		return false;
 	}
 
+	inline void BulkCommandProgress::to_json(Poco::JSON::Object &Obj) const {
+		RESTAPI_utils::field_to_json(Obj, "id", id);
+		RESTAPI_utils::field_to_json(Obj, "command", command);
+		RESTAPI_utils::field_to_json(Obj, "status", status);
+		RESTAPI_utils::field_to_json(Obj, "total", total);
+		RESTAPI_utils::field_to_json(Obj, "sent", sent);
+		RESTAPI_utils::field_to_json(Obj, "outstanding", outstanding);
+	}
+
+	inline bool BulkCommandProgress::from_json(const Poco::JSON::Object::Ptr &Obj) {
+		try {
+			RESTAPI_utils::field_from_json(Obj, "id", id);
+			RESTAPI_utils::field_from_json(Obj, "command", command);
+			RESTAPI_utils::field_from_json(Obj, "status", status);
+			RESTAPI_utils::field_from_json(Obj, "total", total);
+			RESTAPI_utils::field_from_json(Obj, "sent", sent);
+			RESTAPI_utils::field_from_json(Obj, "outstanding", outstanding);
+			return true;
+		} catch (...) {
+		}
+		return false;
+	}
+
 	void NumberOfConnections(NumberOfConnection_t &N) {
 		// N.type = "device_connections_statistics";
 		N.type_id = 1000;
@@ -145,11 +168,18 @@ namespace OpenWifi::GWWebSocketNotifications {
 		UI_WebSocketClientServer()->SendNotification(N);
 	}
 
+	void BulkCommandProgress(const std::string &User, BulkCommandProgress_t &N) {
+		// N.type = "bulk_command_progress";
+		N.type_id = 7000;
+		UI_WebSocketClientServer()->SendUserNotification(User, N);
+	}
+
 	void Register() {
 		static const UI_WebSocketClientServer::NotificationTypeIdVec Notifications = {
 			{1000, "device_connections_statistics"}, {2000, "device_configuration_upgrade"},
 			{3000, "device_firmware_upgrade"},		 {4000, "device_connection"},
-			{5000, "device_disconnection"},			 {6000, "device_statistics"}};
+			{5000, "device_disconnection"},			 {6000, "device_statistics"},
+			{7000, "bulk_command_progress"}};
 
 		UI_WebSocketClientServer()->RegisterNotifications(Notifications);
 	}
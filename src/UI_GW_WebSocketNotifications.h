@@ -42,6 +42,18 @@ namespace OpenWifi::GWWebSocketNotifications {
 		bool from_json(const Poco::JSON::Object::Ptr &Obj);
 	};
 
+	struct BulkCommandProgress {
+		std::string id;
+		std::string command;
+		std::string status;
+		std::uint64_t total = 0;
+		std::uint64_t sent = 0;
+		std::uint64_t outstanding = 0;
+
+		void to_json(Poco::JSON::Object &Obj) const;
+		bool from_json(const Poco::JSON::Object::Ptr &Obj);
+	};
+
 	void Register();
 
 	typedef WebSocketNotification<SingleDevice> SingleDevice_t;
@@ -49,6 +61,7 @@ namespace OpenWifi::GWWebSocketNotifications {
 		SingleDeviceConfigurationChange_t;
 	typedef WebSocketNotification<SingleDeviceFirmwareChange> SingleDeviceFirmwareChange_t;
 	typedef WebSocketNotification<NumberOfConnection> NumberOfConnection_t;
+	typedef WebSocketNotification<BulkCommandProgress> BulkCommandProgress_t;
 
 	void NumberOfConnections(NumberOfConnection_t &N);
 	void DeviceConfigurationChange(SingleDeviceConfigurationChange_t &N);
@@ -63,5 +76,6 @@ namespace OpenWifi::GWWebSocketNotifications {
 	void DeviceConnected(const std::string &User, SingleDevice_t &N);
 	void DeviceDisconnected(const std::string &User, SingleDevice_t &N);
 	void DeviceStatistics(const std::string &User, SingleDevice_t &N);
+	void BulkCommandProgress(const std::string &User, BulkCommandProgress_t &N);
 
 }; // namespace OpenWifi::GWWebSocketNotifications
\ No newline at end of file
@@ -87,6 +87,21 @@ namespace OpenWifi {
 		Config.set_log_callback(KafkaLoggerFun);
 		Config.set_error_callback(KafkaErrorFun);
 
+		//	In batching mode, librdkafka accumulates messages per partition for up to linger ms and
+		//	the partition is picked by hashing the key (the device serial number), so events from a
+		//	single device stay ordered while the load spreads over all partitions.
+		if (Batching_) {
+			Config.set("queue.buffering.max.ms",
+					   std::to_string(MicroServiceConfigGetInt(
+						   "openwifi.kafka.queue.buffering.max.ms", 50)));
+			Config.set("batch.num.messages",
+					   std::to_string(MicroServiceConfigGetInt(
+						   "openwifi.kafka.producer.batch.size", 1000)));
+			Config.set("partitioner", "murmur2_random");
+			Config.set_delivery_report_callback(
+				[this](cppkafka::Producer &, const cppkafka::Message &Msg) { OnDelivery(Msg); });
+		}
+
 		KafkaManager()->SystemInfoWrapper_ =
 			R"lit({ "system" : { "id" : )lit" + std::to_string(MicroServiceID()) +
 			R"lit( , "host" : ")lit" + MicroServicePrivateEndPoint() +
@@ -95,17 +110,42 @@ namespace OpenWifi {
 		cppkafka::Producer Producer(Config);
 		Running_ = true;
 
-		Poco::AutoPtr<Poco::Notification> Note(Queue_.waitDequeueNotification());
-		while (Note && Running_) {
+		poco_information(Logger_,
+						 fmt::format("Producer mode: {}", Batching_ ? "batching" : "synchronous"));
+
+		while (Running_) {
+			Poco::AutoPtr<Poco::Notification> Note(Queue_.waitDequeueNotification(100));
 			try {
 				auto Msg = dynamic_cast<KafkaMessage *>(Note.get());
 				if (Msg != nullptr) {
 					auto NewMessage = cppkafka::MessageBuilder(Msg->Topic());
 					NewMessage.key(Msg->Key());
-					NewMessage.partition(0);
 					NewMessage.payload(Msg->Payload());
-					Producer.produce(NewMessage);
-					Producer.flush();
+					if (Batching_) {
+						NewMessage.timestamp(std::chrono::milliseconds(Msg->Queued()));
+						while (true) {
+							try {
+								Producer.produce(NewMessage);
+								break;
+							} catch (const cppkafka::HandleException &E) {
+								//	librdkafka local queue is full: serve delivery reports to make room
+								if (!Running_ ||
+									E.get_error().get_error() != RD_KAFKA_RESP_ERR__QUEUE_FULL)
+									throw;
+								Producer.poll(std::chrono::milliseconds(100));
+							}
+						}
+						Produced_++;
+					} else {
+						NewMessage.partition(0);
+						Producer.produce(NewMessage);
+						Producer.flush();
+						Produced_++;
+						Delivered_++;
+					}
+				}
+				if (Batching_) {
+					Producer.poll(std::chrono::milliseconds(0));
 				}
 			} catch (const cppkafka::HandleException &E) {
 				poco_warning(Logger_,
@@ -115,11 +155,49 @@ namespace OpenWifi {
 			} catch (...) {
 				poco_error(Logger_, "std::exception");
 			}
-			Note = Queue_.waitDequeueNotification();
+		}
+
+		try {
+			Producer.flush(std::chrono::milliseconds(5000));
+		} catch (const cppkafka::HandleException &E) {
+			poco_warning(Logger_, fmt::format("Could not flush pending messages: {}", E.what()));
 		}
 		poco_information(Logger_, "Stopped...");
 	}
 
+	void KafkaProducer::OnDelivery(const cppkafka::Message &Msg) {
+		if (Msg.get_error()) {
+			DeliveryErrors_++;
+			return;
+		}
+		Delivered_++;
+		auto TimeStamp = Msg.get_timestamp();
+		if (TimeStamp) {
+			auto Now = Utils::NowMs();
+			std::uint64_t Queued = TimeStamp->get_timestamp().count();
+			auto Latency = Now > Queued ? Now - Queued : 0;
+			TotalDeliveryLatency_ += Latency;
+			auto Max = MaxDeliveryLatency_.load();
+			while (Latency > Max && !MaxDeliveryLatency_.compare_exchange_weak(Max, Latency))
+				;
+		}
+	}
+
+	void KafkaProducer::GetStatistics(Poco::JSON::Object &Stats) const {
+		Stats.set("mode", Batching_ ? "batching" : "synchronous");
+		Stats.set("queueDepth", Queue_.size());
+		Stats.set("queueMax", MaxQueueSize_.load());
+		Stats.set("produced", Produced_.load());
+		Stats.set("delivered", Delivered_.load());
+		Stats.set("deliveryErrors", DeliveryErrors_.load());
+		Stats.set("dropped", Dropped_.load());
+		if (Batching_) {
+			Stats.set("averageDeliveryLatencyMs",
+					  Delivered_ ? TotalDeliveryLatency_ / Delivered_ : 0);
+			Stats.set("maxDeliveryLatencyMs", MaxDeliveryLatency_.load());
+		}
+	}
+
 	inline void KafkaConsumer::run() {
 		Utils::SetThreadName("Kafka:Cons");
 
@@ -209,6 +287,9 @@ namespace OpenWifi {
 
 	void KafkaProducer::Start() {
 		if (!Running_) {
+			//	Read before the thread starts: Produce() checks them on the callers' threads.
+			Batching_ = MicroServiceConfigGetBool("openwifi.kafka.producer.batching", false);
+			MaxQueueSize_ = MicroServiceConfigGetInt("openwifi.kafka.producer.queue.max", 100000);
 			Running_ = true;
 			Worker_.start(*this);
 		}
@@ -225,6 +306,10 @@ namespace OpenWifi {
 	void KafkaProducer::Produce(const char *Topic, const std::string &Key,
 								const std::string &Payload) {
 		std::lock_guard G(Mutex_);
+		if (Batching_ && (std::uint64_t)Queue_.size() >= MaxQueueSize_) {
+			Dropped_++;
+			return;
+		}
 		Queue_.enqueueNotification(new KafkaMessage(Topic, Key, Payload));
 	}
 
@@ -306,6 +391,15 @@ namespace OpenWifi {
 		}
 	}
 
+	bool KafkaManager::GetResourceStatistics(Poco::JSON::Object &Stats) {
+		if (!KafkaEnabled_)
+			return false;
+		Poco::JSON::Object Producer;
+		ProducerThr_.GetStatistics(Producer);
+		Stats.set("producer", Producer);
+		return true;
+	}
+
 	[[nodiscard]] std::string KafkaManager::WrapSystemId(const std::string & PayLoad) {
 		return fmt::format(	R"lit({{ "system" : {{ "id" : {}, "host" : "{}" }}, "payload" : {} }})lit",
 						   MicroServiceID(), MicroServicePrivateEndPoint(), PayLoad ) ;
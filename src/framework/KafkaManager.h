@@ -19,16 +19,18 @@ namespace OpenWifi {
 	class KafkaMessage : public Poco::Notification {
 	  public:
 		KafkaMessage(const char * Topic, const std::string &Key, const std::string &Payload)
-			: Topic_(Topic), Key_(Key), Payload_(Payload) {}
+			: Topic_(Topic), Key_(Key), Payload_(Payload), Queued_(Utils::NowMs()) {}
 
 		inline const char * Topic() { return Topic_; }
 		inline const std::string &Key() { return Key_; }
 		inline const std::string &Payload() { return Payload_; }
+		inline std::uint64_t Queued() const { return Queued_; }
 
 	  private:
 		const char *Topic_;
 		std::string Key_;
 		std::string Payload_;
+		std::uint64_t Queued_;
 	};
 
 	class KafkaProducer : public Poco::Runnable {
@@ -37,12 +39,23 @@ namespace OpenWifi {
 		void Start();
 		void Stop();
 		void Produce(const char *Topic, const std::string &Key, const std::string & Payload);
+		void GetStatistics(Poco::JSON::Object &Stats) const;
 
 	  private:
 		std::mutex Mutex_;
 		Poco::Thread Worker_;
 		mutable std::atomic_bool Running_ = false;
 		Poco::NotificationQueue Queue_;
+		std::atomic_bool Batching_ = false;
+		std::atomic_uint64_t MaxQueueSize_ = 100000;
+		std::atomic_uint64_t Produced_ = 0;
+		std::atomic_uint64_t Delivered_ = 0;
+		std::atomic_uint64_t DeliveryErrors_ = 0;
+		std::atomic_uint64_t Dropped_ = 0;
+		std::atomic_uint64_t TotalDeliveryLatency_ = 0;
+		std::atomic_uint64_t MaxDeliveryLatency_ = 0;
+
+		void OnDelivery(const cppkafka::Message &Msg);
 	};
 
 	class KafkaConsumer : public Poco::Runnable {
@@ -85,6 +98,8 @@ namespace OpenWifi {
 		void PostMessage(const char *topic, const std::string &key,
 						 const Poco::JSON::Object &Object, bool WrapMessage = true);
 
+		bool GetResourceStatistics(Poco::JSON::Object &Stats) override;
+
 		[[nodiscard]] std::string WrapSystemId(const std::string & PayLoad);
 		[[nodiscard]] inline bool Enabled() const { return KafkaEnabled_; }
 		inline std::uint64_t RegisterTopicWatcher(const std::string &Topic, Types::TopicNotifyFunction &F) {
@@ -0,0 +1,60 @@
+//
+//	License type: BSD 3-Clause License
+//	License copy: https://github.com/Telecominfraproject/wlan-cloud-ucentralgw/blob/master/LICENSE
+//
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <mutex>
+#include <vector>
+
+#include "Poco/JSON/Object.h"
+
+namespace OpenWifi {
+
+	//	Keeps the last Samples latency measurements (in ms) and reports percentiles over them.
+	class LatencyTracker {
+	  public:
+		static constexpr std::size_t Samples = 1024;
+
+		inline void Add(std::uint64_t ms) {
+			std::lock_guard G(Mutex_);
+			Samples_[Next_++ % Samples] = ms;
+			Count_++;
+			if (ms > Max_)
+				Max_ = ms;
+		}
+
+		inline void to_json(Poco::JSON::Object &Obj) const {
+			std::vector<std::uint64_t> Sorted;
+			std::uint64_t Count, Max;
+			{
+				std::lock_guard G(Mutex_);
+				Count = Count_;
+				Max = Max_;
+				Sorted.assign(Samples_.begin(), Samples_.begin() + std::min(Count_, Samples));
+			}
+			std::sort(Sorted.begin(), Sorted.end());
+			auto Percentile = [&Sorted](std::size_t p) -> std::uint64_t {
+				if (Sorted.empty())
+					return 0;
+				return Sorted[std::min(Sorted.size() - 1, (Sorted.size() * p) / 100)];
+			};
+			Obj.set("count", Count);
+			Obj.set("p50", Percentile(50));
+			Obj.set("p90", Percentile(90));
+			Obj.set("p99", Percentile(99));
+			Obj.set("max", Max);
+		}
+
+	  private:
+		mutable std::mutex Mutex_;
+		std::array<std::uint64_t, Samples> Samples_{};
+		std::size_t Next_ = 0;
+		std::size_t Count_ = 0;
+		std::uint64_t Max_ = 0;
+	};
+
+} // namespace OpenWifi
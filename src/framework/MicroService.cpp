@@ -22,6 +22,7 @@
 #include "framework/MicroService.h"
 #include "framework/MicroServiceErrorHandler.h"
 #include "framework/MicroServiceNames.h"
+#include "framework/OpenAPIClientPool.h"
 #include "framework/RESTAPI_ExtServer.h"
 #include "framework/RESTAPI_GenericServerAccounting.h"
 #include "framework/RESTAPI_IntServer.h"
@@ -397,6 +398,7 @@ namespace OpenWifi {
 		SubSystems_.push_back(ALBHealthCheckServer());
 		SubSystems_.push_back(RESTAPI_ExtServer());
 		SubSystems_.push_back(RESTAPI_IntServer());
+		SubSystems_.push_back(OpenAPIClientPool());
 #ifndef TIP_SECURITY_SERVICE
 		SubSystems_.push_back(AuthClient());
 #endif
@@ -0,0 +1,192 @@
+//
+//	License type: BSD 3-Clause License
+//	License copy: https://github.com/Telecominfraproject/wlan-cloud-ucentralgw/blob/master/LICENSE
+//
+
+#include "framework/OpenAPIClientPool.h"
+
+#include "Poco/Net/HTTPSClientSession.h"
+#include "Poco/Net/NetException.h"
+#include "Poco/Net/SSLManager.h"
+#include "Poco/StreamCopier.h"
+
+#include "fmt/format.h"
+#include "framework/MicroServiceFuncs.h"
+#include "framework/utils.h"
+
+namespace OpenWifi {
+
+	int OpenAPIClientPool::Start() {
+		poco_information(Logger(), "Starting...");
+		MaxSessions_ = std::max((std::uint64_t)1,
+								MicroServiceConfigGetInt("openwifi.internal.restapi.sessions", 16));
+		KeepAlive_ = MicroServiceConfigGetInt("openwifi.internal.restapi.keepalive", 30);
+		return 0;
+	}
+
+	void OpenAPIClientPool::Stop() {
+		poco_information(Logger(), "Stopping...");
+		std::lock_guard G(Mutex_);
+		for (auto &[Name, E] : Endpoints_) {
+			std::lock_guard EG(E->Mutex);
+			E->Idle.clear();
+		}
+		poco_information(Logger(), "Stopped...");
+	}
+
+	OpenAPIClientPool::Endpoint &OpenAPIClientPool::GetEndpoint(const Poco::URI &URI) {
+		auto Key = fmt::format("{}://{}:{}", URI.getScheme(), URI.getHost(), URI.getPort());
+		std::lock_guard G(Mutex_);
+		auto &E = Endpoints_[Key];
+		if (E == nullptr)
+			E = std::make_unique<Endpoint>();
+		return *E;
+	}
+
+	OpenAPIClientPool::ServiceStats &OpenAPIClientPool::GetService(const std::string &Type) {
+		std::lock_guard G(Mutex_);
+		auto &S = Services_[Type];
+		if (S == nullptr)
+			S = std::make_unique<ServiceStats>();
+		return *S;
+	}
+
+	std::unique_ptr<Poco::Net::HTTPClientSession>
+	OpenAPIClientPool::Acquire(Endpoint &E, const Poco::URI &URI, std::uint64_t msTimeout,
+							   bool &Reused) {
+		std::unique_lock G(E.Mutex);
+		if (E.Active >= MaxSessions_) {
+			E.Waits++;
+			if (!E.Available.wait_for(G, std::chrono::milliseconds(msTimeout),
+									  [&] { return E.Active < MaxSessions_; }))
+				throw Poco::TimeoutException(
+					fmt::format("No session available for {}", URI.getAuthority()));
+		}
+		E.Active++;
+		Poco::Timespan Timeout(msTimeout / 1000, (msTimeout % 1000) * 1000);
+		if (!E.Idle.empty()) {
+			auto Session = std::move(E.Idle.back());
+			E.Idle.pop_back();
+			E.Reused++;
+			Reused = true;
+			Session->setTimeout(Timeout);
+			return Session;
+		}
+		E.Created++;
+		auto TLSSession = E.TLSSession;
+		G.unlock();
+
+		std::unique_ptr<Poco::Net::HTTPClientSession> Session;
+		if (URI.getScheme() == "https") {
+			Session = std::make_unique<Poco::Net::HTTPSClientSession>(
+				URI.getHost(), URI.getPort(),
+				Poco::Net::SSLManager::instance().defaultClientContext(), TLSSession);
+		} else {
+			Session = std::make_unique<Poco::Net::HTTPClientSession>(URI.getHost(), URI.getPort());
+		}
+		Session->setKeepAlive(true);
+		Session->setKeepAliveTimeout(Poco::Timespan(KeepAlive_, 0));
+		Session->setTimeout(Timeout);
+		Reused = false;
+		return Session;
+	}
+
+	void OpenAPIClientPool::Release(Endpoint &E,
+									std::unique_ptr<Poco::Net::HTTPClientSession> Session,
+									bool Reusable) {
+		std::lock_guard G(E.Mutex);
+		if (Session != nullptr) {
+			if (auto TLS = dynamic_cast<Poco::Net::HTTPSClientSession *>(Session.get());
+				TLS != nullptr && Reusable) {
+				auto Negotiated = TLS->sslSession();
+				if (!Negotiated.isNull())
+					E.TLSSession = Negotiated;
+			}
+			if (Reusable && E.Idle.size() < MaxSessions_)
+				E.Idle.emplace_back(std::move(Session));
+		}
+		if (!Reusable)
+			E.Failures++;
+		E.Active--;
+		E.Available.notify_one();
+	}
+
+	void OpenAPIClientPool::Exchange(const std::string &Type, const Poco::URI &URI,
+									 std::uint64_t msTimeout, Poco::Net::HTTPRequest &Request,
+									 const std::string &RequestBody,
+									 Poco::Net::HTTPResponse &Response,
+									 std::string &ResponseBody) {
+		auto &E = GetEndpoint(URI);
+		auto &S = GetService(Type);
+		auto Start = Utils::NowMs();
+		S.Requests++;
+		Request.setKeepAlive(true);
+
+		//	A pooled session may have been closed by the other side while it was idle. That only
+		//	shows once the request is sent, so it is retried once on a new session. By then the
+		//	other side may have acted on it, so only GET and DELETE, which can be repeated, are.
+		bool Repeatable = Request.getMethod() == Poco::Net::HTTPRequest::HTTP_GET ||
+						  Request.getMethod() == Poco::Net::HTTPRequest::HTTP_DELETE;
+		for (int Attempt = 0;; Attempt++) {
+			bool Reused = false;
+			auto Session = Acquire(E, URI, msTimeout, Reused);
+			try {
+				std::ostream &os = Session->sendRequest(Request);
+				if (!RequestBody.empty())
+					os << RequestBody;
+				Response.clear();
+				std::istream &is = Session->receiveResponse(Response);
+				ResponseBody.clear();
+				Poco::StreamCopier::copyToString(is, ResponseBody);
+				bool Reusable = Response.getKeepAlive();
+				Release(E, Reusable ? std::move(Session) : nullptr, true);
+				S.Latency.Add(Utils::NowMs() - Start);
+				return;
+			} catch (const Poco::Net::NoMessageException &) {
+				Release(E, nullptr, false);
+				if (!Reused || !Repeatable || Attempt > 0) {
+					S.Errors++;
+					throw;
+				}
+			} catch (const Poco::Net::ConnectionResetException &) {
+				Release(E, nullptr, false);
+				if (!Reused || !Repeatable || Attempt > 0) {
+					S.Errors++;
+					throw;
+				}
+			} catch (...) {
+				Release(E, nullptr, false);
+				S.Errors++;
+				throw;
+			}
+		}
+	}
+
+	bool OpenAPIClientPool::GetResourceStatistics(Poco::JSON::Object &Stats) {
+		std::lock_guard G(Mutex_);
+		Poco::JSON::Object Services;
+		for (const auto &[Type, S] : Services_) {
+			Poco::JSON::Object Entry;
+			S->Latency.to_json(Entry);
+			Entry.set("requests", S->Requests.load());
+			Entry.set("errors", S->Errors.load());
+			Services.set(Type, Entry);
+		}
+		Poco::JSON::Object Endpoints;
+		for (const auto &[Name, E] : Endpoints_) {
+			std::lock_guard EG(E->Mutex);
+			Poco::JSON::Object Entry;
+			Entry.set("active", E->Active);
+			Entry.set("idle", E->Idle.size());
+			Entry.set("created", E->Created);
+			Entry.set("reused", E->Reused);
+			Entry.set("waits", E->Waits);
+			Entry.set("failures", E->Failures);
+			Endpoints.set(Name, Entry);
+		}
+		Stats.set("services", Services);
+		Stats.set("endpoints", Endpoints);
+		return true;
+	}
+
+} // namespace OpenWifi
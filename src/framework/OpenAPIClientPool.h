@@ -0,0 +1,88 @@
+//
+//	License type: BSD 3-Clause License
+//	License copy: https://github.com/Telecominfraproject/wlan-cloud-ucentralgw/blob/master/LICENSE
+//
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "Poco/JSON/Object.h"
+#include "Poco/Net/HTTPClientSession.h"
+#include "Poco/Net/HTTPRequest.h"
+#include "Poco/Net/HTTPResponse.h"
+#include "Poco/Net/Session.h"
+#include "Poco/URI.h"
+
+#include "framework/LatencyTracker.h"
+#include "framework/SubSystemServer.h"
+
+namespace OpenWifi {
+
+	//	Keep-alive HTTP(S) sessions to the other micro services, pooled per endpoint. At most
+	//	MaxSessions_ requests run against one endpoint at a time; further callers wait for a session
+	//	to come back. New TLS sessions resume the last TLS session negotiated with that endpoint.
+	class OpenAPIClientPool : public SubSystemServer {
+	  public:
+		static auto instance() {
+			static auto instance_ = new OpenAPIClientPool;
+			return instance_;
+		}
+
+		int Start() override;
+		void Stop() override;
+		bool GetResourceStatistics(Poco::JSON::Object &Stats) override;
+
+		//	Sends Request (with RequestBody, if any) to the endpoint in URI and reads the whole
+		//	response. Type is the service type, used to group latency statistics. Throws the same
+		//	Poco exceptions as HTTPClientSession.
+		void Exchange(const std::string &Type, const Poco::URI &URI, std::uint64_t msTimeout,
+					  Poco::Net::HTTPRequest &Request, const std::string &RequestBody,
+					  Poco::Net::HTTPResponse &Response, std::string &ResponseBody);
+
+	  private:
+		struct Endpoint {
+			std::mutex Mutex;
+			std::condition_variable Available;
+			std::vector<std::unique_ptr<Poco::Net::HTTPClientSession>> Idle;
+			std::size_t Active = 0;
+			Poco::Net::Session::Ptr TLSSession;
+			std::uint64_t Created = 0;
+			std::uint64_t Reused = 0;
+			std::uint64_t Waits = 0;
+			std::uint64_t Failures = 0;
+		};
+
+		struct ServiceStats {
+			LatencyTracker Latency;
+			std::atomic_uint64_t Requests = 0;
+			std::atomic_uint64_t Errors = 0;
+		};
+
+		std::mutex Mutex_;
+		std::map<std::string, std::unique_ptr<Endpoint>> Endpoints_;
+		std::map<std::string, std::unique_ptr<ServiceStats>> Services_;
+		std::size_t MaxSessions_ = 16;
+		std::uint64_t KeepAlive_ = 30;
+
+		Endpoint &GetEndpoint(const Poco::URI &URI);
+		ServiceStats &GetService(const std::string &Type);
+		std::unique_ptr<Poco::Net::HTTPClientSession> Acquire(Endpoint &E, const Poco::URI &URI,
+															  std::uint64_t msTimeout,
+															  bool &Reused);
+		void Release(Endpoint &E, std::unique_ptr<Poco::Net::HTTPClientSession> Session,
+					 bool Reusable);
+
+		OpenAPIClientPool() noexcept
+			: SubSystemServer("OpenAPIClientPool", "REST-CLNT", "openapi.client") {}
+	};
+
+	inline auto OpenAPIClientPool() { return OpenAPIClientPool::instance(); }
+
+} // namespace OpenWifi
@@ -7,14 +7,25 @@
 #include "Poco/JSON/Parser.h"
 #include "Poco/Logger.h"
 #include "Poco/Net/HTTPRequest.h"
-#include "Poco/Net/HTTPSClientSession.h"
 #include "Poco/URI.h"
 
 #include "fmt/format.h"
 #include "framework/MicroServiceFuncs.h"
+#include "framework/OpenAPIClientPool.h"
 
 namespace OpenWifi {
 
+	static void AddCredentials(Poco::Net::HTTPRequest &Request, const Types::MicroServiceMeta &Svc,
+							   const std::string &BearerToken) {
+		if (BearerToken.empty()) {
+			Request.add("X-API-KEY", Svc.AccessKey);
+			Request.add("X-INTERNAL-NAME", MicroServicePublicEndPoint());
+		} else {
+			// Authorization: Bearer ${token}
+			Request.add("Authorization", "Bearer " + BearerToken);
+		}
+	}
+
 	Poco::Net::HTTPServerResponse::HTTPStatus
 	OpenAPIRequestGet::Do(Poco::JSON::Object::Ptr &ResponseObject, const std::string &BearerToken) {
 		try {
@@ -23,8 +34,6 @@ namespace OpenWifi {
 			for (auto const &Svc : Services) {
 				Poco::URI URI(Svc.PrivateEndPoint);
 
-				auto Secure = (URI.getScheme() == "https");
-
 				URI.setPath(EndPoint_);
 				for (const auto &qp : QueryData_)
 					URI.addQueryParameter(qp.first, qp.second);
@@ -36,41 +45,16 @@ namespace OpenWifi {
 				poco_debug(Poco::Logger::get("REST-CALLER-GET"),
 						   fmt::format(" {}", LoggingStr_.empty() ? URI.toString() : LoggingStr_));
 
-				if (BearerToken.empty()) {
-					Request.add("X-API-KEY", Svc.AccessKey);
-					Request.add("X-INTERNAL-NAME", MicroServicePublicEndPoint());
-				} else {
-					// Authorization: Bearer ${token}
-					Request.add("Authorization", "Bearer " + BearerToken);
-				}
+				AddCredentials(Request, Svc, BearerToken);
 
-				if (Secure) {
-					Poco::Net::HTTPSClientSession Session(URI.getHost(), URI.getPort());
-					Session.setTimeout(Poco::Timespan(msTimeout_ / 1000, msTimeout_ % 1000));
-
-					Session.sendRequest(Request);
-
-					Poco::Net::HTTPResponse Response;
-					std::istream &is = Session.receiveResponse(Response);
-					if (Response.getStatus() == Poco::Net::HTTPResponse::HTTP_OK) {
-						Poco::JSON::Parser P;
-						ResponseObject = P.parse(is).extract<Poco::JSON::Object::Ptr>();
-					}
-					return Response.getStatus();
-				} else {
-					Poco::Net::HTTPClientSession Session(URI.getHost(), URI.getPort());
-					Session.setTimeout(Poco::Timespan(msTimeout_ / 1000, msTimeout_ % 1000));
-
-					Session.sendRequest(Request);
-
-					Poco::Net::HTTPResponse Response;
-					std::istream &is = Session.receiveResponse(Response);
-					if (Response.getStatus() == Poco::Net::HTTPResponse::HTTP_OK) {
-						Poco::JSON::Parser P;
-						ResponseObject = P.parse(is).extract<Poco::JSON::Object::Ptr>();
-					}
-					return Response.getStatus();
+				Poco::Net::HTTPResponse Response;
+				std::string Body;
+				OpenAPIClientPool()->Exchange(Type_, URI, msTimeout_, Request, "", Response, Body);
+				if (Response.getStatus() == Poco::Net::HTTPResponse::HTTP_OK) {
+					Poco::JSON::Parser P;
+					ResponseObject = P.parse(Body).extract<Poco::JSON::Object::Ptr>();
 				}
+				return Response.getStatus();
 			}
 		} catch (const Poco::Exception &E) {
 			Poco::Logger::get("REST-CALLER-GET").log(E);
@@ -85,8 +69,6 @@ namespace OpenWifi {
 			for (auto const &Svc : Services) {
 				Poco::URI URI(Svc.PrivateEndPoint);
 
-				auto Secure = (URI.getScheme() == "https");
-
 				URI.setPath(EndPoint_);
 				for (const auto &qp : QueryData_)
 					URI.addQueryParameter(qp.first, qp.second);
@@ -104,49 +86,15 @@ namespace OpenWifi {
 				Request.setContentType("application/json");
 				Request.setContentLength(obody.str().size());
 
-				if (BearerToken.empty()) {
-					Request.add("X-API-KEY", Svc.AccessKey);
-					Request.add("X-INTERNAL-NAME", MicroServicePublicEndPoint());
-				} else {
-					// Authorization: Bearer ${token}
-					Request.add("Authorization", "Bearer " + BearerToken);
-				}
+				AddCredentials(Request, Svc, BearerToken);
 
-				if (Secure) {
-					Poco::Net::HTTPSClientSession Session(URI.getHost(), URI.getPort());
-					Session.setTimeout(Poco::Timespan(msTimeout_ / 1000, msTimeout_ % 1000));
-
-					std::ostream &os = Session.sendRequest(Request);
-					os << obody.str();
-
-					Poco::Net::HTTPResponse Response;
-					std::istream &is = Session.receiveResponse(Response);
-					if (Response.getStatus() == Poco::Net::HTTPResponse::HTTP_OK) {
-						Poco::JSON::Parser P;
-						ResponseObject = P.parse(is).extract<Poco::JSON::Object::Ptr>();
-					} else {
-						Poco::JSON::Parser P;
-						ResponseObject = P.parse(is).extract<Poco::JSON::Object::Ptr>();
-					}
-					return Response.getStatus();
-				} else {
-					Poco::Net::HTTPClientSession Session(URI.getHost(), URI.getPort());
-					Session.setTimeout(Poco::Timespan(msTimeout_ / 1000, msTimeout_ % 1000));
-
-					std::ostream &os = Session.sendRequest(Request);
-					os << obody.str();
-
-					Poco::Net::HTTPResponse Response;
-					std::istream &is = Session.receiveResponse(Response);
-					if (Response.getStatus() == Poco::Net::HTTPResponse::HTTP_OK) {
-						Poco::JSON::Parser P;
-						ResponseObject = P.parse(is).extract<Poco::JSON::Object::Ptr>();
-					} else {
-						Poco::JSON::Parser P;
-						ResponseObject = P.parse(is).extract<Poco::JSON::Object::Ptr>();
-					}
-					return Response.getStatus();
-				}
+				Poco::Net::HTTPResponse Response;
+				std::string Body;
+				OpenAPIClientPool()->Exchange(Type_, URI, msTimeout_, Request, obody.str(),
+											  Response, Body);
+				Poco::JSON::Parser P;
+				ResponseObject = P.parse(Body).extract<Poco::JSON::Object::Ptr>();
+				return Response.getStatus();
 			}
 		} catch (const Poco::Exception &E) {
 			Poco::Logger::get("REST-CALLER-PUT").log(E);
@@ -163,8 +111,6 @@ namespace OpenWifi {
 			for (auto const &Svc : Services) {
 				Poco::URI URI(Svc.PrivateEndPoint);
 
-				auto Secure = (URI.getScheme() == "https");
-
 				URI.setPath(EndPoint_);
 				for (const auto &qp : QueryData_)
 					URI.addQueryParameter(qp.first, qp.second);
@@ -182,47 +128,15 @@ namespace OpenWifi {
 				Request.setContentType("application/json");
 				Request.setContentLength(obody.str().size());
 
-				if (BearerToken.empty()) {
-					Request.add("X-API-KEY", Svc.AccessKey);
-					Request.add("X-INTERNAL-NAME", MicroServicePublicEndPoint());
-				} else {
-					// Authorization: Bearer ${token}
-					Request.add("Authorization", "Bearer " + BearerToken);
-				}
+				AddCredentials(Request, Svc, BearerToken);
 
-				if (Secure) {
-					Poco::Net::HTTPSClientSession Session(URI.getHost(), URI.getPort());
-					Session.setTimeout(Poco::Timespan(msTimeout_ / 1000, msTimeout_ % 1000));
-					std::ostream &os = Session.sendRequest(Request);
-					os << obody.str();
-
-					Poco::Net::HTTPResponse Response;
-					std::istream &is = Session.receiveResponse(Response);
-					if (Response.getStatus() == Poco::Net::HTTPResponse::HTTP_OK) {
-						Poco::JSON::Parser P;
-						ResponseObject = P.parse(is).extract<Poco::JSON::Object::Ptr>();
-					} else {
-						Poco::JSON::Parser P;
-						ResponseObject = P.parse(is).extract<Poco::JSON::Object::Ptr>();
-					}
-					return Response.getStatus();
-				} else {
-					Poco::Net::HTTPClientSession Session(URI.getHost(), URI.getPort());
-					Session.setTimeout(Poco::Timespan(msTimeout_ / 1000, msTimeout_ % 1000));
-					std::ostream &os = Session.sendRequest(Request);
-					os << obody.str();
-
-					Poco::Net::HTTPResponse Response;
-					std::istream &is = Session.receiveResponse(Response);
-					if (Response.getStatus() == Poco::Net::HTTPResponse::HTTP_OK) {
-						Poco::JSON::Parser P;
-						ResponseObject = P.parse(is).extract<Poco::JSON::Object::Ptr>();
-					} else {
-						Poco::JSON::Parser P;
-						ResponseObject = P.parse(is).extract<Poco::JSON::Object::Ptr>();
-					}
-					return Response.getStatus();
-				}
+				Poco::Net::HTTPResponse Response;
+				std::string Body;
+				OpenAPIClientPool()->Exchange(Type_, URI, msTimeout_, Request, obody.str(),
+											  Response, Body);
+				Poco::JSON::Parser P;
+				ResponseObject = P.parse(Body).extract<Poco::JSON::Object::Ptr>();
+				return Response.getStatus();
 			}
 		} catch (const Poco::Exception &E) {
 			Poco::Logger::get("REST-CALLER-POST").log(E);
@@ -238,8 +152,6 @@ namespace OpenWifi {
 			for (auto const &Svc : Services) {
 				Poco::URI URI(Svc.PrivateEndPoint);
 
-				auto Secure = (URI.getScheme() == "https");
-
 				URI.setPath(EndPoint_);
 				for (const auto &qp : QueryData_)
 					URI.addQueryParameter(qp.first, qp.second);
@@ -251,29 +163,12 @@ namespace OpenWifi {
 
 				Poco::Net::HTTPRequest Request(Poco::Net::HTTPRequest::HTTP_DELETE, Path,
 											   Poco::Net::HTTPMessage::HTTP_1_1);
-				if (BearerToken.empty()) {
-					Request.add("X-API-KEY", Svc.AccessKey);
-					Request.add("X-INTERNAL-NAME", MicroServicePublicEndPoint());
-				} else {
-					// Authorization: Bearer ${token}
-					Request.add("Authorization", "Bearer " + BearerToken);
-				}
+				AddCredentials(Request, Svc, BearerToken);
 
-				if (Secure) {
-					Poco::Net::HTTPSClientSession Session(URI.getHost(), URI.getPort());
-					Session.setTimeout(Poco::Timespan(msTimeout_ / 1000, msTimeout_ % 1000));
-					Session.sendRequest(Request);
-					Poco::Net::HTTPResponse Response;
-					Session.receiveResponse(Response);
-					return Response.getStatus();
-				} else {
-					Poco::Net::HTTPClientSession Session(URI.getHost(), URI.getPort());
-					Session.setTimeout(Poco::Timespan(msTimeout_ / 1000, msTimeout_ % 1000));
-					Session.sendRequest(Request);
-					Poco::Net::HTTPResponse Response;
-					Session.receiveResponse(Response);
-					return Response.getStatus();
-				}
+				Poco::Net::HTTPResponse Response;
+				std::string Body;
+				OpenAPIClientPool()->Exchange(Type_, URI, msTimeout_, Request, "", Response, Body);
+				return Response.getStatus();
 			}
 		} catch (const Poco::Exception &E) {
 			Poco::Logger::get("REST-CALLER-DELETE").log(E);
@@ -281,4 +176,4 @@ namespace OpenWifi {
 		return Poco::Net::HTTPServerResponse::HTTP_GATEWAY_TIMEOUT;
 	}
 
-} // namespace OpenWifi
\ No newline at end of file
+} // namespace OpenWifi
@@ -79,6 +79,13 @@ namespace OpenWifi {
 					Answer.set("peakRealMem", peakRealMem);
 					Answer.set("currVirtMem", currVirtMem);
 					Answer.set("peakVirtMem", peakVirtMem);
+					Poco::JSON::Object SubSystemStatistics;
+					for (const auto &i : MicroServiceGetFullSubSystems()) {
+						Poco::JSON::Object Stats;
+						if (i->GetResourceStatistics(Stats))
+							SubSystemStatistics.set(i->Name(), Stats);
+					}
+					Answer.set("subsystems", SubSystemStatistics);
 					return ReturnObject(Answer);
 				}
 			}
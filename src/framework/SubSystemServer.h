@@ -7,6 +7,7 @@
 #include <mutex>
 #include <string>
 
+#include "Poco/JSON/Object.h"
 #include "Poco/Net/Context.h"
 #include "Poco/Net/PrivateKeyPassphraseHandler.h"
 #include "Poco/Net/SecureServerSocket.h"
@@ -99,6 +100,11 @@ namespace OpenWifi {
 		virtual int Start() = 0;
 		virtual void Stop() = 0;
 
+		//	Subsystems that keep runtime counters report them through the "resources" system command.
+		virtual bool GetResourceStatistics([[maybe_unused]] Poco::JSON::Object &Stats) {
+			return false;
+		}
+
 		struct LoggerWrapper {
 			Poco::Logger &L_;
 			LoggerWrapper(Poco::Logger &L) : L_(L) {}
@@ -432,6 +432,11 @@ namespace OpenWifi::RESTAPI::Errors {
     static const struct msg InvalidRadiusServer { 1191, "Invalid Radius Server." };
 
 	static const struct msg InvalidRRMAction { 1192, "Invalid RRM Action." };
+	static const struct msg InvalidCursor { 1193, "Invalid cursor." };
+	static const struct msg TooManyDevices { 1194, "Too many devices selected." };
+	static const struct msg NoDevicesSelected { 1195, "No devices selected." };
+	static const struct msg BulkCommandNotRunning { 1196, "Bulk command is not running." };
+	static const struct msg EmptyFilter { 1197, "The filter must have at least one criterion." };
 
     static const struct msg SimulationDoesNotExist {
         7000, "Simulation Instance ID does not exist."
@@ -467,6 +472,9 @@ namespace OpenWifi::RESTAPI::Protocol {
 	static const char *ENDDATE = "endDate";
 	static const char *OFFSET = "offset";
 	static const char *LIMIT = "limit";
+	static const char *CURSOR = "cursor";
+	static const char *NEXT = "next";
+	static const char *ASYNC = "async";
 	static const char *LIFETIME = "lifetime";
 	static const char *UUID = "UUID";
 	static const char *DATA = "data";
@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <chrono>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
@@ -38,6 +39,11 @@
 namespace OpenWifi::Utils {
 
 	inline uint64_t Now() { return std::time(nullptr); };
+	inline uint64_t NowMs() {
+		return std::chrono::duration_cast<std::chrono::milliseconds>(
+				   std::chrono::system_clock::now().time_since_epoch())
+			.count();
+	};
 
 	bool NormalizeMac(std::string &Mac);
 
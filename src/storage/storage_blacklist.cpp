@@ -6,10 +6,15 @@
 //	Arilia Wireless Inc.
 //
 
+#include <memory>
+#include <unordered_map>
+
 #include "Poco/Data/RecordSet.h"
+#include "PublishedSnapshot.h"
 #include "RESTObjects/RESTAPI_GWobjects.h"
 #include "StorageService.h"
 #include "fmt/format.h"
+#include "framework/utils.h"
 
 namespace OpenWifi {
 
@@ -59,8 +64,70 @@ namespace OpenWifi {
 		std::uint64_t created;
 	};
 
+	//	The blacklist is checked for every event a device sends, so readers use an immutable
+	//	snapshot without taking a lock, counting a reference or allocating. A Bloom filter in
+	//	front answers for devices that are not listed, which is nearly all of them.
+	struct BlackListSnapshot {
+		static constexpr std::uint64_t NumberOfHashes = 4;
+		static constexpr std::uint64_t BitsPerEntry = 16;
+
+		std::vector<std::uint64_t> Bloom;
+		std::uint64_t BloomMask = 0;
+		std::unordered_map<std::uint64_t, DeviceDetails> Devices;
+
+		//	split a serial number into the two hashes that the probes are derived from
+		static inline std::pair<std::uint64_t, std::uint64_t> Hash(std::uint64_t S) {
+			S ^= S >> 33;
+			S *= 0xff51afd7ed558ccdULL;
+			S ^= S >> 33;
+			S *= 0xc4ceb9fe1a85ec53ULL;
+			S ^= S >> 33;
+			return {S, (S >> 32) | 1};
+		}
+
+		explicit BlackListSnapshot(const std::map<std::string, DeviceDetails> &Entries) {
+			std::uint64_t Bits = 64;
+			while (Bits < Entries.size() * BitsPerEntry)
+				Bits <<= 1;
+			Bloom.resize(Bits / 64);
+			BloomMask = Bits - 1;
+			Devices.reserve(Entries.size());
+			for (const auto &[SerialNumber, Details] : Entries) {
+				if (SerialNumber.empty() || !Utils::ValidSerialNumber(SerialNumber))
+					continue;
+				auto S = Utils::SerialNumberToInt(SerialNumber);
+				Devices[S] = Details;
+				auto [H1, H2] = Hash(S);
+				for (std::uint64_t i = 0; i < NumberOfHashes; i++) {
+					auto Bit = (H1 + i * H2) & BloomMask;
+					Bloom[Bit / 64] |= 1ULL << (Bit % 64);
+				}
+			}
+		}
+
+		[[nodiscard]] inline const DeviceDetails *Find(std::uint64_t S) const {
+			auto [H1, H2] = Hash(S);
+			for (std::uint64_t i = 0; i < NumberOfHashes; i++) {
+				auto Bit = (H1 + i * H2) & BloomMask;
+				if ((Bloom[Bit / 64] & (1ULL << (Bit % 64))) == 0)
+					return nullptr;
+			}
+			auto Hint = Devices.find(S);
+			return Hint == Devices.end() ? nullptr : &Hint->second;
+		}
+	};
+
+	//	Writers hold BlackListMutex, change BlackListDevices and publish a new snapshot. A replaced
+	//	snapshot is freed once no reader can still be looking at it.
 	static std::map<std::string, DeviceDetails> BlackListDevices;
 	static std::recursive_mutex BlackListMutex;
+	static PublishedSnapshot<BlackListSnapshot>
+		CurrentBlackList{std::make_unique<const BlackListSnapshot>(BlackListDevices)};
+
+	//	BlackListMutex must be held.
+	static void PublishBlackList() {
+		CurrentBlackList.Publish(std::make_unique<const BlackListSnapshot>(BlackListDevices));
+	}
 
 	bool Storage::InitializeBlackListCache() {
 		try {
@@ -72,9 +139,10 @@ namespace OpenWifi {
 
 			Poco::Data::RecordSet RSet(Select);
 
+			std::lock_guard G(BlackListMutex);
 			bool More = RSet.moveFirst();
 			while (More) {
-				auto SerialNumber = RSet[0].convert<std::string>();
+				auto SerialNumber = Poco::toLower(RSet[0].convert<std::string>());
 				auto Reason = RSet[1].convert<std::string>();
 				auto Author = RSet[2].convert<std::string>();
 				auto Created = RSet[3].convert<std::uint64_t>();
@@ -82,6 +150,7 @@ namespace OpenWifi {
 					DeviceDetails{.reason = Reason, .author = Author, .created = Created};
 				More = RSet.moveNext();
 			}
+			PublishBlackList();
 			return true;
 		} catch (const Poco::Exception &E) {
 			poco_warning(Logger(), fmt::format("{}: Failed with: {}", std::string(__func__),
@@ -90,7 +159,7 @@ namespace OpenWifi {
 		return false;
 	}
 
-	bool Storage::AddBlackListDevice(GWObjects::BlackListedDevice &Device) {
+	bool Storage::AddBlackListDevice(GWObjects::BlackListedDevice &Device, bool Publish) {
 		try {
 			Poco::Data::Session Sess = Pool_->get();
 			Poco::Data::Statement Insert(Sess);
@@ -104,8 +173,10 @@ namespace OpenWifi {
 			Insert.execute();
 
 			std::lock_guard G(BlackListMutex);
-			BlackListDevices[Device.serialNumber] = DeviceDetails{
+			BlackListDevices[Poco::toLower(Device.serialNumber)] = DeviceDetails{
 				.reason = Device.reason, .author = Device.author, .created = Device.created};
+			if (Publish)
+				PublishBlackList();
 			return true;
 		} catch (const Poco::Exception &E) {
 			poco_warning(Logger(), fmt::format("{}: Failed with: {}", std::string(__func__),
@@ -117,8 +188,10 @@ namespace OpenWifi {
 	bool Storage::AddBlackListDevices(std::vector<GWObjects::BlackListedDevice> &Devices) {
 		try {
 			for (auto &i : Devices) {
-				AddBlackListDevice(i);
+				AddBlackListDevice(i, false);
 			}
+			std::lock_guard G(BlackListMutex);
+			PublishBlackList();
 			return true;
 		} catch (const Poco::Exception &E) {
 			poco_warning(Logger(), fmt::format("{}: Failed with: {}", std::string(__func__),
@@ -140,6 +213,7 @@ namespace OpenWifi {
 
 			std::lock_guard G(BlackListMutex);
 			BlackListDevices.erase(SerialNumber);
+			PublishBlackList();
 			return true;
 		} catch (const Poco::Exception &E) {
 			poco_warning(Logger(), fmt::format("{}: Failed with: {}", std::string(__func__),
@@ -189,8 +263,9 @@ namespace OpenWifi {
 			Update.execute();
 
 			std::lock_guard G(BlackListMutex);
-			BlackListDevices[Device.serialNumber] = DeviceDetails{
+			BlackListDevices[Poco::toLower(Device.serialNumber)] = DeviceDetails{
 				.reason = Device.reason, .author = Device.author, .created = Device.created};
+			PublishBlackList();
 
 			return true;
 
@@ -229,25 +304,26 @@ namespace OpenWifi {
 	}
 
 	uint64_t Storage::GetBlackListDeviceCount() {
-		std::lock_guard G(BlackListMutex);
-		return BlackListDevices.size();
+		return CurrentBlackList.Read(
+			[](const BlackListSnapshot &Snapshot) { return Snapshot.Devices.size(); });
 	}
 
-	bool Storage::IsBlackListed(const std::string &SerialNumber, std::string &reason,
+	bool Storage::IsBlackListed(std::uint64_t SerialNumber, std::string &reason,
 								std::string &author, std::uint64_t &created) {
-		std::lock_guard G(BlackListMutex);
-		auto DeviceHint = BlackListDevices.find(Poco::toLower(SerialNumber));
-		if (DeviceHint == end(BlackListDevices))
-			return false;
-		reason = DeviceHint->second.reason;
-		author = DeviceHint->second.author;
-		created = DeviceHint->second.created;
-		return true;
+		return CurrentBlackList.Read([&](const BlackListSnapshot &Snapshot) {
+			auto Device = Snapshot.Find(SerialNumber);
+			if (Device == nullptr)
+				return false;
+			reason = Device->reason;
+			author = Device->author;
+			created = Device->created;
+			return true;
+		});
 	}
 
-	bool Storage::IsBlackListed(const std::string &SerialNumber) {
-		std::lock_guard G(BlackListMutex);
-		auto DeviceHint = BlackListDevices.find(Poco::toLower(SerialNumber));
-		return DeviceHint != end(BlackListDevices);
+	bool Storage::IsBlackListed(std::uint64_t SerialNumber) {
+		return CurrentBlackList.Read([SerialNumber](const BlackListSnapshot &Snapshot) {
+			return Snapshot.Find(SerialNumber) != nullptr;
+		});
 	}
 } // namespace OpenWifi
\ No newline at end of file
@@ -0,0 +1,70 @@
+//
+//	License type: BSD 3-Clause License
+//	License copy: https://github.com/Telecominfraproject/wlan-cloud-ucentralgw/blob/master/LICENSE
+//
+
+#include "storage_bulkcommands.h"
+
+#include "framework/RESTAPI_utils.h"
+
+namespace OpenWifi {
+	static ORM::FieldVec BulkCommandDB_Fields{ORM::Field{"id", 36, true},
+											  ORM::Field{"command", ORM::FieldType::FT_TEXT},
+											  ORM::Field{"details", ORM::FieldType::FT_TEXT},
+											  ORM::Field{"submittedBy", ORM::FieldType::FT_TEXT},
+											  ORM::Field{"created", ORM::FieldType::FT_BIGINT},
+											  ORM::Field{"completed", ORM::FieldType::FT_BIGINT},
+											  ORM::Field{"status", ORM::FieldType::FT_TEXT},
+											  ORM::Field{"concurrency", ORM::FieldType::FT_BIGINT},
+											  ORM::Field{"rate", ORM::FieldType::FT_BIGINT},
+											  ORM::Field{"devices", ORM::FieldType::FT_TEXT}};
+
+	static ORM::IndexVec MakeIndices(const std::string &shortname) {
+		return ORM::IndexVec{
+			{std::string(shortname + "_created_index"),
+			 ORM::IndexEntryVec{{std::string("created"), ORM::Indextype::ASC}}}};
+	};
+
+	BulkCommandDB::BulkCommandDB(const std::string &TableName, const std::string &Shortname,
+								 OpenWifi::DBType T, Poco::Data::SessionPool &P, Poco::Logger &L)
+		: DB(T, TableName.c_str(), BulkCommandDB_Fields, MakeIndices(Shortname), P, L,
+			 Shortname.c_str()) {}
+
+	bool BulkCommandDB::Upgrade([[maybe_unused]] uint32_t from, uint32_t &to) {
+		to = Version();
+		return true;
+	}
+
+} // namespace OpenWifi
+
+template <>
+void ORM::DB<OpenWifi::BulkCommandRecordTuple, OpenWifi::GWObjects::BulkCommand>::Convert(
+	const OpenWifi::BulkCommandRecordTuple &In, OpenWifi::GWObjects::BulkCommand &Out) {
+	Out.id = In.get<0>();
+	Out.command = In.get<1>();
+	Out.details = In.get<2>();
+	Out.submittedBy = In.get<3>();
+	Out.created = In.get<4>();
+	Out.completed = In.get<5>();
+	Out.status = In.get<6>();
+	Out.concurrency = In.get<7>();
+	Out.rate = In.get<8>();
+	Out.devices =
+		OpenWifi::RESTAPI_utils::to_object_array<OpenWifi::GWObjects::BulkCommandDevice>(
+			In.get<9>());
+}
+
+template <>
+void ORM::DB<OpenWifi::BulkCommandRecordTuple, OpenWifi::GWObjects::BulkCommand>::Convert(
+	const OpenWifi::GWObjects::BulkCommand &In, OpenWifi::BulkCommandRecordTuple &Out) {
+	Out.set<0>(In.id);
+	Out.set<1>(In.command);
+	Out.set<2>(In.details);
+	Out.set<3>(In.submittedBy);
+	Out.set<4>(In.created);
+	Out.set<5>(In.completed);
+	Out.set<6>(In.status);
+	Out.set<7>(In.concurrency);
+	Out.set<8>(In.rate);
+	Out.set<9>(OpenWifi::RESTAPI_utils::to_string(In.devices));
+}
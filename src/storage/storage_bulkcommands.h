@@ -0,0 +1,36 @@
+//
+//	License type: BSD 3-Clause License
+//	License copy: https://github.com/Telecominfraproject/wlan-cloud-ucentralgw/blob/master/LICENSE
+//
+
+#pragma once
+
+#include "RESTObjects/RESTAPI_GWobjects.h"
+#include "framework/orm.h"
+
+namespace OpenWifi {
+
+	typedef Poco::Tuple<std::string, //  id
+						std::string, //  command
+						std::string, //  details
+						std::string, //  submittedBy
+						uint64_t,	 //  created
+						uint64_t,	 //  completed
+						std::string, //  status
+						uint64_t,	 //  concurrency
+						uint64_t,	 //  rate
+						std::string> //  devices
+		BulkCommandRecordTuple;
+	typedef std::vector<BulkCommandRecordTuple> BulkCommandRecordTupleList;
+
+	class BulkCommandDB : public ORM::DB<BulkCommandRecordTuple, GWObjects::BulkCommand> {
+	  public:
+		BulkCommandDB(const std::string &name, const std::string &shortname, OpenWifi::DBType T,
+					  Poco::Data::SessionPool &P, Poco::Logger &L);
+		virtual ~BulkCommandDB() {}
+		inline uint32_t Version() override { return 1; }
+
+		bool Upgrade(uint32_t from, uint32_t &to) override;
+	};
+
+} // namespace OpenWifi
@@ -8,6 +8,7 @@
 
 #include "CapabilitiesCache.h"
 #include "CentralConfig.h"
+#include "DeviceShadow.h"
 #include "Poco/Data/RecordSet.h"
 #include "Poco/JSON/Object.h"
 #include "StorageService.h"
@@ -33,6 +34,7 @@ namespace OpenWifi {
 				Poco::Data::Keywords::use(Now), Poco::Data::Keywords::use(TCaps),
 				Poco::Data::Keywords::use(Now);
 			UpSert.execute();
+			DeviceShadow()->SetCapabilities(Utils::SerialNumberToInt(SerialNumber), TCaps, Now);
 			return true;
 		} catch (const Poco::Exception &E) {
 			poco_warning(Logger(), fmt::format("{}: Failed with: {}", std::string(__func__),
@@ -61,6 +63,7 @@ namespace OpenWifi {
 				Poco::Data::Keywords::use(Now), Poco::Data::Keywords::use(TCaps),
 				Poco::Data::Keywords::use(Now);
 			UpSert.execute();
+			DeviceShadow()->SetCapabilities(Utils::SerialNumberToInt(SerialNumber), TCaps, Now);
 			return true;
 		} catch (const Poco::Exception &E) {
 			poco_warning(Logger(), fmt::format("{}: Failed with: {}", std::string(__func__),
@@ -72,13 +75,32 @@ namespace OpenWifi {
 	bool Storage::GetDeviceCapabilities(std::string &SerialNumber, GWObjects::Capabilities &Caps) {
 		try {
 			Poco::Data::Session Sess = Pool_->get();
-			Poco::Data::Statement Select(Sess);
+			auto SerialNumberInt = Utils::SerialNumberToInt(SerialNumber);
 
+			//	The database stays the record: the shadow's copy is only used when it carries the
+			//	stored LastUpdate, which saves reading the capabilities themselves.
 			std::string TmpSerialNumber;
+			std::uint64_t FirstUpdate = 0, LastUpdate = 0;
+			Poco::Data::Statement Check(Sess);
+			std::string CheckSt{"SELECT SerialNumber, FirstUpdate, LastUpdate FROM Capabilities "
+								"WHERE SerialNumber=?"};
+			Check << ConvertParams(CheckSt), Poco::Data::Keywords::into(TmpSerialNumber),
+				Poco::Data::Keywords::into(FirstUpdate), Poco::Data::Keywords::into(LastUpdate),
+				Poco::Data::Keywords::use(SerialNumber);
+			Check.execute();
+			if (TmpSerialNumber.empty())
+				return false;
+			if (DeviceShadow()->GetCapabilities(SerialNumberInt, Caps) &&
+				Caps.LastUpdate == LastUpdate) {
+				Caps.FirstUpdate = FirstUpdate;
+				return true;
+			}
 
+			Poco::Data::Statement Select(Sess);
 			std::string St{"SELECT SerialNumber, Capabilities, FirstUpdate, LastUpdate FROM "
 						   "Capabilities WHERE SerialNumber=?"};
 
+			TmpSerialNumber.clear();
 			Select << ConvertParams(St), Poco::Data::Keywords::into(TmpSerialNumber),
 				Poco::Data::Keywords::into(Caps.Capabilities),
 				Poco::Data::Keywords::into(Caps.FirstUpdate),
@@ -89,6 +111,7 @@ namespace OpenWifi {
 			if (TmpSerialNumber.empty())
 				return false;
 
+			DeviceShadow()->SetCapabilities(SerialNumberInt, Caps.Capabilities, Caps.LastUpdate);
 			return true;
 		} catch (const Poco::Exception &E) {
 			Logger().log(E);
@@ -105,6 +128,7 @@ namespace OpenWifi {
 
 			Delete << ConvertParams(St), Poco::Data::Keywords::use(SerialNumber);
 			Delete.execute();
+			DeviceShadow()->ClearCapabilities(Utils::SerialNumberToInt(SerialNumber));
 
 			return true;
 		} catch (const Poco::Exception &E) {
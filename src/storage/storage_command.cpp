@@ -144,6 +144,7 @@ namespace OpenWifi {
 			}
 
 			RemoveOldCommands(SerialNumber, Command.Command);
+			CommandManager()->UnqueueCommands(SerialNumber, Command.Command);
 
 			Poco::Data::Session Sess = Pool_->get();
 			Poco::Data::Statement Insert(Sess);
@@ -157,6 +158,9 @@ namespace OpenWifi {
 			Insert << ConvertParams(St), Poco::Data::Keywords::use(R);
 			Insert.execute();
 
+			if (Type == CommandExecutionType::COMMAND_PENDING)
+				CommandManager()->QueueCommand(Command);
+
 			return true;
 
 		} catch (const Poco::Exception &E) {
@@ -167,7 +171,8 @@ namespace OpenWifi {
 
 	bool Storage::GetCommands(std::string &SerialNumber, uint64_t FromDate, uint64_t ToDate,
 							  uint64_t Offset, uint64_t HowMany,
-							  std::vector<GWObjects::CommandDetails> &Commands) {
+							  std::vector<GWObjects::CommandDetails> &Commands,
+							  const PageCursor &After, PageCursor *Next) {
 		try {
 			CommandDetailsRecordList Records;
 			Poco::Data::Session Sess = Pool_->get();
@@ -191,18 +196,31 @@ namespace OpenWifi {
 				DateSelector = " Submitted<=" + std::to_string(ToDate);
 			}
 
+			std::string KeysetSelector;
+			if (After.Valid) {
+				KeysetSelector =
+					std::string(DatesIncluded || !SerialNumber.empty() ? " AND " : "WHERE ") +
+					ComputeKeyset(After, "Submitted", "UUID");
+				Offset = 0;
+			}
+
 			Poco::Data::Statement Select(Sess);
 
-			std::string FullQuery = IntroStatement + DateSelector + " ORDER BY Submitted ASC " +
+			std::string FullQuery = IntroStatement + DateSelector + KeysetSelector +
+									" ORDER BY Submitted ASC, UUID ASC " +
 									ComputeRange(Offset, HowMany);
 
 			Select << FullQuery, Poco::Data::Keywords::into(Records);
 			Select.execute();
+			PageCursor Cursor = After;
 			for (const auto &i : Records) {
 				GWObjects::CommandDetails R;
 				ConvertCommandRecord(i, R);
+				Cursor.Step(R.Submitted, R.UUID);
 				Commands.push_back(R);
 			}
+			if (Next != nullptr)
+				*Next = Records.size() < HowMany ? PageCursor{} : Cursor;
 			Select.reset(Sess);
 
 			return true;
@@ -238,6 +256,7 @@ namespace OpenWifi {
 			Delete << IntroStatement + DateSelector;
 			Delete.execute();
 			Delete.reset(Sess);
+			CommandManager()->UnqueueCommands(SerialNumber, FromDate, ToDate);
 
 			return true;
 		} catch (const Poco::Exception &E) {
@@ -289,14 +308,17 @@ namespace OpenWifi {
 			Poco::Data::Statement Update(Sess);
 
 			std::string St{"UPDATE CommandList SET Status=?,  Executed=?,  Completed=?,  "
-						   "Results=?,  ErrorText=?,  ErrorCode=?  WHERE UUID=?"};
+						   "Results=?,  ErrorText=?,  ErrorCode=?,  WaitingForFile=?,  "
+						   "executionTime=?  WHERE UUID=?"};
 
 			Update << ConvertParams(St), Poco::Data::Keywords::use(Command.Status),
 				Poco::Data::Keywords::use(Command.Executed),
 				Poco::Data::Keywords::use(Command.Completed),
 				Poco::Data::Keywords::use(Command.Results),
 				Poco::Data::Keywords::use(Command.ErrorText),
-				Poco::Data::Keywords::use(Command.ErrorCode), Poco::Data::Keywords::use(UUID);
+				Poco::Data::Keywords::use(Command.ErrorCode),
+				Poco::Data::Keywords::use(Command.WaitingForFile),
+				Poco::Data::Keywords::use(Command.executionTime), Poco::Data::Keywords::use(UUID);
 
 			Update.execute();
 
@@ -432,6 +454,7 @@ namespace OpenWifi {
 			Delete << ConvertParams(St), Poco::Data::Keywords::use(UUID);
 			Delete.execute();
 			Delete.reset(Sess);
+			CommandManager()->UnqueueCommand(UUID);
 			St = "DELETE FROM FileUploads WHERE UUID=?";
 			Delete << ConvertParams(St), Poco::Data::Keywords::use(UUID);
 			Delete.execute();
@@ -473,7 +496,8 @@ namespace OpenWifi {
 	}
 
 	bool Storage::GetReadyToExecuteCommands(uint64_t Offset, uint64_t HowMany,
-											std::vector<GWObjects::CommandDetails> &Commands) {
+											std::vector<GWObjects::CommandDetails> &Commands,
+											const PageCursor &After, PageCursor *Next) {
 
 		try {
 			Poco::Data::Session Sess = Pool_->get();
@@ -484,20 +508,52 @@ namespace OpenWifi {
 						   " FROM CommandList "
 						   " WHERE ((RunAt<=?) And (Executed=0) And (LastTry=0 or (" +
 						   std::to_string(Now) + "-LastTry)>" +
-						   std::to_string(CommandManager()->CommandRetry()) +
-						   ")) ORDER BY Submitted ASC "};
+						   std::to_string(CommandManager()->CommandRetry()) + "))" +
+						   (After.Valid ? " AND " + ComputeKeyset(After, "Submitted", "UUID") : "") +
+						   " ORDER BY Submitted ASC, UUID ASC "};
 			CommandDetailsRecordList Records;
 
+			if (After.Valid)
+				Offset = 0;
 			std::string SS = ConvertParams(St) + ComputeRange(Offset, HowMany);
 			Select << SS, Poco::Data::Keywords::into(Records), Poco::Data::Keywords::use(Now);
 			Select.execute();
 
+			//	the cursor follows every row read, so commands for disconnected devices are
+			//	passed over rather than read again on the next page
+			PageCursor Cursor = After;
 			for (const auto &record : Records) {
 				GWObjects::CommandDetails R;
 				ConvertCommandRecord(record, R);
+				Cursor.Step(R.Submitted, R.UUID);
 				if (AP_WS_Server()->Connected(Utils::SerialNumberToInt(R.SerialNumber)))
 					Commands.push_back(R);
 			}
+			if (Next != nullptr)
+				*Next = Records.size() < HowMany ? PageCursor{} : Cursor;
+			return true;
+		} catch (const Poco::Exception &E) {
+			Logger().log(E);
+		}
+		return false;
+	}
+
+	bool Storage::GetPendingCommands(std::vector<GWObjects::CommandDetails> &Commands) {
+		try {
+			Poco::Data::Session Sess = Pool_->get();
+			Poco::Data::Statement Select(Sess);
+
+			std::string St{"SELECT " + DB_Command_SelectFields +
+						   " FROM CommandList WHERE Executed=0 ORDER BY Submitted ASC"};
+			CommandDetailsRecordList Records;
+			Select << St, Poco::Data::Keywords::into(Records);
+			Select.execute();
+
+			for (const auto &record : Records) {
+				GWObjects::CommandDetails R;
+				ConvertCommandRecord(record, R);
+				Commands.push_back(R);
+			}
 			return true;
 		} catch (const Poco::Exception &E) {
 			Logger().log(E);
@@ -526,46 +582,76 @@ namespace OpenWifi {
 		return false;
 	}
 
+	Storage::CommandResult
+	Storage::MakeCommandResult(const std::string &UUID, const Poco::JSON::Object::Ptr &ReturnVars,
+							   const std::chrono::duration<double, std::milli> &execution_time,
+							   bool FullCommand) {
+		CommandResult R;
+		R.UUID = UUID;
+		R.Completed = FullCommand ? Utils::Now() : 0;
+		R.ExecutionTime = execution_time.count();
+
+		// Parse the result to get the ErrorText and make sure that this is a JSON document
+		if (ReturnVars->has("result")) {
+			auto ResultObj = ReturnVars->get("result");
+			auto ResultFields = ResultObj.extract<Poco::JSON::Object::Ptr>();
+			if (ResultFields->has("status")) {
+				auto StatusObj = ResultFields->get("status");
+				auto StatusInnerObj = StatusObj.extract<Poco::JSON::Object::Ptr>();
+				if (StatusInnerObj->has("error"))
+					R.ErrorCode = StatusInnerObj->get("error");
+				if (StatusInnerObj->has("text"))
+					R.ErrorText = StatusInnerObj->get("text").toString();
+
+				std::stringstream ResultText;
+				Poco::JSON::Stringifier::stringify(ResultObj, ResultText);
+				R.Results = ResultText.str();
+			}
+		}
+		return R;
+	}
+
 	bool Storage::CommandCompleted(std::string &UUID, Poco::JSON::Object::Ptr ReturnVars,
 								   const std::chrono::duration<double, std::milli> &execution_time,
 								   bool FullCommand) {
 		try {
+			return CommandsCompleted(
+				{MakeCommandResult(UUID, ReturnVars, execution_time, FullCommand)});
+		} catch (const Poco::Exception &E) {
+			Logger().log(E);
+		}
+		return false;
+	}
 
-			auto Now = FullCommand ? Utils::Now() : 0;
-
-			// Parse the result to get the ErrorText and make sure that this is a JSON document
-			uint64_t ErrorCode = 0;
-			std::string ErrorText, ResultStr;
-
-			if (ReturnVars->has("result")) {
-				auto ResultObj = ReturnVars->get("result");
-				auto ResultFields = ResultObj.extract<Poco::JSON::Object::Ptr>();
-				if (ResultFields->has("status")) {
-					auto StatusObj = ResultFields->get("status");
-					auto StatusInnerObj = StatusObj.extract<Poco::JSON::Object::Ptr>();
-					if (StatusInnerObj->has("error"))
-						ErrorCode = StatusInnerObj->get("error");
-					if (StatusInnerObj->has("text"))
-						ErrorText = StatusInnerObj->get("text").toString();
-
-					std::stringstream ResultText;
-					Poco::JSON::Stringifier::stringify(ResultObj, ResultText);
-					ResultStr = ResultText.str();
-				}
-			}
+	typedef Poco::Tuple<std::uint64_t, std::uint64_t, std::string, std::string, std::string, double,
+						std::string>
+		CommandResultRecordTuple;
+	typedef std::vector<CommandResultRecordTuple> CommandResultRecordList;
 
+	bool Storage::CommandsCompleted(const std::vector<CommandResult> &Results) {
+		if (Results.empty())
+			return true;
+		try {
 			Poco::Data::Session Sess = Pool_->get();
 			Poco::Data::Statement Update(Sess);
 
 			auto Status = to_string(Storage::CommandExecutionType::COMMAND_COMPLETED);
 			std::string St{"UPDATE CommandList SET Completed=?, ErrorCode=?, ErrorText=?, "
 						   "Results=?, Status=?, executionTime=? WHERE UUID=?"};
-			double tET{execution_time.count()};
-			Update << ConvertParams(St), Poco::Data::Keywords::use(Now),
-				Poco::Data::Keywords::use(ErrorCode), Poco::Data::Keywords::use(ErrorText),
-				Poco::Data::Keywords::use(ResultStr), Poco::Data::Keywords::use(Status),
-				Poco::Data::Keywords::use(tET), Poco::Data::Keywords::use(UUID);
-			Update.execute();
+			CommandResultRecordList Records;
+			Records.reserve(Results.size());
+			for (const auto &R : Results)
+				Records.emplace_back(R.Completed, R.ErrorCode, R.ErrorText, R.Results, Status,
+									 R.ExecutionTime, R.UUID);
+			Sess.begin();
+			try {
+				Update << ConvertParams(St), Poco::Data::Keywords::use(Records);
+				Update.execute();
+				Sess.commit();
+			} catch (...) {
+				Sess.rollback();
+				throw;
+			}
 			return true;
 		} catch (const Poco::Exception &E) {
 			Logger().log(E);
@@ -771,6 +857,8 @@ namespace OpenWifi {
 			std::string St1{"delete from CommandList where Submitted<?"};
 			Delete << ConvertParams(St1), Poco::Data::Keywords::use(Date);
 			Delete.execute();
+			if (Date > 0)
+				CommandManager()->UnqueueCommands("", 0, Date - 1);
 			return true;
 		} catch (const Poco::Exception &E) {
 			Logger().log(E);
@@ -9,8 +9,11 @@
 #include "AP_WS_Server.h"
 #include "CapabilitiesCache.h"
 #include "CentralConfig.h"
+#include "CommandManager.h"
 #include "ConfigurationCache.h"
 #include "Daemon.h"
+#include "DeviceSearchIndex.h"
+#include "DeviceShadow.h"
 #include "FindCountry.h"
 #include "OUIServer.h"
 #include "Poco/Data/RecordSet.h"
@@ -190,19 +193,34 @@ namespace OpenWifi {
 
 	bool Storage::GetDeviceSerialNumbers(uint64_t From, uint64_t HowMany,
 										 std::vector<std::string> &SerialNumbers,
-										 const std::string &orderBy) {
+										 const std::string &orderBy, const PageCursor &After,
+										 PageCursor *Next) {
 		try {
 			Poco::Data::Session Sess = Pool_->get();
 			Poco::Data::Statement Select(Sess);
 
 			std::string st;
-			if (orderBy.empty())
+			if (After.Valid) {
+				st = "SELECT SerialNumber From Devices WHERE" +
+					 ComputeKeyset(After, "", "SerialNumber") + "ORDER BY SerialNumber ASC ";
+				From = 0;
+			} else if (orderBy.empty())
 				st = "SELECT SerialNumber From Devices ORDER BY SerialNumber ASC ";
 			else
 				st = "SELECT SerialNumber From Devices " + orderBy;
 
+			auto First = SerialNumbers.size();
 			Select << st + ComputeRange(From, HowMany), Poco::Data::Keywords::into(SerialNumbers);
 			Select.execute();
+			if (Next != nullptr) {
+				PageCursor Cursor = After;
+				for (auto i = First; i < SerialNumbers.size(); ++i)
+					Cursor.Step(0, SerialNumbers[i]);
+				//	a cursor only follows the serial number order
+				*Next = SerialNumbers.size() - First < HowMany || (!After.Valid && !orderBy.empty())
+							? PageCursor{}
+							: Cursor;
+			}
 			return true;
 		} catch (const Poco::Exception &E) {
 			Logger().log(E);
@@ -366,15 +384,33 @@ namespace OpenWifi {
 		return false;
 	}
 
-	bool Storage::SetDeviceLastRecordedContact(std::string &SerialNumber, std::uint64_t lastRecordedContact) {
+	bool Storage::SetDevicesLastRecordedContact(
+		const std::vector<std::pair<std::string, std::uint64_t>> &Contacts) {
+		if (Contacts.empty())
+			return true;
 		try {
 			Poco::Data::Session 	Sess = Pool_->get();
 			Poco::Data::Statement 	Update(Sess);
 			std::string St{"UPDATE Devices SET lastRecordedContact=?  WHERE SerialNumber=?"};
 
-			Update << ConvertParams(St), Poco::Data::Keywords::use(lastRecordedContact),
-				Poco::Data::Keywords::use(SerialNumber);
-			Update.execute();
+			std::vector<std::uint64_t> LastContacts;
+			std::vector<std::string> SerialNumbers;
+			LastContacts.reserve(Contacts.size());
+			SerialNumbers.reserve(Contacts.size());
+			for (const auto &[SerialNumber, LastContact] : Contacts) {
+				SerialNumbers.emplace_back(SerialNumber);
+				LastContacts.emplace_back(LastContact);
+			}
+			Sess.begin();
+			try {
+				Update << ConvertParams(St), Poco::Data::Keywords::use(LastContacts),
+					Poco::Data::Keywords::use(SerialNumbers);
+				Update.execute();
+				Sess.commit();
+			} catch (...) {
+				Sess.rollback();
+				throw;
+			}
 			return true;
 
 		} catch (const Poco::Exception &E) {
@@ -419,6 +455,7 @@ namespace OpenWifi {
 					Insert.execute();
 					SetCurrentConfigurationID(DeviceDetails.SerialNumber, DeviceDetails.UUID);
 					SerialNumberCache()->AddSerialNumber(DeviceDetails.SerialNumber);
+					DeviceSearchIndex()->Update(DeviceDetails);
 					return true;
 				} else {
 					poco_warning(Logger(), "Cannot create device: invalid configuration.");
@@ -567,6 +604,7 @@ namespace OpenWifi {
 				Update << ConvertParams(St2), Poco::Data::Keywords::use(Firmware),
 					Poco::Data::Keywords::use(Now), Poco::Data::Keywords::use(SerialNumber);
 				Update.execute();
+				DeviceSearchIndex()->SetFirmware(SerialNumber, Firmware);
 				return true;
 			}
 			return true;
@@ -595,6 +633,9 @@ namespace OpenWifi {
 			}
 
 			SerialNumberCache()->DeleteSerialNumber(SerialNumber);
+			DeviceSearchIndex()->Remove(SerialNumber);
+			DeviceShadow()->Remove(Utils::SerialNumberToInt(SerialNumber));
+			CommandManager()->UnqueueCommands(SerialNumber, 0, 0);
 
 			if (KafkaManager()->Enabled()) {
 				Poco::JSON::Object Message;
@@ -723,6 +764,7 @@ namespace OpenWifi {
 			Update << ConvertParams(St2), Poco::Data::Keywords::use(R),
 				Poco::Data::Keywords::use(NewDeviceDetails.SerialNumber);
 			Update.execute();
+			DeviceSearchIndex()->Update(NewDeviceDetails);
 			// GetDevice(NewDeviceDetails.SerialNumber,NewDeviceDetails);
 			return true;
 		} catch (const Poco::Exception &E) {
@@ -732,7 +774,8 @@ namespace OpenWifi {
 	}
 
 	bool Storage::GetDevices(uint64_t From, uint64_t HowMany,
-							 std::vector<GWObjects::Device> &Devices, const std::string &orderBy) {
+							 std::vector<GWObjects::Device> &Devices, const std::string &orderBy,
+							 const PageCursor &After, PageCursor *Next) {
 		DeviceRecordList Records;
 		try {
 			Poco::Data::Session Sess = Pool_->get();
@@ -740,18 +783,32 @@ namespace OpenWifi {
 
 			// std::string st{"SELECT " + DB_DeviceSelectFields + " FROM Devices " + orderBy.empty()
 			// ? " ORDER BY SerialNumber ASC " + ComputeRange(From, HowMany)};
-			std::string st = fmt::format("SELECT {} FROM Devices {} {}", DB_DeviceSelectFields,
-										 orderBy.empty() ? " ORDER BY SerialNumber ASC " : orderBy,
-										 ComputeRange(From, HowMany));
+			std::string st;
+			if (After.Valid) {
+				st = fmt::format("SELECT {} FROM Devices WHERE {} ORDER BY SerialNumber ASC {}",
+								 DB_DeviceSelectFields, ComputeKeyset(After, "", "SerialNumber"),
+								 ComputeRange(0, HowMany));
+			} else {
+				st = fmt::format("SELECT {} FROM Devices {} {}", DB_DeviceSelectFields,
+								 orderBy.empty() ? " ORDER BY SerialNumber ASC " : orderBy,
+								 ComputeRange(From, HowMany));
+			}
 
 			Select << ConvertParams(st), Poco::Data::Keywords::into(Records);
 			Select.execute();
 
+			PageCursor Cursor = After;
 			for (auto &i : Records) {
 				GWObjects::Device D;
 				ConvertDeviceRecord(i, D);
+				Cursor.Step(0, D.SerialNumber);
 				Devices.push_back(D);
 			}
+			//	a cursor only follows the serial number order
+			if (Next != nullptr)
+				*Next = Records.size() < HowMany || (!After.Valid && !orderBy.empty())
+							? PageCursor{}
+							: Cursor;
 			return true;
 		} catch (const Poco::Exception &E) {
 			Logger().log(E);
@@ -806,15 +863,17 @@ namespace OpenWifi {
 
 			Poco::Data::RecordSet RSet(Select);
 
-			uint64_t NumberOfDevices = 0;
+			std::vector<uint64_t> SerialNumbers;
+			SerialNumbers.reserve(RSet.rowCount());
 
 			bool More = RSet.moveFirst();
 			while (More) {
 				auto SerialNumber = RSet[0].convert<std::string>();
-				SerialNumberCache()->AddSerialNumber(SerialNumber);
-				NumberOfDevices++;
+				SerialNumbers.push_back(std::stoull(SerialNumber, nullptr, 16));
 				More = RSet.moveNext();
 			}
+			auto NumberOfDevices = SerialNumbers.size();
+			SerialNumberCache()->Load(std::move(SerialNumbers));
 			Logger().information(fmt::format("Added {} serial numbers to cache.", NumberOfDevices));
 			return true;
 
@@ -824,6 +883,34 @@ namespace OpenWifi {
 		return false;
 	}
 
+	bool Storage::UpdateDeviceSearchIndex() {
+		try {
+			Poco::Data::Session Sess = Pool_->get();
+			Poco::Data::Statement Select(Sess);
+
+			Select << "SELECT SerialNumber, Compatible, Firmware, locale FROM Devices";
+			Select.execute();
+
+			Poco::Data::RecordSet RSet(Select);
+
+			uint64_t NumberOfDevices = 0;
+			bool More = RSet.moveFirst();
+			while (More) {
+				DeviceSearchIndex()->Update(
+					RSet[0].convert<std::string>(), RSet[1].convert<std::string>(),
+					RSet[2].convert<std::string>(), RSet[3].convert<std::string>());
+				NumberOfDevices++;
+				More = RSet.moveNext();
+			}
+			Logger().information(fmt::format("Added {} devices to search index.", NumberOfDevices));
+			return true;
+
+		} catch (const Poco::Exception &E) {
+			Logger().log(E);
+		}
+		return false;
+	}
+
 	static std::string ComputeCertificateTag(GWObjects::CertificateValidation V) {
 		switch (V) {
 		case GWObjects::NO_CERTIFICATE:
@@ -935,48 +1022,32 @@ namespace OpenWifi {
 									 ComputeCertificateTag(ConnState.VerifiedCertificate));
 					UpdateCountedMap(Dashboard.lastContact,
 									 ComputeUpLastContactTag(ConnState.LastContact));
-					GWObjects::HealthCheck HC;
-					if (AP_WS_Server()->GetHealthcheck(SerialNumber, HC))
-						UpdateCountedMap(Dashboard.healths, ComputeSanityTag(HC.Sanity));
-					else
+					StateUtils::DeviceMetrics Metrics;
+					if (!AP_WS_Server()->GetMetrics(SerialNumber, Metrics)) {
 						UpdateCountedMap(Dashboard.healths, ComputeSanityTag(100));
-					std::string LastStats;
-					if (AP_WS_Server()->GetStatistics(SerialNumber, LastStats) &&
-						!LastStats.empty()) {
-						Poco::JSON::Parser P;
-
-						auto RawObject = P.parse(LastStats).extract<Poco::JSON::Object::Ptr>();
-
-						if (RawObject->has("unit")) {
-							auto Unit = RawObject->getObject("unit");
-							if (Unit->has("uptime")) {
+					} else {
+						UpdateCountedMap(Dashboard.healths, ComputeSanityTag(Metrics.Sanity));
+						if (Metrics.HasState) {
+							if (Metrics.HasUptime)
 								UpdateCountedMap(Dashboard.upTimes,
-												 ComputeUpTimeTag(Unit->get("uptime")));
-							}
-							if (Unit->has("memory")) {
-								auto Memory = Unit->getObject("memory");
-								uint64_t Free = Memory->get("free");
-								uint64_t Total = Memory->get("total");
+												 ComputeUpTimeTag(Metrics.Uptime));
+							if (Metrics.HasMemory)
 								UpdateCountedMap(Dashboard.memoryUsed,
-												 ComputeUsedMemoryTag(Free, Total));
-							}
-							if (Unit->has("load")) {
-								auto Load = Unit->getArray("load");
-								UpdateCountedMap(Dashboard.load1,
-												 ComputeLoadTag(Load->getElement<uint64_t>(0)));
-								UpdateCountedMap(Dashboard.load5,
-												 ComputeLoadTag(Load->getElement<uint64_t>(1)));
+												 ComputeUsedMemoryTag(Metrics.MemoryFree,
+																	  Metrics.MemoryTotal));
+							if (Metrics.HasLoad) {
+								UpdateCountedMap(Dashboard.load1, ComputeLoadTag(Metrics.Load[0]));
+								UpdateCountedMap(Dashboard.load5, ComputeLoadTag(Metrics.Load[1]));
 								UpdateCountedMap(Dashboard.load15,
-												 ComputeLoadTag(Load->getElement<uint64_t>(2)));
+												 ComputeLoadTag(Metrics.Load[2]));
 							}
+							UpdateCountedMap(Dashboard.associations, "2G",
+											 ConnState.Associations_2G);
+							UpdateCountedMap(Dashboard.associations, "5G",
+											 ConnState.Associations_5G);
+							UpdateCountedMap(Dashboard.associations, "6G",
+											 ConnState.Associations_6G);
 						}
-
-						uint64_t Associations_2G, Associations_5G, Associations_6G;
-						StateUtils::ComputeAssociations(RawObject, Associations_2G, Associations_5G,
-														Associations_6G);
-						UpdateCountedMap(Dashboard.associations, "2G", Associations_2G);
-						UpdateCountedMap(Dashboard.associations, "5G", Associations_5G);
-						UpdateCountedMap(Dashboard.associations, "6G", Associations_6G);
 					}
 				} else {
 					UpdateCountedMap(Dashboard.status, "not connected");
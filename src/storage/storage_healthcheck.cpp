@@ -6,6 +6,7 @@
 //	Arilia Wireless Inc.
 //
 
+#include "DeviceShadow.h"
 #include "StorageService.h"
 #include "fmt/format.h"
 
@@ -55,9 +56,44 @@ namespace OpenWifi {
 		return false;
 	}
 
+	bool Storage::AddHealthCheckData(const std::vector<GWObjects::HealthCheck> &Checks) {
+		try {
+			Poco::Data::Session Sess = Pool_->get();
+
+			HealthCheckRecordList Records(Checks.size());
+			for (std::size_t i = 0; i < Checks.size(); ++i)
+				ConvertHealthCheckRecord(Checks[i], Records[i]);
+
+			//	One INSERT per RowsPerInsert rows, each row binding its tuple's fields.
+			std::string St{"INSERT INTO HealthChecks ( " + DB_HealthCheckSelectFields + " ) VALUES"};
+			const auto Rows = RowsPerInsert(5);
+			Sess.begin();
+			try {
+				for (std::size_t First = 0; First < Records.size(); First += Rows) {
+					auto Count = std::min(Rows, Records.size() - First);
+					Poco::Data::Statement Insert(Sess);
+					Insert << ConvertParams(MultiRowInsert(St, DB_HealthCheckInsertValues, Count));
+					for (auto i = First; i < First + Count; ++i)
+						Insert.addBind(Poco::Data::Keywords::use(Records[i]));
+					Insert.execute();
+				}
+				Sess.commit();
+			} catch (...) {
+				Sess.rollback();
+				throw;
+			}
+			return true;
+		} catch (const Poco::Exception &E) {
+			poco_warning(Logger(), fmt::format("{}: Failed with: {}", std::string(__func__),
+											   E.displayText()));
+		}
+		return false;
+	}
+
 	bool Storage::GetHealthCheckData(std::string &SerialNumber, uint64_t FromDate, uint64_t ToDate,
 									 uint64_t Offset, uint64_t HowMany,
-									 std::vector<GWObjects::HealthCheck> &Checks) {
+									 std::vector<GWObjects::HealthCheck> &Checks,
+									 const PageCursor &After, PageCursor *Next) {
 		try {
 			HealthCheckRecordList Records;
 			Poco::Data::Session Sess = Pool_->get();
@@ -80,18 +116,48 @@ namespace OpenWifi {
 				DateSelector = " Recorded<=" + std::to_string(ToDate);
 			}
 
+			std::string Join{DatesIncluded || !SerialNumber.empty() ? " AND " : "WHERE "};
+			std::string KeysetSelector;
+			if (After.Valid) {
+				KeysetSelector = Join + ComputeKeyset(After, "Recorded", "SerialNumber");
+				Offset = 0;
+			}
+
 			Poco::Data::Statement Select(Sess);
 
-			Select << Statement + DateSelector + " ORDER BY Recorded ASC " +
+			Select << Statement + DateSelector + KeysetSelector +
+						  " ORDER BY Recorded ASC, SerialNumber ASC " +
 						  ComputeRange(Offset, HowMany),
 				Poco::Data::Keywords::into(Records);
 			Select.execute();
 
+			//	several checks may share (Recorded, SerialNumber)
+			bool Full = Records.size() >= HowMany;
+			if (Next != nullptr && Full) {
+				CompleteLastPosition(
+					Records,
+					[](const HealthCheckRecordTuple &R) {
+						return std::make_pair(R.get<4>(), R.get<0>());
+					},
+					[&](uint64_t Recorded, const std::string &Key, HealthCheckRecordList &Group) {
+						Poco::Data::Statement SelectGroup(Sess);
+						SelectGroup << Statement + DateSelector + Join + "Recorded=" +
+										   std::to_string(Recorded) + " AND SerialNumber='" + Key +
+										   "'",
+							Poco::Data::Keywords::into(Group);
+						SelectGroup.execute();
+					});
+			}
+
+			PageCursor Cursor = After;
 			for (const auto &i : Records) {
 				GWObjects::HealthCheck R;
 				ConvertHealthCheckRecord(i, R);
+				Cursor.Step(R.Recorded, R.SerialNumber);
 				Checks.push_back(R);
 			}
+			if (Next != nullptr)
+				*Next = Full ? Cursor : PageCursor{};
 			Select.reset(Sess);
 			return true;
 		} catch (const Poco::Exception &E) {
@@ -104,6 +170,9 @@ namespace OpenWifi {
 	bool Storage::GetNewestHealthCheckData(std::string &SerialNumber, uint64_t HowMany,
 										   std::vector<GWObjects::HealthCheck> &Checks) {
 
+		if (DeviceShadow()->GetNewestHealthChecks(Utils::SerialNumberToInt(SerialNumber), HowMany,
+										Checks))
+			return true;
 		try {
 			HealthCheckRecordList Records;
 			Poco::Data::Session Sess = Pool_->get();
@@ -159,6 +228,8 @@ namespace OpenWifi {
 
 			Delete.execute();
 
+			DeviceShadow()->RemoveHealthChecks(SerialNumber, FromDate, ToDate);
+
 			return true;
 		} catch (const Poco::Exception &E) {
 			poco_warning(Logger(), fmt::format("{}: Failed with: {}", std::string(__func__),
@@ -175,6 +246,7 @@ namespace OpenWifi {
 			std::string St1{"delete from HealthChecks where recorded<?"};
 			Delete << ConvertParams(St1), Poco::Data::Keywords::use(Date);
 			Delete.execute();
+			DeviceShadow()->RemoveHealthChecksOlderThan(Date);
 			return true;
 		} catch (const Poco::Exception &E) {
 			poco_warning(Logger(), fmt::format("{}: Failed with: {}", std::string(__func__),
@@ -61,9 +61,44 @@ namespace OpenWifi {
 		return false;
 	}
 
+	bool Storage::AddLogs(const std::vector<GWObjects::DeviceLog> &Logs) {
+		try {
+			Poco::Data::Session Sess = Pool_->get();
+
+			DeviceLogsRecordList Records(Logs.size());
+			for (std::size_t i = 0; i < Logs.size(); ++i)
+				ConvertLogsRecord(Logs[i], Records[i]);
+
+			//	One INSERT per RowsPerInsert rows, each row binding its tuple's fields.
+			std::string St{"INSERT INTO DeviceLogs (" + DB_LogsSelectFields + ") values"};
+			const auto Rows = RowsPerInsert(7);
+			Sess.begin();
+			try {
+				for (std::size_t First = 0; First < Records.size(); First += Rows) {
+					auto Count = std::min(Rows, Records.size() - First);
+					Poco::Data::Statement Insert(Sess);
+					Insert << ConvertParams(MultiRowInsert(St, DB_LogsInsertValues, Count));
+					for (auto i = First; i < First + Count; ++i)
+						Insert.addBind(Poco::Data::Keywords::use(Records[i]));
+					Insert.execute();
+				}
+				Sess.commit();
+			} catch (...) {
+				Sess.rollback();
+				throw;
+			}
+			return true;
+		} catch (const Poco::Exception &E) {
+			poco_warning(Logger(), fmt::format("{}: Failed with: {}", std::string(__func__),
+											   E.displayText()));
+		}
+		return false;
+	}
+
 	bool Storage::GetLogData(std::string &SerialNumber, uint64_t FromDate, uint64_t ToDate,
 							 uint64_t Offset, uint64_t HowMany,
-							 std::vector<GWObjects::DeviceLog> &Stats, uint64_t Type) {
+							 std::vector<GWObjects::DeviceLog> &Stats, uint64_t Type,
+							 const PageCursor &After, PageCursor *Next) {
 		try {
 			DeviceLogsRecordList Records;
 			Poco::Data::Session Sess = Pool_->get();
@@ -91,16 +126,46 @@ namespace OpenWifi {
 			TypeSelector = (HasWhere ? " AND LogType=" : " WHERE LogType=") + std::to_string(Type);
 			Poco::Data::Statement Select(Sess);
 
-			Select << Statement + DateSelector + TypeSelector + " ORDER BY Recorded DESC " +
+			//	newest first
+			std::string KeysetSelector;
+			if (After.Valid) {
+				KeysetSelector = " AND " + ComputeKeyset(After, "Recorded", "SerialNumber", true);
+				Offset = 0;
+			}
+
+			Select << Statement + DateSelector + TypeSelector + KeysetSelector +
+						  " ORDER BY Recorded DESC, SerialNumber DESC " +
 						  ComputeRange(Offset, HowMany),
 				Poco::Data::Keywords::into(Records);
 			Select.execute();
 
+			//	several entries may share (Recorded, SerialNumber)
+			bool Full = Records.size() >= HowMany;
+			if (Next != nullptr && Full) {
+				CompleteLastPosition(
+					Records,
+					[](const DeviceLogsRecordTuple &R) {
+						return std::make_pair(R.get<4>(), R.get<0>());
+					},
+					[&](uint64_t Recorded, const std::string &Key, DeviceLogsRecordList &Group) {
+						Poco::Data::Statement SelectGroup(Sess);
+						SelectGroup << Statement + DateSelector + TypeSelector + " AND Recorded=" +
+										   std::to_string(Recorded) + " AND SerialNumber='" + Key +
+										   "'",
+							Poco::Data::Keywords::into(Group);
+						SelectGroup.execute();
+					});
+			}
+
+			PageCursor Cursor = After;
 			for (const auto &i : Records) {
 				GWObjects::DeviceLog R;
 				ConvertLogsRecord(i, R);
+				Cursor.Step(R.Recorded, R.SerialNumber);
 				Stats.push_back(R);
 			}
+			if (Next != nullptr)
+				*Next = Full ? Cursor : PageCursor{};
 			Select.reset(Sess);
 			return true;
 		} catch (const Poco::Exception &E) {
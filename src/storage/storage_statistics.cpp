@@ -7,6 +7,7 @@
 //
 
 #include "AP_WS_Server.h"
+#include "DeviceShadow.h"
 #include "StorageService.h"
 
 #include "fmt/format.h"
@@ -54,6 +55,40 @@ namespace OpenWifi {
 		return false;
 	}
 
+	bool Storage::AddStatisticsData(const std::vector<GWObjects::Statistics> &Stats) {
+		try {
+			Poco::Data::Session Sess(Pool_->get());
+
+			StatsRecordList Records(Stats.size());
+			for (std::size_t i = 0; i < Stats.size(); ++i)
+				ConvertStatsRecord(Stats[i], Records[i]);
+
+			//	One INSERT per RowsPerInsert rows, each row binding its tuple's fields.
+			std::string St{"INSERT INTO Statistics ( " + DB_StatsSelectFields + " ) VALUES"};
+			const auto Rows = RowsPerInsert(4);
+			Sess.begin();
+			try {
+				for (std::size_t First = 0; First < Records.size(); First += Rows) {
+					auto Count = std::min(Rows, Records.size() - First);
+					Poco::Data::Statement Insert(Sess);
+					Insert << ConvertParams(MultiRowInsert(St, DB_StatsInsertValues, Count));
+					for (auto i = First; i < First + Count; ++i)
+						Insert.addBind(Poco::Data::Keywords::use(Records[i]));
+					Insert.execute();
+				}
+				Sess.commit();
+			} catch (...) {
+				Sess.rollback();
+				throw;
+			}
+			return true;
+		} catch (const Poco::Exception &E) {
+			poco_warning(Logger(), fmt::format("{}: Failed with: {}", std::string(__func__),
+											   E.displayText()));
+		}
+		return false;
+	}
+
 	bool Storage::GetNumberOfStatisticsDataRecords(std::string &SerialNumber, uint64_t FromDate,
 												   uint64_t ToDate, std::uint64_t &Count) {
 		try {
@@ -92,7 +127,8 @@ namespace OpenWifi {
 
 	bool Storage::GetStatisticsData(std::string &SerialNumber, uint64_t FromDate, uint64_t ToDate,
 									uint64_t Offset, uint64_t HowMany,
-									std::vector<GWObjects::Statistics> &Stats) {
+									std::vector<GWObjects::Statistics> &Stats,
+									const PageCursor &After, PageCursor *Next) {
 		try {
 			Poco::Data::Session Sess(Pool_->get());
 			Poco::Data::Statement Select(Sess);
@@ -117,16 +153,44 @@ namespace OpenWifi {
 				DateSelector = " Recorded<=" + std::to_string(ToDate);
 			}
 
-			Select << StatementStr + DateSelector + " ORDER BY Recorded ASC " +
+			std::string Join{DatesIncluded || !SerialNumber.empty() ? " AND " : "WHERE "};
+			std::string KeysetSelector;
+			if (After.Valid) {
+				KeysetSelector = Join + ComputeKeyset(After, "Recorded", "SerialNumber");
+				Offset = 0;
+			}
+
+			Select << StatementStr + DateSelector + KeysetSelector +
+						  " ORDER BY Recorded ASC, SerialNumber ASC " +
 						  ComputeRange(Offset, HowMany),
 				Poco::Data::Keywords::into(Records);
 			Select.execute();
 
+			//	several samples may share (Recorded, SerialNumber)
+			bool Full = Records.size() >= HowMany;
+			if (Next != nullptr && Full) {
+				CompleteLastPosition(
+					Records,
+					[](const StatsRecordTuple &R) { return std::make_pair(R.get<3>(), R.get<0>()); },
+					[&](uint64_t Recorded, const std::string &Key, StatsRecordList &Group) {
+						Poco::Data::Statement SelectGroup(Sess);
+						SelectGroup << StatementStr + DateSelector + Join + "Recorded=" +
+										   std::to_string(Recorded) + " AND SerialNumber='" + Key +
+										   "'",
+							Poco::Data::Keywords::into(Group);
+						SelectGroup.execute();
+					});
+			}
+
+			PageCursor Cursor = After;
 			for (const auto &i : Records) {
 				GWObjects::Statistics R;
 				ConvertStatsRecord(i, R);
+				Cursor.Step(R.Recorded, R.SerialNumber);
 				Stats.emplace_back(R);
 			}
+			if (Next != nullptr)
+				*Next = Full ? Cursor : PageCursor{};
 			Select.reset(Sess);
 			return true;
 		} catch (const Poco::Exception &E) {
@@ -139,6 +203,9 @@ namespace OpenWifi {
 
 	bool Storage::GetNewestStatisticsData(std::string &SerialNumber, uint64_t HowMany,
 										  std::vector<GWObjects::Statistics> &Stats) {
+		if (DeviceShadow()->GetNewestStatistics(Utils::SerialNumberToInt(SerialNumber), HowMany,
+										Stats))
+			return true;
 		try {
 			StatsRecordList Records;
 			Poco::Data::Session Sess(Pool_->get());
@@ -190,6 +257,8 @@ namespace OpenWifi {
 			Select << Statement + DateSelector;
 			Select.execute();
 
+			DeviceShadow()->RemoveStatistics(SerialNumber, FromDate, ToDate);
+
 			return true;
 		} catch (const Poco::Exception &E) {
 			poco_warning(Logger(), (fmt::format("{}: Failed with: {}", std::string(__func__),
@@ -206,6 +275,7 @@ namespace OpenWifi {
 			std::string St1{"delete from Statistics where recorded<?"};
 			Delete << ConvertParams(St1), Poco::Data::Keywords::use(Date);
 			Delete.execute();
+			DeviceShadow()->RemoveStatisticsOlderThan(Date);
 			return true;
 		} catch (const Poco::Exception &E) {
 			poco_warning(Logger(), fmt::format("{}: Failed with: {}", std::string(__func__),
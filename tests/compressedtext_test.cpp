@@ -0,0 +1,66 @@
+//
+//	License type: BSD 3-Clause License
+//	License copy: https://github.com/Telecominfraproject/wlan-cloud-ucentralgw/blob/master/LICENSE
+//
+
+#undef NDEBUG
+#include <cassert>
+#include <cstdio>
+#include <string>
+
+#include "CompressedText.h"
+
+using OpenWifi::CompressedText;
+
+static std::string Report() {
+	std::string R{"{\"unit\":{\"load\":[0.1,0.2,0.3]},\"interfaces\":["};
+	for (int i = 0; i < 200; i++)
+		R += "{\"name\":\"wlan" + std::to_string(i) + "\",\"counters\":{\"rx_bytes\":" +
+			 std::to_string(i * 1000) + "}},";
+	R += "{}]}";
+	return R;
+}
+
+static void RoundTrip() {
+	auto Text = Report();
+	CompressedText Plain(Text, false);
+	assert(!Plain.Compressed() && Plain.Text() == Text);
+	assert(Plain.RawSize() == Text.size() && Plain.HeldSize() >= Text.size());
+
+	for (int Level : {1, 9}) {
+		CompressedText Deflated(Text, true, Level);
+		assert(Deflated.Compressed());
+		assert(Deflated.Text() == Text);
+		assert(Deflated.RawSize() == Text.size());
+		assert(Deflated.HeldSize() < Text.size() / 4);
+	}
+}
+
+static void KeptAsIs() {
+	//	text that does not shrink is held plain
+	CompressedText Short("{}", true);
+	assert(!Short.Compressed() && Short.Text() == "{}");
+
+	CompressedText Empty("", true);
+	assert(Empty.Empty() && Empty.Text().empty() && Empty.HeldSize() == 0);
+	CompressedText Default;
+	assert(Default.Empty() && Default.Text().empty());
+}
+
+static void Shared() {
+	auto Text = Report();
+	CompressedText A(Text, true);
+	auto B = A;
+	assert(B.Text() == Text && B.HeldSize() == A.HeldSize());
+	A = CompressedText("{}", true);
+	//	the copy keeps the bytes alive
+	assert(B.Text() == Text && A.Text() == "{}");
+}
+
+int main() {
+	RoundTrip();
+	KeptAsIs();
+	Shared();
+	std::printf("compressedtext: ok\n");
+	return 0;
+}
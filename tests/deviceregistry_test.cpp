@@ -0,0 +1,58 @@
+//
+//	License type: BSD 3-Clause License
+//	License copy: https://github.com/Telecominfraproject/wlan-cloud-ucentralgw/blob/master/LICENSE
+//
+
+#undef NDEBUG
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+
+#include "AP_WS_DeviceRegistry.h"
+
+namespace {
+	struct Connection {
+		std::uint64_t Session = 0;
+	};
+} // namespace
+
+static void Sessions() {
+	OpenWifi::AP_WS_DeviceRegistry<Connection> R;
+	const std::uint64_t SN = 0x903cb3aabbccULL;
+	assert(R.Find(SN) == nullptr);
+
+	assert(R.Register(SN, 10, std::make_shared<Connection>(Connection{10})));
+	assert(R.Find(SN)->Session == 10);
+
+	//	a reconnect replaces the device's session, a late older one does not
+	assert(R.Register(SN, 12, std::make_shared<Connection>(Connection{12})));
+	assert(!R.Register(SN, 11, std::make_shared<Connection>(Connection{11})));
+	assert(!R.Register(SN, 12, std::make_shared<Connection>(Connection{12})));
+	assert(R.Find(SN)->Session == 12);
+
+	//	the session that was replaced cannot remove the device
+	assert(!R.Unregister(SN, 10));
+	assert(R.Find(SN) != nullptr);
+	assert(R.Unregister(SN, 12));
+	assert(R.Find(SN) == nullptr);
+	assert(!R.Unregister(SN, 12));
+}
+
+static void Shards() {
+	OpenWifi::AP_WS_DeviceRegistry<Connection> R;
+	//	devices of one OUI land in different shards
+	const std::uint64_t A = 0x903cb3000001ULL, B = 0x903cb3000002ULL;
+	assert(R.ShardOf(A) != R.ShardOf(B));
+	for (std::uint64_t i = 0; i < 1000; i++)
+		assert(R.Register(A + i, i + 1, std::make_shared<Connection>(Connection{i + 1})));
+	for (std::uint64_t i = 0; i < 1000; i++)
+		assert(R.Find(A + i)->Session == i + 1);
+}
+
+int main() {
+	Sessions();
+	Shards();
+	std::printf("deviceregistry: ok\n");
+	return 0;
+}
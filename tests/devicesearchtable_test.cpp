@@ -0,0 +1,174 @@
+//
+//	License type: BSD 3-Clause License
+//	License copy: https://github.com/Telecominfraproject/wlan-cloud-ucentralgw/blob/master/LICENSE
+//
+
+#undef NDEBUG
+#include <atomic>
+#include <cassert>
+#include <cstdio>
+#include <thread>
+
+#include "DeviceSearchTable.h"
+
+using OpenWifi::DeviceSearchTable;
+
+static std::vector<std::uint64_t> Serials(const std::vector<DeviceSearchTable::Entry> &Results) {
+	std::vector<std::uint64_t> SNs;
+	for (const auto &R : Results)
+		SNs.push_back(R.SerialNumber);
+	return SNs;
+}
+
+static void Fill(DeviceSearchTable &T) {
+	T.Update(0x903cb3000001, {"edgecore_eap101", "TIP-v2.9.0", "CA"});
+	T.Update(0x903cb3000002, {"edgecore_eap102", "TIP-v2.9.0", "US"});
+	T.Update(0x903cb3000003, {"cig_wf188n", "TIP-v3.0.0", "US"});
+	T.Update(0x24f5a2000001, {"edgecore_eap101", "TIP-v3.0.0", "US"});
+	T.SetAddress(0x24f5a2000001, "10.0.0.5");
+}
+
+static void SerialNumberPatterns() {
+	DeviceSearchTable::Query Q;
+	assert(DeviceSearchTable::SetSerialNumber("903cb3", Q));
+	assert(Q.Low == 0x903cb3000000 && Q.High == 0x903cb3ffffff);
+	assert(DeviceSearchTable::SetSerialNumber("*0002", Q));
+	assert(Q.SuffixMask == 0xffff && Q.Suffix == 2);
+	assert(!DeviceSearchTable::SetSerialNumber("90zz", Q));
+	assert(!DeviceSearchTable::SetSerialNumber("903cb30000011", Q));
+	assert((DeviceSearchTable::Terms("  Edge  EAP ") == std::vector<std::string>{"edge", "eap"}));
+}
+
+static void Filters() {
+	DeviceSearchTable T;
+	Fill(T);
+	std::vector<DeviceSearchTable::Entry> R;
+	DeviceSearchTable::FacetCounts F;
+
+	DeviceSearchTable::Query Q;
+	DeviceSearchTable::SetSerialNumber("903cb3", Q);
+	assert(!T.Search(Q, R, F));
+	assert((Serials(R) == std::vector<std::uint64_t>{0x903cb3000001, 0x903cb3000002,
+													 0x903cb3000003}));
+
+	//	terms match the start of the value or of any of its words
+	R.clear();
+	Q = {};
+	Q.Terms[DeviceSearchTable::COMPATIBLE] = DeviceSearchTable::Terms("eap");
+	Q.Terms[DeviceSearchTable::FIRMWARE] = DeviceSearchTable::Terms("v3");
+	T.Search(Q, R, F);
+	assert((Serials(R) == std::vector<std::uint64_t>{0x24f5a2000001}));
+	assert(R[0].Values[DeviceSearchTable::COMPATIBLE] == "edgecore_eap101");
+	assert(R[0].IPAddress == "10.0.0.5");
+
+	R.clear();
+	Q = {};
+	Q.IPAddress = "10.0.";
+	T.Search(Q, R, F);
+	assert(R.size() == 1);
+
+	R.clear();
+	Q = {};
+	DeviceSearchTable::SetSerialNumber("*0001", Q);
+	Q.Facets = true;
+	T.Search(Q, R, F);
+	assert(R.size() == 2 && F.Total == 2);
+	assert(F.Top[DeviceSearchTable::COMPATIBLE].size() == 1);
+	assert(F.Top[DeviceSearchTable::COMPATIBLE][0] ==
+		   std::make_pair(std::string("edgecore_eap101"), (std::uint64_t)2));
+}
+
+static void Pages() {
+	DeviceSearchTable T;
+	for (std::uint64_t i = 0; i < 1000; i++)
+		T.Update(0x903cb3000000 + i * 3, {"c", "f", "l"});
+	for (bool Facets : {false, true}) {
+		DeviceSearchTable::Query Q;
+		Q.Limit = 64;
+		Q.Facets = Facets;
+		std::vector<std::uint64_t> All;
+		while (true) {
+			std::vector<DeviceSearchTable::Entry> R;
+			DeviceSearchTable::FacetCounts F;
+			auto More = T.Search(Q, R, F);
+			if (Facets)
+				assert(F.Total == 1000);
+			for (const auto &E : R)
+				All.push_back(E.SerialNumber);
+			if (!More)
+				break;
+			Q.After = R.back().SerialNumber;
+			Q.HasAfter = true;
+		}
+		assert(All.size() == 1000);
+		for (std::uint64_t i = 0; i < 1000; i++)
+			assert(All[i] == 0x903cb3000000 + i * 3);
+	}
+
+	//	the cursor device is gone: the page still continues right after it
+	DeviceSearchTable::Query Q;
+	Q.After = 0x903cb3000000 + 10 * 3;
+	Q.HasAfter = true;
+	Q.Limit = 2;
+	T.Remove(Q.After);
+	std::vector<DeviceSearchTable::Entry> R;
+	DeviceSearchTable::FacetCounts F;
+	assert(T.Search(Q, R, F));
+	assert((Serials(R) == std::vector<std::uint64_t>{0x903cb3000000 + 11 * 3,
+													 0x903cb3000000 + 12 * 3}));
+}
+
+static void RemoveAndReuse() {
+	DeviceSearchTable T;
+	Fill(T);
+	T.Remove(0x903cb3000002);
+	//	takes the id of the removed device
+	T.Update(0x000000000001, {"x", "y", "z"});
+	std::vector<DeviceSearchTable::Entry> R;
+	DeviceSearchTable::FacetCounts F;
+	DeviceSearchTable::Query Q;
+	Q.Facets = true;
+	T.Search(Q, R, F);
+	assert((Serials(R) == std::vector<std::uint64_t>{0x000000000001, 0x24f5a2000001,
+													 0x903cb3000001, 0x903cb3000003}));
+	assert(T.Devices() == 4);
+	for (const auto &[Value, Count] : F.Top[DeviceSearchTable::LOCALE])
+		assert(Count == (Value == "US" ? 2u : 1u));
+}
+
+//	Searches keep seeing a sorted order while devices come and go.
+static void ConcurrentUpdates() {
+	DeviceSearchTable T;
+	for (std::uint64_t i = 0; i < 2000; i++)
+		T.Update(i * 2, {"c", "f", "l"});
+	std::atomic_bool Done = false;
+	std::thread Writer([&] {
+		for (std::uint64_t Round = 0; Round < 200; Round++) {
+			for (std::uint64_t i = 0; i < 50; i++)
+				T.Remove((Round * 50 + i) % 2000 * 2);
+			for (std::uint64_t i = 0; i < 50; i++)
+				T.Update((Round * 50 + i) % 2000 * 2 + 1, {"c", "f", "l"});
+		}
+		Done = true;
+	});
+	while (!Done) {
+		std::vector<DeviceSearchTable::Entry> R;
+		DeviceSearchTable::FacetCounts F;
+		DeviceSearchTable::Query Q;
+		Q.Limit = 5000;
+		T.Search(Q, R, F);
+		for (std::size_t i = 1; i < R.size(); i++)
+			assert(R[i - 1].SerialNumber < R[i].SerialNumber);
+	}
+	Writer.join();
+}
+
+int main() {
+	SerialNumberPatterns();
+	Filters();
+	Pages();
+	RemoveAndReuse();
+	ConcurrentUpdates();
+	std::printf("devicesearchtable: ok\n");
+	return 0;
+}
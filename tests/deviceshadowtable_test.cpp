@@ -0,0 +1,192 @@
+//
+//	License type: BSD 3-Clause License
+//	License copy: https://github.com/Telecominfraproject/wlan-cloud-ucentralgw/blob/master/LICENSE
+//
+
+#undef NDEBUG
+#include <cassert>
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "DeviceShadowTable.h"
+
+using OpenWifi::CompressedText;
+using OpenWifi::DeviceShadowTable;
+
+static DeviceShadowTable::Statistics Stats(std::uint64_t Recorded) {
+	return {Recorded * 10, Recorded,
+			CompressedText("{\"unit\":{\"load\":[" + std::to_string(Recorded) + "]}}", false)};
+}
+
+static DeviceShadowTable::HealthCheck Check(std::uint64_t Recorded) {
+	return {Recorded * 10, Recorded, 100 - Recorded, "{\"ok\":" + std::to_string(Recorded) + "}"};
+}
+
+//	The shadow only answers for the newest HowMany records when it holds that many; otherwise
+//	the caller goes to the database.
+static void NewestOrDatabase() {
+	DeviceShadowTable T(3);
+	std::vector<DeviceShadowTable::Statistics> S;
+	assert(!T.GetNewestStatistics(1, 1, S));
+	T.SetStatistics(1, Stats(100));
+	T.SetStatistics(1, Stats(200));
+	assert(!T.GetNewestStatistics(1, 3, S));
+	assert(!T.GetNewestStatistics(1, 0, S));
+	assert(T.GetNewestStatistics(1, 2, S));
+	assert(S.size() == 2 && S[0].Recorded == 200 && S[1].Recorded == 100);
+	//	only History records are kept, the newest ones
+	T.SetStatistics(1, Stats(300));
+	T.SetStatistics(1, Stats(400));
+	assert(!T.GetNewestStatistics(1, 4, S));
+	assert(T.GetNewestStatistics(1, 3, S));
+	assert(S[0].Recorded == 400 && S[2].Recorded == 200);
+	assert(S[0].Data.Text() == "{\"unit\":{\"load\":[400]}}");
+
+	std::vector<DeviceShadowTable::HealthCheck> C;
+	assert(!T.GetNewestHealthChecks(1, 1, C));
+	T.SetHealthCheck(1, Check(100));
+	assert(T.GetNewestHealthChecks(1, 1, C));
+	assert(C.size() == 1 && C[0].Sanity == 0 && C[0].Data == "{\"ok\":100}");
+	assert(!T.GetNewestHealthChecks(2, 1, C));
+}
+
+//	A date bounded delete only takes the records in its range; the newest one stays.
+static void RemoveRange() {
+	DeviceShadowTable T(4);
+	for (std::uint64_t R = 100; R <= 400; R += 100) {
+		T.SetStatistics(1, Stats(R));
+		T.SetHealthCheck(1, Check(R));
+		T.SetStatistics(2, Stats(R));
+	}
+	std::vector<DeviceShadowTable::Statistics> S;
+	T.RemoveStatistics(1, 0, 200);
+	assert(T.GetNewestStatistics(1, 2, S));
+	assert(S[0].Recorded == 400 && S[1].Recorded == 300);
+	assert(!T.GetNewestStatistics(1, 3, S));
+	T.RemoveStatistics(1, 350, 0);
+	assert(T.GetNewestStatistics(1, 1, S) && S[0].Recorded == 300);
+	//	other devices are left alone
+	assert(T.GetNewestStatistics(2, 4, S));
+
+	std::vector<DeviceShadowTable::HealthCheck> C;
+	T.RemoveHealthChecks(1, 200, 300);
+	assert(T.GetNewestHealthChecks(1, 2, C));
+	assert(C[0].Recorded == 400 && C[1].Recorded == 100);
+
+	T.RemoveAllStatistics(0, 299);
+	assert(T.GetNewestStatistics(2, 2, S) && !T.GetNewestStatistics(2, 3, S));
+	assert(S[1].Recorded == 300);
+	//	no dates is everything
+	T.RemoveAllStatistics(0, 0);
+	assert(!T.GetNewestStatistics(1, 1, S) && !T.GetNewestStatistics(2, 1, S));
+}
+
+static void Capabilities() {
+	DeviceShadowTable T;
+	DeviceShadowTable::Capabilities Caps;
+	assert(!T.GetCapabilities(1, Caps));
+	T.SetCapabilities(1, "{\"compatible\":\"x\"}", 10);
+	T.SetCapabilities(1, "{\"compatible\":\"y\"}", 20);
+	assert(T.GetCapabilities(1, Caps));
+	assert(Caps.Text == "{\"compatible\":\"y\"}" && Caps.FirstUpdate == 10 && Caps.LastUpdate == 20);
+	T.ClearCapabilities(1);
+	assert(!T.GetCapabilities(1, Caps));
+}
+
+//	What is saved at a checkpoint is what is loaded back after a restart.
+static void SaveAndLoad() {
+	DeviceShadowTable T(2);
+	for (std::uint64_t SN = 1; SN <= 500; SN++) {
+		T.SetStatistics(SN, Stats(SN));
+		T.SetStatistics(SN, Stats(SN + 1000));
+		T.SetHealthCheck(SN, Check(SN));
+		T.SetCapabilities(SN, "caps " + std::to_string(SN), SN);
+		if (SN % 2)
+			T.SetConnection(SN, std::string("packed\0connection", 17) + std::to_string(SN));
+	}
+	assert(T.TakeChanged());
+	assert(!T.TakeChanged());
+	std::stringstream File;
+	assert(T.Save(File) == 500);
+
+	DeviceShadowTable L(2);
+	std::uint64_t Devices = 0;
+	assert(L.Load(File, true, 9, Devices));
+	assert(Devices == 500);
+	for (std::uint64_t SN = 1; SN <= 500; SN++) {
+		std::vector<DeviceShadowTable::Statistics> S;
+		assert(L.GetNewestStatistics(SN, 2, S));
+		assert(S[0].Recorded == SN + 1000 && S[0].UUID == (SN + 1000) * 10);
+		assert(S[1].Data.Text() == Stats(SN).Data.Text());
+		std::vector<DeviceShadowTable::HealthCheck> C;
+		assert(L.GetNewestHealthChecks(SN, 1, C) && !L.GetNewestHealthChecks(SN, 2, C));
+		assert(C[0].Recorded == SN && C[0].Sanity == 100 - SN && C[0].Data == Check(SN).Data);
+		DeviceShadowTable::Capabilities Caps;
+		assert(L.GetCapabilities(SN, Caps) && Caps.Text == "caps " + std::to_string(SN));
+		std::string Connection;
+		assert(L.GetConnection(SN, Connection) == (SN % 2 == 1));
+		if (SN % 2)
+			assert(Connection == std::string("packed\0connection", 17) + std::to_string(SN));
+	}
+	auto Saved = T.GetUsage(), Loaded = L.GetUsage();
+	assert(Saved.Devices == 500 && Loaded.Devices == 500);
+	assert(Saved.StatisticsRawBytes == Loaded.StatisticsRawBytes);
+
+	//	a shorter history keeps the newest records of the file
+	File.clear();
+	File.seekg(0);
+	DeviceShadowTable Short(1);
+	assert(Short.Load(File, false, 1, Devices) && Devices == 500);
+	std::vector<DeviceShadowTable::Statistics> S;
+	assert(Short.GetNewestStatistics(7, 1, S) && S[0].Recorded == 1007);
+	assert(!Short.GetNewestStatistics(7, 2, S));
+}
+
+static void DamagedFiles() {
+	DeviceShadowTable T;
+	std::uint64_t Devices = 0;
+	std::stringstream Empty;
+	assert(!T.Load(Empty, false, 1, Devices));
+	std::stringstream Foreign("not a shadow file at all");
+	assert(!T.Load(Foreign, false, 1, Devices));
+
+	DeviceShadowTable Source;
+	for (std::uint64_t SN = 1; SN <= 10; SN++)
+		Source.SetStatistics(SN, Stats(SN));
+	std::stringstream File;
+	Source.Save(File);
+	auto Bytes = File.str();
+	//	cut in the middle: the devices before the cut are kept
+	std::stringstream Cut(Bytes.substr(0, Bytes.size() / 2));
+	assert(!T.Load(Cut, false, 1, Devices));
+	assert(Devices > 0 && Devices < 10);
+	assert(T.GetUsage().Devices == Devices);
+}
+
+static void BinaryValues() {
+	std::stringstream SS;
+	DeviceShadowTable::Binary::Put(SS, (std::uint64_t)0x0102030405060708ULL);
+	DeviceShadowTable::Binary::Put(SS, std::string("abc"));
+	DeviceShadowTable::Binary::Put(SS, 1.5);
+	assert(SS.str().substr(0, 8) == std::string("\x08\x07\x06\x05\x04\x03\x02\x01", 8));
+	std::uint64_t U = 0;
+	std::string Str;
+	double D = 0;
+	assert(DeviceShadowTable::Binary::Get(SS, U) && U == 0x0102030405060708ULL);
+	assert(DeviceShadowTable::Binary::Get(SS, Str) && Str == "abc");
+	assert(DeviceShadowTable::Binary::Get(SS, D) && D == 1.5);
+	assert(!DeviceShadowTable::Binary::Get(SS, U));
+}
+
+int main() {
+	NewestOrDatabase();
+	RemoveRange();
+	Capabilities();
+	SaveAndLoad();
+	DamagedFiles();
+	BinaryValues();
+	std::printf("deviceshadowtable: ok\n");
+	return 0;
+}
@@ -0,0 +1,123 @@
+//
+//	License type: BSD 3-Clause License
+//	License copy: https://github.com/Telecominfraproject/wlan-cloud-ucentralgw/blob/master/LICENSE
+//
+
+#undef NDEBUG
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "OutstandingRPCTable.h"
+
+namespace {
+
+	using Clock = std::chrono::high_resolution_clock;
+
+	struct Request {
+		std::uint64_t Id = 0;
+		std::uint64_t SerialNumber = 0;
+		std::string UUID;
+		Clock::time_point submitted;
+		Clock::time_point Deadline;
+		std::string Payload;
+	};
+
+	const auto Start = Clock::now();
+
+	Request Make(std::uint64_t Id, std::uint64_t SerialNumber, const std::string &UUID,
+				 int SubmittedMs, int DeadlineMs = 0) {
+		Request R;
+		R.Id = Id;
+		R.SerialNumber = SerialNumber;
+		R.UUID = UUID;
+		R.submitted = Start + std::chrono::milliseconds(SubmittedMs);
+		R.Deadline = Start + std::chrono::milliseconds(DeadlineMs);
+		R.Payload = "payload-" + std::to_string(Id);
+		return R;
+	}
+
+} // namespace
+
+static void Indexes() {
+	OpenWifi::OutstandingRPCTable<Request> T;
+	T.Add(Make(10, 1, "a", 0), false);
+	T.Add(Make(11, 1, "b", 1), false);
+	T.Add(Make(12, 2, "c", 2), false);
+	assert(T.Size() == 3);
+
+	assert(T.Find(11) != nullptr && T.Find(11)->UUID == "b");
+	assert(T.Find(99) == nullptr);
+	assert(T.FirstForDevice(1)->Id == 10);
+	assert((T.ForDevice(1) == std::vector<std::uint64_t>{10, 11}));
+	assert(T.ForDevice(3).empty());
+	assert(T.FindUUID("c")->Id == 12);
+
+	//	the removed request is handed back whole
+	Request Removed;
+	assert(T.Erase(10, &Removed));
+	assert(Removed.Id == 10 && Removed.Payload == "payload-10");
+	assert(!T.Erase(10));
+	assert(T.FirstForDevice(1)->Id == 11);
+	assert(T.FindUUID("a") == nullptr);
+
+	assert(T.Erase(11));
+	assert(T.FirstForDevice(1) == nullptr && T.ForDevice(1).empty());
+	assert(T.Size() == 1);
+}
+
+static void Replaced() {
+	OpenWifi::OutstandingRPCTable<Request> T;
+	T.Add(Make(5, 1, "old", 0, 10), true);
+	T.Add(Make(5, 2, "new", 100), false);
+	assert(T.Size() == 1);
+	assert(T.FindUUID("old") == nullptr && T.FindUUID("new")->Id == 5);
+	assert(T.FirstForDevice(1) == nullptr && T.FirstForDevice(2)->Id == 5);
+	//	neither the old submission time nor the old deadline is left behind
+	assert(T.OldestSubmittedBefore(Start + std::chrono::milliseconds(50)) == nullptr);
+	assert(T.FirstDeadlineAtOrBefore(Start + std::chrono::hours(1)) == nullptr);
+
+	//	the same UUID may be outstanding under two ids
+	T.Add(Make(6, 2, "new", 101), false);
+	assert(T.Erase(5));
+	assert(T.FindUUID("new")->Id == 6);
+}
+
+static void TimeOuts() {
+	OpenWifi::OutstandingRPCTable<Request> T;
+	for (std::uint64_t Id = 1; Id <= 10; Id++)
+		T.Add(Make(Id, Id % 3, "u" + std::to_string(Id), (int)Id * 10), false);
+
+	//	oldest first, strictly before the cutoff
+	std::vector<std::uint64_t> Expired;
+	while (auto R = T.OldestSubmittedBefore(Start + std::chrono::milliseconds(50))) {
+		Expired.push_back(R->Id);
+		T.Erase(R->Id);
+	}
+	assert((Expired == std::vector<std::uint64_t>{1, 2, 3, 4}));
+	assert(T.Size() == 6);
+
+	T.Add(Make(20, 1, "d1", 200, 300), true);
+	T.Add(Make(21, 1, "d2", 200, 100), true);
+	T.Add(Make(22, 1, "d3", 200, 500), true);
+	T.ClearDeadline(*T.Find(21));
+
+	auto At = Start + std::chrono::milliseconds(300);
+	auto Due = T.FirstDeadlineAtOrBefore(At);
+	assert(Due != nullptr && Due->Id == 20);
+	T.Erase(Due->Id);
+	assert(T.FirstDeadlineAtOrBefore(At) == nullptr);
+	assert(T.Find(21) != nullptr);
+	assert(T.FirstDeadlineAtOrBefore(Start + std::chrono::milliseconds(500))->Id == 22);
+}
+
+int main() {
+	Indexes();
+	Replaced();
+	TimeOuts();
+	std::printf("outstandingrpctable: ok\n");
+	return 0;
+}
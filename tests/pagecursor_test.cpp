@@ -0,0 +1,108 @@
+//
+//	License type: BSD 3-Clause License
+//	License copy: https://github.com/Telecominfraproject/wlan-cloud-ucentralgw/blob/master/LICENSE
+//
+
+#undef NDEBUG
+#include <cassert>
+#include <cstdio>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "PageCursor.h"
+
+using OpenWifi::PageCursor;
+
+static std::string Hex(const std::string &Raw) {
+	static const char hex[] = "0123456789abcdef";
+	std::string Token;
+	for (const auto c : Raw) {
+		Token += hex[((unsigned char)c) >> 4];
+		Token += hex[((unsigned char)c) & 0x0f];
+	}
+	return Token;
+}
+
+static void RoundTrip() {
+	PageCursor C;
+	assert(PageCursor::from_token("", C) && !C.Valid);
+
+	C.Step(1700000000, "aabbccddeeff");
+	C.Step(1700000001, "112233445566");
+	assert(C.Valid && C.Time == 1700000001 && C.Key == "112233445566");
+
+	PageCursor D;
+	assert(PageCursor::from_token(C.to_token(), D));
+	assert(D.Valid && D.Time == C.Time && D.Key == C.Key);
+
+	PageCursor U;
+	U.Step(0, "0f6a2c6e-0f8a-4e0b-b1a4-8fa6ad2d11e4");
+	assert(PageCursor::from_token(U.to_token(), D) && D.Time == 0 && D.Key == U.Key);
+}
+
+static void LegacyToken() {
+	//	tokens carrying a skip count still resume after their key
+	PageCursor C;
+	assert(PageCursor::from_token(Hex("1700000000:3:aabbccddeeff"), C));
+	assert(C.Valid && C.Time == 1700000000 && C.Key == "aabbccddeeff");
+}
+
+static void Rejected() {
+	PageCursor C;
+	assert(!PageCursor::from_token("abc", C));
+	assert(!PageCursor::from_token("zz", C));
+	assert(!PageCursor::from_token(Hex("aabbccddeeff"), C));
+	assert(!PageCursor::from_token(Hex(":aabbccddeeff"), C));
+	assert(!PageCursor::from_token(Hex("12x:aabbccddeeff"), C));
+	assert(!PageCursor::from_token(Hex("1::aabbccddeeff"), C));
+	assert(!PageCursor::from_token(Hex("1:2:3:aabbccddeeff"), C));
+	assert(!PageCursor::from_token(Hex("12345678901234567890:aa"), C));
+	assert(!PageCursor::from_token(Hex("1:aa' OR '1'='1"), C));
+	assert(!PageCursor::from_token(Hex("1:aa;"), C));
+	assert(!C.Valid);
+}
+
+using Row = std::pair<std::uint64_t, std::string>;
+
+static void CompletesLastPosition() {
+	//	the table holds three rows at (20, "b"); the page stopped after two of them
+	std::vector<Row> Table{{10, "a"}, {20, "a"}, {20, "b"}, {20, "b"}, {20, "b"}, {30, "a"}};
+	std::vector<Row> Page(Table.begin(), Table.begin() + 4);
+	int Reads = 0;
+	OpenWifi::CompleteLastPosition(
+		Page, [](const Row &R) { return R; },
+		[&](std::uint64_t Time, const std::string &Key, std::vector<Row> &Group) {
+			Reads++;
+			for (const auto &R : Table)
+				if (R.first == Time && R.second == Key)
+					Group.push_back(R);
+		});
+	assert(Reads == 1);
+	assert(Page.size() == 5);
+	assert((Page == std::vector<Row>(Table.begin(), Table.begin() + 5)));
+
+	//	a page made of one position is replaced as a whole
+	std::vector<Row> Same{{20, "b"}, {20, "b"}};
+	OpenWifi::CompleteLastPosition(
+		Same, [](const Row &R) { return R; },
+		[&](std::uint64_t, const std::string &, std::vector<Row> &Group) {
+			Group.assign(3, Row{20, "b"});
+		});
+	assert(Same.size() == 3);
+
+	std::vector<Row> Empty;
+	OpenWifi::CompleteLastPosition(
+		Empty, [](const Row &R) { return R; },
+		[&](std::uint64_t, const std::string &, std::vector<Row> &) { assert(false); });
+	assert(Empty.empty());
+}
+
+int main() {
+	RoundTrip();
+	LegacyToken();
+	Rejected();
+	CompletesLastPosition();
+	std::printf("pagecursor: ok\n");
+	return 0;
+}
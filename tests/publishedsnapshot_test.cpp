@@ -0,0 +1,68 @@
+//
+//	License type: BSD 3-Clause License
+//	License copy: https://github.com/Telecominfraproject/wlan-cloud-ucentralgw/blob/master/LICENSE
+//
+
+#undef NDEBUG
+#include <atomic>
+#include <cassert>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#include "PublishedSnapshot.h"
+
+using OpenWifi::PublishedSnapshot;
+
+static void PublishAndRead() {
+	PublishedSnapshot<std::vector<int>> S(std::make_unique<const std::vector<int>>(3, 1));
+	assert(S.Read([](const std::vector<int> &V) { return V.size(); }) == 3);
+	S.Publish(std::make_unique<const std::vector<int>>(5, 2));
+	assert(S.Read([](const std::vector<int> &V) { return V.size(); }) == 5);
+	assert(S.Latest().size() == 5);
+	assert(S.Replaced() == 1);
+}
+
+//	A reader that throws still leaves, or the next Publish would never return.
+static void ThrowingReader() {
+	PublishedSnapshot<int> S(std::make_unique<const int>(1));
+	try {
+		S.Read([](const int &) -> int { throw 1; });
+		assert(false);
+	} catch (int) {
+	}
+	S.Publish(std::make_unique<const int>(2));
+	assert(S.Read([](const int &V) { return V; }) == 2);
+}
+
+//	Every value holds the same number in each element; a reader seeing a mix, or a value freed
+//	under it when built with a sanitizer, fails.
+static void ConcurrentReaders() {
+	PublishedSnapshot<std::vector<int>> S(std::make_unique<const std::vector<int>>(256, 0));
+	std::atomic_bool Done = false;
+	std::vector<std::thread> Readers;
+	for (int t = 0; t < 4; t++) {
+		Readers.emplace_back([&] {
+			while (!Done) {
+				S.Read([](const std::vector<int> &V) {
+					for (auto E : V)
+						assert(E == V.front());
+				});
+			}
+		});
+	}
+	for (int Round = 1; Round <= 200; Round++)
+		S.Publish(std::make_unique<const std::vector<int>>(256, Round));
+	Done = true;
+	for (auto &R : Readers)
+		R.join();
+	assert(S.Replaced() == 200);
+}
+
+int main() {
+	PublishAndRead();
+	ThrowingReader();
+	ConcurrentReaders();
+	std::printf("publishedsnapshot: ok\n");
+	return 0;
+}
@@ -0,0 +1,93 @@
+//
+//	License type: BSD 3-Clause License
+//	License copy: https://github.com/Telecominfraproject/wlan-cloud-ucentralgw/blob/master/LICENSE
+//
+
+#undef NDEBUG
+#include <cassert>
+#include <cstdio>
+#include <string>
+
+#include "RawJSONObject.h"
+
+using OpenWifi::RawJSONObject;
+
+static void ParseMembers() {
+	RawJSONObject O;
+	assert(O.Parse(R"( { "a" : 12, "s":"x\"y", "o":{"k":[1,{"z":"]"}]}, "l":[ 1 , 2 ], "n":null } )"));
+	assert(O.Raw("a") == "12");
+	assert(O.Raw("o") == R"({"k":[1,{"z":"]"}]})");
+	assert(O.IsObject("o") && !O.IsObject("l"));
+	assert(O.IsArray("l") && !O.IsArray("o"));
+	assert(O.Raw("n") == "null");
+	assert(!O.Has("missing"));
+
+	std::string S;
+	assert(O.GetString("s", S) && S == "x\"y");
+
+	std::uint64_t U = 0;
+	assert(O.GetUInt("a", U) && U == 12);
+	assert(!O.GetUInt("s", U));
+
+	//	frames carry a trailing null
+	std::string Frame{R"({"a":1})"};
+	Frame.push_back('\0');
+	assert(O.Parse(Frame) && O.Raw("a") == "1");
+
+	assert(O.Parse("{}") && !O.Has("a"));
+}
+
+static void RejectMalformed() {
+	RawJSONObject O;
+	assert(!O.Parse(""));
+	assert(!O.Parse("[1,2]"));
+	assert(!O.Parse(R"({"a":1)"));
+	assert(!O.Parse(R"({"a":1} x)"));
+	assert(!O.Parse(R"({"a":[1}})"));
+	assert(!O.Parse(R"({"a" 1})"));
+	assert(!O.Parse(R"({"a":"unterminated})"));
+}
+
+static void GetStringFailureClearsValue() {
+	RawJSONObject O;
+	assert(O.Parse(R"({"u":"ab\u0041cd","n":5,"e":"a\tb"})"));
+	std::string S{"previous"};
+	assert(!O.GetString("u", S) && S.empty());
+	S = "previous";
+	assert(!O.GetString("n", S) && S.empty());
+	S = "previous";
+	assert(!O.GetString("missing", S) && S.empty());
+	assert(O.GetString("e", S) && S == "a\tb");
+}
+
+static void Elements() {
+	std::vector<std::string_view> V;
+	assert(RawJSONObject::Elements(R"([ 1, "a,b", {"x":[2,3]}, [4] ])", V));
+	assert(V.size() == 4);
+	assert(V[0] == "1" && V[1] == R"("a,b")" && V[2] == R"({"x":[2,3]})" && V[3] == "[4]");
+	assert(RawJSONObject::Elements("[]", V) && V.empty());
+	assert(!RawJSONObject::Elements("[1,", V));
+	assert(!RawJSONObject::Elements(R"({"a":1})", V));
+}
+
+static void Numbers() {
+	std::uint64_t U = 0;
+	assert(RawJSONObject::ToUInt("42", U) && U == 42);
+	assert(!RawJSONObject::ToUInt("-1", U));
+	assert(!RawJSONObject::ToUInt("4.2", U));
+	assert(!RawJSONObject::ToUInt("", U));
+	double D = 0;
+	assert(RawJSONObject::ToNumber("45.5", D) && D == 45.5);
+	assert(RawJSONObject::ToNumber("-3", D) && D == -3);
+	assert(!RawJSONObject::ToNumber("1x", D));
+}
+
+int main() {
+	ParseMembers();
+	RejectMalformed();
+	GetStringFailureClearsValue();
+	Elements();
+	Numbers();
+	std::printf("rawjsonobject: ok\n");
+	return 0;
+}
@@ -0,0 +1,111 @@
+//
+//	License type: BSD 3-Clause License
+//	License copy: https://github.com/Telecominfraproject/wlan-cloud-ucentralgw/blob/master/LICENSE
+//
+
+#undef NDEBUG
+#include <atomic>
+#include <cassert>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#include "SerialNumberHashSet.h"
+
+using OpenWifi::SerialNumberHashSet;
+
+static void InsertEraseContains() {
+	SerialNumberHashSet S(16);
+	assert(!S.Contains(0x903cb3000001));
+	assert(S.Insert(0x903cb3000001));
+	assert(!S.Insert(0x903cb3000001));
+	assert(S.Contains(0x903cb3000001));
+	assert(S.Size() == 1);
+	assert(S.Erase(0x903cb3000001));
+	assert(!S.Erase(0x903cb3000001));
+	assert(!S.Contains(0x903cb3000001));
+	assert(S.Size() == 0);
+}
+
+static void Growth() {
+	SerialNumberHashSet S(16);
+	for (std::uint64_t i = 0; i < 10000; i++)
+		assert(S.Insert(0x24f5a2000000 + i * 7));
+	assert(S.Size() == 10000);
+	assert(S.Slots() >= 20000);
+	for (std::uint64_t i = 0; i < 10000; i++) {
+		assert(S.Contains(0x24f5a2000000 + i * 7));
+		assert(!S.Contains(0x24f5a2000000 + i * 7 + 1));
+	}
+	//	every replaced table was freed
+	assert(S.Reclaimed() > 0);
+}
+
+static void DeletedSlotsAreRecycled() {
+	SerialNumberHashSet S(64);
+	//	churn on a small population must not grow the table
+	for (std::uint64_t i = 0; i < 100000; i++) {
+		assert(S.Insert(i));
+		if (i >= 8)
+			assert(S.Erase(i - 8));
+	}
+	assert(S.Size() == 8);
+	assert(S.Slots() == 64);
+	for (std::uint64_t i = 100000 - 8; i < 100000; i++)
+		assert(S.Contains(i));
+}
+
+static void Assign() {
+	SerialNumberHashSet S(16);
+	S.Insert(1);
+	std::vector<std::uint64_t> SNs;
+	for (std::uint64_t i = 100; i < 5000; i++)
+		SNs.push_back(i);
+	S.Assign(SNs);
+	assert(S.Size() == SNs.size());
+	assert(!S.Contains(1));
+	assert(S.Contains(100) && S.Contains(4999));
+	S.Clear();
+	assert(S.Size() == 0 && !S.Contains(100));
+}
+
+//	Readers probe while the writer keeps replacing tables. Built with a sanitizer, this catches
+//	a table freed under a reader.
+static void ConcurrentReaders() {
+	SerialNumberHashSet S(16);
+	for (std::uint64_t i = 0; i < 64; i++)
+		S.Insert(i);
+	std::atomic_bool Done = false;
+	std::vector<std::thread> Readers;
+	for (int t = 0; t < 3; t++) {
+		Readers.emplace_back([&] {
+			while (!Done) {
+				for (std::uint64_t i = 0; i < 64; i++)
+					assert(S.Contains(i));
+			}
+		});
+	}
+	for (int Round = 0; Round < 200; Round++) {
+		for (std::uint64_t i = 0; i < 2000; i++)
+			S.Insert(1000 + i);
+		for (std::uint64_t i = 0; i < 2000; i++)
+			S.Erase(1000 + i);
+		std::vector<std::uint64_t> SNs;
+		for (std::uint64_t i = 0; i < 64 + (std::uint64_t)Round; i++)
+			SNs.push_back(i);
+		S.Assign(SNs);
+	}
+	Done = true;
+	for (auto &R : Readers)
+		R.join();
+}
+
+int main() {
+	InsertEraseContains();
+	Growth();
+	DeletedSlotsAreRecycled();
+	Assign();
+	ConcurrentReaders();
+	std::printf("serialnumberhashset: ok\n");
+	return 0;
+}
@@ -0,0 +1,89 @@
+//
+//	License type: BSD 3-Clause License
+//	License copy: https://github.com/Telecominfraproject/wlan-cloud-ucentralgw/blob/master/LICENSE
+//
+
+#undef NDEBUG
+#include <cassert>
+#include <cstdio>
+#include <map>
+#include <set>
+
+#include "AP_WS_TimingWheel.h"
+
+using OpenWifi::AP_WS_TimingWheel;
+
+static std::set<std::uint64_t> Advance(AP_WS_TimingWheel &W, std::uint64_t Now) {
+	std::set<std::uint64_t> Fired;
+	W.Advance(Now, [&](std::uint64_t Id, std::uint64_t Deadline) -> std::uint64_t {
+		assert(Deadline <= Now);
+		Fired.insert(Id);
+		return 0;
+	});
+	return Fired;
+}
+
+static void FiresWhenDue() {
+	AP_WS_TimingWheel W(1, 16);
+	W.Schedule(1, 1000);
+	W.Schedule(2, 1005);
+	W.Schedule(3, 1005 + 16); //	same slot, next turn
+	assert(W.Size() == 3);
+	assert(Advance(W, 999).empty());
+	assert((Advance(W, 1000) == std::set<std::uint64_t>{1}));
+	assert(Advance(W, 1004).empty());
+	assert((Advance(W, 1005) == std::set<std::uint64_t>{2}));
+	assert(W.Size() == 1);
+	assert(Advance(W, 1020).empty());
+	assert((Advance(W, 1021) == std::set<std::uint64_t>{3}));
+	assert(W.Size() == 0);
+}
+
+static void ScheduledBeforeFirstAdvance() {
+	//	entries due before the first advance must not wait for a full turn
+	AP_WS_TimingWheel W(1, 16);
+	W.Schedule(1, 1000);
+	W.Schedule(2, 1003);
+	assert((Advance(W, 1005) == std::set<std::uint64_t>{1, 2}));
+}
+
+static void LongPause() {
+	AP_WS_TimingWheel W(1, 8);
+	Advance(W, 100);
+	for (std::uint64_t i = 0; i < 20; i++)
+		W.Schedule(i, 101 + i);
+	assert(Advance(W, 1000).size() == 20);
+	assert(W.Size() == 0);
+}
+
+static void PastDeadline() {
+	AP_WS_TimingWheel W(1, 8);
+	Advance(W, 100);
+	W.Schedule(1, 50);
+	assert((Advance(W, 101) == std::set<std::uint64_t>{1}));
+}
+
+static void Reschedule() {
+	AP_WS_TimingWheel W(10, 4);
+	W.Schedule(7, 100);
+	std::map<std::uint64_t, int> Count;
+	for (std::uint64_t Now = 100; Now <= 400; Now += 10) {
+		W.Advance(Now, [&](std::uint64_t Id, std::uint64_t) -> std::uint64_t {
+			Count[Id]++;
+			return Now + 100;
+		});
+	}
+	//	every 100 seconds from 100 to 400
+	assert(Count[7] == 4);
+	assert(W.Size() == 1);
+}
+
+int main() {
+	FiresWhenDue();
+	ScheduledBeforeFirstAdvance();
+	LongPause();
+	PastDeadline();
+	Reschedule();
+	std::printf("timingwheel: ok\n");
+	return 0;
+}